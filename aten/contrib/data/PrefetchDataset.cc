@@ -0,0 +1,186 @@
+#include "PrefetchDataset.h"
+#include "Dataset.h"
+#include "ATen/ATen.h"
+#include <algorithm>
+#include <cassert>
+#include <stdexcept>
+
+using namespace at;
+
+PrefetchDataset::PrefetchDataset(Dataset& dataset, uint64_t batchsize,
+                                 uint64_t numworkers, uint64_t numprefetch,
+                                 bool ordered, bool fullbatches, bool pinmemory)
+   : pool_(std::max<uint64_t>(numworkers, 1)) {
+   assert(batchsize > 0);
+   dataset_ = &dataset;
+   batchsize_ = batchsize;
+   size_ = dataset_->size();
+   if(fullbatches)
+      numbatches_ = size_ / batchsize_;
+   else
+      numbatches_ = (size_ + batchsize_ - 1) / batchsize_;
+   numprefetch_ = std::max<uint64_t>(numprefetch, 1);
+   ordered_ = ordered;
+   pinmemory_ = pinmemory;
+   for(auto fieldkey : dataset_->fieldKeys()) {
+      addFieldKey(fieldkey);
+   }
+
+   // one buffer per batch in flight, and one for the reader:
+   buffers_.resize(numprefetch_ + 1);
+   for(auto& buffer : buffers_) {
+      free_.push_back(&buffer);
+   }
+}
+
+uint64_t PrefetchDataset::batchSize(uint64_t idx) {
+   return std::min(batchsize_, size_ - idx * batchsize_);
+}
+
+void PrefetchDataset::getField(uint64_t idx, std::string& fieldkey, Tensor& field) {
+
+   // assertions:
+   assert(idx < size());
+   assert(hasField(fieldkey));
+
+   // synchronous version of collate(), for a single field:
+   Tensor sample;
+   uint64_t maxsize = batchSize(idx);
+   for(uint64_t n = 0; n < maxsize; n++) {
+      dataset_->getField(idx * batchsize_ + n, fieldkey, sample);
+      if(n == 0) {
+         std::vector<int64_t> fieldsize(1, maxsize);
+         for(int64_t d = 0; d < sample.dim(); ++d) {
+            fieldsize.push_back(sample.size(d));
+         }
+         field.resize_(fieldsize);
+      }
+      select(field, 0, n).copy_(sample);
+   }
+}
+
+uint64_t PrefetchDataset::size() {
+   return numbatches_;
+}
+
+// collate the batch idx into the buffer, on a worker:
+void PrefetchDataset::collate(uint64_t idx, Buffer* buffer) {
+   try {
+      buffer->count = batchSize(idx);
+      buffer->error = nullptr;
+      Tensor sample;
+      for(auto fieldkey : dataset_->fieldKeys()) {
+         Tensor& field = buffer->fields[fieldkey];
+         for(uint64_t n = 0; n < buffer->count; n++) {
+            dataset_->getField(idx * batchsize_ + n, fieldkey, sample);
+
+            // the buffer keeps its memory from one batch to the next, unless
+            // the samples changed:
+            std::vector<int64_t> fieldsize(1, batchsize_);
+            for(int64_t d = 0; d < sample.dim(); ++d) {
+               fieldsize.push_back(sample.size(d));
+            }
+            if(!field.defined() || field.type() != sample.type() ||
+               !field.sizes().equals(fieldsize)) {
+               if(n > 0) {
+                  throw std::runtime_error(
+                     "PrefetchDataset: samples of field " + fieldkey +
+                     " differ in size or type within a batch");
+               }
+               field = sample.type().tensor(fieldsize);
+               if(pinmemory_) {
+                  field = field.pin_memory();
+               }
+            }
+            select(field, 0, n).copy_(sample);
+         }
+      }
+   } catch(...) {
+      buffer->error = std::current_exception();
+   }
+
+   {
+      std::lock_guard<std::mutex> lock(mutex_);
+      ready_[idx] = buffer;
+   }
+   ready_cv_.notify_all();
+}
+
+// start collating batches while there are free buffers:
+void PrefetchDataset::schedule() {
+   while(scheduled_ < numbatches_ &&
+         scheduled_ - delivered_ < numprefetch_ && !free_.empty()) {
+      Buffer* buffer = free_.back();
+      free_.pop_back();
+      uint64_t idx = scheduled_++;
+      pool_.enqueue([this, idx, buffer]() { collate(idx, buffer); });
+   }
+}
+
+// collect the futures of the first count tasks to finish, waitFor() blocks
+// until a task is finished:
+void PrefetchDataset::drain(uint64_t count) {
+   while(drained_ < count) {
+      pool_.waitFor();
+      drained_++;
+   }
+}
+
+bool PrefetchDataset::next(Fields& batch) {
+
+   // the previous batch is not in use anymore:
+   if(current_ != nullptr) {
+      free_.push_back(current_);
+      current_ = nullptr;
+   }
+   schedule();
+   if(delivered_ == numbatches_)
+      return false;
+
+   // wait for the next batch:
+   Buffer* buffer;
+   {
+      std::unique_lock<std::mutex> lock(mutex_);
+      ready_cv_.wait(lock, [this] {
+         return ordered_ ? ready_.count(delivered_) > 0 : !ready_.empty();
+      });
+      auto it = ordered_ ? ready_.find(delivered_) : ready_.begin();
+      buffer = it->second;
+      ready_.erase(it);
+   }
+   delivered_++;
+   drain(delivered_);
+   current_ = buffer;
+   schedule();
+   if(buffer->error)
+      std::rethrow_exception(buffer->error);
+
+   // the last batch may be smaller than its buffer:
+   batch.clear();
+   for(auto& field : buffer->fields) {
+      if(buffer->count == batchsize_)
+         batch[field.first] = field.second;
+      else
+         batch[field.first] = field.second.narrow(0, 0, buffer->count);
+   }
+   return true;
+}
+
+void PrefetchDataset::reset() {
+   drain(scheduled_);
+   for(auto& it : ready_) {
+      free_.push_back(it.second);
+   }
+   ready_.clear();
+   if(current_ != nullptr) {
+      free_.push_back(current_);
+      current_ = nullptr;
+   }
+   scheduled_ = 0;
+   delivered_ = 0;
+   drained_ = 0;
+}
+
+PrefetchDataset::~PrefetchDataset() {
+   drain(scheduled_);
+}
@@ -0,0 +1,76 @@
+#ifndef AT_PREFETCH_DATASET_H
+#define AT_PREFETCH_DATASET_H
+
+#include "Dataset.h"
+#include "ATen/ATen.h"
+#include "threadpool/ThreadPool.h"
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Batches of a dataset, collated on a thread pool ahead of the reader.
+//
+// Up to numprefetch batches are prepared in advance by numworkers threads.
+// Each batch is collated in place into contiguous tensors of size
+// [batchsize, ...] taken from a pool of buffers, which are allocated once
+// (in pinned memory if pinmemory is set) and reused for the whole run. The
+// underlying dataset must support concurrent getField() calls.
+//
+// next() returns the batches in order, or in the order in which they are
+// ready if ordered is false. The tensors it returns are only valid until the
+// following call to next(), after which their buffer is reused.
+class PrefetchDataset : public Dataset
+{
+public:
+   PrefetchDataset(Dataset& dataset, uint64_t batchsize, uint64_t numworkers,
+                   uint64_t numprefetch, bool ordered = true,
+                   bool fullbatches = true, bool pinmemory = false);
+   virtual void getField(uint64_t idx, std::string& fieldkey, at::Tensor& field);
+   virtual uint64_t size();
+   // fills batch with the next batch, returns false at the end of the epoch:
+   bool next(Fields& batch);
+   // waits for the batches in flight and starts again from the first batch:
+   void reset();
+   virtual ~PrefetchDataset();
+private:
+   struct Buffer {
+      Fields fields;
+      uint64_t count = 0;
+      std::exception_ptr error;
+   };
+   void schedule();
+   void collate(uint64_t idx, Buffer* buffer);
+   void drain(uint64_t count);
+   uint64_t batchSize(uint64_t idx);
+
+   Dataset* dataset_;
+   uint64_t batchsize_;
+   uint64_t size_;
+   uint64_t numbatches_;
+   uint64_t numprefetch_;
+   bool ordered_;
+   bool pinmemory_;
+
+   // the buffers, and those which are not in use:
+   std::vector<Buffer> buffers_;
+   std::vector<Buffer*> free_;
+   // the buffer returned by the last call to next():
+   Buffer* current_ = nullptr;
+
+   // the collated batches, by index:
+   std::mutex mutex_;
+   std::condition_variable ready_cv_;
+   std::map<uint64_t, Buffer*> ready_;
+
+   uint64_t scheduled_ = 0;
+   uint64_t delivered_ = 0;
+   uint64_t drained_ = 0;
+
+   // last, so that its workers are joined before the rest is destroyed:
+   ThreadPool pool_;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include "Dataset.h"
+#include "PrefetchDataset.h"
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+using namespace at;
+
+#define CHECK(cond) \
+   if(!(cond)) { \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #cond "\n"; \
+      std::exit(1); \
+   }
+
+static std::string key = "value";
+
+// samples of a single value, equal to their index, which take longer for the
+// first samples so that the batches are collated out of order:
+class SlowDataset : public Dataset
+{
+public:
+   SlowDataset(uint64_t size, int64_t failing = -1)
+      : size_(size), failing_(failing) {
+      addFieldKey(key);
+   }
+   virtual void getField(uint64_t idx, std::string& fieldkey, Tensor& field) {
+      std::this_thread::sleep_for(std::chrono::microseconds(100 * (size_ - idx)));
+      if((int64_t) idx == failing_)
+         throw std::runtime_error("failing sample");
+      field = CPU(kLong).tensor({1});
+      field.fill_((int64_t) idx);
+   }
+   virtual uint64_t size() {
+      return size_;
+   }
+private:
+   uint64_t size_;
+   int64_t failing_;
+};
+
+static int64_t value(Fields& batch, int64_t n) {
+   return batch[key].data<int64_t>()[n];
+}
+
+static void testOrdered() {
+   SlowDataset dataset(20);
+   PrefetchDataset prefetch(dataset, 3, 4, 4, true, false);
+   CHECK(prefetch.size() == 7);
+   for(int epoch = 0; epoch < 2; epoch++) {
+      Fields batch;
+      uint64_t idx = 0;
+      while(prefetch.next(batch)) {
+         int64_t count = batch[key].size(0);
+         CHECK(count == (idx < 6 ? 3 : 2));
+         for(int64_t n = 0; n < count; n++) {
+            CHECK(value(batch, n) == (int64_t) (idx * 3 + n));
+         }
+         idx++;
+      }
+      CHECK(idx == 7);
+      prefetch.reset();
+   }
+}
+
+static void testUnordered() {
+   SlowDataset dataset(20);
+   PrefetchDataset prefetch(dataset, 2, 4, 4, false);
+   Fields batch;
+   std::set<int64_t> seen;
+   while(prefetch.next(batch)) {
+      CHECK(value(batch, 1) == value(batch, 0) + 1);
+      seen.insert(value(batch, 0) / 2);
+   }
+   CHECK(seen.size() == 10);
+}
+
+static void testEarlyDestruction() {
+   // the batches in flight are waited for, and their buffers outlive them:
+   for(int i = 0; i < 10; i++) {
+      SlowDataset dataset(64);
+      PrefetchDataset prefetch(dataset, 4, 3, 6);
+      Fields batch;
+      CHECK(prefetch.next(batch));
+      CHECK(value(batch, 0) == 0);
+   }
+   {
+      SlowDataset dataset(64);
+      PrefetchDataset prefetch(dataset, 4, 3, 6);
+   }
+}
+
+static void testWorkerException() {
+   SlowDataset dataset(12, 5);
+   PrefetchDataset prefetch(dataset, 2, 3, 3);
+   Fields batch;
+   uint64_t idx = 0;
+   uint64_t failed = 0;
+   for(;;) {
+      try {
+         if(!prefetch.next(batch))
+            break;
+         CHECK(value(batch, 0) == (int64_t) (idx * 2));
+      } catch(std::runtime_error& e) {
+         // the error of sample 5 is reported with its batch, the batches
+         // after it are still delivered:
+         CHECK(std::string(e.what()) == "failing sample");
+         CHECK(idx == 2);
+         failed++;
+      }
+      idx++;
+   }
+   CHECK(failed == 1);
+   CHECK(idx == 6);
+}
+
+int main()
+{
+   testOrdered();
+   testUnordered();
+   testEarlyDestruction();
+   testWorkerException();
+   std::cout << "PrefetchDataset tests passed\n";
+   return 0;
+}
@@ -43,19 +43,25 @@ void ThreadPool::synchronize() {
       futures[i].first.wait();
 }
 
-// poll the threads for results:
+// wait for the result of a task:
 unsigned int ThreadPool::waitFor() {
+   if(futures.empty())
+      throw std::runtime_error("waitFor on ThreadPool without tasks");
 
-   // wait until a task is finished:
+   // wait until a task is finished, the tasks signal finished once their
+   // future is ready:
    uint64_t i;
-   std::future_status status;
-   do {
-      for(i = 0; i < futures.size(); i++) {
-         status = futures[i].first.wait_for(std::chrono::microseconds(0));
-         if(status == std::future_status::ready) break;
+   {
+      std::unique_lock<std::mutex> lock(finished_mutex);
+      for(;;) {
+         for(i = 0; i < futures.size(); i++) {
+            auto status = futures[i].first.wait_for(std::chrono::microseconds(0));
+            if(status == std::future_status::ready) break;
+         }
+         if(i < futures.size()) break;
+         finished.wait(lock);
       }
-      std::this_thread::sleep_for(std::chrono::microseconds(1));
-   } while (status != std::future_status::ready);
+   }
 
    // get the result and remove the future:
    futures[i].first.get();
@@ -8,6 +8,9 @@
 #include <mutex>
 #include <condition_variable>
 #include <future>
+#include <functional>
+#include <memory>
+#include <stdexcept>
 
 // definition of the ThreadPool class:
 class ThreadPool {
@@ -35,6 +38,10 @@ class ThreadPool {
       std::mutex queue_mutex;
       std::condition_variable condition;
       bool stop;
+
+      // signaled when a task is finished, to wake up waitFor():
+      std::mutex finished_mutex;
+      std::condition_variable finished;
 };
 
 // enqueue new work item into the pool:
@@ -52,7 +59,11 @@ unsigned int ThreadPool::enqueue(F&& f, Args&&... args)
    {
       std::unique_lock<std::mutex> lock(queue_mutex);
       if(stop) throw std::runtime_error("enqueue on stopped ThreadPool");
-      tasks.emplace([task](){ (*task)(); });
+      tasks.emplace([this, task]() {
+         (*task)();
+         std::lock_guard<std::mutex> finished_lock(finished_mutex);
+         finished.notify_all();
+      });
    }
    condition.notify_one();
 
@@ -0,0 +1,35 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+
+#include "vec512_base.h"
+#include "vec512_float.h"
+#include "vec512_double.h"
+#include "vec512_int.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+
+namespace at {
+namespace vec512 {
+namespace {
+
+template <typename T>
+std::ostream& operator<<(std::ostream& stream, const Vec512<T>& vec) {
+  T buf[Vec512<T>::size];
+  vec.store(buf);
+  stream << "vec[";
+  for (int i = 0; i != vec.size; i++) {
+    if (i != 0) {
+      stream << ", ";
+    }
+    stream << buf[i];
+  }
+  stream << "]";
+  return stream;
+}
+
+}}}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <cmath>
+#include <cstring>
+
+#if defined(__GNUC__)
+#define __at_align64__ __attribute__((aligned(64)))
+#elif defined(_WIN32)
+#define __at_align64__ __declspec(align(64))
+#else
+#define __at_align64__
+#endif
+
+namespace at {
+namespace vec512 {
+namespace {
+
+// NOTE: If you specialize on a type, you must define all operations!
+
+// emulates vectorized types
+template <class T>
+struct Vec512 {
+  static constexpr int size = 64 / sizeof(T);
+  __at_align64__ T values[64 / sizeof(T)];
+  Vec512() {}
+  Vec512(T val) {
+    for (int i = 0; i != size; i++) {
+      values[i] = val;
+    }
+  }
+  void load(const void* ptr) {
+    std::memcpy(values, ptr, 64);
+  };
+  void load_partial(const void* ptr, int count) {
+    std::memcpy(values, ptr, count * sizeof(T));
+  }
+  static Vec512 s_load(const T* ptr) {
+    Vec512 vec;
+    vec.load(ptr);
+    return vec;
+  }
+  void store(T *ptr) const {
+    std::memcpy(ptr, values, 64);
+  }
+  void store_partial(void* ptr, int count) const {
+    std::memcpy(ptr, values, count * sizeof(T));
+  }
+  Vec512<T> map(T (*f)(T)) const {
+    Vec512<T> ret;
+    for (int64_t i = 0; i != size; i++) {
+      ret.values[i] = f(values[i]);
+    }
+    return ret;
+  }
+  Vec512<T> abs() const {
+    Vec512<T> ret;
+    for (int64_t i = 0; i < size; i++) {
+      ret.values[i] = values[i] < 0 ? -values[i] : values[i];
+    }
+    return ret;
+  }
+  Vec512<T> exp() const {
+    return map(std::exp);
+  }
+  Vec512<T> log() const {
+    return map(std::log);
+  }
+  Vec512<T> ceil() const {
+    return map(std::ceil);
+  }
+  Vec512<T> cos() const {
+    return map(std::cos);
+  }
+  Vec512<T> floor() const {
+    return map(std::floor);
+  }
+  Vec512<T> round() const {
+    return map(std::round);
+  }
+  Vec512<T> sin() const {
+    return map(std::sin);
+  }
+  Vec512<T> trunc() const {
+    return map(std::trunc);
+  }
+  Vec512<T> sqrt() const {
+    return map(std::sqrt);
+  }
+};
+
+template <class T> Vec512<T> operator+(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = a.values[i] + b.values[i];
+  }
+  return c;
+}
+
+template <class T> Vec512<T> operator*(const Vec512<T> &a, const Vec512<T> &b) {
+  Vec512<T> c = Vec512<T>();
+  for (int i = 0; i != c.size; i++) {
+    c.values[i] = a.values[i] * b.values[i];
+  }
+  return c;
+}
+
+}}}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+#include "vec512_base.h"
+
+namespace at {
+namespace vec512 {
+namespace {
+
+#ifdef __AVX512F__
+
+template <> class Vec512<float> {
+public:
+  static constexpr int size = 16;
+  __m512 values;
+  Vec512() {}
+  Vec512(__m512 v) : values(v) {}
+  Vec512(float val) {
+    values = _mm512_set1_ps(val);
+  }
+  operator __m512() const {
+    return values;
+  }
+  void load(const void *ptr) {
+    values = _mm512_loadu_ps(reinterpret_cast<const float*>(ptr));
+  }
+  void load_partial(const void *ptr, int count) {
+    __mmask16 mask = (1u << count) - 1;
+    values = _mm512_maskz_loadu_ps(mask, ptr);
+  }
+  static Vec512<float> s_load(const void* ptr) {
+    Vec512<float> vec;
+    vec.load(ptr);
+    return vec;
+  }
+  void store(void *ptr) const {
+    _mm512_storeu_ps(reinterpret_cast<float*>(ptr), values);
+  }
+  void store_partial(void* ptr, int count) const {
+    __mmask16 mask = (1u << count) - 1;
+    _mm512_mask_storeu_ps(ptr, mask, values);
+  }
+  Vec512<float> map(float (*f)(float)) const {
+    __at_align64__ float tmp[16];
+    store(tmp);
+    for (int64_t i = 0; i < 16; i++) {
+      tmp[i] = f(tmp[i]);
+    }
+    return s_load(tmp);
+  }
+  Vec512<float> abs() const {
+    auto mask = _mm512_set1_epi32(0x7fffffff);
+    return _mm512_castsi512_ps(
+        _mm512_and_si512(_mm512_castps_si512(values), mask));
+  }
+  Vec512<float> exp() const {
+    return map(std::exp);
+  }
+  Vec512<float> log() const {
+    return map(std::log);
+  }
+  Vec512<float> sin() const {
+    return map(std::sin);
+  }
+  Vec512<float> cos() const {
+    return map(std::cos);
+  }
+  Vec512<float> ceil() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_POS_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> floor() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> round() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> trunc() const {
+    return _mm512_roundscale_ps(values, (_MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC));
+  }
+  Vec512<float> sqrt() const {
+    return _mm512_sqrt_ps(values);
+  }
+};
+
+template <>
+Vec512<float> inline operator+(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_add_ps(a, b);
+}
+
+template <>
+Vec512<float> inline operator*(const Vec512<float>& a, const Vec512<float>& b) {
+  return _mm512_mul_ps(a, b);
+}
+
+#endif
+
+}}}
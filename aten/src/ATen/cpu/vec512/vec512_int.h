@@ -0,0 +1,151 @@
+#pragma once
+
+#include "ATen/cpu/vec256/intrinsics.h"
+#include "vec512_base.h"
+
+namespace at {
+namespace vec512 {
+namespace {
+
+#ifdef __AVX512F__
+
+struct Vec512i {
+  __m512i values;
+  Vec512i() {}
+  Vec512i(__m512i v) : values(v) {}
+  operator __m512i() const {
+    return values;
+  }
+  void load(const void *ptr) {
+    values = _mm512_loadu_si512(ptr);
+  }
+  void store(void *ptr) const {
+    _mm512_storeu_si512(ptr, values);
+  }
+};
+
+template <>
+struct Vec512<int64_t> : public Vec512i {
+  static constexpr int size = 8;
+  using Vec512i::Vec512i;
+  Vec512() {}
+  Vec512(int64_t v) { values = _mm512_set1_epi64(v); }
+  static Vec512<int64_t> s_load(const void* ptr) {
+    Vec512<int64_t> vec;
+    vec.load(ptr);
+    return vec;
+  }
+  void load_partial(const void *ptr, int count) {
+    __mmask8 mask = (1u << count) - 1;
+    values = _mm512_maskz_loadu_epi64(mask, ptr);
+  }
+  void store_partial(void* ptr, int count) const {
+    __mmask8 mask = (1u << count) - 1;
+    _mm512_mask_storeu_epi64(ptr, mask, values);
+  }
+  Vec512<int64_t> abs() const {
+    return _mm512_abs_epi64(values);
+  }
+};
+
+template <>
+struct Vec512<int32_t> : public Vec512i {
+  static constexpr int size = 16;
+  using Vec512i::Vec512i;
+  Vec512() {}
+  Vec512(int32_t v) { values = _mm512_set1_epi32(v); }
+  static Vec512<int32_t> s_load(const void* ptr) {
+    Vec512<int32_t> vec;
+    vec.load(ptr);
+    return vec;
+  }
+  void load_partial(const void *ptr, int count) {
+    __mmask16 mask = (1u << count) - 1;
+    values = _mm512_maskz_loadu_epi32(mask, ptr);
+  }
+  void store_partial(void* ptr, int count) const {
+    __mmask16 mask = (1u << count) - 1;
+    _mm512_mask_storeu_epi32(ptr, mask, values);
+  }
+  Vec512<int32_t> abs() const {
+    return _mm512_abs_epi32(values);
+  }
+};
+
+template <>
+Vec512<int64_t> inline operator+(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  return _mm512_add_epi64(a, b);
+}
+
+template <>
+Vec512<int32_t> inline operator+(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {
+  return _mm512_add_epi32(a, b);
+}
+
+// _mm512_mullo_epi64 is part of AVX512DQ
+#ifdef __AVX512DQ__
+template <>
+Vec512<int64_t> inline operator*(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  return _mm512_mullo_epi64(a, b);
+}
+#else
+template <>
+Vec512<int64_t> inline operator*(const Vec512<int64_t>& a, const Vec512<int64_t>& b) {
+  __at_align64__ int64_t a_values[8];
+  __at_align64__ int64_t b_values[8];
+  a.store(a_values);
+  b.store(b_values);
+  for (int i = 0; i != 8; i++) {
+    a_values[i] *= b_values[i];
+  }
+  return Vec512<int64_t>::s_load(a_values);
+}
+#endif
+
+template <>
+Vec512<int32_t> inline operator*(const Vec512<int32_t>& a, const Vec512<int32_t>& b) {
+  return _mm512_mullo_epi32(a, b);
+}
+
+// Operations on 16 bit integers are part of AVX512BW
+#ifdef __AVX512BW__
+
+template <>
+struct Vec512<int16_t> : public Vec512i {
+  static constexpr int size = 32;
+  using Vec512i::Vec512i;
+  Vec512() {}
+  Vec512(int16_t v) { values = _mm512_set1_epi16(v); }
+  static Vec512<int16_t> s_load(const void* ptr) {
+    Vec512<int16_t> vec;
+    vec.load(ptr);
+    return vec;
+  }
+  void load_partial(const void *ptr, int count) {
+    __mmask32 mask = count == 32 ? ~__mmask32(0) : (__mmask32(1) << count) - 1;
+    values = _mm512_maskz_loadu_epi16(mask, ptr);
+  }
+  void store_partial(void* ptr, int count) const {
+    __mmask32 mask = count == 32 ? ~__mmask32(0) : (__mmask32(1) << count) - 1;
+    _mm512_mask_storeu_epi16(ptr, mask, values);
+  }
+  Vec512<int16_t> abs() const {
+    return _mm512_abs_epi16(values);
+  }
+};
+
+template <>
+Vec512<int16_t> inline operator+(const Vec512<int16_t>& a, const Vec512<int16_t>& b) {
+  return _mm512_add_epi16(a, b);
+}
+
+template <>
+Vec512<int16_t> inline operator*(const Vec512<int16_t>& a, const Vec512<int16_t>& b) {
+  return _mm512_mullo_epi16(a, b);
+}
+
+#endif
+
+#endif
+
+}}}
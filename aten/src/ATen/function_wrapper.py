@@ -67,10 +67,10 @@ ${return_type} Type::${method_prefix_derived}${api_name}(${type_method_formals})
 }
 """)
 TYPE_METHOD_DECLARATION_CONCRETE = CodeTemplate("""\
-virtual ${return_type} ${api_name}(${type_method_formals_with_defaults}) const;
+virtual ${return_type} ${method_prefix_derived}${api_name}(${type_method_formals_with_defaults}) const;
 """)
 TYPE_METHOD_DEFINITION_CONCRETE = CodeTemplate("""\
-${return_type} Type::${api_name}(${type_method_formals}) const {
+${return_type} Type::${method_prefix_derived}${api_name}(${type_method_formals}) const {
     ${type_definition_body}
 }
 """)
@@ -88,7 +88,7 @@ ${return_type} ${Type}::${method_prefix_derived}${api_name}(${type_method_formal
 # because we will inherit it from the TYPE_METHOD_DEFINITION_CONCRETE in
 # the superclass.  But it doesn't seem to be harmful.
 TYPE_DERIVED_DEFINITION_NATIVE = CodeTemplate("""\
-${return_type} ${Type}::${api_name}(${type_method_formals}) const {
+${return_type} ${Type}::${method_prefix_derived}${api_name}(${type_method_formals}) const {
     ${return_call} at::native::${native_type_method_dispatch}(${actuals});
 }
 """)
@@ -644,6 +644,22 @@ def create_generic(top_env, declarations):
 
         return broadcast_actuals
 
+    def set_broadcast_options(option, broadcast_arg):
+        # type: (FunctionOption, THFormal) -> None
+        broadcast_inplace = 'inplace' in broadcast_arg['broadcast']
+        broadcast_dims = 'dims:' in broadcast_arg['broadcast']
+        option['broadcast_actuals'] = get_broadcast_actuals(broadcast_arg, broadcast_inplace, broadcast_dims)
+        if not broadcast_dims:
+            option['broadcast_returns'] = (["b_" + x for x in option['broadcast_actuals']
+                                           if x != broadcast_arg['name'] or not broadcast_inplace])
+        else:
+            option['broadcast_returns'] = ["b_" + broadcast_arg['name']]
+
+        option['broadcast_function'] = 'expand_' + ('inplace' if broadcast_inplace
+                                                    else 'size' if broadcast_dims else 'outplace')
+        option['broadcast_modified_actuals'] = ['b_' + y if 'b_' + y in option['broadcast_returns'] else y
+                                                for y in option['actuals']]
+
     def emit_nn_body(option):
         # type: (FunctionOption) -> Union[str, List[str]]
         # Concrete definition on Type.cpp for NN functions. Delegates to the
@@ -732,19 +748,7 @@ def create_generic(top_env, declarations):
             top_env['type_method_definitions'].append(
                 TYPE_METHOD_DEFINITION_ABSTRACT.substitute(env))
 
-            broadcast_inplace = 'inplace' in broadcast_arg['broadcast']
-            broadcast_dims = 'dims:' in broadcast_arg['broadcast']
-            option['broadcast_actuals'] = get_broadcast_actuals(broadcast_arg, broadcast_inplace, broadcast_dims)
-            if not broadcast_dims:
-                option['broadcast_returns'] = (["b_" + x for x in option['broadcast_actuals']
-                                               if x != broadcast_arg['name'] or not broadcast_inplace])
-            else:
-                option['broadcast_returns'] = ["b_" + broadcast_arg['name']]
-
-            option['broadcast_function'] = 'expand_' + ('inplace' if broadcast_inplace
-                                                        else 'size' if broadcast_dims else 'outplace')
-            option['broadcast_modified_actuals'] = ['b_' + y if 'b_' + y in option['broadcast_returns'] else y
-                                                    for y in option['actuals']]
+            set_broadcast_options(option, broadcast_arg)
             top_env['type_method_definitions'].append(
                 TYPE_METHOD_DEFINITION_BROADCAST.substitute(env))
 
@@ -903,13 +907,20 @@ def create_generic(top_env, declarations):
         is_function = 'function' in option['variants']
         is_namespace_function = is_function and (dispatch_tensor or dispatch_type)
 
-        option['method_prefix_derived'] = ''
+        broadcast_arg = get_broadcast_argument(option)
+        # "s_" for "same size", as for cwrap declarations
+        option['method_prefix_derived'] = '' if broadcast_arg is None else 's_'
         env = nested_dict(option, top_env)
 
-        broadcast_arg = get_broadcast_argument(option)
         if broadcast_arg is not None:
-            raise Exception("broadcasting is not yet supported for native functions, "
-                            "but specified for function {}", option['name'])
+            if dispatch_type:
+                raise Exception("broadcasting is not supported for type dispatched native "
+                                "functions, but specified for function {}", option['name'])
+            set_broadcast_options(option, broadcast_arg)
+            top_env['type_method_declarations'].append(
+                TYPE_METHOD_DECLARATION_BROADCAST.substitute(env))
+            top_env['type_method_definitions'].append(
+                TYPE_METHOD_DEFINITION_BROADCAST.substitute(env))
 
         top_env['type_method_declarations'].append(
             TYPE_METHOD_DECLARATION_CONCRETE.substitute(env))
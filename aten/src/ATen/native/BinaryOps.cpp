@@ -0,0 +1,138 @@
+#include "ATen/ATen.h"
+#include "ATen/NativeFunctions.h"
+#include "cpu/BinaryOpsKernel.h"
+
+namespace at { namespace native {
+
+// Broadcasting happens in Type before these functions are called, so that
+// autograd and the tracer see the expanded arguments. Only dense tensors of
+// the same type go to the kernels; everything else, e.g. sparse or mismatched
+// types, is passed to the TH implementation, which also reports the errors.
+// Before that, a zero-dim `other` goes to the Scalar overload, like the
+// zero-dim dispatch generated for TH functions, so it may have another type
+// or live on another device.
+static bool is_same_dense_type(const Tensor& result, const Tensor& self, const Tensor& other) {
+  return result.type() == self.type() && other.type() == self.type();
+}
+
+Tensor add(const Tensor& self, const Tensor& other, Scalar alpha) {
+  Tensor result = self.type().tensor();
+  return at::add_out(result, self, other, alpha);
+}
+
+Tensor& add_(Tensor& self, const Tensor& other, Scalar alpha) {
+  return at::add_out(self, self, other, alpha);
+}
+
+Tensor& _add_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  if (other.dim() == 0) {
+    return at::add_out(result, self, Scalar(other), alpha);
+  }
+  if (is_same_dense_type(result, self, other)) {
+    add_kernel(result, self, other, alpha);
+    return result;
+  }
+  return at::_add_out(result, self, other, alpha);
+}
+
+Tensor& _add_out_cuda(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  if (other.dim() == 0) {
+    return at::add_out(result, self, Scalar(other), alpha);
+  }
+  return at::_add_out(result, self, other, alpha);
+}
+
+Tensor& _add_out_sparse(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  return at::_add_out(result, self, other, alpha);
+}
+
+Tensor sub(const Tensor& self, const Tensor& other, Scalar alpha) {
+  Tensor result = self.type().tensor();
+  return at::sub_out(result, self, other, alpha);
+}
+
+Tensor& sub_(Tensor& self, const Tensor& other, Scalar alpha) {
+  return at::sub_out(self, self, other, alpha);
+}
+
+Tensor& _sub_out_cpu(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  if (other.dim() == 0) {
+    return at::sub_out(result, self, Scalar(other), alpha);
+  }
+  if (is_same_dense_type(result, self, other)) {
+    sub_kernel(result, self, other, alpha);
+    return result;
+  }
+  return at::_sub_out(result, self, other, alpha);
+}
+
+Tensor& _sub_out_cuda(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  if (other.dim() == 0) {
+    return at::sub_out(result, self, Scalar(other), alpha);
+  }
+  return at::_sub_out(result, self, other, alpha);
+}
+
+Tensor& _sub_out_sparse(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  return at::_sub_out(result, self, other, alpha);
+}
+
+Tensor mul(const Tensor& self, const Tensor& other) {
+  Tensor result = self.type().tensor();
+  return at::mul_out(result, self, other);
+}
+
+Tensor& mul_(Tensor& self, const Tensor& other) {
+  return at::mul_out(self, self, other);
+}
+
+Tensor& _mul_out_cpu(Tensor& result, const Tensor& self, const Tensor& other) {
+  if (other.dim() == 0) {
+    return at::mul_out(result, self, Scalar(other));
+  }
+  if (is_same_dense_type(result, self, other)) {
+    mul_kernel(result, self, other);
+    return result;
+  }
+  return at::_mul_out(result, self, other);
+}
+
+Tensor& _mul_out_cuda(Tensor& result, const Tensor& self, const Tensor& other) {
+  if (other.dim() == 0) {
+    return at::mul_out(result, self, Scalar(other));
+  }
+  return at::_mul_out(result, self, other);
+}
+
+Tensor& _mul_out_sparse(Tensor& result, const Tensor& self, const Tensor& other) {
+  return at::_mul_out(result, self, other);
+}
+
+Tensor div(const Tensor& self, const Tensor& other) {
+  Tensor result = self.type().tensor();
+  return at::div_out(result, self, other);
+}
+
+Tensor& div_(Tensor& self, const Tensor& other) {
+  return at::div_out(self, self, other);
+}
+
+Tensor& _div_out_cpu(Tensor& result, const Tensor& self, const Tensor& other) {
+  if (other.dim() == 0) {
+    return at::div_out(result, self, Scalar(other));
+  }
+  if (is_same_dense_type(result, self, other)) {
+    div_kernel(result, self, other);
+    return result;
+  }
+  return at::_div_out(result, self, other);
+}
+
+Tensor& _div_out_cuda(Tensor& result, const Tensor& self, const Tensor& other) {
+  if (other.dim() == 0) {
+    return at::div_out(result, self, Scalar(other));
+  }
+  return at::_div_out(result, self, other);
+}
+
+}} // namespace at::native
@@ -1,6 +1,8 @@
 #include "ATen/ATen.h"
+#include "ATen/Dispatch.h"
 #include "ATen/TensorUtils.h"
 #include "ATen/NativeFunctions.h"
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
 
 #include <cstring>
 #include <iostream>
@@ -17,13 +19,6 @@
 namespace at {
 namespace native {
 
-static void make_offset2bag(const Tensor &offsets, const Tensor &indices,
-                            Tensor &offset2bag) {
-  offset2bag.index_fill_(0, offsets, 1); // offset2bag = [1 0 1 0 1]
-  offset2bag[0] = 0;                     // offset2bag = [0 0 1 0 1]
-  offset2bag = offset2bag.cumsum(0);     // offset2bag = [0 0 1 1 2]
-}
-
 template<typename T>
 static void axpy(int64_t n, T a, T *x, int64_t incx, T *y, int64_t incy);
 template<>
@@ -37,59 +32,11 @@ void axpy<double>(int64_t n, double a, double *x, int64_t incx,
   THDoubleBlas_axpy(n, a, x, incx, y, incy);
 }
 
-// This function combines index_select (using select_indices as the index) and
-// index_add (using add_indices as the index), without creating an intermediary
-// tensor to hold the selected embeddings
-template<typename T>
-static void index_select_add(const Tensor &select_indices,
-                             const Tensor &add_indices,
-                             const Tensor &src,
-                             Tensor &output) {
-  auto add_indices_data = add_indices.data<int64_t>();
-  auto select_indices_data = select_indices.data<int64_t>();
-  auto src_data = src.data<T>();
-  auto output_data = output.data<T>();
-  auto numel = add_indices.numel();
-  int64_t ddim = src.sizes()[1];
-  for (int64_t i = 0; i < numel; i++) {
-    axpy<T>(ddim, 1, src_data + ddim * select_indices_data[i], 1,
-            output_data + ddim * add_indices_data[i], 1);
-  }
-}
-
-static void make_bag_size(const Tensor &offsets, const Tensor &indices,
-                          const int64_t mode, Tensor &bag_size) {
-  if (mode == 1) { // MODE_MEAN
-    if (offsets.sizes()[0] != 1) {
-      bag_size.slice(0, 0, bag_size.sizes()[0] - 1, 1) =
-          offsets.slice(0, 1, offsets.sizes()[0], 1) -
-          offsets.slice(0, 0, offsets.sizes()[0] - 1, 1);
-      bag_size[-1] = indices.sizes()[0] - offsets[-1];
-    }
-  }
-}
-
-static Tensor apply_bag_size(const Tensor &offsets, const Tensor &indices,
-                             const int64_t mode, Tensor &output,
-                             const Tensor &bag_size) {
-  if (mode == 1) { // MODE_MEAN
-    if (offsets.sizes()[0] == 1) {
-      auto bag_size_ = indices.sizes()[0];
-      output /= bag_size_;
-    } else {
-      auto bag_size_ =
-          bag_size.toType(output.type()).unsqueeze(1).expand_as(output);
-      output /= bag_size_;
-    }
-  }
-  return output;
-}
-
 static Tensor apply_bag_size_backward(const Tensor &offsets,
                                       const Tensor &indices, const int64_t mode,
                                       Tensor &output, const Tensor &offset2bag,
                                       const Tensor &bag_size) {
-  if (mode == 1) { // MODE_MEAN
+  if (mode == MODE_MEAN) {
     if (offsets.sizes()[0] == 1) {
       auto bag_size_ = indices.sizes()[0];
       output /= bag_size_;
@@ -103,40 +50,64 @@ static Tensor apply_bag_size_backward(const Tensor &offsets,
   return output;
 }
 
-std::tuple<Tensor, Tensor, Tensor>
-embedding_bag_cpu(const Tensor &weight, const Tensor &indices__,
+static void check_per_sample_weights(const char* name,
+                                     const Tensor& per_sample_weights,
+                                     const Tensor& weight,
+                                     const Tensor& indices, int64_t mode) {
+  if (!per_sample_weights.defined()) {
+    return;
+  }
+  if (mode != MODE_SUM) {
+    AT_ERROR("%s: per_sample_weights are only supported for mode='sum'", name);
+  }
+  auto per_sample_weights_arg = TensorArg(per_sample_weights, "per_sample_weights", 1);
+  checkScalarType(name, per_sample_weights_arg, weight.type().scalarType());
+  checkNumel(name, per_sample_weights_arg, indices.numel());
+}
+
+std::tuple<Tensor, Tensor, Tensor, Tensor>
+embedding_bag_cpu(const Tensor &weight_, const Tensor &indices__,
                   const Tensor &offsets__, const bool scale_grad_by_freq,
-                  const int64_t mode, bool sparse) {
+                  const int64_t mode, bool sparse,
+                  const Tensor &per_sample_weights_) {
   auto indices_arg = TensorArg(indices__, "indices__", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   auto offsets_arg = TensorArg(offsets__, "offsets__", 1);
   checkScalarType("embedding_bag", offsets_arg, kLong);
   Tensor indices = indices__.contiguous();
   Tensor offsets = offsets__.contiguous();
-  auto weight_arg = TensorArg(weight, "weight", 1);
+  auto weight_arg = TensorArg(weight_, "weight", 1);
   checkScalarTypes("embedding_bag", weight_arg, {kFloat, kDouble});
+  Tensor weight = weight_.contiguous();
+  if (mode == MODE_MAX && sparse) {
+    AT_ERROR("embedding_bag: mode='max' does not support sparse gradients");
+  }
+  check_per_sample_weights("embedding_bag", per_sample_weights_, weight,
+                           indices, mode);
+  Tensor per_sample_weights = per_sample_weights_.defined()
+      ? per_sample_weights_.contiguous() : per_sample_weights_;
 
-  auto bag_size = at::zeros(indices.type(), offsets.sizes());
-  auto offset2bag =
-      at::zeros(indices__.type(), {indices.sizes()[0]}); // offset2bag = [0 0 0 0 0]
-  make_offset2bag(offsets, indices, offset2bag);
+  auto bag_size = indices.type().tensor(offsets.sizes());
+  auto offset2bag = indices.type().tensor({indices.sizes()[0]});
+  auto max_indices = mode == MODE_MAX
+      ? indices.type().tensor({offsets.sizes()[0], weight.sizes()[1]})
+      : indices.type().tensor({0});
   auto output = at::zeros(weight.type(), {offsets.sizes()[0], weight.sizes()[1]});
-  if (weight.type().scalarType() == kFloat) {
-    index_select_add<float>(indices, offset2bag, weight, output);
-  } else if (weight.type().scalarType() == kDouble) {
-    index_select_add<double>(indices, offset2bag, weight, output);
-  }
-  make_bag_size(offsets, indices, mode, bag_size);
-  auto ret = apply_bag_size(offsets, indices, mode, output, bag_size);
-  return std::tuple<Tensor, Tensor, Tensor>(ret, offset2bag, bag_size);
+  embedding_bag_kernel(output, offset2bag, bag_size, max_indices, weight,
+                       indices, offsets, per_sample_weights, mode);
+  return std::tuple<Tensor, Tensor, Tensor, Tensor>(
+      output, offset2bag, bag_size, max_indices);
 }
 
 Tensor embedding_bag_backward(const Tensor &grad_, const Tensor &indices__,
                               const Tensor &offsets__,
                               const Tensor &offset2bag__,
-                              const Tensor &bag_size_, int64_t num_weights,
+                              const Tensor &bag_size_,
+                              const Tensor &max_indices_,
+                              int64_t num_weights,
                               bool scale_grad_by_freq, int64_t mode,
-                              bool sparse) {
+                              bool sparse,
+                              const Tensor &per_sample_weights) {
   auto indices_arg = TensorArg(indices__, "indices__", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   auto offsets_arg = TensorArg(offsets__, "offsets__", 1);
@@ -150,19 +121,47 @@ Tensor embedding_bag_backward(const Tensor &grad_, const Tensor &indices__,
   if (sparse) {
     return at::embedding_bag_sparse_backward(
         grad_, indices, offsets, offset2bag__, bag_size_, num_weights,
-        scale_grad_by_freq, mode);
+        scale_grad_by_freq, mode, per_sample_weights);
   } else {
     return at::embedding_bag_dense_backward(
-        grad_, indices, offsets, offset2bag__, bag_size_, num_weights,
-        scale_grad_by_freq, mode);
+        grad_, indices, offsets, offset2bag__, bag_size_, max_indices_,
+        num_weights, scale_grad_by_freq, mode, per_sample_weights);
+  }
+}
+
+// Every element of the output of a bag with mode='max' comes from a single
+// row of weight, so its gradient goes to that row only.
+template <typename scalar_t>
+static void embedding_bag_max_backward(Tensor &grad_weight, const Tensor &grad,
+                                       const Tensor &max_indices,
+                                       const std::vector<int64_t> &counts,
+                                       bool scale_grad_by_freq) {
+  auto grad_weight_data = grad_weight.data<scalar_t>();
+  auto grad_data = grad.data<scalar_t>();
+  auto max_indices_data = max_indices.data<int64_t>();
+  int64_t num_bags = grad.sizes()[0];
+  int64_t ddim = grad.sizes()[1];
+  for (int64_t bag = 0; bag < num_bags; bag++) {
+    for (int64_t d = 0; d < ddim; d++) {
+      int64_t index = max_indices_data[bag * ddim + d];
+      // Empty bags have no maximum
+      if (index < 0) {
+        continue;
+      }
+      scalar_t scale = scale_grad_by_freq ? scalar_t(1) / counts[index] : 1;
+      grad_weight_data[index * ddim + d] += grad_data[bag * ddim + d] * scale;
+    }
   }
 }
 
 Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
                                   const Tensor &offsets__,
                                   const Tensor &offset2bag__,
-                                  const Tensor &bag_size_, int64_t num_weights,
-                                  bool scale_grad_by_freq, int64_t mode) {
+                                  const Tensor &bag_size_,
+                                  const Tensor &max_indices_,
+                                  int64_t num_weights,
+                                  bool scale_grad_by_freq, int64_t mode,
+                                  const Tensor &per_sample_weights_) {
   auto grad = grad_.contiguous();
   auto grad_arg = TensorArg(grad, "grad_", 1);
   checkScalarTypes("embedding_bag", grad_arg, {kFloat, kDouble});
@@ -175,6 +174,8 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
   checkContiguous("embedding_bag", offset2bag_arg);
   Tensor indices_ = indices__.contiguous();
   Tensor offsets_ = offsets__.contiguous();
+  Tensor per_sample_weights = per_sample_weights_.defined()
+      ? per_sample_weights_.contiguous() : per_sample_weights_;
 
   Tensor &offset2bag_ = const_cast<Tensor &>(offset2bag__);
 
@@ -186,6 +187,7 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
   auto indices_data = indices.data<int64_t>();
   auto offsets_data = offsets_.data<int64_t>();
   auto offset2bag_data = offset2bag.data<int64_t>();
+  auto ind_sort_data = ind_sort.data<int64_t>();
   int64_t numel = indices.numel();
 
   std::vector<int64_t> counts(num_weights);
@@ -196,6 +198,20 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
     counts[indices_data[i]]++;
   }
 
+  auto index_grad_weight =
+      at::zeros(grad.type(), {num_weights, grad.sizes()[1]}).contiguous();
+
+  if (mode == MODE_MAX) {
+    auto max_indices_arg = TensorArg(max_indices_, "max_indices", 1);
+    checkScalarType("embedding_bag", max_indices_arg, kLong);
+    Tensor max_indices = max_indices_.contiguous();
+    AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_bag_backward", [&] {
+      embedding_bag_max_backward<scalar_t>(index_grad_weight, grad, max_indices,
+                                           counts, scale_grad_by_freq);
+    });
+    return index_grad_weight;
+  }
+
   std::vector<int64_t> counts_uniq;
   counts_uniq.reserve(num_weights);
   int64_t o = 0;
@@ -207,9 +223,6 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
     o++;
   }
 
-  auto index_grad_weight =
-      at::zeros(grad.type(), {num_weights, grad.sizes()[1]}).contiguous();
-
 #pragma omp parallel for if (numel > 1000)
   for (int64_t i = 0; i < (int64_t)counts_uniq.size(); i++) {
     int64_t start = i == 0 ? 0 : counts_uniq[i - 1];
@@ -218,9 +231,9 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
       int64_t source = offset2bag_data[j];
       double scale = 1.0;
       if (scale_grad_by_freq) {
-        scale /= counts[indices_data[i]];
+        scale /= counts[index];
       }
-      if (mode == 1) { // MODE_MEAN
+      if (mode == MODE_MEAN) {
         if (offsets_.sizes()[0] == 1) {
           auto bag_size = indices.sizes()[0];
           scale /= bag_size;
@@ -236,11 +249,17 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
       if (grad.type().scalarType() == kFloat) {
         auto igwd = index_grad_weight.data<float>();
         auto gd = grad.data<float>();
+        if (per_sample_weights.defined()) {
+          scale *= per_sample_weights.data<float>()[ind_sort_data[j]];
+        }
         axpy<float>(ddim, (float)scale, gd + ddim * source, 1,
                     igwd + ddim * index, 1);
       } else if (grad.type().scalarType() == kDouble) {
         auto igwd = index_grad_weight.data<double>();
         auto gd = grad.data<double>();
+        if (per_sample_weights.defined()) {
+          scale *= per_sample_weights.data<double>()[ind_sort_data[j]];
+        }
         axpy<double>(ddim, (double)scale, gd + ddim * source, 1,
                      igwd + ddim * index, 1);
       }
@@ -249,26 +268,97 @@ Tensor embedding_bag_backward_cpu(const Tensor &grad_, const Tensor &indices__,
 
   return index_grad_weight;
 }
+
 Tensor embedding_bag_sparse_backward(
     const Tensor &grad_, const Tensor &indices__, const Tensor &offsets__,
     const Tensor &offset2bag__, const Tensor &bag_size_, int64_t num_weights,
-    bool scale_grad_by_freq, int64_t mode) {
+    bool scale_grad_by_freq, int64_t mode,
+    const Tensor &per_sample_weights_) {
   auto indices_arg = TensorArg(indices__, "indices__", 1);
   checkScalarType("embedding_bag", indices_arg, kLong);
   auto offsets_arg = TensorArg(offsets__, "offsets__", 1);
   checkScalarType("embedding_bag", offsets_arg, kLong);
   auto offset2bag_arg = TensorArg(offset2bag__, "offset2bag__", 1);
   checkScalarType("embedding_bag", offset2bag_arg, kLong);
+  if (mode == MODE_MAX) {
+    AT_ERROR("embedding_bag: mode='max' does not support sparse gradients");
+  }
   Tensor indices = indices__.contiguous();
   Tensor offsets = offsets__.contiguous();
-  Tensor offset2bag = offset2bag__.contiguous();
+  Tensor per_sample_weights = per_sample_weights_.defined()
+      ? per_sample_weights_.contiguous() : per_sample_weights_;
+
+  if (grad_.type().is_cuda()) {
+    // The CUDA version of embedding_bag doesn't support per_sample_weights
+    Tensor offset2bag = offset2bag__.contiguous();
+    Tensor index_grad = grad_.index_select(0, offset2bag);
+    index_grad = apply_bag_size_backward(offsets, indices, mode, index_grad,
+                                         offset2bag, bag_size_);
+    return native::embedding_backward(index_grad, indices, num_weights, -1,
+                                      scale_grad_by_freq, true);
+  }
 
-  Tensor grad = grad_;
-  Tensor index_grad = grad_.index_select(0, offset2bag);
-  index_grad = apply_bag_size_backward(offsets, indices, mode, index_grad,
-                                       offset2bag, bag_size_);
+  // Row i of index_grad is the gradient of the bag containing index i, which
+  // is computed from offsets directly instead of gathering by offset2bag
+  Tensor grad = grad_.contiguous();
+  Tensor index_grad = grad.type().tensor({indices.numel(), grad.sizes()[1]});
+  embedding_bag_sparse_backward_kernel(index_grad, grad, offsets,
+                                       per_sample_weights, indices.numel(),
+                                       mode);
   return native::embedding_backward(index_grad, indices, num_weights, -1,
                                     scale_grad_by_freq, true);
 }
+
+template <typename scalar_t>
+static void embedding_bag_per_sample_weights_backward_template(
+    Tensor &output, const Tensor &grad, const Tensor &weight,
+    const Tensor &indices, const Tensor &offset2bag) {
+  auto output_data = output.data<scalar_t>();
+  auto grad_data = grad.data<scalar_t>();
+  auto weight_data = weight.data<scalar_t>();
+  auto indices_data = indices.data<int64_t>();
+  auto offset2bag_data = offset2bag.data<int64_t>();
+  int64_t numel = indices.numel();
+  int64_t ddim = weight.sizes()[1];
+
+#pragma omp parallel for if (numel * ddim > 1000)
+  for (int64_t i = 0; i < numel; i++) {
+    const scalar_t *grad_row = grad_data + offset2bag_data[i] * ddim;
+    const scalar_t *weight_row = weight_data + indices_data[i] * ddim;
+    scalar_t sum = 0;
+    for (int64_t d = 0; d < ddim; d++) {
+      sum += grad_row[d] * weight_row[d];
+    }
+    output_data[i] = sum;
+  }
+}
+
+// The output of a bag with mode='sum' is linear in every per sample weight,
+// so its gradient is the dot product of the gradient of the bag with the row
+// of weight it scales.
+Tensor embedding_bag_per_sample_weights_backward_cpu(
+    const Tensor &grad_, const Tensor &weight_, const Tensor &indices__,
+    const Tensor &offset2bag__, int64_t mode) {
+  if (mode != MODE_SUM) {
+    AT_ERROR("embedding_bag: per_sample_weights are only supported for mode='sum'");
+  }
+  auto grad = grad_.contiguous();
+  auto grad_arg = TensorArg(grad, "grad_", 1);
+  checkScalarTypes("embedding_bag", grad_arg, {kFloat, kDouble});
+  auto indices_arg = TensorArg(indices__, "indices__", 1);
+  checkScalarType("embedding_bag", indices_arg, kLong);
+  auto offset2bag_arg = TensorArg(offset2bag__, "offset2bag__", 1);
+  checkScalarType("embedding_bag", offset2bag_arg, kLong);
+  Tensor weight = weight_.contiguous();
+  Tensor indices = indices__.contiguous();
+  Tensor offset2bag = offset2bag__.contiguous();
+
+  auto output = grad.type().tensor({indices.numel()});
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_bag_per_sample_weights_backward", [&] {
+    embedding_bag_per_sample_weights_backward_template<scalar_t>(
+        output, grad, weight, indices, offset2bag);
+  });
+  return output;
+}
 }
 } // namespace at::native
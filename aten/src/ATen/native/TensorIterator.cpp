@@ -0,0 +1,114 @@
+#include "ATen/native/TensorIterator.h"
+
+#include "ATen/ExpandUtils.h"
+
+namespace at { namespace native {
+
+TensorIterator::TensorIterator(Tensor& output, TensorList inputs)
+  : ntensors_(inputs.size() + 1) {
+  AT_ASSERT(inputs.size() > 0, "TensorIterator requires at least one input");
+  std::vector<int64_t> shape = inputs[0].sizes().vec();
+  for (size_t i = 1; i < inputs.size(); i++) {
+    shape = infer_size(shape, inputs[i].sizes());
+  }
+  if (!output.sizes().equals(shape)) {
+    output.resize_(shape);
+  }
+
+  numel_ = 1;
+  for (auto size : shape) {
+    numel_ *= size;
+  }
+  // A zero-dim tensor is iterated as a single element
+  int dims = std::max<int>(shape.size(), 1);
+  shape_.resize(dims, 1);
+  for (size_t dim = 0; dim < shape.size(); dim++) {
+    shape_[dim] = shape[shape.size() - 1 - dim];
+  }
+  strides_.resize(dims * ntensors_, 0);
+  data_.resize(ntensors_);
+  compute_strides(output, 0, shape);
+  for (size_t i = 0; i < inputs.size(); i++) {
+    compute_strides(inputs[i], i + 1, shape);
+  }
+
+  reorder_dimensions();
+  coalesce_dimensions();
+}
+
+void TensorIterator::compute_strides(const Tensor& tensor, int arg, IntList shape) {
+  int64_t element_size = tensor.type().elementSizeInBytes();
+  int64_t offset = shape.size() - tensor.dim();
+  for (int64_t i = 0; i < tensor.dim(); i++) {
+    // Broadcast dimensions keep a stride of 0
+    if (tensor.size(i) != 1) {
+      stride(shape.size() - 1 - (offset + i), arg) = tensor.stride(i) * element_size;
+    }
+  }
+  data_[arg] = static_cast<char*>(tensor.data_ptr());
+}
+
+void TensorIterator::reorder_dimensions() {
+  // Insertion sort of the dimensions, moving a dimension inwards if the first
+  // operand that is not broadcast in either of the two dimensions has a
+  // smaller stride in it. The output comes first, so it is written in the
+  // order of its memory layout.
+  auto should_swap = [this](int inner, int outer) {
+    for (int arg = 0; arg < ntensors_; arg++) {
+      int64_t inner_stride = stride(inner, arg);
+      int64_t outer_stride = stride(outer, arg);
+      if (inner_stride != 0 && outer_stride != 0 && inner_stride != outer_stride) {
+        return outer_stride < inner_stride;
+      }
+    }
+    return false;
+  };
+  for (int dim = 1; dim < ndim(); dim++) {
+    for (int d = dim; d > 0 && should_swap(d - 1, d); d--) {
+      std::swap(shape_[d - 1], shape_[d]);
+      for (int arg = 0; arg < ntensors_; arg++) {
+        std::swap(stride(d - 1, arg), stride(d, arg));
+      }
+    }
+  }
+}
+
+void TensorIterator::coalesce_dimensions() {
+  // Merges the outer dimension into the inner one if every operand steps
+  // from the last element of the inner dimension to the next element of the
+  // outer one with its inner stride
+  auto can_coalesce = [this](int inner, int outer) {
+    if (shape_[inner] == 1 || shape_[outer] == 1) {
+      return true;
+    }
+    for (int arg = 0; arg < ntensors_; arg++) {
+      if (stride(inner, arg) * shape_[inner] != stride(outer, arg)) {
+        return false;
+      }
+    }
+    return true;
+  };
+  int prev_dim = 0;
+  for (int dim = 1; dim < ndim(); dim++) {
+    if (can_coalesce(prev_dim, dim)) {
+      if (shape_[prev_dim] == 1) {
+        for (int arg = 0; arg < ntensors_; arg++) {
+          stride(prev_dim, arg) = stride(dim, arg);
+        }
+      }
+      shape_[prev_dim] *= shape_[dim];
+    } else {
+      prev_dim++;
+      if (prev_dim != dim) {
+        shape_[prev_dim] = shape_[dim];
+        for (int arg = 0; arg < ntensors_; arg++) {
+          stride(prev_dim, arg) = stride(dim, arg);
+        }
+      }
+    }
+  }
+  shape_.resize(prev_dim + 1);
+  strides_.resize(shape_.size() * ntensors_);
+}
+
+}} // namespace at::native
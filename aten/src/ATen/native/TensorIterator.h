@@ -0,0 +1,115 @@
+#pragma once
+
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+#include "ATen/SmallVector.h"
+
+#include <algorithm>
+
+// TensorIterator applies an element-wise function to CPU tensors which may be
+// non-contiguous or broadcast against each other, using the TBB thread pool
+// of ATen/Parallel.h.
+//
+// The first operand is the output. It is resized to the broadcast shape of
+// the inputs, then the dimensions of all operands are permuted so that the
+// innermost one has the smallest strides, and adjacent dimensions that can be
+// indexed as a single one are merged. A contiguous tensor thus becomes one
+// dimension of numel() elements, whatever its sizes.
+//
+// for_each calls the inner loop
+//
+//   void loop(char** data, const int64_t* strides, int64_t n)
+//
+// where data[i] points to the first element of operand i and strides[i] is
+// its stride in bytes. All operands share n, the length of the innermost
+// dimension or of a part of it. Kernels dispatch on the scalar type and
+// special-case the contiguous strides so that the compiler vectorizes them,
+// see cpu/BinaryOpsKernel.cpp.
+
+namespace at { namespace native {
+
+struct TensorIterator {
+  TensorIterator(Tensor& output, TensorList inputs);
+
+  int ntensors() const { return ntensors_; }
+  int ndim() const { return shape_.size(); }
+  int64_t numel() const { return numel_; }
+
+  // Runs loop over the elements [begin, end) in the order of the iteration
+  // space, on the calling thread
+  template <typename loop_t>
+  void serial_for_each(loop_t loop, int64_t begin, int64_t end) const;
+
+  // Splits the elements into ranges of at least grain_size elements and runs
+  // them in parallel if there is more than one
+  template <typename loop_t>
+  void for_each(loop_t loop, int64_t grain_size = internal::TBB_GRAIN_SIZE) const;
+
+ private:
+  int64_t& stride(int dim, int arg) { return strides_[dim * ntensors_ + arg]; }
+  int64_t stride(int dim, int arg) const { return strides_[dim * ntensors_ + arg]; }
+
+  void compute_strides(const Tensor& tensor, int arg, IntList shape);
+  void reorder_dimensions();
+  void coalesce_dimensions();
+
+  int ntensors_;
+  int64_t numel_;
+  // Sizes and byte strides of the iteration space, innermost dimension first
+  SmallVector<int64_t, 6> shape_;
+  SmallVector<int64_t, 18> strides_;
+  SmallVector<char*, 3> data_;
+};
+
+template <typename loop_t>
+void TensorIterator::serial_for_each(loop_t loop, int64_t begin, int64_t end) const {
+  if (begin >= end) {
+    return;
+  }
+  int dims = ndim();
+  SmallVector<int64_t, 6> counter;
+  counter.resize(dims);
+  int64_t linear_index = begin;
+  for (int dim = 0; dim < dims; dim++) {
+    counter[dim] = linear_index % shape_[dim];
+    linear_index /= shape_[dim];
+  }
+  SmallVector<char*, 3> ptrs;
+  ptrs.resize(ntensors_);
+  while (begin < end) {
+    for (int arg = 0; arg < ntensors_; arg++) {
+      char* ptr = data_[arg];
+      for (int dim = 0; dim < dims; dim++) {
+        ptr += counter[dim] * stride(dim, arg);
+      }
+      ptrs[arg] = ptr;
+    }
+    int64_t n = std::min(shape_[0] - counter[0], end - begin);
+    loop(ptrs.data(), strides_.data(), n);
+    begin += n;
+    counter[0] += n;
+    for (int dim = 0; dim < dims - 1 && counter[dim] == shape_[dim]; dim++) {
+      counter[dim] = 0;
+      counter[dim + 1]++;
+    }
+  }
+}
+
+template <typename loop_t>
+void TensorIterator::for_each(loop_t loop, int64_t grain_size) const {
+  if (numel_ == 0) {
+    return;
+  }
+  if (numel_ < grain_size) {
+    serial_for_each(loop, 0, numel_);
+    return;
+  }
+  internal::init_tbb_num_threads();
+  tbb::parallel_for(
+      tbb::blocked_range<int64_t>(0, numel_, grain_size),
+      [&](const tbb::blocked_range<int64_t>& r) {
+        serial_for_each(loop, r.begin(), r.end());
+      });
+}
+
+}} // namespace at::native
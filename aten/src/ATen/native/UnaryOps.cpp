@@ -26,11 +26,8 @@ Tensor& _ ## op ## _out_cuda(Tensor& result, const Tensor& self) {            \
   return at::_ ## op ## _out(result, self);                                   \
 }                                                                             \
 Tensor& _ ## op ## _out_cpu(Tensor& result, const Tensor& self) {             \
-  if (result.is_contiguous() && self.is_contiguous()) {                       \
-    result.resize_(self.sizes());                                             \
-    if (result.numel() > 0) {                                                 \
-      op ## Impl(result, self);                                               \
-    }                                                                         \
+  if (result.type() == self.type()) {                                         \
+    op ## Impl(result, self);                                                 \
     return result;                                                            \
   }                                                                           \
   return at::_ ## op ## _out(result, self);                                   \
@@ -1,58 +1,297 @@
 // Returns unique elements of input tensor.
+//
+// Large inputs are processed in parallel: elements are split into partitions
+// by the top bits of their hash, then every partition is deduplicated with
+// its own open addressing hash table. Inverse indices and counts come out of
+// the same pass over the partition.
 
 #include "ATen/ATen.h"
 #include "ATen/Dispatch.h"
 
-#include <set>
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <numeric>
 #include <tuple>
-#include <unordered_map>
-#include <unordered_set>
+#include <vector>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 namespace at {
 namespace native{
 
 namespace {
 
+// Inputs with fewer elements are deduplicated by a single thread
+constexpr int64_t UNIQUE_PARALLEL_THRESHOLD = 1 << 16;
+// Number of partitions per thread, more partitions balance the load better
+// when some of them are larger than others
+constexpr int UNIQUE_PARTITIONS_PER_THREAD = 4;
+constexpr int64_t UNIQUE_INITIAL_TABLE_SIZE = 64;
+
+// Elements that compare equal have the same hash, in particular -0.0 and 0.0
+template <typename scalar_t>
+inline uint64_t unique_hash(scalar_t value) {
+  if (value == 0) {
+    value = 0;
+  }
+  uint64_t h = 0;
+  std::memcpy(&h, &value, sizeof(scalar_t));
+  // Finalizer of MurmurHash3, mixes all bits into the top and bottom ones
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+  return h;
+}
+
+// Open addressing hash table assigning consecutive ids to distinct values,
+// in the order of their first occurrence.
+template <typename scalar_t>
+class UniqueTable {
+ public:
+  UniqueTable(bool return_counts)
+    : return_counts_(return_counts) {
+    rehash(UNIQUE_INITIAL_TABLE_SIZE);
+  }
+
+  int64_t insert(scalar_t value) {
+    // Keep the load factor at most 1/2
+    if (2 * (int64_t(values_.size()) + 1) > int64_t(ids_.size())) {
+      rehash(2 * ids_.size());
+    }
+    int64_t slot = unique_hash(value) & mask_;
+    while (true) {
+      int64_t id = ids_[slot];
+      if (id < 0) {
+        id = values_.size();
+        keys_[slot] = value;
+        ids_[slot] = id;
+        values_.push_back(value);
+        if (return_counts_) {
+          counts_.push_back(1);
+        }
+        return id;
+      }
+      if (keys_[slot] == value) {
+        if (return_counts_) {
+          counts_[id]++;
+        }
+        return id;
+      }
+      slot = (slot + 1) & mask_;
+    }
+  }
+
+  const std::vector<scalar_t>& values() const {
+    return values_;
+  }
+
+  const std::vector<int64_t>& counts() const {
+    return counts_;
+  }
+
+ private:
+  void rehash(int64_t size) {
+    keys_.assign(size, 0);
+    ids_.assign(size, -1);
+    mask_ = size - 1;
+    for (int64_t id = 0; id < int64_t(values_.size()); ++id) {
+      int64_t slot = unique_hash(values_[id]) & mask_;
+      while (ids_[slot] >= 0) {
+        slot = (slot + 1) & mask_;
+      }
+      keys_[slot] = values_[id];
+      ids_[slot] = id;
+    }
+  }
+
+  bool return_counts_;
+  int64_t mask_;
+  std::vector<scalar_t> keys_;
+  std::vector<int64_t> ids_;
+  std::vector<scalar_t> values_;
+  std::vector<int64_t> counts_;
+};
+
 template <typename scalar_t>
-std::tuple<Tensor, Tensor> _unique_cpu_template(
+std::tuple<Tensor, Tensor, Tensor> _unique_cpu_template(
     const Tensor& self,
     const bool sorted,
-    const bool return_inverse) {
+    const bool return_inverse,
+    const bool return_counts) {
   const Tensor& input = self.contiguous();
   const scalar_t* input_data = input.data<scalar_t>();
-  std::unordered_set<scalar_t> set(input_data, input_data + input.numel());
-  Tensor output = input.type().tensor({static_cast<int64_t>(set.size())});
-  scalar_t* output_data = output.data<scalar_t>();
-
-  if (sorted) {
-    std::vector<scalar_t> vec(set.begin(), set.end());
-    std::sort(vec.begin(), vec.end());
-    std::copy(vec.begin(), vec.end(), output_data);
-  } else {
-    std::copy(set.begin(), set.end(), output_data);
-  }
+  const int64_t numel = input.numel();
 
   Tensor inverse_indices = self.type().toScalarType(kLong).tensor({0});
+  int64_t* inverse_indices_data = nullptr;
   if (return_inverse) {
     inverse_indices.resize_(input.sizes());
-    int64_t* inverse_indices_data = inverse_indices.data<int64_t>();
-    std::unordered_map<scalar_t, int64_t> inverse_map;
-    inverse_map.reserve(output.numel());
-    for (int i = 0; i < output.numel(); ++i) {
-      inverse_map[output_data[i]] = i;
+    inverse_indices_data = inverse_indices.data<int64_t>();
+  }
+
+  int num_threads = 1;
+#ifdef _OPENMP
+  if (numel >= UNIQUE_PARALLEL_THRESHOLD) {
+    num_threads = omp_get_max_threads();
+  }
+#endif
+  int partition_bits = 0;
+  if (num_threads > 1) {
+    while ((1 << partition_bits) < UNIQUE_PARTITIONS_PER_THREAD * num_threads) {
+      partition_bits++;
     }
-    for (int i = 0; i < input.numel(); ++i) {
-      inverse_indices_data[i] = inverse_map[input_data[i]];
+  }
+  const int64_t num_partitions = int64_t(1) << partition_bits;
+  auto partition_of = [partition_bits](scalar_t value) -> int64_t {
+    return partition_bits == 0 ? 0 : unique_hash(value) >> (64 - partition_bits);
+  };
+
+  // Reorder elements (and their positions, for the inverse) so that every
+  // partition is contiguous. Within a partition elements keep their order.
+  const scalar_t* values = input_data;
+  const int64_t* positions = nullptr;
+  std::unique_ptr<scalar_t[]> partitioned_values;
+  std::unique_ptr<int64_t[]> partitioned_positions;
+  std::vector<int64_t> partition_begin(num_partitions + 1, 0);
+  partition_begin[num_partitions] = numel;
+  if (num_partitions > 1) {
+    auto block_begin = [numel, num_threads](int64_t t) {
+      return numel * t / num_threads;
+    };
+    // offsets[t * num_partitions + p] is where thread t writes the elements
+    // of partition p
+    std::vector<int64_t> offsets(num_threads * num_partitions, 0);
+    #pragma omp parallel for num_threads(num_threads)
+    for (int t = 0; t < num_threads; ++t) {
+      int64_t* histogram = &offsets[t * num_partitions];
+      for (int64_t i = block_begin(t); i < block_begin(t + 1); ++i) {
+        histogram[partition_of(input_data[i])]++;
+      }
+    }
+    int64_t offset = 0;
+    for (int64_t p = 0; p < num_partitions; ++p) {
+      partition_begin[p] = offset;
+      for (int t = 0; t < num_threads; ++t) {
+        int64_t count = offsets[t * num_partitions + p];
+        offsets[t * num_partitions + p] = offset;
+        offset += count;
+      }
+    }
+
+    partitioned_values.reset(new scalar_t[numel]);
+    if (return_inverse) {
+      partitioned_positions.reset(new int64_t[numel]);
+    }
+    #pragma omp parallel for num_threads(num_threads)
+    for (int t = 0; t < num_threads; ++t) {
+      int64_t* offset = &offsets[t * num_partitions];
+      for (int64_t i = block_begin(t); i < block_begin(t + 1); ++i) {
+        int64_t j = offset[partition_of(input_data[i])]++;
+        partitioned_values[j] = input_data[i];
+        if (return_inverse) {
+          partitioned_positions[j] = i;
+        }
+      }
+    }
+    values = partitioned_values.get();
+    positions = partitioned_positions.get();
+  }
+
+  // Deduplicate every partition, inverse indices are local to the partition
+  // until its offset in the output is known
+  std::vector<std::unique_ptr<UniqueTable<scalar_t>>> tables(num_partitions);
+  #pragma omp parallel for schedule(dynamic) num_threads(num_threads)
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    tables[p].reset(new UniqueTable<scalar_t>(return_counts));
+    auto& table = *tables[p];
+    for (int64_t i = partition_begin[p]; i < partition_begin[p + 1]; ++i) {
+      int64_t id = table.insert(values[i]);
+      if (return_inverse) {
+        inverse_indices_data[positions ? positions[i] : i] = id;
+      }
     }
   }
-  return std::make_tuple(output, inverse_indices);
+
+  std::vector<int64_t> unique_begin(num_partitions + 1, 0);
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    unique_begin[p + 1] = unique_begin[p] + tables[p]->values().size();
+  }
+  const int64_t num_unique = unique_begin[num_partitions];
+
+  Tensor output = input.type().tensor({num_unique});
+  scalar_t* output_data = output.data<scalar_t>();
+  Tensor counts = self.type().toScalarType(kLong).tensor({return_counts ? num_unique : 0});
+  int64_t* counts_data = return_counts ? counts.data<int64_t>() : nullptr;
+  #pragma omp parallel for num_threads(num_threads)
+  for (int64_t p = 0; p < num_partitions; ++p) {
+    auto& table = *tables[p];
+    std::copy(table.values().begin(), table.values().end(),
+              output_data + unique_begin[p]);
+    if (return_counts) {
+      std::copy(table.counts().begin(), table.counts().end(),
+                counts_data + unique_begin[p]);
+    }
+    if (return_inverse && unique_begin[p] > 0) {
+      for (int64_t i = partition_begin[p]; i < partition_begin[p + 1]; ++i) {
+        inverse_indices_data[positions[i]] += unique_begin[p];
+      }
+    }
+  }
+
+  if (sorted) {
+    // order[k] is the current index of the k-th smallest unique element
+    std::vector<int64_t> order(num_unique);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [output_data](int64_t a, int64_t b) {
+      return output_data[a] < output_data[b];
+    });
+    std::vector<scalar_t> sorted_values(num_unique);
+    for (int64_t k = 0; k < num_unique; ++k) {
+      sorted_values[k] = output_data[order[k]];
+    }
+    std::copy(sorted_values.begin(), sorted_values.end(), output_data);
+    if (return_counts) {
+      std::vector<int64_t> sorted_counts(num_unique);
+      for (int64_t k = 0; k < num_unique; ++k) {
+        sorted_counts[k] = counts_data[order[k]];
+      }
+      std::copy(sorted_counts.begin(), sorted_counts.end(), counts_data);
+    }
+    if (return_inverse) {
+      std::vector<int64_t> rank(num_unique);
+      for (int64_t k = 0; k < num_unique; ++k) {
+        rank[order[k]] = k;
+      }
+      #pragma omp parallel for num_threads(num_threads)
+      for (int64_t i = 0; i < numel; ++i) {
+        inverse_indices_data[i] = rank[inverse_indices_data[i]];
+      }
+    }
+  }
+
+  return std::make_tuple(output, inverse_indices, counts);
 }
 } // namespace
 
 std::tuple<Tensor, Tensor>
 _unique_cpu(const Tensor& self, const bool sorted, const bool return_inverse) {
   return AT_DISPATCH_ALL_TYPES(self.type(), "unique", [&] {
-    return _unique_cpu_template<scalar_t>(self, sorted, return_inverse);
+    Tensor output, inverse_indices;
+    std::tie(output, inverse_indices, std::ignore) =
+        _unique_cpu_template<scalar_t>(self, sorted, return_inverse, false);
+    return std::make_tuple(output, inverse_indices);
+  });
+}
+
+std::tuple<Tensor, Tensor, Tensor>
+_unique_with_counts_cpu(const Tensor& self, const bool sorted, const bool return_inverse) {
+  return AT_DISPATCH_ALL_TYPES(self.type(), "unique", [&] {
+    return _unique_cpu_template<scalar_t>(self, sorted, return_inverse, true);
   });
 }
 
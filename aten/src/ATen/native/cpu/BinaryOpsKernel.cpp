@@ -0,0 +1,107 @@
+#include "ATen/native/cpu/BinaryOpsKernel.h"
+
+#include "ATen/Dispatch.h"
+#include "ATen/native/TensorIterator.h"
+
+namespace at { namespace native { namespace {
+
+// The loops over contiguous operands, and over contiguous operands with one
+// broadcast input, are written over typed pointers so that the compiler
+// vectorizes them for every CPU capability this file is compiled for.
+template <typename scalar_t, typename op_t>
+static void binary_loop(char** data, const int64_t* strides, int64_t n, op_t op) {
+  constexpr int64_t size = sizeof(scalar_t);
+  auto out = reinterpret_cast<scalar_t*>(data[0]);
+  auto a = reinterpret_cast<const scalar_t*>(data[1]);
+  auto b = reinterpret_cast<const scalar_t*>(data[2]);
+  if (strides[0] == size && strides[1] == size && strides[2] == size) {
+    for (int64_t i = 0; i < n; i++) {
+      out[i] = op(a[i], b[i]);
+    }
+  } else if (strides[0] == size && strides[1] == 0 && strides[2] == size) {
+    scalar_t a_value = *a;
+    for (int64_t i = 0; i < n; i++) {
+      out[i] = op(a_value, b[i]);
+    }
+  } else if (strides[0] == size && strides[1] == size && strides[2] == 0) {
+    scalar_t b_value = *b;
+    for (int64_t i = 0; i < n; i++) {
+      out[i] = op(a[i], b_value);
+    }
+  } else {
+    char* out_ptr = data[0];
+    const char* a_ptr = data[1];
+    const char* b_ptr = data[2];
+    for (int64_t i = 0; i < n; i++) {
+      *reinterpret_cast<scalar_t*>(out_ptr) = op(
+          *reinterpret_cast<const scalar_t*>(a_ptr),
+          *reinterpret_cast<const scalar_t*>(b_ptr));
+      out_ptr += strides[0];
+      a_ptr += strides[1];
+      b_ptr += strides[2];
+    }
+  }
+}
+
+template <typename scalar_t, typename op_t>
+static void binary_apply(Tensor& result, const Tensor& self, const Tensor& other, op_t op) {
+  TensorIterator iter(result, {self, other});
+  iter.for_each([op](char** data, const int64_t* strides, int64_t n) {
+    binary_loop<scalar_t>(data, strides, n, op);
+  });
+}
+
+static void add_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "add", [&] {
+    scalar_t alpha_value = alpha.to<scalar_t>();
+    if (alpha_value == 1) {
+      binary_apply<scalar_t>(result, self, other, [](scalar_t a, scalar_t b) {
+        return a + b;
+      });
+    } else {
+      binary_apply<scalar_t>(result, self, other, [alpha_value](scalar_t a, scalar_t b) {
+        return a + alpha_value * b;
+      });
+    }
+  });
+}
+
+static void sub_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "sub", [&] {
+    scalar_t alpha_value = alpha.to<scalar_t>();
+    if (alpha_value == 1) {
+      binary_apply<scalar_t>(result, self, other, [](scalar_t a, scalar_t b) {
+        return a - b;
+      });
+    } else {
+      binary_apply<scalar_t>(result, self, other, [alpha_value](scalar_t a, scalar_t b) {
+        return a - alpha_value * b;
+      });
+    }
+  });
+}
+
+static void mul_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "mul", [&] {
+    binary_apply<scalar_t>(result, self, other, [](scalar_t a, scalar_t b) {
+      return a * b;
+    });
+  });
+}
+
+static void div_kernel_impl(Tensor& result, const Tensor& self, const Tensor& other) {
+  AT_DISPATCH_ALL_TYPES(self.type(), "div", [&] {
+    binary_apply<scalar_t>(result, self, other, [](scalar_t a, scalar_t b) {
+      return a / b;
+    });
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(add_kernel, &add_kernel_impl);
+REGISTER_DISPATCH(sub_kernel, &sub_kernel_impl);
+REGISTER_DISPATCH(mul_kernel, &mul_kernel_impl);
+REGISTER_DISPATCH(div_kernel, &div_kernel_impl);
+
+}} // namespace at::native
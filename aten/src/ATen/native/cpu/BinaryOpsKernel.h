@@ -0,0 +1,21 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+// Element-wise result = self op other for tensors of the same type, which
+// may be non-contiguous or broadcast against each other. result is resized
+// to the broadcast shape.
+using binary_fn = void(*)(Tensor& result, const Tensor& self, const Tensor& other);
+using binary_fn_alpha = void(*)(Tensor& result, const Tensor& self, const Tensor& other, Scalar alpha);
+
+// result = self + alpha * other
+extern DispatchStub<binary_fn_alpha> add_kernel;
+// result = self - alpha * other
+extern DispatchStub<binary_fn_alpha> sub_kernel;
+extern DispatchStub<binary_fn> mul_kernel;
+extern DispatchStub<binary_fn> div_kernel;
+
+}} // namespace at::native
@@ -0,0 +1,205 @@
+#include "ATen/native/cpu/EmbeddingBagKernel.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "ATen/Dispatch.h"
+#include "ATen/Parallel.h"
+#include "ATen/native/cpu/Vectorized.h"
+
+namespace at { namespace native { namespace {
+
+// Number of indices to look ahead when prefetching rows of weight, the same
+// distance as in caffe2/perfkernels/embedding_lookup_avx2.cc
+constexpr int64_t PREFETCH_DISTANCE = 16;
+constexpr int64_t CACHE_LINE_SIZE = 64;
+
+static inline void prefetch_row(const void* row, int64_t size) {
+#if defined(__GNUC__)
+  auto ptr = static_cast<const char*>(row);
+  for (int64_t offset = 0; offset < size; offset += CACHE_LINE_SIZE) {
+    __builtin_prefetch(ptr + offset, 0, 3);
+  }
+#endif
+}
+
+// Calls func(begin, end) on ranges of bags, in parallel if the total amount
+// of work is large enough
+template <typename F>
+static void parallel_for_bags(int64_t num_bags, int64_t work_per_bag, F func) {
+  if (num_bags * work_per_bag < internal::TBB_GRAIN_SIZE || num_bags == 1) {
+    func(0, num_bags);
+    return;
+  }
+  internal::init_tbb_num_threads();
+  int64_t grain = std::max<int64_t>(
+      internal::TBB_GRAIN_SIZE / std::max<int64_t>(work_per_bag, 1), 1);
+  tbb::parallel_for(
+      tbb::blocked_range<int64_t>(0, num_bags, grain),
+      [&func](const tbb::blocked_range<int64_t>& r) {
+        func(r.begin(), r.end());
+      });
+}
+
+template <typename scalar_t>
+struct EmbeddingBag {
+  using Vec = Vectorized<scalar_t>;
+
+  // out[0 ... size-1] += row[0 ... size-1] * scale
+  static void add_row(scalar_t* out, const scalar_t* row, scalar_t scale, int64_t size) {
+    int64_t d = 0;
+    if (scale == 1) {
+      for (; d + Vec::size <= size; d += Vec::size) {
+        (Vec::s_load(out + d) + Vec::s_load(row + d)).store(out + d);
+      }
+      for (; d < size; d++) {
+        out[d] += row[d];
+      }
+    } else {
+      Vec vscale(scale);
+      for (; d + Vec::size <= size; d += Vec::size) {
+        (Vec::s_load(out + d) + Vec::s_load(row + d) * vscale).store(out + d);
+      }
+      for (; d < size; d++) {
+        out[d] += row[d] * scale;
+      }
+    }
+  }
+
+  // out[0 ... size-1] = row[0 ... size-1] * scale
+  static void scale_row(scalar_t* out, const scalar_t* row, scalar_t scale, int64_t size) {
+    Vec vscale(scale);
+    int64_t d = 0;
+    for (; d + Vec::size <= size; d += Vec::size) {
+      (Vec::s_load(row + d) * vscale).store(out + d);
+    }
+    for (; d < size; d++) {
+      out[d] = row[d] * scale;
+    }
+  }
+
+  static void apply(Tensor& output, Tensor& offset2bag, Tensor& bag_size,
+                    Tensor& max_indices, const Tensor& weight,
+                    const Tensor& indices, const Tensor& offsets,
+                    const Tensor& per_sample_weights, int64_t mode) {
+    auto output_data = output.data<scalar_t>();
+    auto offset2bag_data = offset2bag.data<int64_t>();
+    auto bag_size_data = bag_size.data<int64_t>();
+    auto max_indices_data = mode == MODE_MAX ? max_indices.data<int64_t>() : nullptr;
+    auto weight_data = weight.data<scalar_t>();
+    auto indices_data = indices.data<int64_t>();
+    auto offsets_data = offsets.data<int64_t>();
+    auto per_sample_weights_data = per_sample_weights.defined()
+        ? per_sample_weights.data<scalar_t>() : nullptr;
+
+    int64_t num_indices = indices.numel();
+    int64_t num_bags = offsets.numel();
+    int64_t ddim = weight.size(1);
+    int64_t row_bytes = ddim * sizeof(scalar_t);
+
+    auto bag_end = [=](int64_t bag) {
+      return bag + 1 < num_bags ? offsets_data[bag + 1] : num_indices;
+    };
+
+    int64_t average_bag_size = num_indices / std::max<int64_t>(num_bags, 1) + 1;
+    parallel_for_bags(num_bags, average_bag_size * ddim, [&](int64_t first_bag, int64_t last_bag) {
+      int64_t last_index = first_bag < last_bag ? bag_end(last_bag - 1) : 0;
+      for (int64_t bag = first_bag; bag < last_bag; bag++) {
+        int64_t begin = offsets_data[bag];
+        int64_t end = bag_end(bag);
+        bag_size_data[bag] = end - begin;
+        scalar_t* out = output_data + bag * ddim;
+        int64_t* max_idx = max_indices_data ? max_indices_data + bag * ddim : nullptr;
+
+        if (mode == MODE_MAX) {
+          std::fill(max_idx, max_idx + ddim, -1);
+        }
+        for (int64_t i = begin; i < end; i++) {
+          if (i + PREFETCH_DISTANCE < last_index) {
+            prefetch_row(weight_data + indices_data[i + PREFETCH_DISTANCE] * ddim, row_bytes);
+          }
+          offset2bag_data[i] = bag;
+          int64_t index = indices_data[i];
+          const scalar_t* row = weight_data + index * ddim;
+          if (mode == MODE_MAX) {
+            if (i == begin) {
+              std::copy(row, row + ddim, out);
+              std::fill(max_idx, max_idx + ddim, index);
+            } else {
+              for (int64_t d = 0; d < ddim; d++) {
+                // NaN wins, as in max
+                if (row[d] > out[d] || std::isnan(row[d])) {
+                  out[d] = row[d];
+                  max_idx[d] = index;
+                }
+              }
+            }
+          } else {
+            scalar_t scale = per_sample_weights_data ? per_sample_weights_data[i] : 1;
+            add_row(out, row, scale, ddim);
+          }
+        }
+        if (mode == MODE_MEAN && end > begin) {
+          scale_row(out, out, scalar_t(1) / (end - begin), ddim);
+        }
+      }
+    });
+  }
+
+  static void sparse_backward(Tensor& values, const Tensor& grad,
+                              const Tensor& offsets,
+                              const Tensor& per_sample_weights,
+                              int64_t num_indices, int64_t mode) {
+    auto values_data = values.data<scalar_t>();
+    auto grad_data = grad.data<scalar_t>();
+    auto offsets_data = offsets.data<int64_t>();
+    auto per_sample_weights_data = per_sample_weights.defined()
+        ? per_sample_weights.data<scalar_t>() : nullptr;
+    int64_t num_bags = offsets.numel();
+    int64_t ddim = grad.size(1);
+
+    int64_t average_bag_size = num_indices / std::max<int64_t>(num_bags, 1) + 1;
+    parallel_for_bags(num_bags, average_bag_size * ddim, [&](int64_t first_bag, int64_t last_bag) {
+      for (int64_t bag = first_bag; bag < last_bag; bag++) {
+        int64_t begin = offsets_data[bag];
+        int64_t end = bag + 1 < num_bags ? offsets_data[bag + 1] : num_indices;
+        const scalar_t* grad_row = grad_data + bag * ddim;
+        scalar_t bag_scale = mode == MODE_MEAN && end > begin
+            ? scalar_t(1) / (end - begin) : scalar_t(1);
+        for (int64_t i = begin; i < end; i++) {
+          scalar_t scale = per_sample_weights_data
+              ? bag_scale * per_sample_weights_data[i] : bag_scale;
+          scale_row(values_data + i * ddim, grad_row, scale, ddim);
+        }
+      }
+    });
+  }
+};
+
+static void embedding_bag_kernel_impl(
+    Tensor& output, Tensor& offset2bag, Tensor& bag_size, Tensor& max_indices,
+    const Tensor& weight, const Tensor& indices, const Tensor& offsets,
+    const Tensor& per_sample_weights, int64_t mode) {
+  AT_DISPATCH_FLOATING_TYPES(weight.type(), "embedding_bag", [&] {
+    EmbeddingBag<scalar_t>::apply(output, offset2bag, bag_size, max_indices,
+                                  weight, indices, offsets, per_sample_weights,
+                                  mode);
+  });
+}
+
+static void embedding_bag_sparse_backward_kernel_impl(
+    Tensor& values, const Tensor& grad, const Tensor& offsets,
+    const Tensor& per_sample_weights, int64_t num_indices, int64_t mode) {
+  AT_DISPATCH_FLOATING_TYPES(grad.type(), "embedding_bag_sparse_backward", [&] {
+    EmbeddingBag<scalar_t>::sparse_backward(values, grad, offsets,
+                                            per_sample_weights, num_indices,
+                                            mode);
+  });
+}
+
+}  // anonymous namespace
+
+REGISTER_DISPATCH(embedding_bag_kernel, &embedding_bag_kernel_impl);
+REGISTER_DISPATCH(embedding_bag_sparse_backward_kernel, &embedding_bag_sparse_backward_kernel_impl);
+
+}}  // namespace at::native
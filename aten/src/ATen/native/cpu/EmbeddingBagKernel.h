@@ -0,0 +1,31 @@
+#pragma once
+
+#include <ATen/ATen.h>
+#include "CapabilityDispatch.h"
+
+namespace at { namespace native {
+
+constexpr int64_t MODE_SUM = 0;
+constexpr int64_t MODE_MEAN = 1;
+constexpr int64_t MODE_MAX = 2;
+
+// Reduces the rows of weight selected by every bag in a single pass over
+// indices, parallel across bags. Fills output, offset2bag, bag_size and, for
+// MODE_MAX, max_indices, which have to be allocated by the caller.
+// per_sample_weights is either undefined or holds one scale per index.
+using embedding_bag_fn = void(*)(
+    Tensor& output, Tensor& offset2bag, Tensor& bag_size, Tensor& max_indices,
+    const Tensor& weight, const Tensor& indices, const Tensor& offsets,
+    const Tensor& per_sample_weights, int64_t mode);
+
+// Fills the values of the sparse gradient of embedding_bag: row i of values
+// is the gradient of the bag containing index i, scaled by its per sample
+// weight and, for MODE_MEAN, by the bag size.
+using embedding_bag_sparse_backward_fn = void(*)(
+    Tensor& values, const Tensor& grad, const Tensor& offsets,
+    const Tensor& per_sample_weights, int64_t num_indices, int64_t mode);
+
+extern DispatchStub<embedding_bag_fn> embedding_bag_kernel;
+extern DispatchStub<embedding_bag_sparse_backward_fn> embedding_bag_sparse_backward_kernel;
+
+}} // namespace at::native
@@ -5,12 +5,10 @@
 #include "ATen/Dispatch.h"
 #include "ATen/Parallel.h"
 #include "ATen/optional.h"
-#include "ATen/cpu/vec256/vec256.h"
+#include "ATen/native/cpu/Vectorized.h"
 
 namespace at { namespace native { namespace {
 
-using namespace vec256;
-
 static inline int64_t round_down(int64_t a, int64_t m) {
   return a - (a % m);
 }
@@ -29,15 +27,16 @@ static void parallel_for(int64_t end, int64_t step, bool parallelize, F func) {
 static tbb::affinity_partitioner ap;
 
 // Vectorized reduction defined by reduce operation `Op` with identity `ident`.
-// The reduction is built on top of reduce128, which reduces down a column
-// 128 bytes wide (WIDTH scalar elements). The width of 128 bytes is chosen
-// because of the "adjacent cache line prefetch" behavior on x86 CPUs.
+// The reduction is built on top of reduce_columns, which reduces down a
+// column four vectors wide (WIDTH scalar elements): 128 bytes with Vec256 and
+// 256 bytes with Vec512. A multiple of 128 bytes is chosen because of the
+// "adjacent cache line prefetch" behavior on x86 CPUs.
 template<typename scalar_t, template <class> class Op, int ident>
 struct Reduction {
-  // reduction width in number of scalar elements
-  static constexpr int WIDTH = 128 / sizeof(scalar_t);
+  using Vec = Vectorized<scalar_t>;
 
-  using Vec = Vec256<scalar_t>;
+  // reduction width in number of scalar elements
+  static constexpr int WIDTH = 4 * Vec::size;
   using Reduce = Op<Vec>;
   using ReduceScalar = Op<scalar_t>;
 
@@ -75,14 +74,14 @@ struct Reduction {
           scalar_t(ident),
           [=](const tbb::blocked_range<int64_t>& r, scalar_t init) {
             scalar_t buf[WIDTH];
-            reduce128(&data[r.begin() * WIDTH], buf, r.end() - r.begin(), WIDTH);
+            reduce_columns(&data[r.begin() * WIDTH], buf, r.end() - r.begin(), WIDTH);
             return std::accumulate(buf, buf + WIDTH, init, ReduceScalar());
           },
           ReduceScalar(),
           ap);
     } else {
       scalar_t buf[WIDTH];
-      reduce128(data, buf, k, WIDTH);
+      reduce_columns(data, buf, k, WIDTH);
       sum = std::accumulate(buf, buf + WIDTH, scalar_t(ident), ReduceScalar());
     }
 
@@ -92,11 +91,12 @@ struct Reduction {
     return sum;
   }
 
-  // Reduce down a column of WIDTH elements (128 bytes) with the given number
-  // of rows. Stores the results in out[0 ... WIDTH-1].
-  static void reduce128(const scalar_t* data, scalar_t* out, int64_t rows, int64_t stride) {
-    Vec acc[4] = {ident, ident, ident, ident};  // 128 bytes (two cache lines)
-    static_assert(sizeof(acc) == 128, "accumulator should be 128 bytes");
+  // Reduce down a column of WIDTH elements with the given number of rows.
+  // Stores the results in out[0 ... WIDTH-1].
+  static void reduce_columns(const scalar_t* data, scalar_t* out, int64_t rows, int64_t stride) {
+    Vec acc[4] = {ident, ident, ident, ident};  // two or four cache lines
+    static_assert(sizeof(acc) == WIDTH * sizeof(scalar_t),
+                  "accumulator should be WIDTH elements");
     for (int64_t row = 0; row != rows; row++) {
       for (int j = 0; j != 4; j++) {
         auto val = Vec::s_load(&data[row * stride + j * Vec::size]);
@@ -113,7 +113,7 @@ struct Reduction {
     int64_t cols_rounded = round_down(cols, WIDTH);
     bool paralellize = cols * rows > internal::TBB_GRAIN_SIZE;
     parallel_for(cols_rounded, WIDTH, paralellize, [=](int64_t col) {
-      reduce128(&data[col], &out[col], rows, stride);
+      reduce_columns(&data[col], &out[col], rows, stride);
     });
 
     if (cols_rounded != cols) {
@@ -1,19 +1,19 @@
 #include "ATen/native/cpu/UnaryOpsKernel.h"
 
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 #include "ATen/Dispatch.h"
 #include "ATen/Parallel.h"
-#include "ATen/cpu/vec256/vec256.h"
+#include "ATen/native/TensorIterator.h"
 #include "ATen/native/cpu/CapabilityDispatch.h"
+#include "ATen/native/cpu/Vectorized.h"
 
 namespace at { namespace native { namespace {
 
-using namespace vec256;
-
 template <typename scalar_t, typename F>
 static void unary_kernel(scalar_t* arr_out, const scalar_t* arr_in, int64_t size, F func) {
-  using Vec = Vec256<scalar_t>;
+  using Vec = Vectorized<scalar_t>;
   int64_t size_rounded = size - (size % Vec::size);
   int64_t k = 0;
   for (; k != size_rounded; k += Vec::size) {
@@ -28,31 +28,41 @@ static void unary_kernel(scalar_t* arr_out, const scalar_t* arr_in, int64_t size
   }
 }
 
+// Applies func to n elements at strided locations by gathering them into a
+// buffer of contiguous elements
+template <typename scalar_t, typename F>
+static void unary_kernel_strided(char* out, int64_t out_stride, const char* in,
+                                 int64_t in_stride, int64_t n, F func) {
+  constexpr int64_t BUFFER_SIZE = 256;
+  scalar_t buffer[BUFFER_SIZE];
+  for (int64_t begin = 0; begin < n; begin += BUFFER_SIZE) {
+    int64_t size = std::min(BUFFER_SIZE, n - begin);
+    for (int64_t i = 0; i < size; i++) {
+      buffer[i] = *reinterpret_cast<const scalar_t*>(in + (begin + i) * in_stride);
+    }
+    unary_kernel(buffer, buffer, size, func);
+    for (int64_t i = 0; i < size; i++) {
+      *reinterpret_cast<scalar_t*>(out + (begin + i) * out_stride) = buffer[i];
+    }
+  }
+}
+
 template <class scalar_t, class F>
 static void parallel_apply(Tensor& result, const Tensor& self, F f) {
-  internal::init_tbb_num_threads();
-
-  static tbb::affinity_partitioner ap;
-
-  auto arr_out = result.data<scalar_t>();
-  auto arr_in = self.data<scalar_t>();
-  int64_t size = self.numel();
-  if (size < internal::TBB_GRAIN_SIZE) {
-    unary_kernel(arr_out, arr_in, size, f);
-  } else {
-    tbb::parallel_for(
-        tbb::blocked_range<int64_t>(0, size, internal::TBB_GRAIN_SIZE),
-        [&](const tbb::blocked_range<int64_t>& r) {
-          auto size = r.end() - r.begin();
-          unary_kernel(arr_out + r.begin(), arr_in + r.begin(), size, f);
-        },
-        ap);
-  }
+  TensorIterator iter(result, {self});
+  iter.for_each([f](char** data, const int64_t* strides, int64_t n) {
+    if (strides[0] == sizeof(scalar_t) && strides[1] == sizeof(scalar_t)) {
+      unary_kernel(reinterpret_cast<scalar_t*>(data[0]),
+                   reinterpret_cast<const scalar_t*>(data[1]), n, f);
+    } else {
+      unary_kernel_strided<scalar_t>(data[0], strides[0], data[1], strides[1], n, f);
+    }
+  });
 }
 
 static void abs_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_ALL_TYPES(self.type(), "abs", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.abs();
     });
   });
@@ -60,7 +70,7 @@ static void abs_kernel(Tensor& result, const Tensor& self) {
 
 static void ceil_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "ceil", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.ceil();
     });
   });
@@ -68,7 +78,7 @@ static void ceil_kernel(Tensor& result, const Tensor& self) {
 
 static void cos_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "cos", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.cos();
     });
   });
@@ -76,7 +86,7 @@ static void cos_kernel(Tensor& result, const Tensor& self) {
 
 static void exp_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "exp", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.exp();
     });
   });
@@ -84,7 +94,7 @@ static void exp_kernel(Tensor& result, const Tensor& self) {
 
 static void floor_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "floor", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.floor();
     });
   });
@@ -92,7 +102,7 @@ static void floor_kernel(Tensor& result, const Tensor& self) {
 
 static void log_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "log", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.log();
     });
   });
@@ -100,7 +110,7 @@ static void log_kernel(Tensor& result, const Tensor& self) {
 
 static void round_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "round", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.round();
     });
   });
@@ -108,7 +118,7 @@ static void round_kernel(Tensor& result, const Tensor& self) {
 
 static void sin_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "sin", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.sin();
     });
   });
@@ -116,7 +126,7 @@ static void sin_kernel(Tensor& result, const Tensor& self) {
 
 static void sqrt_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "sqrt", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.sqrt();
     });
   });
@@ -124,7 +134,7 @@ static void sqrt_kernel(Tensor& result, const Tensor& self) {
 
 static void trunc_kernel(Tensor& result, const Tensor& self) {
   AT_DISPATCH_FLOATING_TYPES(self.type(), "trunc", [&] {
-    parallel_apply<scalar_t>(result, self, [](const Vec256<scalar_t>& x) {
+    parallel_apply<scalar_t>(result, self, [](const Vectorized<scalar_t>& x) {
       return x.trunc();
     });
   });
@@ -21,9 +21,9 @@ extern DispatchStub<unary_fn> sqrtImpl;
 extern DispatchStub<unary_fn> truncImpl;
 
 // Missing unary functions
-// TODO: Add generic apply function for contiguous and non-contiguous tensors
-// The goal here is to move more ops entirely into ATen and take advantage of
-// automatic vectorization with file-specific flags
+// The kernels iterate with TensorIterator, so they support non-contiguous
+// tensors. The goal here is to move more ops entirely into ATen and take
+// advantage of automatic vectorization with file-specific flags
 // acos
 // asin
 // atan
@@ -0,0 +1,22 @@
+#pragma once
+
+#include "ATen/cpu/vec256/vec256.h"
+#include "ATen/cpu/vec512/vec512.h"
+
+// Vectorized<T> is the widest vector type available to the capability the
+// including file is being compiled for: Vec512 for AVX512 and Vec256 for
+// everything else. Kernels in this folder should use it rather than naming
+// Vec256 directly, so that they take advantage of 512-bit registers when
+// they are dispatched to an AVX512 machine.
+
+namespace at { namespace native { namespace {
+
+#if defined(CPU_CAPABILITY_AVX512)
+template <typename T>
+using Vectorized = vec512::Vec512<T>;
+#else
+template <typename T>
+using Vectorized = vec256::Vec256<T>;
+#endif
+
+}}}  // namespace at::native
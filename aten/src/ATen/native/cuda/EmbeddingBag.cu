@@ -143,10 +143,17 @@ __global__ void EmbeddingBag_accGradParametersKernel(
 }
 }
 
-std::tuple<Tensor, Tensor, Tensor>
+std::tuple<Tensor, Tensor, Tensor, Tensor>
 embedding_bag_cuda(const Tensor &weight, const Tensor &indices,
                    const Tensor &offsets, const bool scale_grad_by_freq,
-                   const int64_t mode, bool sparse) {
+                   const int64_t mode, bool sparse,
+                   const Tensor &per_sample_weights) {
+  if (mode == 2) { // MODE_MAX
+    AT_ERROR("embedding_bag_cuda: mode='max' is only supported on CPU");
+  }
+  if (per_sample_weights.defined()) {
+    AT_ERROR("embedding_bag_cuda: per_sample_weights are only supported on CPU");
+  }
   auto indices_arg = TensorArg(indices, "indices", 1);
   checkScalarType("embedding_bag_cuda", indices_arg, kLong);
   checkContiguous("embedding_bag_cuda", indices_arg);
@@ -182,14 +189,19 @@ embedding_bag_cuda(const Tensor &weight, const Tensor &indices,
   });
 
   THCudaCheck(cudaGetLastError());
-  return std::tuple<Tensor, Tensor, Tensor>(output, offset2bag, bag_size);
+  auto max_indices = indices.type().tensor({0});
+  return std::tuple<Tensor, Tensor, Tensor, Tensor>(output, offset2bag,
+                                                    bag_size, max_indices);
 }
 
 Tensor embedding_bag_backward_cuda(const Tensor &grad_, const Tensor &indices,
                                    const Tensor &offsets,
                                    const Tensor &offset2bag,
-                                   const Tensor &bag_size_, int64_t num_weights,
-                                   bool scale_grad_by_freq, int64_t mode) {
+                                   const Tensor &bag_size_,
+                                   const Tensor &max_indices,
+                                   int64_t num_weights,
+                                   bool scale_grad_by_freq, int64_t mode,
+                                   const Tensor &per_sample_weights) {
   Tensor grad = grad_.contiguous();
   auto indices_arg = TensorArg(indices, "indices", 1);
   checkScalarType("embedding_bag_cuda", indices_arg, kLong);
@@ -281,5 +293,11 @@ Tensor embedding_bag_backward_cuda(const Tensor &grad_, const Tensor &indices,
   THCudaCheck(cudaGetLastError());
   return grad_weight;
 }
+
+Tensor embedding_bag_per_sample_weights_backward_cuda(
+    const Tensor &grad, const Tensor &weight, const Tensor &indices,
+    const Tensor &offset2bag, int64_t mode) {
+  AT_ERROR("embedding_bag_cuda: per_sample_weights are only supported on CPU");
+}
 }
 }
@@ -12,5 +12,12 @@ _unique_cuda(const Tensor& self, const bool sorted, const bool return_inverse) {
       "Pull requests welcome!");
 }
 
+std::tuple<Tensor, Tensor, Tensor>
+_unique_with_counts_cuda(const Tensor& self, const bool sorted, const bool return_inverse) {
+  throw std::runtime_error(
+      "unique is currently CPU-only, and lacks CUDA support. "
+      "Pull requests welcome!");
+}
+
 }  // namespace native
 }  // namespace at
@@ -81,6 +81,15 @@ def parse_arguments(args, func_decl, func_name, func_return):
     return arguments
 
 
+def set_broadcast(arguments, broadcasts):
+    # broadcast maps the name of an argument to the same specification as the
+    # 'broadcast' field of cwrap arguments, e.g. "other inplace"
+    for name, spec in broadcasts.items():
+        matches = [argument for argument in arguments if argument['name'] == name]
+        assert len(matches) == 1, "broadcast argument {} not found".format(name)
+        matches[0]['broadcast'] = spec
+
+
 def has_sparse_dispatches(dispatches):
     for dispatch in dispatches:
         if 'Sparse' in dispatch:
@@ -111,6 +120,7 @@ def run(paths):
             declaration['variants'] = func.get('variants', ['method', 'function'])
             declaration['arguments'] = func.get('arguments', parse_arguments(arguments, func,
                                                 declaration['name'], declaration['return']))
+            set_broadcast(declaration['arguments'], func.get('broadcast', {}))
             declaration['type_method_definition_dispatch'] = func.get('dispatch', declaration['name'])
             declaration['aten_sparse'] = has_sparse_dispatches(
                 declaration['type_method_definition_dispatch'])
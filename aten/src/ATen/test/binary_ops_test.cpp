@@ -0,0 +1,163 @@
+#define CATCH_CONFIG_MAIN
+#include "catch.hpp"
+
+#include "ATen/ATen.h"
+#include "ATen/Parallel.h"
+#include "test_seed.h"
+
+using namespace at;
+
+// The results of the TensorIterator kernels of add, sub, mul and div are
+// compared with their TH implementations, which are kept as _add, _sub, _mul
+// and _div. Floating point results may differ in rounding, e.g. if the
+// compiler contracts a + alpha * b.
+static void requireSame(const Tensor& t1, const Tensor& t2) {
+  REQUIRE(t1.is_same_size(t2));
+  if (isFloatingType(t1.type().scalarType())) {
+    REQUIRE(t1.allclose(t2));
+  } else {
+    REQUIRE(t1.equal(t2));
+  }
+}
+
+static void requireSameAsTH(const Tensor& a, const Tensor& b) {
+  requireSame(a.add(b), a._add(b));
+  requireSame(a.add(b, 3), a._add(b, 3));
+  requireSame(a.sub(b), a._sub(b));
+  requireSame(a.sub(b, 3), a._sub(b, 3));
+  requireSame(a.mul(b), a._mul(b));
+  requireSame(a.div(b), a._div(b));
+}
+
+// Values without zeros, so that integer division is defined
+static Tensor nonzero(Type& T, IntList sizes) {
+  return (rand(CPU(kDouble), sizes) * 9 + 1).toType(T);
+}
+
+static void test(Type& T) {
+  SECTION( "contiguous" ) {
+    requireSameAsTH(nonzero(T, {3, 4}), nonzero(T, {3, 4}));
+  }
+
+  SECTION( "broadcast" ) {
+    auto a = nonzero(T, {3, 1, 5});
+    auto b = nonzero(T, {4, 1});
+    REQUIRE(a.add(b).sizes().equals({3, 4, 5}));
+    requireSameAsTH(a, b);
+    requireSameAsTH(b, a);
+    requireSameAsTH(a, nonzero(T, {}));
+    requireSameAsTH(nonzero(T, {}), a);
+  }
+
+  SECTION( "non-contiguous" ) {
+    auto a = nonzero(T, {6, 8});
+    auto b = nonzero(T, {8, 6});
+    requireSameAsTH(a.t(), b);
+    requireSameAsTH(a.t(), b.t().t());
+    requireSameAsTH(a.narrow(1, 1, 4), b.narrow(0, 2, 6).t());
+    requireSameAsTH(a.slice(0, 0, 6, 2), b.slice(1, 0, 6, 2).t().narrow(0, 0, 3));
+    requireSameAsTH(a.select(1, 3), b.select(0, 5));
+  }
+
+  SECTION( "in-place and out" ) {
+    auto a = nonzero(T, {4, 5});
+    auto b = nonzero(T, {5});
+    auto expected = a._mul(b);
+    auto result = T.tensor();
+    at::mul_out(result, a, b);
+    requireSame(result, expected);
+    // The output is written through its own strides
+    auto out = T.tensor({5, 4}).t();
+    at::mul_out(out, a, b);
+    requireSame(out, expected);
+    auto c = a.clone();
+    c.mul_(b);
+    requireSame(c, expected);
+    auto d = a.clone();
+    d.add_(b, 2);
+    requireSame(d, a._add(b, 2));
+  }
+
+  SECTION( "parallel" ) {
+    // Enough elements for for_each to split them into several ranges
+    int64_t n = 4 * internal::TBB_GRAIN_SIZE + 3;
+    requireSameAsTH(nonzero(T, {n}), nonzero(T, {n}));
+    requireSameAsTH(nonzero(T, {n / 64, 64}).t(), nonzero(T, {64}));
+    requireSameAsTH(nonzero(T, {internal::TBB_GRAIN_SIZE - 1}),
+                    nonzero(T, {internal::TBB_GRAIN_SIZE - 1}));
+  }
+
+  SECTION( "empty" ) {
+    auto a = T.tensor({0});
+    REQUIRE(a.add(a).numel() == 0);
+  }
+}
+
+TEST_CASE( "binary ops", "[cpu]" ) {
+  manual_seed(123);
+
+  SECTION( "Float" ) {
+    test(CPU(kFloat));
+  }
+  SECTION( "Double" ) {
+    test(CPU(kDouble));
+  }
+  SECTION( "Int" ) {
+    test(CPU(kInt));
+  }
+  SECTION( "Long" ) {
+    test(CPU(kLong));
+  }
+  SECTION( "Byte" ) {
+    test(CPU(kByte));
+  }
+
+  SECTION( "integer division truncates" ) {
+    auto a = CPU(kInt).tensor({2});
+    a.fill_(7);
+    auto b = CPU(kInt).tensor({2});
+    b.fill_(2);
+    auto expected = CPU(kInt).tensor({2});
+    expected.fill_(3);
+    REQUIRE(a.div(b).equal(expected));
+    REQUIRE(a._div(b).equal(expected));
+  }
+
+  SECTION( "mixed types" ) {
+    // Arguments are not promoted to a common type: tensors of different
+    // types go to TH, which rejects them as before
+    auto a = randn(CPU(kFloat), {3});
+    auto b = randn(CPU(kDouble), {3});
+    REQUIRE_THROWS(a.add(b));
+    REQUIRE_THROWS(a.mul(b));
+    auto result = CPU(kDouble).tensor();
+    REQUIRE_THROWS(at::add_out(result, a, a));
+  }
+
+  SECTION( "zero-dim other of another type" ) {
+    // A zero-dim other goes to the Scalar overload, whatever its type
+    auto a = nonzero(CPU(kFloat), {});
+    auto b = nonzero(CPU(kDouble), {});
+    auto expected = a.add(b.toType(CPU(kFloat)));
+    requireSame(a.add(b), expected);
+    requireSame(a.sub(b, 2), a.sub(b.toType(CPU(kFloat)), 2));
+    requireSame(a.mul(b), a.mul(b.toType(CPU(kFloat))));
+    requireSame(a.div(b), a.div(b.toType(CPU(kFloat))));
+    auto c = a.clone();
+    c.add_(b);
+    requireSame(c, expected);
+    auto result = CPU(kFloat).tensor();
+    at::add_out(result, a, b);
+    requireSame(result, expected);
+  }
+
+  SECTION( "zero-dim other on another device" ) {
+    if (at::hasCUDA()) {
+      auto a = nonzero(CUDA(kFloat), {});
+      auto b = nonzero(CPU(kFloat), {});
+      auto expected = a.toBackend(kCPU).add(b);
+      requireSame(a.add(b).toBackend(kCPU), expected);
+      requireSame(a.mul(b).toBackend(kCPU), a.toBackend(kCPU).mul(b));
+    }
+  }
+}
@@ -0,0 +1,75 @@
+// Times the runtime dispatched kernels in ATen/native/cpu. The kernel for a
+// capability is chosen once per process, so compare capabilities by running
+// the benchmark several times, e.g.
+//
+//   cpu_kernel_benchmark
+//   ATEN_DISABLE_AVX512=1 cpu_kernel_benchmark
+//   ATEN_DISABLE_AVX512=1 ATEN_DISABLE_AVX2=1 cpu_kernel_benchmark
+//
+// Usage: cpu_kernel_benchmark [numel]
+
+#include "ATen/ATen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+using namespace at;
+
+namespace {
+
+template <typename F>
+double time_us(F f, int iterations) {
+  double best = 0;
+  for (int i = 0; i < 5; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    for (int j = 0; j < iterations; ++j) {
+      f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    double us = std::chrono::duration<double, std::micro>(end - start).count();
+    if (i == 0 || us < best) {
+      best = us;
+    }
+  }
+  return best / iterations;
+}
+
+void benchmark(ScalarType scalar_type, int64_t numel) {
+  Tensor input = CPU(scalar_type).rand({numel}).sub_(0.5).mul_(100);
+  Tensor matrix = input.view({numel / 64, 64});
+  Tensor output = CPU(scalar_type).tensor({numel});
+  // Small inputs are repeated so that every measurement takes a while
+  int iterations = std::max<int64_t>(1, (int64_t(1) << 24) / numel);
+
+  std::cout << toString(scalar_type) << "\t" << numel;
+  std::cout << "\t" << time_us([&] { input.sum(); }, iterations);
+  std::cout << "\t" << time_us([&] { matrix.sum(0); }, iterations);
+  std::cout << "\t" << time_us([&] { input.prod(); }, iterations);
+  std::cout << "\t" << time_us([&] { at::abs_out(output, input); }, iterations);
+  std::cout << "\t" << time_us([&] { at::ceil_out(output, input); }, iterations);
+  std::cout << "\t" << time_us([&] { at::floor_out(output, input); }, iterations);
+  std::cout << "\t" << time_us([&] { at::round_out(output, input); }, iterations);
+  std::cout << "\t" << time_us([&] { at::trunc_out(output, input); }, iterations);
+  std::cout << "\t" << time_us([&] { at::sqrt_out(output, input); }, iterations);
+  std::cout << std::endl;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int64_t numel = argc > 1 ? std::atoll(argv[1]) : int64_t(1) << 22;
+  numel = std::max<int64_t>(64, numel - numel % 64);
+
+  std::cout << "type\tnumel\tsum (us)\tsum(0) (us)\tprod (us)\tabs (us)"
+            << "\tceil (us)\tfloor (us)\tround (us)\ttrunc (us)\tsqrt (us)"
+            << std::endl;
+  for (ScalarType scalar_type : {kFloat, kDouble}) {
+    // in L1, in L2 and in memory
+    for (int64_t n : {int64_t(2048), int64_t(1) << 16, numel}) {
+      benchmark(scalar_type, n);
+    }
+  }
+  return 0;
+}
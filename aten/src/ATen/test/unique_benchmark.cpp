@@ -0,0 +1,95 @@
+// Compares at::_unique against the previous implementation based on
+// std::unordered_set, on inputs with various numbers of distinct elements.
+//
+// Usage: unique_benchmark [numel]
+
+#include "ATen/ATen.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <tuple>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+using namespace at;
+
+namespace {
+
+std::tuple<Tensor, Tensor> unordered_set_unique(
+    const Tensor& self,
+    const bool sorted,
+    const bool return_inverse) {
+  const Tensor& input = self.contiguous();
+  const int64_t* input_data = input.data<int64_t>();
+  std::unordered_set<int64_t> set(input_data, input_data + input.numel());
+  Tensor output = input.type().tensor({static_cast<int64_t>(set.size())});
+  int64_t* output_data = output.data<int64_t>();
+
+  if (sorted) {
+    std::vector<int64_t> vec(set.begin(), set.end());
+    std::sort(vec.begin(), vec.end());
+    std::copy(vec.begin(), vec.end(), output_data);
+  } else {
+    std::copy(set.begin(), set.end(), output_data);
+  }
+
+  Tensor inverse_indices = self.type().toScalarType(kLong).tensor({0});
+  if (return_inverse) {
+    inverse_indices.resize_(input.sizes());
+    int64_t* inverse_indices_data = inverse_indices.data<int64_t>();
+    std::unordered_map<int64_t, int64_t> inverse_map;
+    inverse_map.reserve(output.numel());
+    for (int64_t i = 0; i < output.numel(); ++i) {
+      inverse_map[output_data[i]] = i;
+    }
+    for (int64_t i = 0; i < input.numel(); ++i) {
+      inverse_indices_data[i] = inverse_map[input_data[i]];
+    }
+  }
+  return std::make_tuple(output, inverse_indices);
+}
+
+template <typename F>
+double time_ms(F f, int iterations = 3) {
+  double best = 0;
+  for (int i = 0; i < iterations; ++i) {
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto end = std::chrono::steady_clock::now();
+    double ms = std::chrono::duration<double, std::milli>(end - start).count();
+    if (i == 0 || ms < best) {
+      best = ms;
+    }
+  }
+  return best;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+  int64_t numel = argc > 1 ? std::atoll(argv[1]) : 10000000;
+
+  std::cout << "numel = " << numel << std::endl;
+  std::cout << "cardinality\tsorted\tinverse\tunordered_set (ms)\t_unique (ms)"
+            << std::endl;
+  for (int64_t cardinality : {int64_t(16), int64_t(1) << 10, int64_t(1) << 16,
+                              int64_t(1) << 20, numel}) {
+    Tensor input = CPU(kLong).tensor({numel}).random_(0, cardinality);
+    for (bool sorted : {false, true}) {
+      for (bool return_inverse : {false, true}) {
+        double baseline = time_ms([&] {
+          unordered_set_unique(input, sorted, return_inverse);
+        });
+        double current = time_ms([&] {
+          at::_unique(input, sorted, return_inverse);
+        });
+        std::cout << cardinality << "\t" << sorted << "\t" << return_inverse
+                  << "\t" << baseline << "\t" << current << std::endl;
+      }
+    }
+  }
+  return 0;
+}
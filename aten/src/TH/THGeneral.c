@@ -159,6 +159,15 @@ void THSetGCHandler( void (*torchGCFunction_)(void *data), void *data )
   torchGCData = data;
 }
 
+/* Bytes requested from THAlloc and THRealloc by the calling thread, which
+ * profilers read around a region of code to attribute its allocations. */
+static __thread int64_t threadAllocatedBytes = 0;
+
+int64_t THGetThreadAllocatedBytes(void)
+{
+  return threadAllocatedBytes;
+}
+
 /* it is guaranteed the allocated size is not bigger than PTRDIFF_MAX */
 static ptrdiff_t getAllocSize(void *ptr) {
 #if defined(__unix) && defined(HAVE_MALLOC_USABLE_SIZE)
@@ -217,6 +226,7 @@ void* THAlloc(ptrdiff_t size)
   if(!ptr)
     THError("$ Torch: not enough memory: you tried to allocate %dGB. Buy new RAM!", size/1073741824);
 
+  threadAllocatedBytes += size;
   return ptr;
 }
 
@@ -244,6 +254,7 @@ void* THRealloc(void *ptr, ptrdiff_t size)
   if(!newptr)
     THError("$ Torch: not enough memory: you tried to reallocate %dGB. Buy new RAM!", size/1073741824);
 
+  threadAllocatedBytes += size;
   return newptr;
 }
 
@@ -79,6 +79,21 @@ SET(AVX2_CODE "
   }
 ")
 
+SET(AVX512_CODE "
+  #include <immintrin.h>
+
+  int main()
+  {
+    __m512i a = _mm512_set1_epi64(0);
+    __m512d b = _mm512_set1_pd(0);
+    a = _mm512_abs_epi64(a);
+    a = _mm512_mullo_epi64(a, a);
+    a = _mm512_abs_epi16(a);
+    b = _mm512_roundscale_pd(b, _MM_FROUND_TO_ZERO | _MM_FROUND_NO_EXC);
+    return 0;
+  }
+")
+
 MACRO(CHECK_SSE lang type flags)
   SET(__FLAG_I 1)
   SET(CMAKE_REQUIRED_FLAGS_SAVE ${CMAKE_REQUIRED_FLAGS})
@@ -123,3 +138,28 @@ CHECK_SSE(CXX "SSE4_1" " ;-msse4.1;-msse4;/arch:SSE4")
 CHECK_SSE(CXX "SSE4_2" " ;-msse4.2;-msse4;/arch:SSE4")
 CHECK_SSE(CXX "AVX" " ;-mavx;/arch:AVX")
 CHECK_SSE(CXX "AVX2" " ;-mavx2 -mfma;/arch:AVX2")
+
+# The AVX512 kernels are only run after checking the CPU at runtime, so the
+# compiler support is enough and the build machine itself doesn't need AVX512
+INCLUDE(CheckCXXSourceCompiles)
+IF(NOT DEFINED CXX_AVX512_FOUND)
+  SET(CMAKE_REQUIRED_FLAGS_SAVE ${CMAKE_REQUIRED_FLAGS})
+  FOREACH(__FLAG "-mavx512f -mavx512dq -mavx512bw -mavx512vl -mfma" "/arch:AVX512")
+    IF(NOT CXX_HAS_AVX512)
+      SET(CMAKE_REQUIRED_FLAGS ${__FLAG})
+      UNSET(CXX_HAS_AVX512 CACHE)
+      CHECK_CXX_SOURCE_COMPILES("${AVX512_CODE}" CXX_HAS_AVX512)
+      IF(CXX_HAS_AVX512)
+        SET(CXX_AVX512_FLAGS "${__FLAG}" CACHE STRING "CXX AVX512 flags")
+      ENDIF()
+    ENDIF()
+  ENDFOREACH()
+  SET(CMAKE_REQUIRED_FLAGS ${CMAKE_REQUIRED_FLAGS_SAVE})
+  IF(CXX_HAS_AVX512)
+    SET(CXX_AVX512_FOUND TRUE CACHE BOOL "CXX AVX512 support")
+  ELSE()
+    SET(CXX_AVX512_FOUND FALSE CACHE BOOL "CXX AVX512 support")
+    SET(CXX_AVX512_FLAGS "" CACHE STRING "CXX AVX512 flags")
+  ENDIF()
+  MARK_AS_ADVANCED(CXX_AVX512_FOUND CXX_AVX512_FLAGS)
+ENDIF()
@@ -11,6 +11,7 @@ $BUILD_ROOT/src/ATen/test/broadcast_test
 $BUILD_ROOT/src/ATen/test/wrapdim_test
 $BUILD_ROOT/src/ATen/test/dlconvertor_test
 $BUILD_ROOT/src/ATen/test/native_test
+$BUILD_ROOT/src/ATen/test/binary_ops_test
 $BUILD_ROOT/src/ATen/test/scalar_tensor_test
 $BUILD_ROOT/src/ATen/test/undefined_tensor_test
 if [[ -x $BUILD_ROOT/src/ATen/test/cudnn_test ]]; then
@@ -0,0 +1,111 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Compares the default TaskThreadPool against WorkStealingThreadPool when
+// running async_scheduling nets of cheap operators, where the cost is
+// dominated by scheduling overhead.
+
+#include <thread>
+
+#include "benchmark/benchmark.h"
+
+#include "caffe2/core/net.h"
+#include "caffe2/core/operator.h"
+#include "caffe2/core/workspace.h"
+
+using namespace caffe2;
+
+namespace {
+
+class BenchmarkNoOp final : public OperatorBase {
+ public:
+  using OperatorBase::OperatorBase;
+
+  bool Run(int /* unused */ /*stream_id*/) override {
+    return true;
+  }
+};
+
+REGISTER_CPU_OPERATOR(BenchmarkNoOp, BenchmarkNoOp);
+OPERATOR_SCHEMA(BenchmarkNoOp).NumInputs(0, INT_MAX).NumOutputs(0, INT_MAX);
+
+// Builds a net with `depth` layers of `width` ops, every op of a layer
+// depends on all ops of the previous layer; the first layer reads "in".
+NetDef LayeredNet(int depth, int width, bool work_stealing) {
+  NetDef net_def;
+  net_def.set_name("async_net_thread_pool_benchmark");
+  net_def.set_type("async_scheduling");
+  net_def.set_num_workers(std::thread::hardware_concurrency());
+  net_def.add_external_input("in");
+  auto* arg = net_def.add_arg();
+  arg->set_name("work_stealing");
+  arg->set_i(work_stealing);
+
+  std::vector<std::string> prev_outputs{"in"};
+  for (int d = 0; d < depth; ++d) {
+    std::vector<std::string> outputs;
+    for (int w = 0; w < width; ++w) {
+      auto* op = net_def.add_op();
+      op->set_type("BenchmarkNoOp");
+      for (const auto& input : prev_outputs) {
+        op->add_input(input);
+      }
+      outputs.push_back(
+          "out_" + caffe2::to_string(d) + "_" + caffe2::to_string(w));
+      op->add_output(outputs.back());
+    }
+    prev_outputs = outputs;
+  }
+  return net_def;
+}
+
+void RunLayeredNet(benchmark::State& state, int depth, int width) {
+  Workspace ws;
+  ws.CreateBlob("in");
+  auto net_def = LayeredNet(depth, width, state.range(0));
+  auto net = CreateNet(net_def, &ws);
+  CAFFE_ENFORCE(net);
+  while (state.KeepRunning()) {
+    CAFFE_ENFORCE(net->Run());
+  }
+  state.SetItemsProcessed(state.iterations() * depth * width);
+}
+
+} // namespace
+
+// Arg: 0 - TaskThreadPool, 1 - WorkStealingThreadPool
+
+static void BM_AsyncNetWide(benchmark::State& state) {
+  RunLayeredNet(state, 2, state.range(1));
+}
+BENCHMARK(BM_AsyncNetWide)
+    ->ArgPair(0, 64)
+    ->ArgPair(1, 64)
+    ->ArgPair(0, 512)
+    ->ArgPair(1, 512)
+    ->UseRealTime();
+
+static void BM_AsyncNetDeep(benchmark::State& state) {
+  RunLayeredNet(state, state.range(1), 4);
+}
+BENCHMARK(BM_AsyncNetDeep)
+    ->ArgPair(0, 64)
+    ->ArgPair(1, 64)
+    ->ArgPair(0, 512)
+    ->ArgPair(1, 512)
+    ->UseRealTime();
+
+BENCHMARK_MAIN()
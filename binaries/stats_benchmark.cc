@@ -0,0 +1,83 @@
+/**
+ * Copyright (c) 2016-present, Facebook, Inc.
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// Measures the cost of updating exported stats from many threads at once,
+// against a single shared atomic as the stats used to be.
+
+#include <atomic>
+
+#include "benchmark/benchmark.h"
+
+#include "caffe2/core/stats.h"
+
+using namespace caffe2;
+
+namespace {
+
+struct BenchmarkStats {
+  CAFFE_STAT_CTOR(BenchmarkStats);
+  CAFFE_EXPORTED_STAT(counter);
+  CAFFE_AVG_EXPORTED_STAT(avg);
+  CAFFE_HISTOGRAM_EXPORTED_STAT(histogram);
+};
+
+BenchmarkStats& stats() {
+  static BenchmarkStats stats("stats_benchmark");
+  return stats;
+}
+
+std::atomic<int64_t> sharedCounter{0};
+
+} // namespace
+
+static void BM_SharedAtomic(benchmark::State& state) {
+  while (state.KeepRunning()) {
+    benchmark::DoNotOptimize(sharedCounter.fetch_add(1));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SharedAtomic)->ThreadRange(1, 32);
+
+static void BM_ExportedStat(benchmark::State& state) {
+  auto& s = stats();
+  while (state.KeepRunning()) {
+    CAFFE_EVENT(s, counter);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_ExportedStat)->ThreadRange(1, 32);
+
+static void BM_AvgExportedStat(benchmark::State& state) {
+  auto& s = stats();
+  int64_t value = 0;
+  while (state.KeepRunning()) {
+    CAFFE_EVENT(s, avg, ++value);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_AvgExportedStat)->ThreadRange(1, 32);
+
+static void BM_HistogramExportedStat(benchmark::State& state) {
+  auto& s = stats();
+  int64_t value = 0;
+  while (state.KeepRunning()) {
+    CAFFE_EVENT(s, histogram, (++value & 4095));
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_HistogramExportedStat)->ThreadRange(1, 32);
+
+BENCHMARK_MAIN()
@@ -16,6 +16,17 @@ namespace db {
  */
 enum Mode { READ, WRITE, NEW };
 
+/**
+ * The bytes of a tensor that a database keeps outside of its serialized
+ * BlobProto, for example in a memory-mapped file. They stay valid as long as
+ * owner is alive, so that tensors can alias them instead of copying them.
+ */
+struct ExternalTensorData {
+  const void* data = nullptr;
+  size_t nbytes = 0;
+  std::shared_ptr<void> owner;
+};
+
 /**
  * An abstract class for the cursor of the database while reading.
  */
@@ -51,6 +62,18 @@ class Cursor {
    * reached the end of the database, return false.
    */
   virtual bool Valid() = 0;
+  /**
+   * If the current value is a tensor whose bytes are stored outside of the
+   * serialized proto, fills proto with everything but the tensor data and
+   * external with the bytes, and returns true. Otherwise returns false, and
+   * value() has to be parsed instead. This is optional for dbs, and in
+   * default no value has external data.
+   */
+  virtual bool ExternalTensorValue(
+      BlobProto* /*proto*/,
+      ExternalTensorData* /*external*/) {
+    return false;
+  }
 
   DISABLE_COPY_AND_ASSIGN(Cursor);
 };
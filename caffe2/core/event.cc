@@ -14,10 +14,20 @@ CAFFE2_API EventErrorMessageFunction
 CAFFE2_API EventSetFinishedFunction
     Event::event_finished_setter_[MaxDeviceTypes];
 CAFFE2_API EventResetFunction Event::event_resetter_[MaxDeviceTypes];
+CAFFE2_API EventSetCallbackFunction
+    Event::event_callback_setter_[MaxDeviceTypes];
 
 namespace {
 const std::string kNoError = "No error";
+
+// Runs callbacks taken from the wrapper, expected to be called without
+// holding the wrapper's mutex
+void RunCallbacksCPU(std::vector<EventCallbackFunction>& callbacks) {
+  for (auto& callback : callbacks) {
+    callback();
+  }
 }
+} // namespace
 
 void EventCreateCPU(const DeviceOption& option, Event* event) {
   event->event_ = std::make_shared<CPUEventWrapper>(option);
@@ -28,6 +38,7 @@ void EventRecordCPU(
     const void* /* unused */,
     const char* err_msg) {
   auto* wrapper = static_cast<CPUEventWrapper*>(event->event_.get());
+  std::vector<EventCallbackFunction> callbacks;
   std::unique_lock<std::mutex> lock(wrapper->mutex_);
 
   // Possible state changes:
@@ -48,8 +59,11 @@ void EventRecordCPU(
       wrapper->err_msg_ = err_msg;
       wrapper->status_ = EventStatus::EVENT_FAILED;
       wrapper->cv_completed_.notify_all();
+      callbacks.swap(wrapper->callbacks_);
     }
   }
+  lock.unlock();
+  RunCallbacksCPU(callbacks);
 }
 
 void EventFinishCPU(const Event* event) {
@@ -83,6 +97,7 @@ const std::string& EventErrorMessageCPU(const Event* event) {
 
 void EventSetFinishedCPU(const Event* event, const char* err_msg) {
   auto* wrapper = static_cast<CPUEventWrapper*>(event->event_.get());
+  std::vector<EventCallbackFunction> callbacks;
   std::unique_lock<std::mutex> lock(wrapper->mutex_);
 
   CAFFE_ENFORCE(
@@ -97,6 +112,9 @@ void EventSetFinishedCPU(const Event* event, const char* err_msg) {
     wrapper->status_ = EventStatus::EVENT_FAILED;
   }
   wrapper->cv_completed_.notify_all();
+  callbacks.swap(wrapper->callbacks_);
+  lock.unlock();
+  RunCallbacksCPU(callbacks);
 }
 
 void EventResetCPU(Event* event) {
@@ -104,6 +122,19 @@ void EventResetCPU(Event* event) {
   std::unique_lock<std::mutex> lock(wrapper->mutex_);
   wrapper->status_ = EventStatus::EVENT_INITIALIZED;
   wrapper->err_msg_ = "";
+  wrapper->callbacks_.clear();
+}
+
+void EventSetCallbackCPU(Event* event, EventCallbackFunction callback) {
+  auto* wrapper = static_cast<CPUEventWrapper*>(event->event_.get());
+  std::unique_lock<std::mutex> lock(wrapper->mutex_);
+  if (wrapper->status_ == EventStatus::EVENT_SUCCESS ||
+      wrapper->status_ == EventStatus::EVENT_FAILED) {
+    lock.unlock();
+    callback();
+  } else {
+    wrapper->callbacks_.push_back(callback);
+  }
 }
 
 REGISTER_EVENT_CREATE_FUNCTION(CPU, EventCreateCPU);
@@ -115,5 +146,6 @@ REGISTER_EVENT_QUERY_FUNCTION(CPU, EventQueryCPU);
 REGISTER_EVENT_ERROR_MESSAGE_FUNCTION(CPU, EventErrorMessageCPU);
 REGISTER_EVENT_SET_FINISHED_FUNCTION(CPU, EventSetFinishedCPU);
 REGISTER_EVENT_RESET_FUNCTION(CPU, EventResetCPU);
+REGISTER_EVENT_SET_CALLBACK_FUNCTION(CPU, EventSetCallbackCPU);
 
 } // namespace caffe2
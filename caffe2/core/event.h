@@ -47,6 +47,12 @@ typedef const std::string& (*EventErrorMessageFunction)(const Event*);
 typedef void (*EventSetFinishedFunction)(const Event*, const char*);
 typedef void (*EventResetFunction)(Event*);
 
+// Sets callback that is called when event is finished (SUCCESS or FAILED
+// status), callback is called immediately if event is already finished.
+// Callbacks are cleared by Reset
+typedef std::function<void()> EventCallbackFunction;
+typedef void (*EventSetCallbackFunction)(Event*, EventCallbackFunction);
+
 class Event {
  public:
   explicit Event(const DeviceOption& option)
@@ -116,6 +122,16 @@ class Event {
     return event_finished_setter_[type_](this, err_msg);
   }
 
+  bool SupportsCallback() const {
+    return event_callback_setter_[type_] != nullptr;
+  }
+
+  void SetCallback(EventCallbackFunction callback) {
+    CAFFE_ENFORCE(
+        event_callback_setter_[type_], "Event does not support callbacks");
+    event_callback_setter_[type_](this, callback);
+  }
+
   // If parent op has succeeded, then we can run any child op;
   // If parent op is in scheduled state, we need to check that:
   //  - child op supports async scheduling
@@ -168,6 +184,8 @@ class Event {
   CAFFE2_API static EventSetFinishedFunction
       event_finished_setter_[MaxDeviceTypes];
   CAFFE2_API static EventResetFunction event_resetter_[MaxDeviceTypes];
+  CAFFE2_API static EventSetCallbackFunction
+      event_callback_setter_[MaxDeviceTypes];
 
   template <int d>
   friend struct EventCreateFunctionRegisterer;
@@ -186,6 +204,8 @@ class Event {
   friend struct EventSetFinishedFunctionRegisterer;
   template <int d>
   friend struct EventResetFunctionRegisterer;
+  template <int d>
+  friend struct EventSetCallbackFunctionRegisterer;
 };
 
 template <int d>
@@ -285,6 +305,18 @@ struct EventResetFunctionRegisterer {
   static EventResetFunctionRegisterer<d> g_event_reset_##d(f); \
   }
 
+template <int d>
+struct EventSetCallbackFunctionRegisterer {
+  explicit EventSetCallbackFunctionRegisterer(EventSetCallbackFunction f) {
+    static_assert(d < MaxDeviceTypes, "");
+    Event::event_callback_setter_[d] = f;
+  }
+};
+#define REGISTER_EVENT_SET_CALLBACK_FUNCTION(d, f)                          \
+  namespace {                                                               \
+  static EventSetCallbackFunctionRegisterer<d> g_event_set_callback_##d(f); \
+  }
+
 } // namespace caffe2
 
 #endif // CAFFE2_CORE_EVENT_H_
@@ -18,6 +18,7 @@ struct CPUEventWrapper {
   std::condition_variable cv_completed_;
   std::atomic<int> status_;
   std::string err_msg_;
+  std::vector<EventCallbackFunction> callbacks_;
 };
 
 void EventCreateCPU(const DeviceOption& option, Event* event);
@@ -41,4 +42,6 @@ bool EventCanScheduleCPU(const Event*, const Event*);
 
 void EventResetCPU(Event*);
 
+void EventSetCallbackCPU(Event*, EventCallbackFunction);
+
 } // namespace caffe2
@@ -22,4 +22,30 @@ TEST(EventCPUTest, EventBasics) {
   event.Wait(CPU, &context);
 }
 
+TEST(EventCPUTest, EventCallbacks) {
+  DeviceOption device_option;
+  device_option.set_device_type(CPU);
+  Event event(device_option);
+  CPUContext context;
+  ASSERT_TRUE(event.SupportsCallback());
+
+  int num_calls = 0;
+  context.Record(&event);
+  event.SetCallback([&num_calls]() { ++num_calls; });
+  ASSERT_EQ(num_calls, 0);
+  event.SetFinished();
+  ASSERT_EQ(num_calls, 1);
+
+  // Callback on a finished event is called immediately
+  event.SetCallback([&num_calls]() { ++num_calls; });
+  ASSERT_EQ(num_calls, 2);
+
+  // Reset drops pending callbacks
+  event.Reset();
+  event.SetCallback([&num_calls]() { ++num_calls; });
+  event.Reset();
+  event.SetFinished("error");
+  ASSERT_EQ(num_calls, 2);
+}
+
 } // namespace caffe2
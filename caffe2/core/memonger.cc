@@ -1,8 +1,12 @@
 #include "caffe2/core/memonger.h"
 
+#include <algorithm>
 #include <set>
 #include <unordered_set>
 
+#include "caffe2/core/context.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/types.h"
 #include "caffe2/utils/proto_utils.h"
 
 namespace caffe2 {
@@ -589,5 +593,215 @@ NetDef compute_blob_recycling_for_dag(
       blob_shapes);
 }
 
+namespace {
+
+// Slices are aligned like the allocations of CPUContext
+constexpr size_t kArenaAlignment = 64;
+
+size_t align_arena_offset(size_t nbytes) {
+  return (nbytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+}
+
+// Ops without a device option run on the device of the net
+bool is_cpu_op(const NetDef& net, const OperatorDef& op) {
+  const auto& device_option =
+      op.has_device_option() ? op.device_option() : net.device_option();
+  return device_option.device_type() == CPU;
+}
+
+} // namespace
+
+ArenaPlan plan_inference_arena(
+    const NetDef& net,
+    const std::set<string>& static_blobs,
+    const TensorShapes& shapes) {
+  ArenaPlan plan;
+  if (net.type() != "" && net.type() != "simple") {
+    LOG(INFO) << "Cannot plan memory for nets of type: " << net.type();
+    return plan;
+  }
+
+  std::set<string> excluded(static_blobs.begin(), static_blobs.end());
+  excluded.insert(net.external_input().begin(), net.external_input().end());
+  excluded.insert(net.external_output().begin(), net.external_output().end());
+
+  // Step 1: lifetime of each blob, from its first output to its last use.
+  // Blobs used by a non CPU op are left alone.
+  std::map<string, std::pair<int, int>> ranges;
+  std::set<string> non_cpu_blobs;
+  for (int i = 0; i < net.op_size(); i++) {
+    const auto& op = net.op(i);
+    if (op.type() == "RecurrentNetwork") {
+      LOG(INFO) << "Arena planning does not support RecurrentNetwork yet";
+      return ArenaPlan();
+    }
+    for (auto& inp : op.input()) {
+      auto rit = ranges.find(inp);
+      if (rit != ranges.end()) {
+        rit->second.second = i;
+      }
+    }
+    for (auto& outp : op.output()) {
+      if (excluded.count(outp)) {
+        continue;
+      }
+      auto rit = ranges.find(outp);
+      if (rit == ranges.end()) {
+        ranges[outp] = std::make_pair(i, i);
+      } else {
+        rit->second.second = i;
+      }
+    }
+    if (!is_cpu_op(net, op)) {
+      non_cpu_blobs.insert(op.input().begin(), op.input().end());
+      non_cpu_blobs.insert(op.output().begin(), op.output().end());
+    }
+  }
+
+  // Step 2: size of each blob, from the inferred shapes
+  std::vector<std::pair<string, ArenaSlice>> blobs;
+  for (const auto& shape : shapes.shapes()) {
+    auto rit = ranges.find(shape.name());
+    if (rit == ranges.end() || non_cpu_blobs.count(shape.name()) ||
+        shape.unknown_shape() || shape.unknown_dims_size() > 0 ||
+        shape.data_type() == TensorProto_DataType_UNDEFINED) {
+      continue;
+    }
+    const auto& meta = DataTypeToTypeMeta(shape.data_type());
+    if (meta.ctor() != nullptr || meta.itemsize() == 0) {
+      continue;
+    }
+    ArenaSlice slice;
+    slice.offset = 0;
+    slice.first_op = rit->second.first;
+    slice.last_op = rit->second.second;
+    slice.dims.assign(shape.dims().begin(), shape.dims().end());
+    slice.data_type = shape.data_type();
+    size_t size = 1;
+    for (auto d : slice.dims) {
+      size *= d;
+    }
+    slice.nbytes = align_arena_offset(size * meta.itemsize());
+    if (slice.nbytes == 0) {
+      continue;
+    }
+    blobs.emplace_back(shape.name(), slice);
+  }
+
+  // Step 3: place the blobs from the largest, each at the smallest gap
+  // between the already placed blobs it overlaps with that fits it
+  std::stable_sort(
+      blobs.begin(),
+      blobs.end(),
+      [](const std::pair<string, ArenaSlice>& a,
+         const std::pair<string, ArenaSlice>& b) {
+        if (a.second.nbytes != b.second.nbytes) {
+          return a.second.nbytes > b.second.nbytes;
+        }
+        return a.second.first_op < b.second.first_op;
+      });
+  std::vector<const ArenaSlice*> placed;
+  for (auto& blob : blobs) {
+    auto& slice = blob.second;
+    std::vector<std::pair<size_t, size_t>> taken;
+    for (const auto* other : placed) {
+      if (other->first_op <= slice.last_op &&
+          slice.first_op <= other->last_op) {
+        taken.emplace_back(other->offset, other->offset + other->nbytes);
+      }
+    }
+    std::sort(taken.begin(), taken.end());
+    size_t best_offset = 0;
+    size_t best_gap = 0;
+    bool found = false;
+    size_t end = 0;
+    for (const auto& range : taken) {
+      if (range.first >= end + slice.nbytes) {
+        size_t gap = range.first - end;
+        if (!found || gap < best_gap) {
+          best_offset = end;
+          best_gap = gap;
+          found = true;
+        }
+      }
+      end = std::max(end, range.second);
+    }
+    slice.offset = found ? best_offset : end;
+    plan.arena_nbytes =
+        std::max(plan.arena_nbytes, slice.offset + slice.nbytes);
+    plan.unshared_nbytes += slice.nbytes;
+    placed.push_back(&slice);
+  }
+
+  std::vector<size_t> live_nbytes(net.op_size(), 0);
+  for (const auto& blob : blobs) {
+    for (int i = blob.second.first_op; i <= blob.second.last_op; i++) {
+      live_nbytes[i] += blob.second.nbytes;
+    }
+    plan.slices.insert(blob);
+  }
+  for (auto nbytes : live_nbytes) {
+    plan.min_nbytes = std::max(plan.min_nbytes, nbytes);
+  }
+
+  LOG(INFO) << "planned " << plan.slices.size() << " blobs in an arena of "
+            << plan.arena_nbytes << " bytes (lower bound "
+            << plan.min_nbytes << ", unshared " << plan.unshared_nbytes
+            << ")";
+  return plan;
+}
+
+string ArenaReport::DebugString() const {
+  std::stringstream ss;
+  ss << "planned peak memory: " << planned_nbytes
+     << " bytes, actual: " << actual_nbytes << " bytes, " << bound_blobs
+     << " blobs in the arena, " << unbound_blobs << " out of it";
+  return ss.str();
+}
+
+InferenceArena::InferenceArena(const ArenaPlan& plan) : plan_(plan) {
+  if (plan_.arena_nbytes > 0) {
+    auto ptr_and_deleter = CPUContext::New(plan_.arena_nbytes);
+    data_.reset(ptr_and_deleter.first, ptr_and_deleter.second);
+  }
+}
+
+void InferenceArena::bind(Workspace* ws) const {
+  auto data = data_;
+  for (const auto& it : plan_.slices) {
+    const auto& slice = it.second;
+    auto* tensor = ws->CreateBlob(it.first)->GetMutable<TensorCPU>();
+    tensor->Resize(slice.dims);
+    tensor->ShareExternalPointer(
+        static_cast<char*>(data_.get()) + slice.offset,
+        DataTypeToTypeMeta(slice.data_type),
+        slice.nbytes,
+        [data](void* /* unused */) {});
+  }
+}
+
+ArenaReport InferenceArena::report(Workspace* ws) const {
+  ArenaReport report;
+  report.planned_nbytes = plan_.arena_nbytes;
+  report.actual_nbytes = plan_.arena_nbytes;
+  for (const auto& it : plan_.slices) {
+    const auto* blob = ws->GetBlob(it.first);
+    if (!blob || !blob->IsType<TensorCPU>()) {
+      report.unbound_blobs++;
+      continue;
+    }
+    const auto& tensor = blob->Get<TensorCPU>();
+    const char* expected = static_cast<const char*>(data_.get()) +
+        it.second.offset;
+    if (tensor.capacity_nbytes() > 0 && tensor.raw_data() == expected) {
+      report.bound_blobs++;
+    } else {
+      report.unbound_blobs++;
+      report.actual_nbytes += tensor.capacity_nbytes();
+    }
+  }
+  return report;
+}
+
 } // memonger
 } // caffe2
@@ -1,6 +1,9 @@
 #ifndef CAFFE2_CORE_MEMONGER_H_
 #define CAFFE2_CORE_MEMONGER_H_
 
+#include <map>
+#include <memory>
+#include <set>
 #include <unordered_set>
 
 #include "caffe2/core/common.h"
@@ -23,6 +26,73 @@ NetDef compute_blob_recycling_for_dag(
     const std::unordered_set<string>& dont_share_blob_names,
     const std::unordered_map<string, vector<int>>& blob_shapes);
 
+// Where a blob lives in the arena of an inference net, and between which ops
+struct ArenaSlice {
+  size_t offset;
+  size_t nbytes;
+  int first_op;
+  int last_op;
+  vector<TIndex> dims;
+  TensorProto::DataType data_type;
+};
+
+struct ArenaPlan {
+  std::map<string, ArenaSlice> slices;
+  // Size of the arena, i.e. the planned peak memory of the planned blobs
+  size_t arena_nbytes = 0;
+  // Largest total size of the blobs alive at the same op, below which no
+  // plan can go
+  size_t min_nbytes = 0;
+  // Total size of the blobs if each of them has its own buffer
+  size_t unshared_nbytes = 0;
+};
+
+// Plans the intermediate blobs of a simple net in a single arena. Each blob
+// lives from the first op that outputs it to the last op that uses it, and
+// two blobs whose lifetimes overlap get disjoint slices. Blobs are placed
+// from the largest down, each in the smallest gap left by the blobs it
+// overlaps with.
+//
+// Only CPU tensors of known shape and fundamental type are planned, and not
+// the external inputs and outputs of the net nor static_blobs.
+ArenaPlan plan_inference_arena(
+    const NetDef& net,
+    const std::set<string>& static_blobs,
+    const TensorShapes& shapes);
+
+struct ArenaReport {
+  size_t planned_nbytes = 0;
+  // Arena plus the memory of planned blobs that left it, e.g. because an op
+  // resized them beyond their slice
+  size_t actual_nbytes = 0;
+  int bound_blobs = 0;
+  int unbound_blobs = 0;
+
+  string DebugString() const;
+};
+
+// The memory of an ArenaPlan. bind() shares its slices with the tensors of
+// the planned blobs before the net first runs, so that the ops write their
+// outputs in place instead of allocating them. The memory stays alive as
+// long as the arena or any of these tensors do.
+class InferenceArena {
+ public:
+  explicit InferenceArena(const ArenaPlan& plan);
+
+  void bind(Workspace* ws) const;
+
+  // Compares the plan with where the blobs of ws actually are
+  ArenaReport report(Workspace* ws) const;
+
+  const ArenaPlan& plan() const {
+    return plan_;
+  }
+
+ private:
+  ArenaPlan plan_;
+  std::shared_ptr<void> data_;
+};
+
 } // memonger
 } // caffe2
 
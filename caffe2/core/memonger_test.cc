@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cmath>
+
+#include <gtest/gtest.h>
+#include "caffe2/core/memonger.h"
+
+namespace caffe2 {
+
+namespace {
+
+// X -> A -> B -> C -> Y, where A and C are never alive at the same time
+NetDef ChainNet() {
+  NetDef net;
+  net.add_external_input("X");
+  net.add_external_output("Y");
+  const char* blobs[] = {"X", "A", "B", "C", "Y"};
+  for (int i = 0; i < 4; ++i) {
+    auto* op = net.add_op();
+    op->set_type("Relu");
+    op->add_input(blobs[i]);
+    op->add_output(blobs[i + 1]);
+  }
+  return net;
+}
+
+TensorShapes ChainShapes() {
+  TensorShapes shapes;
+  for (const char* name : {"X", "A", "B", "C", "Y"}) {
+    auto* shape = shapes.add_shapes();
+    shape->set_name(name);
+    shape->add_dims(10);
+    shape->add_dims(100);
+    shape->set_data_type(TensorProto_DataType_FLOAT);
+  }
+  return shapes;
+}
+
+// X -> A -> B -> C, Y = A + C, where A is alive while B and C are computed
+NetDef DiamondNet() {
+  NetDef net;
+  net.add_external_input("X");
+  net.add_external_output("Y");
+  const char* ops[][3] = {{"Relu", "X", "A"},
+                          {"Sigmoid", "A", "B"},
+                          {"Relu", "B", "C"}};
+  for (const auto& def : ops) {
+    auto* op = net.add_op();
+    op->set_type(def[0]);
+    op->add_input(def[1]);
+    op->add_output(def[2]);
+  }
+  auto* add = net.add_op();
+  add->set_type("Add");
+  add->add_input("A");
+  add->add_input("C");
+  add->add_output("Y");
+  return net;
+}
+
+} // namespace
+
+TEST(MemongerArenaTest, PlansDisjointLifetimesInPlace) {
+  auto plan = memonger::plan_inference_arena(ChainNet(), {}, ChainShapes());
+  // The external input and output are not planned
+  EXPECT_EQ(plan.slices.size(), 3);
+  const auto& a = plan.slices.at("A");
+  const auto& b = plan.slices.at("B");
+  const auto& c = plan.slices.at("C");
+  EXPECT_EQ(a.nbytes, 4032);
+  EXPECT_EQ(a.first_op, 0);
+  EXPECT_EQ(a.last_op, 1);
+  EXPECT_EQ(a.offset, c.offset);
+  EXPECT_NE(a.offset, b.offset);
+  EXPECT_EQ(plan.arena_nbytes, 2 * 4032);
+  EXPECT_EQ(plan.min_nbytes, 2 * 4032);
+  EXPECT_EQ(plan.unshared_nbytes, 3 * 4032);
+}
+
+TEST(MemongerArenaTest, SkipsStaticAndUnknownBlobs) {
+  auto shapes = ChainShapes();
+  shapes.mutable_shapes(3)->set_unknown_shape(true);
+  auto plan = memonger::plan_inference_arena(ChainNet(), {"A"}, shapes);
+  EXPECT_EQ(plan.slices.size(), 1);
+  EXPECT_EQ(plan.slices.count("B"), 1);
+  EXPECT_EQ(plan.arena_nbytes, 4032);
+}
+
+TEST(MemongerArenaTest, BindsTensorsToTheArena) {
+  auto plan = memonger::plan_inference_arena(ChainNet(), {}, ChainShapes());
+  Workspace ws;
+  {
+    memonger::InferenceArena arena(plan);
+    arena.bind(&ws);
+    auto report = arena.report(&ws);
+    EXPECT_EQ(report.bound_blobs, 3);
+    EXPECT_EQ(report.unbound_blobs, 0);
+    EXPECT_EQ(report.actual_nbytes, report.planned_nbytes);
+
+    auto* a = ws.GetBlob("A")->GetMutable<TensorCPU>();
+    auto* c = ws.GetBlob("C")->GetMutable<TensorCPU>();
+    EXPECT_EQ(a->dims(), std::vector<TIndex>({10, 100}));
+    EXPECT_EQ(a->mutable_data<float>(), c->mutable_data<float>());
+
+    // Growing a tensor beyond its slice moves it out of the arena
+    auto* b = ws.GetBlob("B")->GetMutable<TensorCPU>();
+    b->Resize(20, 100);
+    b->mutable_data<float>();
+    report = arena.report(&ws);
+    EXPECT_EQ(report.bound_blobs, 2);
+    EXPECT_EQ(report.unbound_blobs, 1);
+    EXPECT_EQ(report.actual_nbytes, report.planned_nbytes + 8000);
+  }
+  // The tensors keep the arena alive
+  auto* a = ws.GetBlob("A")->GetMutable<TensorCPU>();
+  a->mutable_data<float>()[999] = 1.0f;
+}
+
+TEST(MemongerArenaTest, SkipsOpsOnTheDeviceOfTheNet) {
+  auto net = ChainNet();
+  net.mutable_device_option()->set_device_type(CUDA);
+  auto plan = memonger::plan_inference_arena(net, {}, ChainShapes());
+  EXPECT_EQ(plan.slices.size(), 0);
+  // An op can still run on CPU in a CUDA net
+  for (int i = 0; i < net.op_size(); ++i) {
+    net.mutable_op(i)->mutable_device_option()->set_device_type(CPU);
+  }
+  plan = memonger::plan_inference_arena(net, {}, ChainShapes());
+  EXPECT_EQ(plan.slices.size(), 3);
+}
+
+TEST(MemongerArenaTest, RunsNetInTheArena) {
+  auto net = DiamondNet();
+  auto plan = memonger::plan_inference_arena(net, {}, ChainShapes());
+  EXPECT_EQ(plan.slices.size(), 3);
+  EXPECT_NE(plan.slices.at("A").offset, plan.slices.at("B").offset);
+  EXPECT_NE(plan.slices.at("A").offset, plan.slices.at("C").offset);
+
+  Workspace ws;
+  auto* x = ws.CreateBlob("X")->GetMutable<TensorCPU>();
+  x->Resize(10, 100);
+  for (int i = 0; i < x->size(); ++i) {
+    x->mutable_data<float>()[i] = (i - 500) / 100.0f;
+  }
+  memonger::InferenceArena arena(plan);
+  arena.bind(&ws);
+  ASSERT_TRUE(ws.RunNetOnce(net));
+
+  auto report = arena.report(&ws);
+  EXPECT_EQ(report.bound_blobs, 3);
+  EXPECT_EQ(report.unbound_blobs, 0);
+  const auto& y = ws.GetBlob("Y")->Get<TensorCPU>();
+  EXPECT_EQ(y.dims(), std::vector<TIndex>({10, 100}));
+  for (int i = 0; i < y.size(); ++i) {
+    float a = std::max(x->data<float>()[i], 0.0f);
+    float c = 1.0f / (1.0f + std::exp(-a));
+    EXPECT_NEAR(y.data<float>()[i], a + c, 1e-5);
+  }
+}
+
+} // namespace caffe2
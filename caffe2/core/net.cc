@@ -126,7 +126,7 @@ unique_ptr<NetBase> CreateNet(
   return net;
 }
 
-std::shared_ptr<TaskThreadPool> ExecutorHelper::GetPool(
+std::shared_ptr<TaskThreadPoolBase> ExecutorHelper::GetPool(
     const DeviceOption& /* unused */) const {
   CAFFE_THROW("Not implemented");
 }
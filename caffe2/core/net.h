@@ -127,7 +127,7 @@ class NetBase : public Observable<NetBase> {
 class ExecutorHelper {
  public:
   ExecutorHelper() {}
-  virtual std::shared_ptr<TaskThreadPool> GetPool(
+  virtual std::shared_ptr<TaskThreadPoolBase> GetPool(
       const DeviceOption& option) const;
   virtual ~ExecutorHelper() {}
 };
@@ -49,6 +49,12 @@ CAFFE2_DEFINE_string(
 
 CAFFE2_DEFINE_int(caffe2_net_async_tracing_nth, 100, "Trace every Nth batch");
 
+CAFFE2_DEFINE_bool(
+    caffe2_net_async_work_stealing,
+    false,
+    "Use work-stealing CPU thread pool by default "
+    "(overridden by net's work_stealing argument)");
+
 namespace caffe2 {
 
 thread_local std::vector<int> AsyncNetBase::stream_counters_;
@@ -80,6 +86,8 @@ AsyncNetBase::AsyncNetBase(
   }
 
   num_workers_ = net_def->has_num_workers() ? net_def->num_workers() : -1;
+  use_work_stealing_ = ArgumentHelper::GetSingleArgument<NetDef, bool>(
+      *net_def, "work_stealing", FLAGS_caffe2_net_async_work_stealing);
   batch_iter_ = 0;
 
   initTracer(net_def);
@@ -110,22 +118,21 @@ bool AsyncNetBase::RunAsync() {
   return DoRunAsync();
 }
 
-std::shared_ptr<TaskThreadPool> AsyncNetBase::pool_getter(
+std::shared_ptr<TaskThreadPoolBase> AsyncNetBase::pool_getter(
     PoolsMap& pools,
-    int device_type,
+    const std::string& pool_type,
     int device_id,
     int pool_size) {
   std::unique_lock<std::mutex> pools_lock(pools_mutex_);
   auto pool = pools[device_id][pool_size];
   if (!pool) {
-    pool = ThreadPoolRegistry()->Create(
-        DeviceTypeName(device_type), device_id, pool_size);
+    pool = ThreadPoolRegistry()->Create(pool_type, device_id, pool_size);
     pools[device_id][pool_size] = pool;
   }
   return pool;
 }
 
-std::shared_ptr<TaskThreadPool> AsyncNetBase::pool(
+std::shared_ptr<TaskThreadPoolBase> AsyncNetBase::pool(
     const DeviceOption& device_option) {
   if (device_option.device_type() == CPU) {
     auto numa_node_id = device_option.numa_node_id();
@@ -133,13 +140,17 @@ std::shared_ptr<TaskThreadPool> AsyncNetBase::pool(
         numa_node_id >= -1 &&
             numa_node_id < FLAGS_caffe2_net_async_max_numa_nodes,
         "Invalid NUMA node id: " + caffe2::to_string(numa_node_id));
-    return pool_getter(cpu_pools_, CPU, numa_node_id, num_workers_);
+    return pool_getter(
+        cpu_pools_,
+        use_work_stealing_ ? "CPU_WORK_STEALING" : DeviceTypeName(CPU),
+        numa_node_id,
+        num_workers_);
   } else if (device_option.device_type() == CUDA) {
     auto gpu_id = device_option.cuda_gpu_id();
     CAFFE_ENFORCE(
         gpu_id >= 0 && gpu_id < FLAGS_caffe2_net_async_max_gpus,
         "Invalid GPU id: " + caffe2::to_string(gpu_id));
-    return pool_getter(gpu_pools_, CUDA, gpu_id, num_workers_);
+    return pool_getter(gpu_pools_, DeviceTypeName(CUDA), gpu_id, num_workers_);
   } else {
     CAFFE_THROW(
         "Unsupported device type " +
@@ -196,6 +207,14 @@ bool AsyncNetBase::canSchedule(
   return true;
 }
 
+bool AsyncNetBase::canSchedule(int parent_id, int child_id) {
+  auto& parent_event = event(parent_id);
+  auto first_child_op_id = chains_[child_id].front();
+  auto* first_child_op = operators_[first_child_op_id];
+  return parent_event.CanSchedule(
+      first_child_op->event(), first_child_op->SupportsAsyncScheduling());
+}
+
 int AsyncNetBase::tasksNum() const {
   return chains_.size();
 }
@@ -290,22 +309,21 @@ void AsyncNetBase::finalizeEvents() {
 
 AsyncNetBase::~AsyncNetBase() {}
 
-CAFFE_DEFINE_SHARED_REGISTRY(ThreadPoolRegistry, TaskThreadPool, int, int);
+CAFFE_DEFINE_SHARED_REGISTRY(
+    ThreadPoolRegistry,
+    TaskThreadPoolBase,
+    int,
+    int);
 
 CAFFE_REGISTER_CREATOR(ThreadPoolRegistry, CPU, GetAsyncNetCPUThreadPool);
+CAFFE_REGISTER_CREATOR(
+    ThreadPoolRegistry,
+    CPU_WORK_STEALING,
+    GetAsyncNetCPUWorkStealingThreadPool);
 
-/* static */
-std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
-    int numa_node_id,
-    int pool_size) {
-  // Note: numa_node_id = -1 (DeviceOption's default value) corresponds to
-  // no NUMA used
-  static std::
-      unordered_map<int, std::unordered_map<int, std::weak_ptr<TaskThreadPool>>>
-          pools;
-  static std::mutex pool_mutex;
-  std::lock_guard<std::mutex> lock(pool_mutex);
+namespace {
 
+int GetCPUPoolSize(int numa_node_id, int pool_size) {
   if (pool_size <= 0) {
     if (FLAGS_caffe2_net_async_cpu_pool_size > 0) {
       pool_size = FLAGS_caffe2_net_async_cpu_pool_size;
@@ -322,15 +340,51 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
     LOG(INFO) << "Using specified CPU pool size: " << pool_size
               << "; NUMA node id: " << numa_node_id;
   }
+  return pool_size;
+}
+
+// Returns a CPU pool of type PoolType shared between all nets that use the
+// same (NUMA node, pool size) pair
+template <typename PoolType>
+std::shared_ptr<TaskThreadPoolBase> GetSharedCPUThreadPool(
+    int numa_node_id,
+    int pool_size) {
+  // Note: numa_node_id = -1 (DeviceOption's default value) corresponds to
+  // no NUMA used
+  static std::unordered_map<
+      int,
+      std::unordered_map<int, std::weak_ptr<TaskThreadPoolBase>>>
+      pools;
+  static std::mutex pool_mutex;
+  std::lock_guard<std::mutex> lock(pool_mutex);
+
+  pool_size = GetCPUPoolSize(numa_node_id, pool_size);
 
   auto shared_pool = pools[numa_node_id][pool_size].lock();
   if (!shared_pool) {
     LOG(INFO) << "Created CPU pool, size: " << pool_size
               << "; NUMA node id: " << numa_node_id;
-    shared_pool = std::make_shared<TaskThreadPool>(pool_size, numa_node_id);
+    shared_pool = std::make_shared<PoolType>(pool_size, numa_node_id);
     pools[numa_node_id][pool_size] = shared_pool;
   }
   return shared_pool;
 }
 
+} // namespace
+
+/* static */
+std::shared_ptr<TaskThreadPoolBase> GetAsyncNetCPUThreadPool(
+    int numa_node_id,
+    int pool_size) {
+  return GetSharedCPUThreadPool<TaskThreadPool>(numa_node_id, pool_size);
+}
+
+/* static */
+std::shared_ptr<TaskThreadPoolBase> GetAsyncNetCPUWorkStealingThreadPool(
+    int numa_node_id,
+    int pool_size) {
+  return GetSharedCPUThreadPool<WorkStealingThreadPool>(
+      numa_node_id, pool_size);
+}
+
 } // namespace caffe2
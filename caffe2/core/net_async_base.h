@@ -12,6 +12,7 @@
 #include "caffe2/proto/caffe2.pb.h"
 #include "caffe2/utils/proto_utils.h"
 #include "caffe2/utils/thread_pool.h"
+#include "caffe2/utils/work_stealing_thread_pool.h"
 
 namespace caffe2 {
 
@@ -40,6 +41,7 @@ class AsyncNetBase : public NetBase {
   bool canSchedule(
       int chain_id,
       const std::vector<EventStatus>* status = nullptr);
+  bool canSchedule(int parent_id, int child_id);
 
   int tasksNum() const;
   Event& event(int task_id) const;
@@ -53,7 +55,7 @@ class AsyncNetBase : public NetBase {
       const std::vector<int>& wait_task_ids) const;
   void run(int task_id, int stream_id);
   int stream(int task_id);
-  std::shared_ptr<TaskThreadPool> pool(const DeviceOption& device_option);
+  std::shared_ptr<TaskThreadPoolBase> pool(const DeviceOption& device_option);
 
   void finishTasks(const std::unordered_set<int>& task_ids);
   void finalizeEvents();
@@ -71,12 +73,13 @@ class AsyncNetBase : public NetBase {
   // first int key - device id, second - pool size, one pool per (device, size)
   typedef std::unordered_map<
       int,
-      std::unordered_map<int, std::shared_ptr<TaskThreadPool>>>
+      std::unordered_map<int, std::shared_ptr<TaskThreadPoolBase>>>
       PoolsMap;
   PoolsMap cpu_pools_;
   PoolsMap gpu_pools_;
   static thread_local std::vector<int> stream_counters_;
   int num_workers_;
+  bool use_work_stealing_;
 
   // Tracing
   void initTracer(const std::shared_ptr<const NetDef>& net_def);
@@ -91,8 +94,11 @@ class AsyncNetBase : public NetBase {
  private:
   OperatorBase* op(int op_idx) const;
 
-  std::shared_ptr<TaskThreadPool>
-  pool_getter(PoolsMap& pools, int device_type, int device_id, int pool_size);
+  std::shared_ptr<TaskThreadPoolBase> pool_getter(
+      PoolsMap& pools,
+      const std::string& pool_type,
+      int device_id,
+      int pool_size);
 
   std::unique_ptr<AsyncNetExecutorHelper> helper_;
 
@@ -100,12 +106,16 @@ class AsyncNetBase : public NetBase {
   friend class tracing::Tracer;
 };
 
-CAFFE_DECLARE_SHARED_REGISTRY(ThreadPoolRegistry, TaskThreadPool, int, int);
+CAFFE_DECLARE_SHARED_REGISTRY(
+    ThreadPoolRegistry,
+    TaskThreadPoolBase,
+    int,
+    int);
 
 class AsyncNetExecutorHelper : public ExecutorHelper {
  public:
   explicit AsyncNetExecutorHelper(AsyncNetBase* net) : net_(net) {}
-  std::shared_ptr<TaskThreadPool> GetPool(
+  std::shared_ptr<TaskThreadPoolBase> GetPool(
       const DeviceOption& option) const override {
     return net_->pool(option);
   }
@@ -114,7 +124,11 @@ class AsyncNetExecutorHelper : public ExecutorHelper {
   AsyncNetBase* net_;
 };
 
-std::shared_ptr<TaskThreadPool> GetAsyncNetCPUThreadPool(
+std::shared_ptr<TaskThreadPoolBase> GetAsyncNetCPUThreadPool(
+    int numa_node_id,
+    int pool_size);
+
+std::shared_ptr<TaskThreadPoolBase> GetAsyncNetCPUWorkStealingThreadPool(
     int numa_node_id,
     int pool_size);
 
@@ -8,7 +8,7 @@ namespace caffe2 {
 
 CAFFE_REGISTER_CREATOR(ThreadPoolRegistry, CUDA, GetAsyncNetGPUThreadPool);
 
-std::shared_ptr<TaskThreadPool> GetAsyncNetGPUThreadPool(
+std::shared_ptr<TaskThreadPoolBase> GetAsyncNetGPUThreadPool(
     int gpu_id,
     int pool_size) {
   // For GPU, use per device thread pools of predefined constant size
@@ -16,11 +16,11 @@ std::shared_ptr<TaskThreadPool> GetAsyncNetGPUThreadPool(
     LOG(INFO) << "Overriding GPU pool size: using "
               << FLAGS_caffe2_threads_per_gpu << " threads per GPU";
   }
-  static std::unordered_map<int, std::weak_ptr<TaskThreadPool>> pools;
+  static std::unordered_map<int, std::weak_ptr<TaskThreadPoolBase>> pools;
   static std::mutex pool_mutex;
   std::lock_guard<std::mutex> lock(pool_mutex);
 
-  std::shared_ptr<TaskThreadPool> shared_pool = nullptr;
+  std::shared_ptr<TaskThreadPoolBase> shared_pool = nullptr;
   if (pools.count(gpu_id)) {
     shared_pool = pools.at(gpu_id).lock();
   }
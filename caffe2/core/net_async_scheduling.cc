@@ -10,7 +10,10 @@ namespace caffe2 {
 AsyncSchedulingNet::AsyncSchedulingNet(
     const std::shared_ptr<const NetDef>& net_def,
     Workspace* ws)
-    : AsyncNetBase(net_def, ws), running_(false) {
+    : AsyncNetBase(net_def, ws),
+      running_(false),
+      pending_parent_events_(new std::atomic<int>[tasksNum()]),
+      stats_("async_net/stats/" + net_def->name()) {
   reset();
 }
 
@@ -23,6 +26,7 @@ void AsyncSchedulingNet::reset() {
     auto& task_ops = chains_[task_id];
     auto& task_op_node = operator_nodes_[task_ops.front()];
     task_op_node.runtime_parent_count_ = parents(task_id).size();
+    pending_parent_events_[task_id] = 0;
   }
   exception_messages_.clear();
 }
@@ -50,19 +54,16 @@ void AsyncSchedulingNet::schedule(int task_id) {
     }
 
     auto task_count = ++processed_tasks_num_;
+    if (task_count == tasksNum()) {
+      // Wake up the cleanup thread waiting for all tasks to be processed
+      std::unique_lock<std::mutex> cleanup_lock(cleanup_mutex_);
+      cleanup_cv_.notify_all();
+    }
 
     for (auto child_id : children(task_id)) {
       int parent_count = updateParentCount(child_id);
       if (parent_count == 0) {
-        if (cleanup_ || FLAGS_caffe2_net_async_always_schedule_child ||
-            canSchedule(child_id)) {
-          schedule(child_id);
-        } else {
-          const auto& device_option = event(child_id).GetDeviceOption();
-          pool(device_option)
-              ->run(std::bind(
-                  &AsyncSchedulingNet::pollAndSchedule, this, child_id));
-        }
+        scheduleChild(child_id);
       }
     }
 
@@ -86,11 +87,12 @@ void AsyncSchedulingNet::schedule(int task_id) {
           return;
         }
         cleanup_ = true;
-      }
 
-      // Errors are not recoverable and happen in exceptional cases,
-      // ok to busy wait
-      while (processed_tasks_num_ != tasksNum()) {
+        // Errors are not recoverable and happen in exceptional cases,
+        // wait until the last processed task notifies us
+        cleanup_cv_.wait(cleanup_lock, [this]() {
+          return processed_tasks_num_ == tasksNum();
+        });
       }
 
       // Make sure all events are set, wait for scheduled events
@@ -102,11 +104,65 @@ void AsyncSchedulingNet::schedule(int task_id) {
   });
 }
 
+void AsyncSchedulingNet::scheduleChild(int child_id) {
+  // After an error the child is not run, and the events of parents that
+  // were skipped only finish in the cleanup, which waits for the child
+  if (!success_ || cleanup_ || FLAGS_caffe2_net_async_always_schedule_child ||
+      canSchedule(child_id)) {
+    schedule(child_id);
+    return;
+  }
+
+  // Some of the parents' events are not finished yet and do not allow
+  // async scheduling of the child (e.g. CUDA parent and CPU child);
+  // wait for them using event callbacks, fall back to polling if any of
+  // them doesn't support callbacks
+  std::vector<int> blocking_parents;
+  for (auto parent_id : parents(child_id)) {
+    if (!canSchedule(parent_id, child_id)) {
+      if (!event(parent_id).SupportsCallback()) {
+        CAFFE_EVENT(stats_, task_polls);
+        const auto& device_option = event(child_id).GetDeviceOption();
+        pool(device_option)
+            ->run(std::bind(
+                &AsyncSchedulingNet::pollAndSchedule, this, child_id));
+        return;
+      }
+      blocking_parents.push_back(parent_id);
+    }
+  }
+
+  CAFFE_EVENT(stats_, task_event_callbacks);
+  // Hold an extra count while setting callbacks, so that callbacks of the
+  // events that finish in the meantime can't schedule the child early
+  pending_parent_events_[child_id] = blocking_parents.size() + 1;
+  for (auto parent_id : blocking_parents) {
+    event(parent_id).SetCallback(
+        std::bind(&AsyncSchedulingNet::parentCallback, this, child_id));
+  }
+  parentCallback(child_id);
+}
+
+void AsyncSchedulingNet::parentCallback(int child_id) {
+  if (--pending_parent_events_[child_id] != 0) {
+    return;
+  }
+  // Exactly one caller gets here: all parents' events are finished,
+  // if any of them failed, the child is not run and the net is cleaned up
+  for (auto parent_id : parents(child_id)) {
+    if (query(parent_id) == EventStatus::EVENT_FAILED) {
+      success_ = false;
+    }
+  }
+  schedule(child_id);
+}
+
 void AsyncSchedulingNet::pollAndSchedule(int task_id) {
   if (canSchedule(task_id) || cleanup_) {
     // force schedule the rest of the tasks if cleanup is started
     schedule(task_id);
   } else {
+    CAFFE_EVENT(stats_, task_polls);
     const auto& device_option = event(task_id).GetDeviceOption();
     pool(device_option)
         ->run(std::bind(&AsyncSchedulingNet::pollAndSchedule, this, task_id));
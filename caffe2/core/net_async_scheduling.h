@@ -19,6 +19,8 @@ class AsyncSchedulingNet : public AsyncNetBase {
 
   void pollAndSchedule(int task_id);
   void schedule(int task_id);
+  void scheduleChild(int child_id);
+  void parentCallback(int child_id);
   void reset();
   virtual void finishRun();
   int updateParentCount(int child_id);
@@ -29,12 +31,26 @@ class AsyncSchedulingNet : public AsyncNetBase {
   std::atomic<bool> success_;
 
   std::mutex cleanup_mutex_;
+  std::condition_variable cleanup_cv_;
   std::atomic<bool> cleanup_;
 
   std::atomic<int> processed_tasks_num_;
+  // Per task: number of parent events a child is still waiting on after
+  // all of its parents have been processed
+  std::unique_ptr<std::atomic<int>[]> pending_parent_events_;
   std::mutex exception_mutex_;
   std::vector<std::string> exception_messages_;
 
+  // Stats
+  struct AsyncSchedulingNetStats {
+    CAFFE_STAT_CTOR(AsyncSchedulingNetStats);
+    // Tasks re-enqueued to poll parents' events
+    CAFFE_EXPORTED_STAT(task_polls);
+    // Tasks scheduled from parent event callbacks, each avoids polling
+    CAFFE_EXPORTED_STAT(task_event_callbacks);
+  };
+  AsyncSchedulingNetStats stats_;
+
   DISABLE_COPY_AND_ASSIGN(AsyncSchedulingNet);
 };
 
@@ -1,4 +1,8 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <chrono>
+#include <mutex>
+#include <thread>
 #include "caffe2/core/net.h"
 #include "caffe2/core/net_dag.h"
 #include "caffe2/core/operator.h"
@@ -620,4 +624,198 @@ TEST(NetTest, OperatorWithExecutorHelper) {
   ASSERT_TRUE(net->Run());
 }
 
+TEST(NetTest, AsyncSchedulingWorkStealing) {
+  const auto spec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        arg {
+          name: "work_stealing"
+          i: 1
+        }
+        op {
+          input: "in"
+          output: "hidden"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "hidden"
+          output: "out1"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "hidden"
+          output: "out2"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "hidden"
+          output: "out3"
+          type: "NetTestDummy"
+        }
+        op {
+          input: "out1"
+          input: "out2"
+          input: "out3"
+          output: "out"
+          type: "NetTestDummy"
+        }
+        op {
+          type: "ExecutorHelperDummy"
+        }
+)DOC";
+
+  Workspace ws;
+  ws.CreateBlob("in");
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(spec, &net_def));
+  net_def.set_num_workers(kTestPoolSize);
+
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  for (int i = 0; i < 10; i++) {
+    counter.exchange(0);
+    ASSERT_TRUE(net->Run());
+    ASSERT_EQ(5, counter.load());
+  }
+}
+
+namespace {
+
+std::mutex completion_mutex;
+std::vector<std::string> completion_order;
+
+// A CPU op whose async part finishes on another thread after a delay, so that
+// async_scheduling waits for its event with a callback before scheduling the
+// ops that depend on it. Logs its output when the async part finishes.
+class NetTestAsyncCPUDummyOp final : public Operator<CPUContext> {
+ public:
+  NetTestAsyncCPUDummyOp(const OperatorDef& operator_def, Workspace* ws)
+      : Operator<CPUContext>(operator_def, ws),
+        fail_(OperatorBase::GetSingleArgument<bool>("fail", false)),
+        delay_ms_(OperatorBase::GetSingleArgument<int>("delay_ms", 0)) {}
+
+  ~NetTestAsyncCPUDummyOp() override {
+    join();
+  }
+
+  bool RunOnDevice() override {
+    join();
+    thread_ = std::thread([this]() {
+      std::this_thread::sleep_for(std::chrono::milliseconds(delay_ms_));
+      {
+        std::lock_guard<std::mutex> lock(completion_mutex);
+        completion_order.push_back(debug_def().output(0));
+      }
+      event().SetFinished(fail_ ? "async part failed" : nullptr);
+    });
+    return true;
+  }
+
+  bool HasAsyncPart() const override {
+    return true;
+  }
+
+ private:
+  void join() {
+    if (thread_.joinable()) {
+      thread_.join();
+    }
+  }
+
+  const bool fail_;
+  const int delay_ms_;
+  std::thread thread_;
+};
+
+REGISTER_CPU_OPERATOR(NetTestAsyncCPUDummy, NetTestAsyncCPUDummyOp);
+OPERATOR_SCHEMA(NetTestAsyncCPUDummy).NumInputs(0, INT_MAX).NumOutputs(1);
+
+// a -> b -> c and a2 -> b, where a finishes last of a and a2
+const auto kAsyncCallbackSpec = R"DOC(
+        name: "example"
+        type: "async_scheduling"
+        external_input: "in"
+        op {
+          input: "in"
+          output: "a"
+          type: "NetTestAsyncCPUDummy"
+          arg {
+            name: "delay_ms"
+            i: 20
+          }
+        }
+        op {
+          input: "in"
+          output: "a2"
+          type: "NetTestAsyncCPUDummy"
+        }
+        op {
+          input: "a"
+          input: "a2"
+          output: "b"
+          type: "NetTestAsyncCPUDummy"
+        }
+        op {
+          input: "b"
+          output: "c"
+          type: "NetTestAsyncCPUDummy"
+        }
+)DOC";
+
+int completionIndex(const std::string& name) {
+  auto it = std::find(completion_order.begin(), completion_order.end(), name);
+  return it == completion_order.end() ? -1 : it - completion_order.begin();
+}
+
+} // namespace
+
+TEST(NetTest, AsyncSchedulingEventCallbacks) {
+  Workspace ws;
+  ws.CreateBlob("in");
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kAsyncCallbackSpec, &net_def));
+  net_def.set_num_workers(kTestPoolSize);
+
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  for (int i = 0; i < 10; i++) {
+    completion_order.clear();
+    ASSERT_TRUE(net->Run());
+    ASSERT_EQ(4, completion_order.size());
+    // Each op is scheduled once the async parts of all its parents finished
+    EXPECT_LT(completionIndex("a"), completionIndex("b"));
+    EXPECT_LT(completionIndex("a2"), completionIndex("b"));
+    EXPECT_LT(completionIndex("b"), completionIndex("c"));
+  }
+}
+
+TEST(NetTest, AsyncSchedulingEventCallbackFailure) {
+  Workspace ws;
+  ws.CreateBlob("in");
+
+  NetDef net_def;
+  CAFFE_ENFORCE(TextFormat::ParseFromString(kAsyncCallbackSpec, &net_def));
+  net_def.set_num_workers(kTestPoolSize);
+  auto* arg = net_def.mutable_op(0)->add_arg();
+  arg->set_name("fail");
+  arg->set_i(1);
+
+  std::unique_ptr<NetBase> net(CreateNet(net_def, &ws));
+  for (int i = 0; i < 10; i++) {
+    completion_order.clear();
+    try {
+      net->Run();
+      FAIL() << "The failed async part was not reported";
+    } catch (const EnforceNotMet& e) {
+      EXPECT_NE(
+          std::string(e.what()).find("async part failed"), std::string::npos);
+    }
+    // The failure reaches the callback of b, so b and c never run
+    EXPECT_EQ(-1, completionIndex("b"));
+    EXPECT_EQ(-1, completionIndex("c"));
+    EXPECT_NE(-1, completionIndex("a"));
+  }
+}
+
 } // namespace caffe2
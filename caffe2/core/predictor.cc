@@ -53,13 +53,17 @@ const ::google::protobuf::RepeatedPtrField<::std::string>& getBlobs(
 }
 } // namespace
 
-Predictor::Predictor(const MetaNetDef& def, Workspace* parent)
+Predictor::Predictor(
+    const MetaNetDef& def,
+    Workspace* parent,
+    int num_workspaces)
     : Predictor(
           getNet(
               def,
               PredictorConsts::default_instance().global_init_net_type()),
           getNet(def, PredictorConsts::default_instance().predict_net_type()),
-          parent) {
+          parent,
+          num_workspaces) {
   const auto& inputs =
       getBlobs(def, PredictorConsts::default_instance().inputs_blob_type());
   for (const auto& input : inputs) {
@@ -70,7 +74,8 @@ Predictor::Predictor(const MetaNetDef& def, Workspace* parent)
 Predictor::Predictor(
     const NetDef& init_net,
     const NetDef& run_net,
-    Workspace* parent)
+    Workspace* parent,
+    int num_workspaces)
     : run_net_(run_net), ws_(parent) {
   CAFFE_ENFORCE(ws_.RunNetOnce(init_net));
 
@@ -82,16 +87,32 @@ Predictor::Predictor(
     if (!initialized.count(name)) {
       auto* blob = ws_.CreateBlob(name);
       blob->template GetMutable<TensorCPU>();
+      localBlobNames_.insert(name);
+    } else if (ws_.GetBlob(name)->template IsType<TensorCPU>()) {
+      // Inputs that init_net created can still be fed by the caller, give
+      // each child its own tensor aliasing the initialized data
+      localBlobNames_.insert(name);
+      initializedInputNames_.insert(name);
+    }
+  }
+  for (const auto& op : run_net.op()) {
+    for (const auto& name : op.output()) {
+      localBlobNames_.insert(name);
     }
   }
   CAFFE_ENFORCE(ws_.CreateNet(run_net));
+
+  workspacePool_.reserve(num_workspaces);
+  for (int i = 0; i < num_workspaces; ++i) {
+    workspacePool_.push_back(createChildWorkspace());
+  }
 }
 
 Predictor::~Predictor() {}
 
 bool Predictor::run(const TensorVector& inputs, TensorVector* outputs) {
   CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
-  for (auto i = 0; i < inputs.size(); ++i) {
+  for (size_t i = 0; i < inputs.size(); ++i) {
     shareInputTensor(&ws_, run_net_.external_input(i), inputs[i]);
   }
 
@@ -100,7 +121,7 @@ bool Predictor::run(const TensorVector& inputs, TensorVector* outputs) {
   }
 
   outputs->resize(run_net_.external_output_size());
-  for (auto i = 0; i < outputs->size(); ++i) {
+  for (size_t i = 0; i < outputs->size(); ++i) {
     (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
   }
   return true;
@@ -122,9 +143,113 @@ bool Predictor::run_map(const TensorMap& inputs, TensorVector* outputs) {
   }
 
   outputs->resize(run_net_.external_output_size());
-  for (auto i = 0; i < outputs->size(); ++i) {
+  for (size_t i = 0; i < outputs->size(); ++i) {
     (*outputs)[i] = extractOutputTensor(&ws_, run_net_.external_output(i));
   }
   return true;
 }
+
+std::unique_ptr<Workspace> Predictor::createChildWorkspace() {
+  auto ws = caffe2::make_unique<Workspace>(&ws_);
+  // Hide the parent's blobs written by run_net, so that concurrent runs
+  // don't share activations
+  for (const auto& name : localBlobNames_) {
+    ws->CreateLocalBlob(name);
+  }
+  for (const auto& name : run_net_.external_input()) {
+    if (!localBlobNames_.count(name)) {
+      continue;
+    }
+    auto* tensor = ws->GetBlob(name)->template GetMutable<TensorCPU>();
+    if (initializedInputNames_.count(name)) {
+      const auto& initialized = ws_.GetBlob(name)->template Get<TensorCPU>();
+      // Skip tensors init_net created without ever shaping them
+      if (initialized.size() >= 0) {
+        tensor->ResizeLike(initialized);
+        tensor->ShareData(initialized);
+      }
+    }
+  }
+  CAFFE_ENFORCE(ws->CreateNet(run_net_));
+  return ws;
+}
+
+void Predictor::enforceIsLocalInput(const std::string& name) const {
+  // Feeding a blob forwarded from ws_ would write into the tensor shared by
+  // all concurrent callers
+  CAFFE_ENFORCE(
+      localBlobNames_.count(name),
+      "Input is not local to child workspaces: ",
+      name);
+}
+
+std::unique_ptr<Workspace> Predictor::checkoutWorkspace() {
+  {
+    std::lock_guard<std::mutex> lock(workspacePoolMutex_);
+    if (!workspacePool_.empty()) {
+      auto ws = std::move(workspacePool_.back());
+      workspacePool_.pop_back();
+      return ws;
+    }
+  }
+  // Pool is exhausted, the number of child workspaces grows up to the
+  // number of concurrent callers
+  return createChildWorkspace();
+}
+
+void Predictor::returnWorkspace(std::unique_ptr<Workspace> ws) {
+  std::lock_guard<std::mutex> lock(workspacePoolMutex_);
+  workspacePool_.push_back(std::move(ws));
+}
+
+bool Predictor::runChildNet(Workspace* ws, OutputTensorVector* outputs) {
+  if (!ws->RunNet(run_net_.name())) {
+    return false;
+  }
+
+  outputs->resize(run_net_.external_output_size());
+  for (size_t i = 0; i < outputs->size(); ++i) {
+    auto& output = (*outputs)[i];
+    if (!output) {
+      output = caffe2::make_unique<TensorCPU>();
+    }
+    // Swap the result out instead of copying it, the child workspace keeps
+    // the caller's previous buffer for the next run
+    output->swap(*extractOutputTensor(ws, run_net_.external_output(i)));
+  }
+  return true;
+}
+
+bool Predictor::run_concurrent(
+    const TensorVector& inputs,
+    OutputTensorVector* outputs) {
+  CAFFE_ENFORCE(inputs.size() <= run_net_.external_input_size());
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    enforceIsLocalInput(run_net_.external_input(i));
+  }
+  WorkspaceGuard ws(this);
+  for (size_t i = 0; i < inputs.size(); ++i) {
+    shareInputTensor(ws.get(), run_net_.external_input(i), inputs[i]);
+  }
+  return runChildNet(ws.get(), outputs);
+}
+
+bool Predictor::run_map_concurrent(
+    const TensorMap& inputs,
+    OutputTensorVector* outputs) {
+  if (!inputNames_.empty()) {
+    CAFFE_ENFORCE_EQ(inputs.size(), inputNames_.size());
+  }
+  for (const auto& input : inputs) {
+    if (!inputNames_.empty()) {
+      CAFFE_ENFORCE_GT(inputNames_.count(input.first), 0);
+    }
+    enforceIsLocalInput(input.first);
+  }
+  WorkspaceGuard ws(this);
+  for (auto input : inputs) {
+    shareInputTensor(ws.get(), input.first, input.second);
+  }
+  return runChildNet(ws.get(), outputs);
+}
 } // namespace caffe2
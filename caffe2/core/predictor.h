@@ -1,5 +1,6 @@
 #pragma once
 
+#include <mutex>
 #include <unordered_set>
 #include "caffe2/core/net.h"
 #include "caffe2/core/tensor.h"
@@ -12,17 +13,24 @@ class Predictor {
  public:
   using TensorVector = std::vector<TensorCPU*>;
   using TensorMap = std::unordered_map<std::string, TensorCPU*>;
+  using OutputTensorVector = std::vector<std::unique_ptr<TensorCPU>>;
 
   // MetaNetDef contains 'init_net', 'run_net', and meta-info
   // The meta-info is used to verify inputs are correctly passed
-  Predictor(const MetaNetDef& net, Workspace* parent = nullptr);
+  Predictor(
+      const MetaNetDef& net,
+      Workspace* parent = nullptr,
+      int num_workspaces = 0);
 
   // Runs the `init_net` once, then saves the `run_net` to be executed
   // in `::run`
+  // `num_workspaces` child workspaces with instantiated `run_net` are
+  // created upfront for `::run_concurrent`
   Predictor(
       const NetDef& init_net,
       const NetDef& run_net,
-      Workspace* parent = nullptr);
+      Workspace* parent = nullptr,
+      int num_workspaces = 0);
   ~Predictor();
 
   // Executes `run_net` on the inputs.
@@ -39,8 +47,25 @@ class Predictor {
   bool run(const TensorVector& inputs, TensorVector* outputs);
 
   // Similar to run, but consumes a map of name to tensor as input
+  // run and run_map feed and execute `run_net` in the predictor's own
+  // workspace, they must not be mixed with the `*_concurrent` calls on the
+  // same Predictor
   bool run_map(const TensorMap& inputs, TensorVector* outputs);
 
+  // Thread-safe versions of run and run_map, can be called concurrently.
+  // Blobs created by `init_net` live once in the predictor's workspace and
+  // are shared read-only; `run_net` is executed in a child workspace checked
+  // out from a pool, so `run_net` must not write into them.
+  // Every tensor in run_net::external_inputs can be fed, including the ones
+  // created by `init_net`: each child workspace has its own tensor for them,
+  // initially aliasing the data from `init_net`.
+  // Output tensors are swapped out of the child workspace and owned by the
+  // caller, buffers of tensors already present in `outputs` are recycled.
+  bool run_concurrent(const TensorVector& inputs, OutputTensorVector* outputs);
+  bool run_map_concurrent(
+      const TensorMap& inputs,
+      OutputTensorVector* outputs);
+
   const NetDef& def() const {
     return run_net_;
   };
@@ -50,8 +75,40 @@ class Predictor {
   };
 
  private:
+  // Holds a child workspace checked out from the pool and returns it when
+  // going out of scope, also if running the net throws
+  class WorkspaceGuard {
+   public:
+    explicit WorkspaceGuard(Predictor* predictor)
+        : predictor_(predictor), ws_(predictor->checkoutWorkspace()) {}
+    ~WorkspaceGuard() {
+      predictor_->returnWorkspace(std::move(ws_));
+    }
+    Workspace* get() const {
+      return ws_.get();
+    }
+
+   private:
+    Predictor* predictor_;
+    std::unique_ptr<Workspace> ws_;
+  };
+
+  std::unique_ptr<Workspace> createChildWorkspace();
+  std::unique_ptr<Workspace> checkoutWorkspace();
+  void returnWorkspace(std::unique_ptr<Workspace> ws);
+  void enforceIsLocalInput(const std::string& name) const;
+  bool runChildNet(Workspace* ws, OutputTensorVector* outputs);
+
   NetDef run_net_;
   Workspace ws_;
   std::unordered_set<std::string> inputNames_;
+
+  // Blobs that are local to child workspaces: run_net's tensor inputs and
+  // all outputs of run_net's operators
+  std::unordered_set<std::string> localBlobNames_;
+  // run_net's inputs initialized by init_net, aliased in child workspaces
+  std::unordered_set<std::string> initializedInputNames_;
+  std::mutex workspacePoolMutex_;
+  std::vector<std::unique_ptr<Workspace>> workspacePool_;
 };
 }
@@ -6,6 +6,9 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+#include <thread>
+
 namespace caffe2 {
 
 namespace {
@@ -197,6 +200,48 @@ TEST_F(PredictorTest, SimpleBatchSizedMapInput) {
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
 
+TEST_F(PredictorTest, ConcurrentRun) {
+  const int kNumThreads = 4;
+  const int kNumIters = 10;
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorVector input{inputData->template GetMutable<TensorCPU>()};
+  // run() must not be mixed with run_concurrent() on the same Predictor
+  Predictor reference(parseNetDef(initSpec), parseNetDef(predictSpec));
+  Predictor::TensorVector expected;
+  reference.run(input, &expected);
+
+  std::vector<std::thread> threads;
+  std::atomic<int> num_matches(0);
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&]() {
+      Predictor::OutputTensorVector output;
+      for (int i = 0; i < kNumIters; ++i) {
+        if (!p_->run_concurrent(input, &output)) {
+          continue;
+        }
+        if (output.size() == 1 && output.front()->size() == 10 &&
+            std::abs(
+                output.front()->data<float>()[4] -
+                expected.front()->data<float>()[4]) < 1E-4) {
+          ++num_matches;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_matches, kNumThreads * kNumIters);
+}
+
+TEST_F(PredictorTest, ConcurrentRunRejectsUnknownInput) {
+  auto inputData = randomTensor({1, 4}, ctx_.get());
+  Predictor::TensorMap input{
+      {"not_an_input", inputData->template GetMutable<TensorCPU>()}};
+  Predictor::OutputTensorVector output;
+  EXPECT_THROW(p_->run_map_concurrent(input, &output), EnforceNotMet);
+}
+
 class PredictorMetaNetDefTest : public testing::Test {
  public:
   void SetUp() override {
@@ -222,4 +267,45 @@ TEST_F(PredictorMetaNetDefTest, SimpleMetaNetDefInitializer) {
   EXPECT_TRUE(output.front()->dim(1) == 10);
   EXPECT_NEAR(output.front()->data<float>()[4], 0.1209, 1E-4);
 }
+
+TEST_F(PredictorMetaNetDefTest, ConcurrentRunInitializedInput) {
+  // "data" is created by init_net, concurrent callers must each see their
+  // own input rather than the tensor in the predictor's workspace
+  const int kNumThreads = 4;
+  const int kNumIters = 10;
+  std::vector<std::unique_ptr<Blob>> inputData;
+  std::vector<float> expected;
+  for (int t = 0; t < kNumThreads; ++t) {
+    inputData.push_back(randomTensor({1, 4}, ctx_.get()));
+    Predictor reference(parseMetaNetDef(metaSpec));
+    Predictor::TensorMap input{
+        {"data", inputData.back()->template GetMutable<TensorCPU>()}};
+    Predictor::TensorVector output;
+    reference.run_map(input, &output);
+    expected.push_back(output.front()->data<float>()[4]);
+  }
+
+  std::vector<std::thread> threads;
+  std::atomic<int> num_matches(0);
+  for (int t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&, t]() {
+      Predictor::TensorMap input{
+          {"data", inputData[t]->template GetMutable<TensorCPU>()}};
+      Predictor::OutputTensorVector output;
+      for (int i = 0; i < kNumIters; ++i) {
+        if (!p_->run_map_concurrent(input, &output)) {
+          continue;
+        }
+        if (output.size() == 1 && output.front()->size() == 10 &&
+            std::abs(output.front()->data<float>()[4] - expected[t]) < 1E-4) {
+          ++num_matches;
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(num_matches, kNumThreads * kNumIters);
+}
 } // namespace caffe2
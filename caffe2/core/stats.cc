@@ -1,10 +1,36 @@
 #include "caffe2/core/stats.h"
 
+#include <algorithm>
 #include <condition_variable>
 #include <thread>
 
 namespace caffe2 {
 
+namespace detail {
+
+size_t statNumShards() {
+  static const size_t numShards = []() {
+    size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+    size_t n = 1;
+    while (n < cores && n < 64) {
+      n *= 2;
+    }
+    return n;
+  }();
+  return numShards;
+}
+
+size_t statShardIndex() {
+  // Threads are given shards in turn, so that up to statNumShards() threads
+  // never share one
+  static std::atomic<size_t> nextThread{0};
+  static thread_local size_t index =
+      nextThread.fetch_add(1) & (statNumShards() - 1);
+  return index;
+}
+
+} // namespace detail
+
 ExportedStatMap toMap(const ExportedStatList& stats) {
   ExportedStatMap statMap;
   for (const auto& stat : stats) {
@@ -46,6 +72,14 @@ void StatRegistry::update(const ExportedStatList& data) {
 
 StatRegistry::~StatRegistry() {}
 
+StatValue* HistogramExportedStat::addBucket(int bucket) {
+  int64_t lower = bucket == 0 ? 0 : int64_t(1) << (bucket - 1);
+  auto* counter = StatRegistry::get().add(
+      histogramName_ + "/bucket_" + caffe2::to_string(lower));
+  buckets_[bucket].store(counter, std::memory_order_release);
+  return counter;
+}
+
 StatRegistry& StatRegistry::get() {
   static StatRegistry r;
   return r;
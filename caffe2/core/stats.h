@@ -11,20 +11,64 @@
 
 namespace caffe2 {
 
+namespace detail {
+// Index of the shard of StatValue updated by the calling thread
+size_t statShardIndex();
+// Number of shards of a StatValue, a power of two
+size_t statNumShards();
+} // namespace detail
+
+/**
+ * @brief A counter that many threads can update without contention.
+ *
+ * The counter is split in shards, one per core up to 64, each on its own
+ * cache line. A thread always updates the same shard, and the shards are
+ * only summed when the value is read, e.g. by StatRegistry::publish().
+ */
 class StatValue {
-  std::atomic<int64_t> v_{0};
+  // Shards are this many atomics apart, i.e. on different cache lines
+  static constexpr size_t kShardStride = 64 / sizeof(std::atomic<int64_t>);
+
+  std::unique_ptr<std::atomic<int64_t>[]> shards_;
+
+  std::atomic<int64_t>& shard(size_t i) const {
+    return shards_[i * kShardStride];
+  }
 
  public:
+  StatValue()
+      : shards_(new std::atomic<int64_t>[detail::statNumShards() *
+                                         kShardStride]) {
+    for (size_t i = 0; i < detail::statNumShards(); ++i) {
+      shard(i).store(0, std::memory_order_relaxed);
+    }
+  }
+
+  /**
+   * Adds inc to the counter, and returns the updated value of the shard of
+   * the calling thread, since the total would cost a pass over all shards.
+   */
   int64_t increment(int64_t inc) {
-    return v_ += inc;
+    return shard(detail::statShardIndex())
+               .fetch_add(inc, std::memory_order_relaxed) +
+        inc;
   }
 
   int64_t reset(int64_t value = 0) {
-    return v_.exchange(value);
+    int64_t total = 0;
+    for (size_t i = 0; i < detail::statNumShards(); ++i) {
+      total += shard(i).exchange(0);
+    }
+    shard(0).fetch_add(value);
+    return total;
   }
 
   int64_t get() const {
-    return v_.load();
+    int64_t total = 0;
+    for (size_t i = 0; i < detail::statNumShards(); ++i) {
+      total += shard(i).load(std::memory_order_relaxed);
+    }
+    return total;
   }
 };
 
@@ -103,7 +147,8 @@ ExportedStatMap toMap(const ExportedStatList& stats);
  * The probe will be set up with the following arguments:
  *   - Probe name: field name (e.g. "num_runs")
  *   - Arg #0: instance name (e.g. "first", "second")
- *   - Arg #1: For CAFFE_EXPORTED_STAT, value of the updated counter
+ *   - Arg #1: For CAFFE_EXPORTED_STAT, value of the updated shard of the
+ *             counter, see StatValue
  *             For CAFFE_STAT, -1 since no counter is available
  *   - Args ...: Arguments passed to CAFFE_EVENT, including update value
  *             when provided.
@@ -258,6 +303,56 @@ class DetailedExportedStat : public ExportedStat {
   }
 };
 
+/**
+ * @brief Counts values, e.g. latencies, in buckets of a log2 scale.
+ *
+ * Bucket 0 counts the values below 1, and bucket b > 0 the values in
+ * [2^(b-1), 2^b). Each bucket is exported as a counter named
+ * <name>/bucket_<2^(b-1)>, created the first time it counts a value, along
+ * with <name>/sum and <name>/count as for CAFFE_AVG_EXPORTED_STAT.
+ */
+class HistogramExportedStat : public AvgExportedStat {
+ public:
+  static constexpr int kNumBuckets = 64;
+
+ private:
+  std::string histogramName_;
+  std::atomic<StatValue*> buckets_[kNumBuckets];
+
+  StatValue* addBucket(int bucket);
+
+ public:
+  HistogramExportedStat(const std::string& gn, const std::string& n)
+      : AvgExportedStat(gn, n), histogramName_(gn + "/" + n) {
+    for (auto& bucket : buckets_) {
+      bucket.store(nullptr, std::memory_order_relaxed);
+    }
+  }
+
+  static int bucketOf(int64_t value) {
+    int bucket = 0;
+    for (uint64_t v = value > 0 ? value : 0; v; v >>= 1) {
+      ++bucket;
+    }
+    return bucket;
+  }
+
+  int64_t increment(int64_t value = 1) {
+    int bucket = bucketOf(value);
+    auto* counter = buckets_[bucket].load(std::memory_order_acquire);
+    if (!counter) {
+      counter = addBucket(bucket);
+    }
+    counter->increment(1);
+    return AvgExportedStat::increment(value);
+  }
+
+  template <typename T, typename Unused1, typename... Unused>
+  int64_t increment(T value, Unused1, Unused...) {
+    return increment(value);
+  }
+};
+
 namespace detail {
 
 template <class T>
@@ -306,6 +401,11 @@ _ScopeGuard<T> ScopeGuard(T f) {
     groupName, #name                     \
   }
 
+#define CAFFE_HISTOGRAM_EXPORTED_STAT(name) \
+  HistogramExportedStat name {              \
+    groupName, #name                        \
+  }
+
 #define CAFFE_DETAILED_EXPORTED_STAT(name) \
   DetailedExportedStat name {              \
     groupName, #name                       \
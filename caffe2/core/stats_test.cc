@@ -117,5 +117,52 @@ TEST(StatsTest, StatsTestSimple) {
       toMap(reg2.publish()), ExportedStatMap({{"i1/s3", 0}, {"i2/s3", 0}}));
 }
 
+TEST(StatsTest, StatsTestConcurrent) {
+  struct TestStats {
+    CAFFE_STAT_CTOR(TestStats);
+    CAFFE_EXPORTED_STAT(hits);
+  } stats("concurrent");
+  const int kThreads = 16;
+  const int kIncrements = 10000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < kThreads; ++t) {
+    threads.emplace_back([&stats]() {
+      for (int i = 0; i < kIncrements; ++i) {
+        CAFFE_EVENT(stats, hits);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_SUBSET(
+      toMap(StatRegistry::get().publish(true)),
+      ExportedStatMap({{"concurrent/hits", kThreads * kIncrements}}));
+  EXPECT_SUBSET(
+      toMap(StatRegistry::get().publish()),
+      ExportedStatMap({{"concurrent/hits", 0}}));
+}
+
+TEST(StatsTest, StatsTestHistogram) {
+  struct TestStats {
+    CAFFE_STAT_CTOR(TestStats);
+    CAFFE_HISTOGRAM_EXPORTED_STAT(latency);
+  } stats("histogram");
+  for (int64_t value : {0, 1, 3, 2, 1000, 1023, 1024}) {
+    CAFFE_EVENT(stats, latency, value);
+  }
+  auto published = toMap(StatRegistry::get().publish());
+  EXPECT_SUBSET(
+      published,
+      ExportedStatMap({{"histogram/latency/bucket_0", 1},
+                       {"histogram/latency/bucket_1", 1},
+                       {"histogram/latency/bucket_2", 2},
+                       {"histogram/latency/bucket_512", 2},
+                       {"histogram/latency/bucket_1024", 1},
+                       {"histogram/latency/count", 7},
+                       {"histogram/latency/sum", 3053}}));
+  EXPECT_EQ(published.count("histogram/latency/bucket_4"), 0);
+}
+
 } // namespace
 } // namespace caffe2
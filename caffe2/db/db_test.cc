@@ -1,9 +1,11 @@
 #include <cstdio>
+#include <cstring>
 #include <iomanip>
 #include <sstream>
 #include <thread>
 
 #include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/context.h"
 #include "caffe2/core/db.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/proto/caffe2.pb.h"
@@ -86,6 +88,59 @@ TEST(DBSeekTest, LMDB) {
   DBSeekTestWrapper("lmdb");
 }
 
+TEST(DBSeekTest, MmapDB) {
+  DBSeekTestWrapper("mmapdb");
+}
+
+TEST(MmapDBTest, ExternalTensorValue) {
+  std::string name = std::tmpnam(nullptr);
+  Blob blob;
+  auto* tensor = blob.GetMutable<TensorCPU>();
+  tensor->Resize(5, 7);
+  float* data = tensor->mutable_data<float>();
+  for (int i = 0; i < tensor->size(); ++i) {
+    data[i] = i * 0.5;
+  }
+  {
+    std::unique_ptr<DB> db(CreateDB("mmapdb", name, NEW));
+    ASSERT_TRUE(db.get());
+    // Writes the tensor in chunks, which the db merges back
+    TensorSerializer<CPUContext>().SerializeWithChunkSize(
+        blob, "tensor", [&db](const string& key, const string& value) {
+          std::unique_ptr<Transaction> trans(db->NewTransaction());
+          trans->Put(key, value);
+          trans->Commit();
+        }, 4);
+  }
+
+  std::unique_ptr<DB> db(CreateDB("mmapdb", name, READ));
+  std::unique_ptr<Cursor> cursor(db->NewCursor());
+  ASSERT_TRUE(cursor->Valid());
+  EXPECT_EQ(cursor->key(), "tensor");
+  BlobProto proto;
+  ExternalTensorData external;
+  ASSERT_TRUE(cursor->ExternalTensorValue(&proto, &external));
+  EXPECT_EQ(proto.tensor().dims_size(), 2);
+  EXPECT_EQ(proto.tensor().float_data_size(), 0);
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(external.data) % 64, 0);
+  ASSERT_EQ(external.nbytes, tensor->nbytes());
+  EXPECT_EQ(memcmp(external.data, data, external.nbytes), 0);
+
+  // Readers that parse the value get the whole tensor
+  Blob loaded;
+  loaded.Deserialize(cursor->value());
+  const auto& loaded_tensor = loaded.Get<TensorCPU>();
+  EXPECT_EQ(loaded_tensor.dims(), tensor->dims());
+  EXPECT_EQ(memcmp(loaded_tensor.raw_data(), data, tensor->nbytes()), 0);
+  cursor->Next();
+  EXPECT_FALSE(cursor->Valid());
+
+  // The mapping outlives the db and the cursor
+  cursor.reset();
+  db.reset();
+  EXPECT_EQ(memcmp(external.data, data, external.nbytes), 0);
+}
+
 TEST(DBReaderTest, Reader) {
   std::string name = std::tmpnam(nullptr);
   CreateAndFill("leveldb", name);
@@ -0,0 +1,533 @@
+/**
+ * MmapDB is a checkpoint format that is loaded by memory-mapping the file
+ * instead of parsing it. The bytes of every tensor are stored flat and
+ * aligned, so that a LoadOp on CPU makes the tensors alias the mapped pages:
+ * loading is then independent of the size of the model, pages are only read
+ * from disk when they are first touched, and all the processes that load the
+ * same file share one copy of it in the page cache.
+ *
+ * The file layout, in host byte order, is
+ *
+ *   header:  magic, version, index_offset, num_entries     (4 x 8 bytes)
+ *   data:    the values, and the tensor bytes aligned to kMmapDBAlignment
+ *   index:   num_entries entries sorted by key, each made of
+ *            value_offset, value_size, data_offset, data_size   (4 x 8 bytes)
+ *            flags, key_size                                    (2 x 4 bytes)
+ *            key                                         (key_size bytes)
+ *
+ * The value of a tensor entry is its BlobProto without the data, which is at
+ * data_offset. Tensors that SaveOp writes in several chunks are merged into a
+ * single entry keyed by the blob name. Values that are not tensors of
+ * fundamental types are stored as they are.
+ */
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <mutex>
+
+#include "caffe2/core/blob_serialization.h"
+#include "caffe2/core/context.h"
+#include "caffe2/core/db.h"
+#include "caffe2/core/logging.h"
+#include "caffe2/core/types.h"
+
+namespace caffe2 {
+namespace db {
+
+namespace {
+
+constexpr char kMmapDBMagic[8] = {'C', '2', 'M', 'M', 'A', 'P', 'D', 'B'};
+constexpr uint64_t kMmapDBVersion = 1;
+// Enough for the widest vector loads, and a cache line
+constexpr uint64_t kMmapDBAlignment = 64;
+// Set in the flags of the entries whose tensor bytes are at data_offset
+constexpr uint32_t kMmapDBExternalData = 1;
+
+struct MmapDBHeader {
+  char magic[8];
+  uint64_t version;
+  uint64_t index_offset;
+  uint64_t num_entries;
+};
+static_assert(sizeof(MmapDBHeader) == 32, "Unexpected mmapdb header size");
+
+struct MmapDBIndexEntry {
+  uint64_t value_offset;
+  uint64_t value_size;
+  uint64_t data_offset;
+  uint64_t data_size;
+  uint32_t flags;
+  uint32_t key_size;
+};
+static_assert(sizeof(MmapDBIndexEntry) == 40, "Unexpected mmapdb entry size");
+
+inline bool InFile(uint64_t offset, uint64_t size, uint64_t file_size) {
+  return offset <= file_size && size <= file_size - offset;
+}
+
+void WriteAt(
+    int fd,
+    uint64_t offset,
+    const void* data,
+    size_t size,
+    const string& path) {
+  const char* ptr = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = pwrite(fd, ptr, size, offset);
+    if (written < 0 && errno == EINTR) {
+      continue;
+    }
+    CAFFE_ENFORCE(written > 0, "Cannot write ", path, ": ", strerror(errno));
+    ptr += written;
+    offset += written;
+    size -= written;
+  }
+}
+
+struct MmapDBEntry {
+  string key;
+  MmapDBIndexEntry index;
+};
+
+// A mapped mmapdb file, shared by the db, its cursors and the tensors that
+// alias it. The file is unmapped when the last of them goes away.
+struct MmapDBFile {
+  std::shared_ptr<void> mapping;
+  const char* base = nullptr;
+  uint64_t size = 0;
+  std::vector<MmapDBEntry> entries;
+};
+
+std::shared_ptr<const MmapDBFile> OpenMmapDBFile(const string& source) {
+  int fd = open(source.c_str(), O_RDONLY);
+  CAFFE_ENFORCE(fd >= 0, "Cannot open file: ", source);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    CAFFE_THROW("Cannot stat file: ", source, ": ", strerror(errno));
+  }
+  const uint64_t size = st.st_size;
+  if (size < sizeof(MmapDBHeader)) {
+    close(fd);
+    CAFFE_THROW("Truncated mmapdb file: ", source);
+  }
+  // A private mapping: clean pages are read lazily and shared with every
+  // other process that maps the file, while a loaded tensor that is modified
+  // in place, e.g. by training, gets its own copy of the pages it writes and
+  // leaves the file untouched.
+  void* addr =
+      mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  CAFFE_ENFORCE(
+      addr != MAP_FAILED, "Cannot mmap file: ", source, ": ", strerror(errno));
+
+  auto file = std::make_shared<MmapDBFile>();
+  file->mapping =
+      std::shared_ptr<void>(addr, [size](void* ptr) { munmap(ptr, size); });
+  file->base = static_cast<const char*>(addr);
+  file->size = size;
+
+  MmapDBHeader header;
+  memcpy(&header, file->base, sizeof(header));
+  CAFFE_ENFORCE(
+      memcmp(header.magic, kMmapDBMagic, sizeof(kMmapDBMagic)) == 0,
+      "Not a mmapdb file: ",
+      source);
+  CAFFE_ENFORCE_EQ(
+      header.version, kMmapDBVersion, "Unsupported mmapdb file: ", source);
+  CAFFE_ENFORCE(
+      header.index_offset >= sizeof(header) && header.index_offset <= size,
+      "Corrupted mmapdb index: ",
+      source);
+  CAFFE_ENFORCE_LE(
+      header.num_entries,
+      (size - header.index_offset) / sizeof(MmapDBIndexEntry),
+      "Corrupted mmapdb index: ",
+      source);
+
+  uint64_t pos = header.index_offset;
+  file->entries.resize(header.num_entries);
+  for (auto& entry : file->entries) {
+    CAFFE_ENFORCE(
+        InFile(pos, sizeof(entry.index), size),
+        "Corrupted mmapdb index: ",
+        source);
+    memcpy(&entry.index, file->base + pos, sizeof(entry.index));
+    pos += sizeof(entry.index);
+    CAFFE_ENFORCE(
+        InFile(pos, entry.index.key_size, size),
+        "Corrupted mmapdb index: ",
+        source);
+    entry.key.assign(file->base + pos, entry.index.key_size);
+    pos += entry.index.key_size;
+    CAFFE_ENFORCE(
+        InFile(entry.index.value_offset, entry.index.value_size, size) &&
+            InFile(entry.index.data_offset, entry.index.data_size, size),
+        "Corrupted mmapdb entry ",
+        entry.key,
+        " in ",
+        source);
+    CAFFE_ENFORCE(
+        &entry == &file->entries.front() || (&entry - 1)->key < entry.key,
+        "Unsorted mmapdb index: ",
+        source);
+  }
+  return file;
+}
+
+class MmapDBCursor : public Cursor {
+ public:
+  explicit MmapDBCursor(std::shared_ptr<const MmapDBFile> file)
+      : file_(std::move(file)), pos_(0) {}
+  ~MmapDBCursor() {}
+
+  void Seek(const string& key) override {
+    const auto& entries = file_->entries;
+    pos_ = std::lower_bound(
+               entries.begin(),
+               entries.end(),
+               key,
+               [](const MmapDBEntry& entry, const string& key) {
+                 return entry.key < key;
+               }) -
+        entries.begin();
+  }
+
+  bool SupportsSeek() override { return true; }
+
+  void SeekToFirst() override { pos_ = 0; }
+
+  void Next() override { ++pos_; }
+
+  string key() override { return current().key; }
+
+  string value() override {
+    const auto& index = current().index;
+    if (!(index.flags & kMmapDBExternalData)) {
+      return string(file_->base + index.value_offset, index.value_size);
+    }
+    // Rebuilds the whole proto for the readers that do not alias the bytes
+    BlobProto proto;
+    ExternalTensorData external;
+    ExternalTensorValue(&proto, &external);
+    auto* tensor_proto = proto.mutable_tensor();
+    vector<TIndex> dims(
+        tensor_proto->dims().begin(), tensor_proto->dims().end());
+    TensorCPU tensor(dims);
+    tensor.ShareExternalPointer(
+        const_cast<void*>(external.data),
+        DataTypeToTypeMeta(tensor_proto->data_type()),
+        external.nbytes);
+    DeviceOption device_detail = tensor_proto->device_detail();
+    bool has_device_detail = tensor_proto->has_device_detail();
+    tensor_proto->clear_dims();
+    TensorSerializer<CPUContext>().Serialize(
+        tensor, proto.name(), tensor_proto, 0, tensor.size());
+    tensor_proto->clear_segment();
+    if (has_device_detail) {
+      *tensor_proto->mutable_device_detail() = device_detail;
+    } else {
+      tensor_proto->clear_device_detail();
+    }
+    return proto.SerializeAsString();
+  }
+
+  bool Valid() override { return pos_ < file_->entries.size(); }
+
+  bool ExternalTensorValue(BlobProto* proto, ExternalTensorData* external)
+      override {
+    const auto& entry = current();
+    if (!(entry.index.flags & kMmapDBExternalData)) {
+      return false;
+    }
+    CAFFE_ENFORCE(
+        proto->ParseFromArray(
+            file_->base + entry.index.value_offset, entry.index.value_size),
+        "Corrupted mmapdb value for ",
+        entry.key);
+    external->data = file_->base + entry.index.data_offset;
+    external->nbytes = entry.index.data_size;
+    external->owner = file_->mapping;
+    return true;
+  }
+
+ private:
+  const MmapDBEntry& current() const {
+    CAFFE_ENFORCE_LT(pos_, file_->entries.size(), "Cursor is not valid");
+    return file_->entries[pos_];
+  }
+
+  std::shared_ptr<const MmapDBFile> file_;
+  size_t pos_;
+};
+
+// Writes a new mmapdb file. Puts may come from several threads, e.g. the
+// chunks of a tensor from the serializer threads of SaveOp. The file is
+// written next to its destination and only renamed over it once it is
+// complete, so that processes which map the previous version keep reading
+// consistent data.
+class MmapDBWriter {
+ public:
+  explicit MmapDBWriter(const string& source)
+      : source_(source), temp_path_(source + ".tmp") {
+    fd_ = open(temp_path_.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    CAFFE_ENFORCE(fd_ >= 0, "Cannot open file: ", temp_path_);
+  }
+  ~MmapDBWriter() {
+    try {
+      Close();
+    } catch (const std::exception& e) {
+      LOG(ERROR) << "Failed to write mmapdb " << source_ << ": " << e.what();
+    }
+  }
+
+  void Put(const string& key, const string& value) {
+    BlobProto proto;
+    if (proto.ParseFromString(value) && proto.type() == kTensorBlobType &&
+        proto.has_tensor() &&
+        proto.tensor().data_type() != TensorProto_DataType_STRING &&
+        proto.tensor().data_type() != TensorProto_DataType_UNDEFINED) {
+      PutTensor(key.substr(0, key.find(kChunkIdSeparator)), &proto);
+      return;
+    }
+    uint64_t offset;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto& entry = NewEntry(key);
+      offset = entry.index.value_offset = end_;
+      entry.index.value_size = value.size();
+      end_ += value.size();
+    }
+    WriteAt(fd_, offset, value.data(), value.size(), temp_path_);
+  }
+
+  void Close() {
+    std::lock_guard<std::mutex> guard(mutex_);
+    if (fd_ < 0) {
+      return;
+    }
+    try {
+      string index;
+      for (auto& it : entries_) {
+        auto& entry = it.second;
+        if (entry.index.flags & kMmapDBExternalData) {
+          CAFFE_ENFORCE_EQ(
+              entry.filled, entry.numel, "Incomplete tensor: ", it.first);
+          entry.index.value_offset = end_;
+          entry.index.value_size = entry.meta.size();
+          WriteAt(fd_, end_, entry.meta.data(), entry.meta.size(), temp_path_);
+          end_ += entry.meta.size();
+        }
+        entry.index.key_size = it.first.size();
+        index.append(
+            reinterpret_cast<const char*>(&entry.index), sizeof(entry.index));
+        index.append(it.first);
+      }
+      MmapDBHeader header;
+      memcpy(header.magic, kMmapDBMagic, sizeof(kMmapDBMagic));
+      header.version = kMmapDBVersion;
+      header.index_offset = end_;
+      header.num_entries = entries_.size();
+      WriteAt(fd_, end_, index.data(), index.size(), temp_path_);
+      WriteAt(fd_, 0, &header, sizeof(header), temp_path_);
+      CAFFE_ENFORCE(close(fd_) == 0, "Cannot write ", temp_path_);
+      fd_ = -1;
+      CAFFE_ENFORCE(
+          rename(temp_path_.c_str(), source_.c_str()) == 0,
+          "Cannot rename ",
+          temp_path_,
+          " to ",
+          source_,
+          ": ",
+          strerror(errno));
+    } catch (...) {
+      if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+      }
+      unlink(temp_path_.c_str());
+      throw;
+    }
+  }
+
+ private:
+  struct PendingEntry {
+    MmapDBIndexEntry index = MmapDBIndexEntry();
+    // For tensors, the BlobProto without the data, and the number of
+    // elements of the tensor and of the chunks written so far
+    string meta;
+    int64_t numel = 0;
+    int64_t filled = 0;
+    size_t itemsize = 0;
+  };
+
+  PendingEntry& NewEntry(const string& key) {
+    CAFFE_ENFORCE(fd_ >= 0, "mmapdb is closed: ", source_);
+    auto result = entries_.emplace(key, PendingEntry());
+    CAFFE_ENFORCE(result.second, "Duplicate key in mmapdb: ", key);
+    return result.first->second;
+  }
+
+  // Writes the data of a chunk of the tensor at its place in the flat
+  // buffer of the tensor
+  void PutTensor(const string& key, BlobProto* proto) {
+    auto& tensor_proto = *proto->mutable_tensor();
+    int64_t numel = 1;
+    for (const auto dim : tensor_proto.dims()) {
+      numel *= dim;
+    }
+    int64_t begin = 0;
+    int64_t end = numel;
+    if (tensor_proto.has_segment()) {
+      begin = tensor_proto.segment().begin();
+      end = tensor_proto.segment().end();
+    }
+    CAFFE_ENFORCE(
+        0 <= begin && begin <= end && end <= numel,
+        "Invalid chunk ",
+        begin,
+        ' ',
+        end,
+        " of tensor ",
+        key);
+
+    uint64_t offset;
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      auto it = entries_.find(key);
+      if (it == entries_.end()) {
+        auto& entry = NewEntry(key);
+        BlobProto meta;
+        meta.set_name(proto->name());
+        meta.set_type(proto->type());
+        auto* meta_tensor = meta.mutable_tensor();
+        *meta_tensor->mutable_dims() = tensor_proto.dims();
+        meta_tensor->set_data_type(tensor_proto.data_type());
+        meta_tensor->set_name(tensor_proto.name());
+        if (tensor_proto.has_device_detail()) {
+          *meta_tensor->mutable_device_detail() = tensor_proto.device_detail();
+        }
+        entry.meta = meta.SerializeAsString();
+        entry.numel = numel;
+        entry.itemsize =
+            DataTypeToTypeMeta(tensor_proto.data_type()).itemsize();
+        entry.index.flags = kMmapDBExternalData;
+        entry.index.data_offset = (end_ + kMmapDBAlignment - 1) /
+            kMmapDBAlignment * kMmapDBAlignment;
+        entry.index.data_size = numel * entry.itemsize;
+        end_ = entry.index.data_offset + entry.index.data_size;
+        it = entries_.find(key);
+      }
+      auto& entry = it->second;
+      CAFFE_ENFORCE(
+          entry.index.flags & kMmapDBExternalData,
+          "Key is both a tensor and another value: ",
+          key);
+      CAFFE_ENFORCE_EQ(
+          entry.numel, numel, "Chunks of different sizes for tensor ", key);
+      entry.filled += end - begin;
+      CAFFE_ENFORCE_LE(
+          entry.filled, entry.numel, "Duplicate chunks for tensor ", key);
+      offset = entry.index.data_offset + begin * entry.itemsize;
+    }
+
+    // Decodes the chunk alone, as a tensor of its own size on CPU
+    tensor_proto.clear_dims();
+    tensor_proto.add_dims(end - begin);
+    tensor_proto.clear_segment();
+    tensor_proto.clear_device_detail();
+    TensorCPU chunk;
+    TensorDeserializer<CPUContext>().Deserialize(tensor_proto, &chunk);
+    if (chunk.nbytes() > 0) {
+      WriteAt(fd_, offset, chunk.raw_data(), chunk.nbytes(), temp_path_);
+    }
+  }
+
+  string source_;
+  string temp_path_;
+  int fd_;
+  // The end of the data written or reserved so far
+  uint64_t end_ = sizeof(MmapDBHeader);
+  std::map<string, PendingEntry> entries_;
+  std::mutex mutex_;
+
+  DISABLE_COPY_AND_ASSIGN(MmapDBWriter);
+};
+
+class MmapDBTransaction : public Transaction {
+ public:
+  explicit MmapDBTransaction(MmapDBWriter* writer) : writer_(writer) {}
+  ~MmapDBTransaction() { Commit(); }
+
+  void Put(const string& key, const string& value) override {
+    writer_->Put(key, value);
+  }
+
+  // Puts are written to the file right away, and it is completed by closing
+  // the db
+  void Commit() override {}
+
+ private:
+  MmapDBWriter* writer_;
+
+  DISABLE_COPY_AND_ASSIGN(MmapDBTransaction);
+};
+
+} // namespace
+
+class MmapDB : public DB {
+ public:
+  MmapDB(const string& source, Mode mode) : DB(source, mode) {
+    switch (mode) {
+      case NEW:
+        writer_ = make_unique<MmapDBWriter>(source);
+        break;
+      case WRITE:
+        CAFFE_THROW(
+            "mmapdb files cannot be appended to, open them as NEW: ", source);
+        break;
+      case READ:
+        file_ = OpenMmapDBFile(source);
+        break;
+    }
+    VLOG(1) << "Opened MmapDB " << source;
+  }
+  // The writer logs the errors of an implicit close instead of throwing
+  ~MmapDB() {}
+
+  void Close() override {
+    if (writer_) {
+      writer_->Close();
+    }
+    file_.reset();
+  }
+
+  unique_ptr<Cursor> NewCursor() override {
+    CAFFE_ENFORCE_EQ(this->mode_, READ);
+    CAFFE_ENFORCE(file_, "mmapdb is closed");
+    return make_unique<MmapDBCursor>(file_);
+  }
+
+  unique_ptr<Transaction> NewTransaction() override {
+    CAFFE_ENFORCE_EQ(this->mode_, NEW);
+    return make_unique<MmapDBTransaction>(writer_.get());
+  }
+
+ private:
+  std::unique_ptr<MmapDBWriter> writer_;
+  std::shared_ptr<const MmapDBFile> file_;
+};
+
+REGISTER_CAFFE2_DB(MmapDB, MmapDB);
+REGISTER_CAFFE2_DB(mmapdb, MmapDB);
+
+}  // namespace db
+}  // namespace caffe2
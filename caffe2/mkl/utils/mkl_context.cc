@@ -17,5 +17,6 @@ REGISTER_EVENT_QUERY_FUNCTION(MKLDNN, EventQueryCPU);
 REGISTER_EVENT_ERROR_MESSAGE_FUNCTION(MKLDNN, EventErrorMessageCPU);
 REGISTER_EVENT_SET_FINISHED_FUNCTION(MKLDNN, EventSetFinishedCPU);
 REGISTER_EVENT_RESET_FUNCTION(MKLDNN, EventResetCPU);
+REGISTER_EVENT_SET_CALLBACK_FUNCTION(MKLDNN, EventSetCallbackCPU);
 
 } // namespace caffe2
@@ -42,6 +42,11 @@ If at least one input is passed, then it is assumed that that input blobs are a
 set of DBReaders to load from. Otherwise the db or dbs argument is used to load
 blobs from one single db or multiple dbs respectively. db_type argument is used
 to specify the type of the input db/dbs.
+
+With db_type mmapdb, the tensors loaded on CPU are not copied but alias the
+pages of the memory-mapped file, which are read lazily and shared by all the
+processes that load the same file. Writing to such a tensor copies the pages
+it touches and leaves the file unchanged.
 )DOC")
     .Arg(
         "absolute_path",
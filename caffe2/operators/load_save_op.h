@@ -215,15 +215,10 @@ class LoadOp final : public Operator<Context> {
       }
 
       BlobProto proto;
-      CAFFE_ENFORCE(
-          proto.ParseFromString(cursor->value()), "Couldn't parse Proto");
-      if (!keep_device_) {
-        // If we are not keeping the device as the one specified in the
-        // proto, we will set the current device.
-        SetCurrentDevice(&proto);
-      }
+      db::ExternalTensorData external;
+      ReadProto(cursor, &proto, &external);
       Blob* blob = ws_->CreateBlob(key);
-      ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
+      ProcessBlob(blob, proto, external, blob_states, key, &loaded_blobs);
     }
     *total_loaded_blobs += loaded_blobs;
   }
@@ -249,15 +244,11 @@ class LoadOp final : public Operator<Context> {
 
         VLOG(2) << "Deserializing blob " << key;
         BlobProto proto;
-        CAFFE_ENFORCE(proto.ParseFromString(cursor->value()));
-        if (!keep_device_) {
-          // If we are not keeping the device as the one specified in the
-          // proto, we will set the current device.
-          SetCurrentDevice(&proto);
-        }
+        db::ExternalTensorData external;
+        ReadProto(cursor, &proto, &external);
         auto blobIndex = output_indices_[key];
         Blob* blob = outputs.at(blobIndex);
-        ProcessBlob(blob, proto, blob_states, key, &loaded_blobs);
+        ProcessBlob(blob, proto, external, blob_states, key, &loaded_blobs);
 
         if (*total_loaded_blobs + loaded_blobs == OutputSize()) {
           break;
@@ -268,6 +259,33 @@ class LoadOp final : public Operator<Context> {
     *total_loaded_blobs += loaded_blobs;
   }
 
+  // Reads the value at the cursor. The tensors whose bytes the db keeps
+  // outside of the proto, e.g. in a memory-mapped file, are returned as
+  // external data when they are loaded on CPU, so that they can be aliased
+  // instead of copied. The other devices deserialize the whole proto.
+  void ReadProto(
+      Cursor* cursor,
+      BlobProto* proto,
+      db::ExternalTensorData* external) {
+    if (cursor->ExternalTensorValue(proto, external)) {
+      if (!keep_device_) {
+        SetCurrentDevice(proto);
+      }
+      if (proto->tensor().device_detail().device_type() == CPU) {
+        return;
+      }
+      proto->Clear();
+      *external = db::ExternalTensorData();
+    }
+    CAFFE_ENFORCE(
+        proto->ParseFromString(cursor->value()), "Couldn't parse Proto");
+    if (!keep_device_) {
+      // If we are not keeping the device as the one specified in the
+      // proto, we will set the current device.
+      SetCurrentDevice(proto);
+    }
+  }
+
   string buildBlobNameFromDbKey(const string& dbKey) {
     string key = dbKey.substr(0, dbKey.find(kChunkIdSeparator));
     if (!strip_prefix_.empty()) {
@@ -286,6 +304,7 @@ class LoadOp final : public Operator<Context> {
   void ProcessBlob(
       Blob* blob,
       const BlobProto& proto,
+      const db::ExternalTensorData& external,
       std::unordered_map<string, BlobState>* blob_states_ptr,
       const string& key,
       int* loaded_blobs) {
@@ -298,7 +317,11 @@ class LoadOp final : public Operator<Context> {
       // different GPU.
       blob->Reset();
     }
-    blob->Deserialize(proto);
+    if (external.owner) {
+      ShareExternalTensor(blob, proto, external);
+    } else {
+      blob->Deserialize(proto);
+    }
     if (proto.has_content_num_chunks()) {
       if (!blob_states.count(key)) {
         blob_states[key] = BlobState(proto.content_num_chunks());
@@ -374,6 +397,30 @@ class LoadOp final : public Operator<Context> {
     }
   }
 
+  // Makes the CPU tensor of the blob alias the external data, which is kept
+  // alive by the tensor.
+  void ShareExternalTensor(
+      Blob* blob,
+      const BlobProto& proto,
+      const db::ExternalTensorData& external) {
+    const auto& tensor_proto = proto.tensor();
+    vector<TIndex> dims(tensor_proto.dims().begin(), tensor_proto.dims().end());
+    const auto& meta = DataTypeToTypeMeta(tensor_proto.data_type());
+    auto* tensor = blob->GetMutable<TensorCPU>();
+    tensor->Resize(dims);
+    CAFFE_ENFORCE_EQ(
+        tensor->size() * meta.itemsize(),
+        external.nbytes,
+        "Data size mismatch for tensor ",
+        proto.name());
+    auto owner = external.owner;
+    tensor->ShareExternalPointer(
+        const_cast<void*>(external.data),
+        meta,
+        external.nbytes,
+        [owner](void* /*unused*/) {});
+  }
+
   void validateBlobStates(
       const std::unordered_map<string, BlobState>& blob_states) {
     for (const auto& iter : blob_states) {
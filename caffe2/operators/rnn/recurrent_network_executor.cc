@@ -15,10 +15,26 @@ std::unique_ptr<RecurrentNetworkExecutorBase> createRNNExecutor<CPUContext>(
     std::map<string, string>& recurrent_input_map,
     std::string timestep_blob,
     ArgumentHelper rnn_args) {
-  auto* exec = new ThreadedRecurrentNetworkExecutor(
-      step_net_def, recurrent_input_map, timestep_blob);
   int num_threads =
       rnn_args.GetSingleArgument<int>("rnn_executor.num_threads", 0);
+  if (rnn_args.GetSingleArgument<int>("rnn_executor.wavefront", 0)) {
+    auto* exec = new WavefrontRecurrentNetworkExecutor(
+        step_net_def, recurrent_input_map, timestep_blob);
+    if (num_threads > 0) {
+      exec->setNumThreads(num_threads);
+      LOG(INFO) << "Set num threads: " << num_threads;
+    }
+    int max_batch =
+        rnn_args.GetSingleArgument<int>("rnn_executor.max_batch", 0);
+    if (max_batch > 0) {
+      exec->setMaxBatch(max_batch);
+    }
+    exec->debug_ = rnn_args.GetSingleArgument<int>("rnn_executor_debug", 0);
+    return std::unique_ptr<RecurrentNetworkExecutorBase>(exec);
+  }
+
+  auto* exec = new ThreadedRecurrentNetworkExecutor(
+      step_net_def, recurrent_input_map, timestep_blob);
   if (num_threads > 0) {
     exec->setNumThreads(num_threads);
     LOG(INFO) << "Set num threads: " << num_threads;
@@ -69,11 +85,9 @@ bool ThreadedRecurrentNetworkExecutor::RunBackwards(int T) {
   return true;
 }
 
-/**
- * Runs a single op and updates its dependencies when finished. If
- * dependent ops are ready to run, adds them to the task_queue.
- */
-void ThreadedRecurrentNetworkExecutor::RunOp(OpTask job, int thread_id) {
+void RecurrentNetworkExecutorBase::RunOpAndCollectReady(
+    const OpTask& job,
+    std::vector<OpTask>* ready) {
   bool first_timestep =
       ((job.forward() && job.timestep == 0) ||
        (job.backward() && job.timestep == job.T - 1));
@@ -124,9 +138,21 @@ void ThreadedRecurrentNetworkExecutor::RunOp(OpTask job, int thread_id) {
     }
 
     if (proc_inputs == num_req_inputs || num_req_inputs == 0) {
-      task_queue_.Push(OpTask(t, depidx, job.T, job.direction));
+      ready->push_back(OpTask(t, depidx, job.T, job.direction));
     }
   }
+}
+
+/**
+ * Runs a single op and updates its dependencies when finished. If
+ * dependent ops are ready to run, adds them to the task_queue.
+ */
+void ThreadedRecurrentNetworkExecutor::RunOp(OpTask job, int /*thread_id*/) {
+  std::vector<OpTask> ready;
+  RunOpAndCollectReady(job, &ready);
+  for (const auto& task : ready) {
+    task_queue_.Push(task);
+  }
 
   // Decrement countdown: when at zero, we have run all ops and can
   // notify the caller thread.
@@ -219,4 +245,257 @@ void ThreadedRecurrentNetworkExecutor::_Exec() {
       "RNN executor encountered failure. See prior error logs for details.");
 }
 
+/**
+ * Implementation of WavefrontRecurrentNetworkExecutor.
+ */
+
+WavefrontRecurrentNetworkExecutor::~WavefrontRecurrentNetworkExecutor() {
+  {
+    std::lock_guard<std::mutex> lk(work_mtx_);
+    stop_ = true;
+  }
+  work_cv_.notify_all();
+  VLOG(1) << "Joining workers.";
+  for (auto& worker : workers_) {
+    worker.join();
+  }
+}
+
+bool WavefrontRecurrentNetworkExecutor::Run(int T) {
+  CAFFE_ENFORCE(timestep_ops_.size() >= T);
+  Exec(T, 1, 0);
+  return true;
+}
+
+bool WavefrontRecurrentNetworkExecutor::RunBackwards(int T) {
+  CAFFE_ENFORCE(timestep_ops_.size() >= T);
+  Exec(T, -1, T - 1);
+  return true;
+}
+
+/**
+ * The priority of an op at a timestep is the length of the longest chain
+ * of ops that depend on it, through the following timesteps of the run.
+ */
+void WavefrontRecurrentNetworkExecutor::ComputePriorities(
+    int T,
+    int direction) {
+  int num_ops = timestep_ops_template_.size();
+  priority_.assign(T * num_ops, 0);
+  for (int step = T - 1; step >= 0; step--) {
+    int t = direction == 1 ? step : T - 1 - step;
+    bool last_timestep = step == T - 1;
+    // Dependencies within a timestep are on later ops
+    for (int i = num_ops - 1; i >= 0; i--) {
+      int longest = 0;
+      for (int depidx : timestep_ops_template_[i].dependencies) {
+        int dep_t = t;
+        if (depidx <= i) {
+          if (last_timestep) {
+            continue;
+          }
+          dep_t += direction;
+        }
+        longest = std::max(longest, priority_[dep_t * num_ops + depidx]);
+      }
+      priority_[t * num_ops + i] = longest + 1;
+    }
+  }
+}
+
+void WavefrontRecurrentNetworkExecutor::Exec(
+    int T,
+    int direction,
+    int first_timestep) {
+  CAFFE_ENFORCE_EQ(
+      false, failed_, "Tried to execute a previously failed RNN executor");
+
+  ComputePriorities(T, direction);
+  countdown_ = T * timestep_ops_[0].size();
+  finished_timesteps_ = 0;
+
+  while (queues_.size() < num_threads_) {
+    queues_.emplace_back(new WorkerQueue());
+  }
+
+  // Spread the frontier ops over the workers
+  int worker_id = 0;
+  for (auto& rnn_op : timestep_ops_[first_timestep]) {
+    if (rnn_op.frontier) {
+      Push(worker_id, OpTask(first_timestep, rnn_op.order, T, direction));
+      worker_id = (worker_id + 1) % num_threads_;
+    }
+  }
+
+  // Start threads if not started
+  std::unique_lock<std::mutex> lk(countdown_mtx_);
+  while (workers_.size() < num_threads_) {
+    VLOG(1) << "Start RNN worker " << workers_.size() << " / " << num_threads_;
+    workers_.push_back(std::thread(
+        &WavefrontRecurrentNetworkExecutor::WorkerFunction,
+        this,
+        workers_.size()));
+  }
+
+  // Wait until threads finish.
+  Timer t;
+  while (!failed_ && countdown_ > 0) {
+    cv_.wait_for(lk, std::chrono::seconds(30), [&] {
+      if (t.Seconds() > 10) {
+        LOG(INFO) << "RNN Executor still running, remaining ops: "
+                  << countdown_;
+      }
+      return failed_ || countdown_ == 0;
+    });
+  }
+
+  CAFFE_ENFORCE_EQ(
+      false,
+      failed_,
+      "RNN executor encountered failure. See prior error logs for details.");
+}
+
+void WavefrontRecurrentNetworkExecutor::Push(
+    int worker_id,
+    const OpTask& task) {
+  int num_ops = timestep_ops_template_.size();
+  int priority = priority_[task.timestep * num_ops + task.op_idx];
+  auto& queue = *queues_[worker_id];
+  {
+    std::lock_guard<std::mutex> lk(queue.mutex);
+    queue.heap.push_back(PrioritizedTask{task, priority});
+    std::push_heap(queue.heap.begin(), queue.heap.end());
+  }
+  pending_.fetch_add(1);
+  // Sleeping workers check pending_ under work_mtx_ before they wait
+  if (sleeping_.load() > 0) {
+    std::lock_guard<std::mutex> lk(work_mtx_);
+    work_cv_.notify_one();
+  }
+}
+
+bool WavefrontRecurrentNetworkExecutor::TryPop(
+    WorkerQueue* queue,
+    std::vector<OpTask>* batch,
+    bool own) {
+  std::lock_guard<std::mutex> lk(queue->mutex);
+  auto& heap = queue->heap;
+  if (heap.empty()) {
+    return false;
+  }
+  std::pop_heap(heap.begin(), heap.end());
+  batch->push_back(heap.back().task);
+  heap.pop_back();
+
+  // Other timesteps of the same op are independent of it, since they are
+  // all ready
+  if (own && max_batch_ > 1) {
+    int op_idx = batch->front().op_idx;
+    auto it = heap.begin();
+    while (it != heap.end() && batch->size() < max_batch_) {
+      if (it->task.op_idx == op_idx) {
+        batch->push_back(it->task);
+        *it = heap.back();
+        heap.pop_back();
+      } else {
+        ++it;
+      }
+    }
+    std::make_heap(heap.begin(), heap.end());
+  }
+  pending_.fetch_sub(batch->size());
+  return true;
+}
+
+bool WavefrontRecurrentNetworkExecutor::PopBatch(
+    int worker_id,
+    std::vector<OpTask>* batch) {
+  batch->clear();
+  for (;;) {
+    if (TryPop(queues_[worker_id].get(), batch, true)) {
+      return true;
+    }
+    for (int i = 1; i < queues_.size(); i++) {
+      auto* victim = queues_[(worker_id + i) % queues_.size()].get();
+      if (TryPop(victim, batch, false)) {
+        return true;
+      }
+    }
+
+    std::unique_lock<std::mutex> lk(work_mtx_);
+    sleeping_.fetch_add(1);
+    work_cv_.wait(lk, [this] { return stop_ || pending_.load() > 0; });
+    sleeping_.fetch_sub(1);
+    if (stop_) {
+      return false;
+    }
+  }
+}
+
+bool WavefrontRecurrentNetworkExecutor::CanStart(const OpTask& task) {
+  if (max_parallel_timesteps_ <= 0) {
+    return true;
+  }
+  int step = task.forward() ? task.timestep : task.T - 1 - task.timestep;
+  std::lock_guard<std::mutex> lk(deferred_mtx_);
+  if (step - finished_timesteps_ >= max_parallel_timesteps_) {
+    deferred_.push_back(task);
+    return false;
+  }
+  return true;
+}
+
+/**
+ * Run-loop for executor threads: pop tasks from the own queue of the
+ * worker, or steal them from others, and run them.
+ */
+void WavefrontRecurrentNetworkExecutor::WorkerFunction(int worker_id) {
+  size_t num_jobs = 0;
+  std::vector<OpTask> batch;
+  std::vector<OpTask> ready;
+  while (PopBatch(worker_id, &batch)) {
+    for (const auto& job : batch) {
+      if (failed_ || !CanStart(job)) {
+        continue;
+      }
+      try {
+        ready.clear();
+        RunOpAndCollectReady(job, &ready);
+        for (const auto& task : ready) {
+          Push(worker_id, task);
+        }
+        if (job.op_idx == timestep_ops_template_.size() - 1) {
+          std::vector<OpTask> released;
+          {
+            std::lock_guard<std::mutex> lk(deferred_mtx_);
+            finished_timesteps_++;
+            released.swap(deferred_);
+          }
+          for (const auto& task : released) {
+            Push(worker_id, task);
+          }
+        }
+        num_jobs++;
+      } catch (::caffe2::EnforceNotMet& enf) {
+        std::unique_lock<std::mutex> lk(countdown_mtx_);
+        LOG(ERROR) << "Crash at thread " << worker_id << " timestep "
+                   << job.timestep
+                   << " op:" << ProtoDebugString(step_net_def_.op(job.op_idx))
+                   << enf.what();
+        failed_ = true;
+        cv_.notify_one();
+        continue;
+      }
+
+      // Decrement countdown: when at zero, we have run all ops and can
+      // notify the caller thread.
+      if (countdown_.fetch_sub(1) == 1) {
+        std::unique_lock<std::mutex> lk(countdown_mtx_);
+        cv_.notify_one();
+      }
+    }
+  }
+  VLOG(1) << "Worker exiting, did run: " << num_jobs << " jobs";
+}
+
 } // namespace caffe2
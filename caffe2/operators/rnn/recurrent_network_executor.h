@@ -457,6 +457,13 @@ class RecurrentNetworkExecutorBase {
 
   virtual bool ignoreLinkDependencies() = 0;
 
+  /**
+   * Runs a single op and knocks down the dependencies of the ops that
+   * depend on it. Adds those that have all their inputs to 'ready'.
+   * Used by the CPU executors.
+   */
+  void RunOpAndCollectReady(const OpTask& job, std::vector<OpTask>* ready);
+
   std::vector<std::vector<RNNNetOperator>> timestep_ops_;
   std::vector<OperatorBase*> op_ptrs_;
 
@@ -530,6 +537,114 @@ class ThreadedRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase {
   int num_threads_ = 4;
 };
 
+/**
+ * CPU executor that schedules ops along the diagonal wavefront of the
+ * unrolled network, enabled with the rnn_executor.wavefront argument.
+ *
+ * Ops of a multi-layer RNN depend on the previous layer in the same
+ * timestep and on the same layer in the previous timestep, so layer L at
+ * timestep t can run alongside layer L+1 at timestep t-1. Before each run,
+ * every op of every timestep gets as priority the length of the longest
+ * chain of ops that depend on it, and ready ops with the longest chain run
+ * first. This keeps the whole diagonal busy rather than letting the lower
+ * layers run ahead.
+ *
+ * Each worker has its own priority queue, where it puts the ops that its
+ * ops made ready, and steals from the others when its own is empty. If
+ * rnn_executor.max_batch is set above 1, a worker also takes from its queue
+ * up to max_batch - 1 other ready instances of the op it is about to run,
+ * at different timesteps, and runs them back to back while the op's weights
+ * are in cache.
+ */
+class WavefrontRecurrentNetworkExecutor : public RecurrentNetworkExecutorBase {
+ public:
+  WavefrontRecurrentNetworkExecutor(
+      const NetDef& step_net_def,
+      std::map<string, string>& recurrent_input_map,
+      std::string timestep_blob)
+      : RecurrentNetworkExecutorBase(
+            step_net_def,
+            recurrent_input_map,
+            timestep_blob),
+        failed_(false) {}
+
+  ~WavefrontRecurrentNetworkExecutor();
+
+  bool Run(int T) override;
+
+  bool RunBackwards(int T) override;
+
+  bool ignoreLinkDependencies() override {
+    return false;
+  }
+
+  void setNumThreads(int n) {
+    num_threads_ = n;
+  }
+
+  void setMaxBatch(int n) {
+    max_batch_ = n;
+  }
+
+ private:
+  struct PrioritizedTask {
+    OpTask task;
+    int priority;
+
+    bool operator<(const PrioritizedTask& other) const {
+      return priority < other.priority;
+    }
+  };
+
+  // A max-heap of tasks by priority
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::vector<PrioritizedTask> heap;
+  };
+
+  void ComputePriorities(int T, int direction);
+
+  void Exec(int T, int direction, int first_timestep);
+
+  void Push(int worker_id, const OpTask& task);
+
+  // Pops the tasks to run next into 'batch', waiting if there are none.
+  // Returns false when the executor stops.
+  bool PopBatch(int worker_id, std::vector<OpTask>* batch);
+
+  bool TryPop(WorkerQueue* queue, std::vector<OpTask>* batch, bool own);
+
+  // Returns false if the task cannot start yet because of
+  // max_parallel_timesteps_, in which case it is put aside
+  bool CanStart(const OpTask& task);
+
+  void WorkerFunction(int worker_id);
+
+  // priority_[t * num ops + op]
+  std::vector<int> priority_;
+  std::vector<std::unique_ptr<WorkerQueue>> queues_;
+  std::atomic<int> pending_{0};
+  std::atomic<int> sleeping_{0};
+  std::mutex work_mtx_;
+  std::condition_variable work_cv_;
+  bool stop_ = false;
+
+  std::atomic<int> countdown_;
+  std::atomic<bool> failed_;
+  std::mutex countdown_mtx_;
+  std::condition_variable cv_;
+
+  // Tasks waiting for earlier timesteps to finish, see SetMaxParallelTimesteps
+  std::mutex deferred_mtx_;
+  std::vector<OpTask> deferred_;
+  int finished_timesteps_ = 0;
+
+  std::vector<std::thread> workers_;
+  int num_threads_ = 4;
+  // Off by default
+  int max_batch_ = 1;
+};
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_RECURRENT_NETWORK_EXECUTOR_H_
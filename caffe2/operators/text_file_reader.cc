@@ -1,3 +1,9 @@
+#include <condition_variable>
+#include <exception>
+#include <map>
+#include <mutex>
+#include <thread>
+
 #include "caffe2/core/context.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/tensor.h"
@@ -7,32 +13,275 @@
 
 namespace caffe2 {
 
+inline void convert(
+    TensorProto_DataType dst_type,
+    const char* src_start,
+    const char* src_end,
+    void* dst) {
+  switch (dst_type) {
+    case TensorProto_DataType_STRING: {
+      static_cast<std::string*>(dst)->assign(src_start, src_end);
+    } break;
+    case TensorProto_DataType_FLOAT: {
+      // TODO(azzolini): avoid copy, use faster convertion
+      std::string str_copy(src_start, src_end);
+      const char* src_copy = str_copy.c_str();
+      char* src_copy_end;
+      float val = strtof(src_copy, &src_copy_end);
+      if (src_copy == src_copy_end) {
+        throw std::runtime_error("Invalid float: " + str_copy);
+      }
+      *static_cast<float*>(dst) = val;
+    } break;
+    default:
+      throw std::runtime_error("Unsupported type.");
+  }
+}
+
+// Reads a memory-mapped file with several threads. The file is split into
+// ranges of whole lines, which the threads tokenize and convert to the field
+// types ahead of the readers, up to a few ranges per thread. The rows are
+// returned in the order of the file, or in the order in which the ranges are
+// converted if ordered is false.
+class ParallelTextFileReader {
+ public:
+  ParallelTextFileReader(
+      const std::vector<char>& delims,
+      char escape,
+      const std::string& filename,
+      int numPasses,
+      const std::vector<int>& types,
+      const std::vector<TypeMeta>& metas,
+      int numThreads,
+      bool ordered,
+      size_t chunkSize)
+      : file_(filename),
+        delims_(delims),
+        escape_(escape),
+        fieldTypes_(types),
+        fieldMetas_(metas),
+        ordered_(ordered),
+        ranges_(splitLines(
+            file_.begin(),
+            file_.end(),
+            chunkSize,
+            delims.at(0),
+            escape)),
+        numChunks_(ranges_.size() * numPasses),
+        maxPending_(2 * numThreads) {
+    for (int i = 0; i < numThreads; ++i) {
+      workers_.emplace_back([this]() { work(); });
+    }
+  }
+
+  ~ParallelTextFileReader() {
+    {
+      std::lock_guard<std::mutex> guard(mutex_);
+      stop_ = true;
+    }
+    workCv_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // Copies up to maxRows rows into the fields, and returns the number of
+  // rows copied, which is 0 at the end of the last pass.
+  TIndex read(TIndex maxRows, std::vector<char*>& datas, CPUContext* context) {
+    TIndex rowsRead = 0;
+    while (rowsRead < maxRows) {
+      if (!current_ || current_->rowsRead == current_->numRows) {
+        if (!nextChunk()) {
+          break;
+        }
+        continue;
+      }
+      auto rows =
+          std::min(maxRows - rowsRead, current_->numRows - current_->rowsRead);
+      for (int field = 0; field < datas.size(); ++field) {
+        const auto& meta = fieldMetas_[field];
+        context->CopyItems<CPUContext, CPUContext>(
+            meta,
+            rows,
+            static_cast<const char*>(current_->fields[field].raw_data()) +
+                current_->rowsRead * meta.itemsize(),
+            datas[field]);
+        datas[field] += rows * meta.itemsize();
+      }
+      current_->rowsRead += rows;
+      rowsRead += rows;
+    }
+    return rowsRead;
+  }
+
+ private:
+  // The rows of a range of the file, converted to the field types
+  struct Chunk {
+    explicit Chunk(size_t numFields) : fields(numFields) {}
+
+    std::vector<TensorCPU> fields;
+    TIndex numRows{0};
+    TIndex rowsRead{0};
+    std::exception_ptr error;
+  };
+
+  // Waits for the next chunk to read, and returns false after the last one
+  bool nextChunk() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (chunksRead_ == numChunks_) {
+      current_.reset();
+      return false;
+    }
+    readyCv_.wait(lock, [this]() {
+      return ordered_ ? ready_.count(chunksRead_) > 0 : !ready_.empty();
+    });
+    auto it = ordered_ ? ready_.find(chunksRead_) : ready_.begin();
+    current_ = std::move(it->second);
+    ready_.erase(it);
+    ++chunksRead_;
+    lock.unlock();
+    workCv_.notify_all();
+    if (current_->error) {
+      std::rethrow_exception(current_->error);
+    }
+    return true;
+  }
+
+  void work() {
+    while (true) {
+      size_t id;
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        workCv_.wait(lock, [this]() {
+          return stop_ || nextChunk_ == numChunks_ ||
+              nextChunk_ < chunksRead_ + maxPending_;
+        });
+        if (stop_ || nextChunk_ == numChunks_) {
+          return;
+        }
+        id = nextChunk_++;
+      }
+      auto chunk = convertChunk(ranges_[id % ranges_.size()]);
+      {
+        std::lock_guard<std::mutex> guard(mutex_);
+        ready_[id] = std::move(chunk);
+      }
+      readyCv_.notify_all();
+    }
+  }
+
+  std::unique_ptr<Chunk> convertChunk(const CharRange& range) {
+    const int numFields = fieldTypes_.size();
+    std::unique_ptr<Chunk> chunk(new Chunk(numFields));
+    try {
+      Tokenizer tokenizer(delims_, escape_);
+      TokenizedString tokenized;
+      tokenizer.next(range.start, range.end, tokenized);
+      const auto& tokens = tokenized.tokens();
+      for (int i = 0; i < tokens.size(); ++i) {
+        int field = i % numFields;
+        CAFFE_ENFORCE(
+            (field == 0 && tokens[i].startDelimId == 0) ||
+                (field > 0 && tokens[i].startDelimId == 1),
+            "Invalid number of columns in the lines starting at byte ",
+            range.start - file_.begin());
+      }
+      CAFFE_ENFORCE(
+          tokens.size() % numFields == 0,
+          "Invalid number of fields at the end of the lines starting at byte ",
+          range.start - file_.begin());
+      chunk->numRows = tokens.size() / numFields;
+      for (int field = 0; field < numFields; ++field) {
+        auto& tensor = chunk->fields[field];
+        tensor.Resize(chunk->numRows);
+        char* data =
+            static_cast<char*>(tensor.raw_mutable_data(fieldMetas_[field]));
+        for (TIndex row = 0; row < chunk->numRows; ++row) {
+          const auto& token = tokens[row * numFields + field];
+          convert(
+              static_cast<TensorProto_DataType>(fieldTypes_[field]),
+              token.start,
+              token.end,
+              data);
+          data += fieldMetas_[field].itemsize();
+        }
+      }
+    } catch (...) {
+      chunk->error = std::current_exception();
+    }
+    return chunk;
+  }
+
+  MappedFile file_;
+  const std::vector<char> delims_;
+  const char escape_;
+  const std::vector<int> fieldTypes_;
+  const std::vector<TypeMeta> fieldMetas_;
+  const bool ordered_;
+  const std::vector<CharRange> ranges_;
+  const size_t numChunks_;
+  const size_t maxPending_;
+
+  std::mutex mutex_;
+  std::condition_variable workCv_;
+  std::condition_variable readyCv_;
+  bool stop_{false};
+  // Index of the next chunk to convert, and number of chunks handed to the
+  // readers. A chunk is the range of index id % ranges_.size() in the pass
+  // id / ranges_.size().
+  size_t nextChunk_{0};
+  size_t chunksRead_{0};
+  std::map<size_t, std::unique_ptr<Chunk>> ready_;
+  // Only used by the readers, under the lock of the instance
+  std::unique_ptr<Chunk> current_;
+  std::vector<std::thread> workers_;
+};
+
 struct TextFileReaderInstance {
   TextFileReaderInstance(
       const std::vector<char>& delims,
       char escape,
       const std::string& filename,
       int numPasses,
-      const std::vector<int>& types)
-      : fileReader(filename),
-        tokenizer(Tokenizer(delims, escape), &fileReader, numPasses),
-        fieldTypes(types) {
+      const std::vector<int>& types,
+      int numThreads = 0,
+      bool ordered = true,
+      size_t chunkSize = 0)
+      : fieldTypes(types) {
     for (const auto dt : fieldTypes) {
       fieldMetas.push_back(
           DataTypeToTypeMeta(static_cast<TensorProto_DataType>(dt)));
       fieldByteSizes.push_back(fieldMetas.back().itemsize());
     }
+    if (numThreads > 0) {
+      parallelReader.reset(new ParallelTextFileReader(
+          delims,
+          escape,
+          filename,
+          numPasses,
+          fieldTypes,
+          fieldMetas,
+          numThreads,
+          ordered,
+          chunkSize));
+    } else {
+      fileReader.reset(new FileReader(filename));
+      tokenizer.reset(new BufferedTokenizer(
+          Tokenizer(delims, escape), fileReader.get(), numPasses));
+    }
   }
 
-  FileReader fileReader;
-  BufferedTokenizer tokenizer;
+  // Either a single tokenizer reading the file sequentially, or a parallel
+  // reader of the mapped file
+  std::unique_ptr<FileReader> fileReader;
+  std::unique_ptr<BufferedTokenizer> tokenizer;
+  std::unique_ptr<ParallelTextFileReader> parallelReader;
   std::vector<int> fieldTypes;
   std::vector<TypeMeta> fieldMetas;
   std::vector<size_t> fieldByteSizes;
   size_t rowsRead{0};
 
-  // hack to guarantee thread-safeness of the read op
-  // TODO(azzolini): support multi-threaded reading.
+  // guarantees the thread-safeness of the read op
   std::mutex globalMutex_;
 };
 
@@ -42,14 +291,26 @@ class CreateTextFileReaderOp : public Operator<CPUContext> {
       : Operator<CPUContext>(operator_def, ws),
         filename_(GetSingleArgument<string>("filename", "")),
         numPasses_(GetSingleArgument<int>("num_passes", 1)),
-        fieldTypes_(GetRepeatedArgument<int>("field_types")) {
+        fieldTypes_(GetRepeatedArgument<int>("field_types")),
+        numThreads_(GetSingleArgument<int>("num_threads", 0)),
+        ordered_(GetSingleArgument<bool>("ordered", true)),
+        chunkSize_(GetSingleArgument<int64_t>("chunk_size", 1 << 20)) {
     CAFFE_ENFORCE(fieldTypes_.size() > 0, "field_types arg must be non-empty");
+    CAFFE_ENFORCE_GE(numThreads_, 0);
+    CAFFE_ENFORCE_GT(chunkSize_, 0);
   }
 
   bool RunOnDevice() override {
     *OperatorBase::Output<std::unique_ptr<TextFileReaderInstance>>(0) =
         std::unique_ptr<TextFileReaderInstance>(new TextFileReaderInstance(
-            {'\n', '\t'}, '\0', filename_, numPasses_, fieldTypes_));
+            {'\n', '\t'},
+            '\0',
+            filename_,
+            numPasses_,
+            fieldTypes_,
+            numThreads_,
+            ordered_,
+            chunkSize_));
     return true;
   }
 
@@ -57,33 +318,11 @@ class CreateTextFileReaderOp : public Operator<CPUContext> {
   std::string filename_;
   int numPasses_;
   std::vector<int> fieldTypes_;
+  int numThreads_;
+  bool ordered_;
+  int64_t chunkSize_;
 };
 
-inline void convert(
-    TensorProto_DataType dst_type,
-    const char* src_start,
-    const char* src_end,
-    void* dst) {
-  switch (dst_type) {
-    case TensorProto_DataType_STRING: {
-      static_cast<std::string*>(dst)->assign(src_start, src_end);
-    } break;
-    case TensorProto_DataType_FLOAT: {
-      // TODO(azzolini): avoid copy, use faster convertion
-      std::string str_copy(src_start, src_end);
-      const char* src_copy = str_copy.c_str();
-      char* src_copy_end;
-      float val = strtof(src_copy, &src_copy_end);
-      if (src_copy == src_copy_end) {
-        throw std::runtime_error("Invalid float: " + str_copy);
-      }
-      *static_cast<float*>(dst) = val;
-    } break;
-    default:
-      throw std::runtime_error("Unsupported type.");
-  }
-}
-
 class TextFileReaderReadOp : public Operator<CPUContext> {
  public:
   TextFileReaderReadOp(const OperatorDef& operator_def, Workspace* ws)
@@ -113,8 +352,11 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
     }
 
     int rowsRead = 0;
-    {
-      // TODO(azzolini): support multi-threaded reading
+    if (instance->parallelReader) {
+      std::lock_guard<std::mutex> guard(instance->globalMutex_);
+      rowsRead = instance->parallelReader->read(batchSize_, datas, &context_);
+      instance->rowsRead += rowsRead;
+    } else {
       std::lock_guard<std::mutex> guard(instance->globalMutex_);
 
       bool finished = false;
@@ -122,7 +364,7 @@ class TextFileReaderReadOp : public Operator<CPUContext> {
       while (!finished && (rowsRead < batchSize_)) {
         int field;
         for (field = 0; field < numFields; ++field) {
-          finished = !instance->tokenizer.next(token);
+          finished = !instance->tokenizer->next(token);
           if (finished) {
             CAFFE_ENFORCE(
                 field == 0, "Invalid number of fields at end of file.");
@@ -173,6 +415,20 @@ OPERATOR_SCHEMA(CreateTextFileReader)
     .Arg(
         "field_types",
         "List with type of each field. Type enum is found at core.DataType.")
+    .Arg(
+        "num_threads",
+        "(int, default 0) if positive, the file is memory-mapped and its lines "
+        "are tokenized and converted by that many threads ahead of the reads. "
+        "Otherwise the file is read sequentially by the read op.")
+    .Arg(
+        "ordered",
+        "(bool, default true) with num_threads, whether the rows are read in "
+        "the order of the file. If false, ranges of lines are read in the "
+        "order in which they are converted.")
+    .Arg(
+        "chunk_size",
+        "(int, default 1MB) with num_threads, number of bytes of the ranges of "
+        "lines that the threads convert at once.")
     .Output(0, "handler", "Pointer to the created TextFileReaderInstance.");
 
 OPERATOR_SCHEMA(TextFileReaderRead)
@@ -1,6 +1,10 @@
 #include "caffe2/operators/text_file_reader_utils.h"
 
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
 #include <cerrno>
 #include <cstring>
 #include <sstream>
@@ -116,4 +120,74 @@ void FileReader::operator()(CharRange& range) {
   range.start = buffer;
   range.end = buffer + numRead;
 }
+
+MappedFile::MappedFile(const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    throw std::runtime_error(
+        "Error opening file for reading: " + std::string(std::strerror(errno)) +
+        " Path=" + path);
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    close(fd);
+    throw std::runtime_error(
+        "Error reading file size: " + std::string(std::strerror(errno)) +
+        " Path=" + path);
+  }
+  size_ = st.st_size;
+  if (size_ > 0) {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (data == MAP_FAILED) {
+      close(fd);
+      throw std::runtime_error(
+          "Error mapping file: " + std::string(std::strerror(errno)) +
+          " Path=" + path);
+    }
+    madvise(data, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<char*>(data);
+  }
+  close(fd);
+}
+
+MappedFile::~MappedFile() {
+  if (data_) {
+    munmap(data_, size_);
+  }
+}
+
+std::vector<CharRange> splitLines(
+    char* start,
+    char* end,
+    size_t chunkSize,
+    char delim,
+    char escape) {
+  std::vector<CharRange> ranges;
+  char* rangeStart = start;
+  while (rangeStart < end) {
+    char* rangeEnd = end;
+    if (end - rangeStart > chunkSize) {
+      for (char* ch = rangeStart + std::max<size_t>(chunkSize, 1) - 1;
+           ch < end;
+           ++ch) {
+        if (*ch != delim) {
+          continue;
+        }
+        // The delimiter is escaped if it follows an odd number of escapes,
+        // counting from the start of the range, which is also a line start
+        char* escapes = ch;
+        while (escapes > rangeStart && *(escapes - 1) == escape) {
+          --escapes;
+        }
+        if ((ch - escapes) % 2 == 0) {
+          rangeEnd = ch + 1;
+          break;
+        }
+      }
+    }
+    ranges.push_back({rangeStart, rangeEnd});
+    rangeStart = rangeEnd;
+  }
+  return ranges;
+}
 }
@@ -117,6 +117,36 @@ class FileReader : public StringProvider {
   std::unique_ptr<char[]> buffer_;
 };
 
+// Maps a whole file in memory, read-only. Its pages are read when they are
+// first touched.
+class MappedFile {
+ public:
+  explicit MappedFile(const std::string& path);
+  ~MappedFile();
+  char* begin() const {
+    return data_;
+  }
+  char* end() const {
+    return data_ + size_;
+  }
+
+ private:
+  char* data_{nullptr};
+  size_t size_{0};
+
+  DISABLE_COPY_AND_ASSIGN(MappedFile);
+};
+
+// Splits [start, end) into ranges of at least chunkSize bytes, each ending
+// right after a delimiter that is not escaped, except for the last one, so
+// that the ranges can be tokenized independently of each other.
+std::vector<CharRange> splitLines(
+    char* start,
+    char* end,
+    size_t chunkSize,
+    char delim,
+    char escape);
+
 } // namespace caffe2
 
 #endif // CAFFE2_OPERATORS_TEXT_FILE_READER_UTILS_H
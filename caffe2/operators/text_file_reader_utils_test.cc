@@ -119,4 +119,30 @@ TEST(TextFileReaderUtilsTest, TokenizeTest) {
   std::remove(tmpname);
 }
 
+TEST(TextFileReaderUtilsTest, SplitLinesTest) {
+  std::string ch = "a\tb\nescaped\\\nline\nescape\\\\\nlast";
+  std::vector<std::string> expected = {
+      "a\tb\n", "escaped\\\nline\n", "escape\\\\\n", "last"};
+  for (size_t chunkSize = 1; chunkSize <= 4; ++chunkSize) {
+    auto ranges =
+        splitLines(&ch.front(), &ch.back() + 1, chunkSize, '\n', '\\');
+    EXPECT_EQ(expected.size(), ranges.size());
+    for (int i = 0; i < ranges.size(); ++i) {
+      EXPECT_EQ(expected.at(i), std::string(ranges[i].start, ranges[i].end));
+    }
+  }
+
+  // Each range can be tokenized on its own
+  Tokenizer tokenizer({'\n', '\t'}, '\\');
+  TokenizedString tokenized;
+  auto ranges = splitLines(&ch.front(), &ch.back() + 1, 1, '\n', '\\');
+  tokenizer.next(ranges[1].start, ranges[1].end, tokenized);
+  ASSERT_EQ(1, tokenized.tokens().size());
+  const auto& token = tokenized.tokens()[0];
+  EXPECT_EQ("escaped\nline", std::string(token.start, token.end));
+
+  auto all = splitLines(&ch.front(), &ch.back() + 1, ch.size(), '\n', '\\');
+  EXPECT_EQ(1, all.size());
+}
+
 } // namespace caffe2
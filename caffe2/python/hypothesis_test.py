@@ -620,6 +620,38 @@ class TestOperators(hu.HypothesisTestCase):
 
         self.assertReferenceChecks(gc, op, [var, nz, indices, grad], ftrl)
 
+    @given(num_shards=st.integers(min_value=0, max_value=100),
+           block_size=st.sampled_from([1, 16]),
+           **hu.gcs_cpu_only)
+    def test_sparse_ftrl_sgd_sharded(self, num_shards, block_size, gc, dc):
+        # duplicated rows are updated in order whatever the number of shards
+        num_rows = 200
+        num_indices = 20000
+        var = np.random.randn(num_rows, block_size).astype(np.float32)
+        n = np.abs(np.random.randn(num_rows, block_size))
+        z = np.random.randn(num_rows, block_size)
+        nz = np.stack([n, z], axis=-1).astype(np.float32)
+        indices = np.random.randint(0, num_rows, num_indices).astype(np.int64)
+        grad = np.random.randn(num_indices, block_size).astype(np.float32)
+
+        def run(num_shards):
+            workspace.FeedBlob("var", var, device_option=gc)
+            workspace.FeedBlob("nz", nz, device_option=gc)
+            workspace.FeedBlob("indices", indices, device_option=gc)
+            workspace.FeedBlob("grad", grad, device_option=gc)
+            workspace.RunOperatorOnce(core.CreateOperator(
+                "SparseFtrl",
+                ["var", "nz", "indices", "grad"],
+                ["var", "nz"],
+                num_shards=num_shards,
+                device_option=gc))
+            return workspace.FetchBlob("var"), workspace.FetchBlob("nz")
+
+        serial_var, serial_nz = run(1)
+        sharded_var, sharded_nz = run(num_shards)
+        np.testing.assert_array_equal(serial_var, sharded_var)
+        np.testing.assert_array_equal(serial_nz, sharded_nz)
+
     # Reference
     @staticmethod
     def _dense_ftrl_send_alpha_by_input(beta, lambda1, lambda2, w, nz, g, alpha):
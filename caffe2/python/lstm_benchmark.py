@@ -156,6 +156,7 @@ def create_model(args, queue, label_queue, input_shape):
                     op,
                     num_threads=args.rnn_executor_num_threads,
                     max_cuda_streams=args.rnn_executor_max_cuda_streams,
+                    wavefront=args.rnn_executor_wavefront,
                 )
     return model, output
 
@@ -325,6 +326,11 @@ def GetArgumentParser():
         default=None,
         help="Maximum number of CUDA streams used by RNN executor on GPU"
     )
+    parser.add_argument(
+        "--rnn_executor_wavefront",
+        action="store_true",
+        help="Whether to use the wavefront scheduling CPU RNN executor"
+    )
     return parser
 
 
@@ -10,7 +10,7 @@ from hypothesis import given, settings, HealthCheck
 import hypothesis.strategies as st
 import numpy as np
 
-from caffe2.python import core
+from caffe2.python import core, workspace
 import caffe2.python.hypothesis_test_util as hu
 
 
@@ -283,3 +283,47 @@ class TestAdagrad(hu.HypothesisTestCase):
             gc, op,
             [param, momentum, indices, grad, lr],
             ref_row_wise_sparse)
+
+    @given(op_type=st.sampled_from(["SparseAdagrad", "RowWiseSparseAdagrad"]),
+           num_shards=st.integers(min_value=0, max_value=100),
+           block_size=st.sampled_from([1, 3, 64]),
+           seed=st.integers(min_value=0, max_value=1000))
+    def test_sparse_adagrad_sharded(self, op_type, num_shards, block_size,
+                                    seed):
+        # Updates of duplicated rows must be applied in the order of the
+        # indices, so the result is the same bit for bit as the serial loop.
+        np.random.seed(seed)
+        num_rows = 500
+        num_indices = 20000
+        param = np.random.randn(num_rows, block_size).astype(np.float32)
+        if op_type == "SparseAdagrad":
+            momentum = np.abs(np.random.randn(num_rows, block_size))
+        else:
+            momentum = np.abs(np.random.randn(num_rows))
+        momentum = momentum.astype(np.float32)
+        # about half of the updates go to a few rows
+        indices = np.where(
+            np.random.rand(num_indices) < 0.5,
+            np.random.randint(0, 5, num_indices),
+            np.random.randint(0, num_rows, num_indices)).astype(np.int64)
+        grad = np.random.randn(num_indices, block_size).astype(np.float32)
+        lr = np.array([-0.1], dtype=np.float32)
+
+        def run(num_shards):
+            workspace.FeedBlob("param", param)
+            workspace.FeedBlob("momentum", momentum)
+            workspace.FeedBlob("indices", indices)
+            workspace.FeedBlob("grad", grad)
+            workspace.FeedBlob("lr", lr)
+            workspace.RunOperatorOnce(core.CreateOperator(
+                op_type,
+                ["param", "momentum", "indices", "grad", "lr"],
+                ["param", "momentum"],
+                num_shards=num_shards))
+            return (workspace.FetchBlob("param"),
+                    workspace.FetchBlob("momentum"))
+
+        serial_param, serial_momentum = run(1)
+        sharded_param, sharded_momentum = run(num_shards)
+        np.testing.assert_array_equal(serial_param, sharded_param)
+        np.testing.assert_array_equal(serial_momentum, sharded_momentum)
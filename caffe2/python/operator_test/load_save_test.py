@@ -456,5 +456,11 @@ class TestLoadSave(TestLoadSaveBase):
                 raise
 
 
+class TestLoadSaveMmapDB(TestLoadSave):
+
+    def __init__(self, methodName):
+        super(TestLoadSaveMmapDB, self).__init__(methodName, db_type='mmapdb')
+
+
 if __name__ == '__main__':
     unittest.main()
@@ -3,7 +3,7 @@ from __future__ import division
 from __future__ import print_function
 from __future__ import unicode_literals
 
-from caffe2.python import model_helper, workspace, core, rnn_cell
+from caffe2.python import model_helper, workspace, core, rnn_cell, recurrent
 from caffe2.python.attention import AttentionType
 
 import numpy as np
@@ -183,9 +183,14 @@ class TestRNNExecutor(unittest.TestCase):
         workspace.RunNetOnce(model.param_init_net)
         init_ws = {k: workspace.FetchBlob(k) for k in workspace.Blobs()}
 
-        # Run with executor
-        for enable_executor in [0, 1]:
+        # Run without executor, with the threaded executor, and with the
+        # wavefront executor with and without batching the instances of an op
+        exec_ws = {}
+        configs = [(0, 0, 1), (1, 0, 1), (1, 1, 1), (1, 1, 4)]
+        for enable_executor, wavefront, max_batch in configs:
             self.enable_rnn_executor(model.net, enable_executor, forward_only)
+            self.set_executor_arg(model.net, 'wavefront', wavefront)
+            self.set_executor_arg(model.net, 'max_batch', max_batch)
             workspace.ResetWorkspace()
 
             # Reset original state
@@ -212,13 +217,15 @@ class TestRNNExecutor(unittest.TestCase):
                 for k in workspace.Blobs():
                     ws[k + "." + str(j)] = workspace.FetchBlob(k)
 
-            if enable_executor:
-                rnn_exec_ws = ws
-            else:
-                non_exec_ws = ws
+            exec_ws[(enable_executor, wavefront, max_batch)] = ws
 
         # Test that all blobs are equal after running with executor
         # or without.
+        non_exec_ws = exec_ws[configs[0]]
+        for config in configs[1:]:
+            self._compare_ws(non_exec_ws, exec_ws[config])
+
+    def _compare_ws(self, non_exec_ws, rnn_exec_ws):
         self.assertEqual(list(non_exec_ws.keys()), list(rnn_exec_ws.keys()))
 
         mismatch = False
@@ -255,6 +262,16 @@ class TestRNNExecutor(unittest.TestCase):
         # start failing as this function will become defective.
         self.assertEqual(1 if forward_only else 2, num_found)
 
+    def set_executor_arg(self, net, name, value):
+        for op in net.Proto().op:
+            if op.type.startswith("RecurrentNetwork"):
+                for arg in op.arg:
+                    if arg.name == 'rnn_executor.' + name:
+                        arg.i = value
+                        break
+                else:
+                    recurrent.set_rnn_executor_config(op, **{name: value})
+
     if __name__ == "__main__":
         import unittest
         import random
@@ -12,6 +12,14 @@ import numpy as np
 
 class TestTextFileReader(TestCase):
     def test_text_file_reader(self):
+        self._test_text_file_reader()
+
+    def test_text_file_reader_threaded(self):
+        for ordered in [True, False]:
+            self._test_text_file_reader(
+                num_threads=3, ordered=ordered, chunk_size=8)
+
+    def _test_text_file_reader(self, **kwargs):
         schema = Struct(
             ('field1', Scalar(dtype=str)),
             ('field2', Scalar(dtype=str)),
@@ -40,7 +48,8 @@ class TestTextFileReader(TestCase):
                         filename=txt_file.name,
                         schema=schema,
                         batch_size=batch_size,
-                        num_passes=num_passes)
+                        num_passes=num_passes,
+                        **kwargs)
                     workspace.RunNetOnce(init_net)
 
                     net = core.Net('read_net')
@@ -54,8 +63,17 @@ class TestTextFileReader(TestCase):
                             results[i] = np.append(results[i], arrays[i])
                         if workspace.FetchBlob(should_stop):
                             break
+                    if not kwargs.get('ordered', True):
+                        # Ranges of lines come in any order, but each row
+                        # stays whole, so sort the rows
+                        order = np.argsort(results[0], kind='mergesort')
+                        results = [r[order] for r in results]
                     for i in range(num_fields):
                         col_batch = np.tile(col_data[i], num_passes)
+                        if not kwargs.get('ordered', True):
+                            col_batch = col_batch[np.argsort(
+                                np.tile(col_data[0], num_passes),
+                                kind='mergesort')]
                         if col_batch.dtype in (np.float32, np.float64):
                             np.testing.assert_array_almost_equal(
                                 col_batch, results[i], decimal=3)
@@ -286,7 +286,8 @@ def recurrent_net(
     return results[:-1]
 
 
-def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None):
+def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None,
+                            wavefront=None, max_batch=None):
     from caffe2.proto import caffe2_pb2
     assert rnn_op.type in {'RecurrentNetwork', 'RecurrentNetworkGradient'}
 
@@ -300,6 +301,10 @@ def set_rnn_executor_config(rnn_op, num_threads=None, max_cuda_streams=None):
         add_arg('num_threads', num_threads)
     if max_cuda_streams is not None:
         add_arg('max_cuda_streams', max_cuda_streams)
+    if wavefront is not None:
+        add_arg('wavefront', int(wavefront))
+    if max_batch is not None:
+        add_arg('max_batch', max_batch)
 
 
 def retrieve_step_blobs(net, prefix='rnn'):
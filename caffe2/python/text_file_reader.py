@@ -13,7 +13,8 @@ class TextFileReader(Reader):
     """
     Wrapper around operators for reading from text files.
     """
-    def __init__(self, init_net, filename, schema, num_passes=1, batch_size=1):
+    def __init__(self, init_net, filename, schema, num_passes=1, batch_size=1,
+                 num_threads=0, ordered=True, chunk_size=None):
         """
         Create op for building a TextFileReader instance in the workspace.
 
@@ -24,6 +25,12 @@ class TextFileReader(Reader):
                          Currently, only support Struct of strings.
             num_passes : Number of passes over the data.
             batch_size : Number of rows to read at a time.
+            num_threads: If positive, number of threads that convert the
+                         lines of the memory-mapped file ahead of the reads.
+            ordered    : With num_threads, whether rows are read in the order
+                         of the file.
+            chunk_size : With num_threads, number of bytes of the ranges of
+                         lines converted at once.
         """
         assert isinstance(schema, Struct), 'Schema must be a schema.Struct'
         for name, child in schema.get_children():
@@ -32,11 +39,17 @@ class TextFileReader(Reader):
         field_types = [
             data_type_for_dtype(dtype) for dtype in schema.field_types()]
         Reader.__init__(self, schema)
+        kwargs = {}
+        if chunk_size is not None:
+            kwargs['chunk_size'] = chunk_size
         self._reader = init_net.CreateTextFileReader(
             [],
             filename=filename,
             num_passes=num_passes,
-            field_types=field_types)
+            field_types=field_types,
+            num_threads=num_threads,
+            ordered=ordered,
+            **kwargs)
         self._batch_size = batch_size
 
     def read(self, net):
@@ -1,10 +1,8 @@
 #include "caffe2/queue/blobs_queue.h"
 
-#include <atomic>
-#include <condition_variable>
+#include <algorithm>
+#include <chrono>
 #include <memory>
-#include <mutex>
-#include <queue>
 
 #include "caffe2/core/blob_stats.h"
 #include "caffe2/core/logging.h"
@@ -22,20 +20,16 @@ static constexpr uint64_t SDT_TIMEOUT = (uint64_t)-1;
 static constexpr uint64_t SDT_ABORT = (uint64_t)-2;
 static constexpr uint64_t SDT_CANCEL = (uint64_t)-3;
 
-BlobsQueue::BlobsQueue(
+namespace {
+
+std::vector<std::vector<Blob*>> createQueueBlobs(
     Workspace* ws,
     const std::string& queueName,
     size_t capacity,
     size_t numBlobs,
-    bool enforceUniqueName,
-    const std::vector<std::string>& fieldNames)
-    : numBlobs_(numBlobs), name_(queueName), stats_(queueName) {
-  if (!fieldNames.empty()) {
-    CAFFE_ENFORCE_EQ(
-        fieldNames.size(), numBlobs, "Wrong number of fieldNames provided.");
-    stats_.queue_dequeued_bytes.setDetails(fieldNames);
-  }
-  queue_.reserve(capacity);
+    bool enforceUniqueName) {
+  std::vector<std::vector<Blob*>> queue;
+  queue.reserve(capacity);
   for (auto i = 0; i < capacity; ++i) {
     std::vector<Blob*> blobs;
     blobs.reserve(numBlobs);
@@ -49,9 +43,35 @@ BlobsQueue::BlobsQueue(
       }
       blobs.push_back(ws->CreateBlob(blobName));
     }
-    queue_.push_back(blobs);
+    queue.push_back(blobs);
+  }
+  DCHECK_EQ(queue.size(), capacity);
+  return queue;
+}
+
+} // namespace
+
+BlobsQueue::BlobsQueue(
+    Workspace* ws,
+    const std::string& queueName,
+    size_t capacity,
+    size_t numBlobs,
+    bool enforceUniqueName,
+    const std::vector<std::string>& fieldNames)
+    : numBlobs_(numBlobs),
+      name_(queueName),
+      queue_(createQueueBlobs(
+          ws,
+          queueName,
+          capacity,
+          numBlobs,
+          enforceUniqueName)),
+      stats_(queueName) {
+  if (!fieldNames.empty()) {
+    CAFFE_ENFORCE_EQ(
+        fieldNames.size(), numBlobs, "Wrong number of fieldNames provided.");
+    stats_.queue_dequeued_bytes.setDetails(fieldNames);
   }
-  DCHECK_EQ(queue_.size(), capacity);
 }
 
 bool BlobsQueue::blockingRead(
@@ -61,23 +81,32 @@ bool BlobsQueue::blockingRead(
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
   CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
-  std::unique_lock<std::mutex> g(mutex_);
-  auto canRead = [this]() {
-    CAFFE_ENFORCE_LE(reader_, writer_);
-    return reader_ != writer_;
-  };
+  CAFFE_ENFORCE(inputs.size() >= numBlobs_);
   // Decrease queue balance before reading to indicate queue read pressure
   // is being increased (-ve queue balance indicates more reads than writes)
   CAFFE_EVENT(stats_, queue_balance, -1);
-  if (timeout_secs > 0) {
-    std::chrono::milliseconds timeout_ms(int(timeout_secs * 1000));
-    cv_.wait_for(
-        g, timeout_ms, [this, canRead]() { return closing_ || canRead(); });
-  } else {
-    cv_.wait(g, [this, canRead]() { return closing_ || canRead(); });
+  auto read = [this, &inputs](std::vector<Blob*>& result) {
+    doRead(inputs, result);
+  };
+  bool success = queue_.tryPop(read);
+  if (!success) {
+    CAFFE_EVENT(stats_, queue_read_stalls);
+    Timer stallTimer;
+    if (timeout_secs > 0) {
+      // A zero timeout would wait forever, so a positive timeout lasts at
+      // least 1ns, however small it is
+      auto timeout = std::max(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::duration<float>(timeout_secs)),
+          std::chrono::nanoseconds(1));
+      success = queue_.pop(read, timeout);
+    } else {
+      success = queue_.pop(read);
+    }
+    CAFFE_EVENT(stats_, read_stall_time_ns, stallTimer.NanoSeconds());
   }
-  if (!canRead()) {
-    if (timeout_secs > 0 && !closing_) {
+  if (!success) {
+    if (timeout_secs > 0 && !queue_.isClosed()) {
       LOG(ERROR) << "DequeueBlobs timed out in " << timeout_secs << " secs";
       CAFFE_SDT(queue_read_end, name, (void*)this, SDT_TIMEOUT);
     } else {
@@ -85,38 +114,61 @@ bool BlobsQueue::blockingRead(
     }
     return false;
   }
-  DCHECK(canRead());
-  auto& result = queue_[reader_ % queue_.size()];
-  CAFFE_ENFORCE(inputs.size() >= result.size());
-  for (auto i = 0; i < result.size(); ++i) {
-    auto bytes = BlobStat::sizeBytes(*result[i]);
-    CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
-    using std::swap;
-    swap(*(inputs[i]), *(result[i]));
-  }
-  CAFFE_SDT(queue_read_end, name, (void*)this, writer_ - reader_);
+  CAFFE_SDT(queue_read_end, name, (void*)this, queue_.sizeGuess());
   CAFFE_EVENT(stats_, queue_dequeued_records);
-  ++reader_;
-  cv_.notify_all();
   CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
   return true;
 }
 
+size_t BlobsQueue::blockingReadMany(
+    const std::vector<std::vector<Blob*>>& inputs,
+    size_t maxRecords) {
+  Timer readTimer;
+  auto keeper = this->shared_from_this();
+  const auto& name = name_.c_str();
+  CAFFE_SDT(queue_read_start, name, (void*)this, SDT_BLOCKING_OP);
+  CAFFE_ENFORCE(maxRecords <= inputs.size());
+  for (size_t i = 0; i < maxRecords; ++i) {
+    CAFFE_ENFORCE(inputs[i].size() >= numBlobs_);
+  }
+  CAFFE_EVENT(stats_, queue_balance, -1);
+  size_t numRead = 0;
+  auto read = [this, &inputs, &numRead](std::vector<Blob*>& result) {
+    doRead(inputs[numRead++], result);
+  };
+  queue_.tryPopMany(maxRecords, read);
+  if (numRead == 0 && maxRecords > 0) {
+    CAFFE_EVENT(stats_, queue_read_stalls);
+    Timer stallTimer;
+    queue_.popMany(maxRecords, read);
+    CAFFE_EVENT(stats_, read_stall_time_ns, stallTimer.NanoSeconds());
+  }
+  if (numRead == 0) {
+    CAFFE_SDT(queue_read_end, name, (void*)this, SDT_CANCEL);
+    return 0;
+  }
+  CAFFE_SDT(queue_read_end, name, (void*)this, queue_.sizeGuess());
+  CAFFE_EVENT(stats_, queue_dequeued_records, numRead);
+  CAFFE_EVENT(stats_, read_time_ns, readTimer.NanoSeconds());
+  return numRead;
+}
+
 bool BlobsQueue::tryWrite(const std::vector<Blob*>& inputs) {
   Timer writeTimer;
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
   CAFFE_SDT(queue_write_start, name, (void*)this, SDT_NONBLOCKING_OP);
-  std::unique_lock<std::mutex> g(mutex_);
-  if (!canWrite()) {
+  CAFFE_ENFORCE(inputs.size() >= numBlobs_);
+  auto write = [this, &inputs](std::vector<Blob*>& result) {
+    // Increase queue balance before writing to indicate queue write pressure
+    // is being increased (+ve queue balance indicates more writes than reads)
+    CAFFE_EVENT(stats_, queue_balance, 1);
+    doWrite(inputs, result);
+  };
+  if (!queue_.tryPush(write)) {
     CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
     return false;
   }
-  // Increase queue balance before writing to indicate queue write pressure is
-  // being increased (+ve queue balance indicates more writes than reads)
-  CAFFE_EVENT(stats_, queue_balance, 1);
-  DCHECK(canWrite());
-  doWrite(inputs);
   CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
   return true;
 }
@@ -126,48 +178,55 @@ bool BlobsQueue::blockingWrite(const std::vector<Blob*>& inputs) {
   auto keeper = this->shared_from_this();
   const auto& name = name_.c_str();
   CAFFE_SDT(queue_write_start, name, (void*)this, SDT_BLOCKING_OP);
-  std::unique_lock<std::mutex> g(mutex_);
+  CAFFE_ENFORCE(inputs.size() >= numBlobs_);
   // Increase queue balance before writing to indicate queue write pressure is
   // being increased (+ve queue balance indicates more writes than reads)
   CAFFE_EVENT(stats_, queue_balance, 1);
-  cv_.wait(g, [this]() { return closing_ || canWrite(); });
-  if (!canWrite()) {
+  auto write = [this, &inputs](std::vector<Blob*>& result) {
+    doWrite(inputs, result);
+  };
+  bool success = queue_.tryPush(write);
+  if (!success) {
+    CAFFE_EVENT(stats_, queue_write_stalls);
+    Timer stallTimer;
+    success = queue_.push(write);
+    CAFFE_EVENT(stats_, write_stall_time_ns, stallTimer.NanoSeconds());
+  }
+  if (!success) {
     CAFFE_SDT(queue_write_end, name, (void*)this, SDT_ABORT);
     return false;
   }
-  DCHECK(canWrite());
-  doWrite(inputs);
   CAFFE_EVENT(stats_, write_time_ns, writeTimer.NanoSeconds());
   return true;
 }
 
 void BlobsQueue::close() {
-  closing_ = true;
-
-  std::lock_guard<std::mutex> g(mutex_);
-  cv_.notify_all();
+  queue_.close();
 }
 
-bool BlobsQueue::canWrite() {
-  // writer is always within [reader, reader + size)
-  // we can write if reader is within [reader, reader + size)
-  CAFFE_ENFORCE_LE(reader_, writer_);
-  CAFFE_ENFORCE_LE(writer_, reader_ + queue_.size());
-  return writer_ != reader_ + queue_.size();
+void BlobsQueue::doRead(
+    const std::vector<Blob*>& inputs,
+    std::vector<Blob*>& result) {
+  for (auto i = 0; i < result.size(); ++i) {
+    auto bytes = BlobStat::sizeBytes(*result[i]);
+    CAFFE_EVENT(stats_, queue_dequeued_bytes, bytes, i);
+    using std::swap;
+    swap(*(inputs[i]), *(result[i]));
+  }
 }
 
-void BlobsQueue::doWrite(const std::vector<Blob*>& inputs) {
-  auto& result = queue_[writer_ % queue_.size()];
-  CAFFE_ENFORCE(inputs.size() >= result.size());
-  const auto& name = name_.c_str();
+void BlobsQueue::doWrite(
+    const std::vector<Blob*>& inputs,
+    std::vector<Blob*>& result) {
   for (auto i = 0; i < result.size(); ++i) {
     using std::swap;
     swap(*(inputs[i]), *(result[i]));
   }
   CAFFE_SDT(
-      queue_write_end, name, (void*)this, reader_ + queue_.size() - writer_);
-  ++writer_;
-  cv_.notify_all();
+      queue_write_end,
+      name_.c_str(),
+      (void*)this,
+      queue_.capacity() - queue_.sizeGuess());
 }
 
 } // namespace caffe2
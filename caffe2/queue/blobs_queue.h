@@ -1,21 +1,20 @@
 #pragma once
 
-#include <atomic>
-#include <condition_variable>
 #include <memory>
-#include <mutex>
-#include <queue>
+#include <vector>
 
 #include "caffe2/core/blob_stats.h"
 #include "caffe2/core/logging.h"
 #include "caffe2/core/stats.h"
 #include "caffe2/core/tensor.h"
 #include "caffe2/core/workspace.h"
+#include "caffe2/queue/mpmc_ring.h"
 
 namespace caffe2 {
 
 // A thread-safe, bounded, blocking queue.
-// Modelled as a circular buffer.
+// Modelled as a lock-free circular buffer, see MPMCRing: readers and writers
+// only wait on each other when the queue is empty or full.
 
 // Containing blobs are owned by the workspace.
 // On read, we swap out the underlying data for the blob passed in for blobs
@@ -37,6 +36,12 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
   bool blockingRead(
       const std::vector<Blob*>& inputs,
       float timeout_secs = 0.0f);
+  // Reads up to maxRecords records into the first entries of inputs in one
+  // go, after waiting for at least one, and returns the number of records
+  // read. Returns 0 if the queue is closed and empty.
+  size_t blockingReadMany(
+      const std::vector<std::vector<Blob*>>& inputs,
+      size_t maxRecords);
   bool tryWrite(const std::vector<Blob*>& inputs);
   bool blockingWrite(const std::vector<Blob*>& inputs);
   void close();
@@ -45,18 +50,12 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
   }
 
  private:
-  bool canWrite();
-  void doWrite(const std::vector<Blob*>& inputs);
-
-  std::atomic<bool> closing_{false};
+  void doRead(const std::vector<Blob*>& inputs, std::vector<Blob*>& result);
+  void doWrite(const std::vector<Blob*>& inputs, std::vector<Blob*>& result);
 
   size_t numBlobs_;
-  std::mutex mutex_; // protects all variables in the class.
-  std::condition_variable cv_;
-  int64_t reader_{0};
-  int64_t writer_{0};
-  std::vector<std::vector<Blob*>> queue_;
   const std::string name_;
+  MPMCRing<std::vector<Blob*>> queue_;
 
   struct QueueStats {
     CAFFE_STAT_CTOR(QueueStats);
@@ -65,6 +64,12 @@ class BlobsQueue : public std::enable_shared_from_this<BlobsQueue> {
     CAFFE_DETAILED_EXPORTED_STAT(queue_dequeued_bytes);
     CAFFE_AVG_EXPORTED_STAT(read_time_ns);
     CAFFE_AVG_EXPORTED_STAT(write_time_ns);
+    // Number of reads that found the queue empty, and writes that found it
+    // full, and the time they waited
+    CAFFE_EXPORTED_STAT(queue_read_stalls);
+    CAFFE_EXPORTED_STAT(queue_write_stalls);
+    CAFFE_AVG_EXPORTED_STAT(read_stall_time_ns);
+    CAFFE_AVG_EXPORTED_STAT(write_stall_time_ns);
   } stats_;
 };
 } // namespace caffe2
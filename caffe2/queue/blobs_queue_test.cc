@@ -0,0 +1,52 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "caffe2/core/blob.h"
+#include "caffe2/core/tensor.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/queue/blobs_queue.h"
+
+namespace caffe2 {
+
+TEST(BlobsQueueTest, ReadWrite) {
+  Workspace ws;
+  auto queue = std::make_shared<BlobsQueue>(&ws, "queue", 2, 1, true);
+  Blob in;
+  in.GetMutable<TensorCPU>()->Resize(3);
+  in.GetMutable<TensorCPU>()->mutable_data<float>()[0] = 1.0f;
+  EXPECT_TRUE(queue->blockingWrite({&in}));
+
+  Blob out;
+  EXPECT_TRUE(queue->blockingRead({&out}));
+  EXPECT_EQ(out.Get<TensorCPU>().size(), 3);
+  EXPECT_EQ(out.Get<TensorCPU>().data<float>()[0], 1.0f);
+}
+
+TEST(BlobsQueueTest, SubMillisecondTimeout) {
+  Workspace ws;
+  auto queue = std::make_shared<BlobsQueue>(&ws, "queue", 1, 1, true);
+  Blob out;
+  // A timeout below 1ms must not round down to 0, which waits forever
+  auto start = std::chrono::steady_clock::now();
+  EXPECT_FALSE(queue->blockingRead({&out}, 0.0001f));
+  EXPECT_FALSE(queue->blockingRead({&out}, 1e-9f));
+  EXPECT_LT(std::chrono::steady_clock::now() - start, std::chrono::seconds(5));
+}
+
+TEST(BlobsQueueTest, NoTimeoutWaitsUntilClosed) {
+  Workspace ws;
+  auto queue = std::make_shared<BlobsQueue>(&ws, "queue", 1, 1, true);
+  Blob out;
+  bool success = true;
+  std::thread reader(
+      [&queue, &out, &success]() { success = queue->blockingRead({&out}); });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  queue->close();
+  reader.join();
+  EXPECT_FALSE(success);
+}
+
+} // namespace caffe2
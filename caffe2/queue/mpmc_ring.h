@@ -0,0 +1,284 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/logging.h"
+
+namespace caffe2 {
+
+// Lets threads wait for a condition that other threads change without
+// holding a lock. Notifying costs one atomic increment while nobody waits;
+// the mutex and condition variable (a futex on Linux) are only used by
+// threads that really have to sleep.
+//
+// A waiter calls prepareWait(), checks the condition again, and then either
+// cancelWait() if it holds or wait() on the returned key. A notifyAll() that
+// comes after prepareWait() wakes the waiter, even if it is not sleeping yet.
+class EventCount {
+ public:
+  EventCount() {}
+
+  uint64_t prepareWait() {
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_seq_cst);
+  }
+
+  void cancelWait() {
+    waiters_.fetch_sub(1, std::memory_order_seq_cst);
+  }
+
+  void wait(uint64_t key) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this, key]() { return epoch_.load() != key; });
+    waiters_.fetch_sub(1, std::memory_order_seq_cst);
+  }
+
+  // Returns false if the deadline passed before a notification
+  template <typename Clock, typename Duration>
+  bool waitUntil(
+      uint64_t key,
+      const std::chrono::time_point<Clock, Duration>& deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    bool notified = cv_.wait_until(
+        lock, deadline, [this, key]() { return epoch_.load() != key; });
+    waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    return notified;
+  }
+
+  void notifyAll() {
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) > 0) {
+      std::lock_guard<std::mutex> guard(mutex_);
+      cv_.notify_all();
+    }
+  }
+
+ private:
+  std::atomic<uint64_t> epoch_{0};
+  std::atomic<int64_t> waiters_{0};
+  std::mutex mutex_;
+  std::condition_variable cv_;
+
+  DISABLE_COPY_AND_ASSIGN(EventCount);
+};
+
+// A bounded multi-producer multi-consumer ring of slots of type T.
+//
+// Each slot carries a sequence number, from which producers and consumers
+// know whether it is free or full for the position they claim with a CAS on
+// the push or pop position (D. Vyukov's bounded MPMC queue). Writing and
+// reading a slot then happen in place, outside of any lock, and threads only
+// sleep when the ring is full or empty. The sequence number counts the turns
+// of the slot, two per lap of the ring, so that a capacity of one works.
+//
+// The slots are not destroyed when read: push and pop take a function that
+// writes or reads the claimed slot, e.g. by swapping or moving its content.
+// These functions must not throw, since the slot is claimed by then.
+template <typename T>
+class MPMCRing {
+ public:
+  explicit MPMCRing(size_t capacity) : MPMCRing(std::vector<T>(capacity)) {}
+
+  // Takes the initial content of the slots, e.g. preallocated buffers
+  explicit MPMCRing(std::vector<T> slots)
+      : capacity_(slots.size()), cells_(new Cell[slots.size()]) {
+    CAFFE_ENFORCE_GT(capacity_, 0, "Ring capacity must be positive");
+    for (size_t i = 0; i < capacity_; ++i) {
+      cells_[i].seq.store(0, std::memory_order_relaxed);
+      cells_[i].value = std::move(slots[i]);
+    }
+  }
+
+  size_t capacity() const {
+    return capacity_;
+  }
+
+  // Number of full slots, which may be stale by the time it returns
+  size_t sizeGuess() const {
+    auto pushPos = pushPos_.load(std::memory_order_acquire);
+    auto popPos = popPos_.load(std::memory_order_acquire);
+    return pushPos > popPos ? pushPos - popPos : 0;
+  }
+
+  // Calls write on the next free slot, or returns false if the ring is full
+  template <typename F>
+  bool tryPush(F&& write) {
+    uint64_t pos = pushPos_.load(std::memory_order_relaxed);
+    Cell* cell;
+    for (;;) {
+      cell = &cells_[pos % capacity_];
+      uint64_t seq = cell->seq.load(std::memory_order_acquire);
+      int64_t diff = static_cast<int64_t>(seq - freeSeq(pos));
+      if (diff == 0) {
+        if (pushPos_.compare_exchange_weak(
+                pos, pos + 1, std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = pushPos_.load(std::memory_order_relaxed);
+      }
+    }
+    write(cell->value);
+    cell->seq.store(fullSeq(pos), std::memory_order_release);
+    notEmpty_.notifyAll();
+    return true;
+  }
+
+  // Calls read on the oldest full slot, or returns false if the ring is empty
+  template <typename F>
+  bool tryPop(F&& read) {
+    return tryPopMany(1, read) == 1;
+  }
+
+  // Claims up to n consecutive full slots at once, calls read on each of
+  // them in order, and returns their number
+  template <typename F>
+  size_t tryPopMany(size_t n, F&& read) {
+    uint64_t pos = popPos_.load(std::memory_order_relaxed);
+    size_t count;
+    for (;;) {
+      count = 0;
+      int64_t diff = 0;
+      while (count < n) {
+        const Cell& cell = cells_[(pos + count) % capacity_];
+        uint64_t seq = cell.seq.load(std::memory_order_acquire);
+        diff = static_cast<int64_t>(seq - fullSeq(pos + count));
+        if (diff != 0) {
+          break;
+        }
+        ++count;
+      }
+      if (count == 0) {
+        if (diff < 0) {
+          return 0;
+        }
+        // Another consumer took this position
+        pos = popPos_.load(std::memory_order_relaxed);
+        continue;
+      }
+      if (popPos_.compare_exchange_weak(
+              pos, pos + count, std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    for (size_t i = 0; i < count; ++i) {
+      Cell& cell = cells_[(pos + i) % capacity_];
+      read(cell.value);
+      cell.seq.store(freeSeq(pos + i + capacity_), std::memory_order_release);
+    }
+    notFull_.notifyAll();
+    return count;
+  }
+
+  // Blocking versions: they wait while the ring is full, or empty, and fail
+  // once it is closed, or after the timeout if it is positive. Closing does
+  // not prevent pushing to a ring that has free slots, nor popping the slots
+  // that are still full.
+  template <typename F>
+  bool push(
+      F&& write,
+      std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0)) {
+    return waitFor(notFull_, timeout, [&]() { return tryPush(write); });
+  }
+
+  template <typename F>
+  bool pop(
+      F&& read,
+      std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0)) {
+    return waitFor(notEmpty_, timeout, [&]() { return tryPop(read); });
+  }
+
+  // Waits for at least one full slot, and pops up to n of them
+  template <typename F>
+  size_t popMany(
+      size_t n,
+      F&& read,
+      std::chrono::nanoseconds timeout = std::chrono::nanoseconds(0)) {
+    size_t count = 0;
+    waitFor(notEmpty_, timeout, [&]() {
+      count = tryPopMany(n, read);
+      return count > 0;
+    });
+    return count;
+  }
+
+  // Wakes up all the waiting threads, which fail if they cannot proceed
+  void close() {
+    closed_.store(true);
+    notEmpty_.notifyAll();
+    notFull_.notifyAll();
+  }
+
+  bool isClosed() const {
+    return closed_.load();
+  }
+
+ private:
+  struct Cell {
+    std::atomic<uint64_t> seq;
+    T value;
+  };
+
+  // Sequence number of the slot of pos when it is free, or full, for pos
+  uint64_t freeSeq(uint64_t pos) const {
+    return 2 * (pos / capacity_);
+  }
+
+  uint64_t fullSeq(uint64_t pos) const {
+    return 2 * (pos / capacity_) + 1;
+  }
+
+  template <typename Attempt>
+  bool waitFor(
+      EventCount& event,
+      std::chrono::nanoseconds timeout,
+      Attempt attempt) {
+    auto deadline = std::chrono::steady_clock::now() + timeout;
+    for (;;) {
+      if (attempt()) {
+        return true;
+      }
+      auto key = event.prepareWait();
+      if (attempt()) {
+        event.cancelWait();
+        return true;
+      }
+      if (closed_.load()) {
+        event.cancelWait();
+        return false;
+      }
+      if (timeout.count() > 0) {
+        if (!event.waitUntil(key, deadline)) {
+          return attempt();
+        }
+      } else {
+        event.wait(key);
+      }
+    }
+  }
+
+  const size_t capacity_;
+  std::unique_ptr<Cell[]> cells_;
+  std::atomic<bool> closed_{false};
+  // Producers and consumers update different cache lines
+  char pad0_[64];
+  std::atomic<uint64_t> pushPos_{0};
+  char pad1_[64];
+  std::atomic<uint64_t> popPos_{0};
+  char pad2_[64];
+  EventCount notEmpty_;
+  EventCount notFull_;
+
+  DISABLE_COPY_AND_ASSIGN(MPMCRing);
+};
+
+} // namespace caffe2
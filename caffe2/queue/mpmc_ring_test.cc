@@ -0,0 +1,111 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+#include "caffe2/queue/mpmc_ring.h"
+
+namespace caffe2 {
+
+TEST(MPMCRingTest, PushPopInOrder) {
+  MPMCRing<int> ring(4);
+  EXPECT_EQ(ring.capacity(), 4);
+  for (int i = 0; i < 4; ++i) {
+    EXPECT_TRUE(ring.tryPush([i](int& slot) { slot = i; }));
+  }
+  EXPECT_FALSE(ring.tryPush([](int& slot) { slot = -1; }));
+  EXPECT_EQ(ring.sizeGuess(), 4);
+
+  int value = -1;
+  EXPECT_TRUE(ring.tryPop([&value](int& slot) { value = slot; }));
+  EXPECT_EQ(value, 0);
+
+  std::vector<int> values;
+  auto read = [&values](int& slot) { values.push_back(slot); };
+  EXPECT_EQ(ring.tryPopMany(10, read), 3);
+  EXPECT_EQ(values, std::vector<int>({1, 2, 3}));
+  EXPECT_EQ(ring.tryPopMany(10, read), 0);
+  EXPECT_EQ(ring.sizeGuess(), 0);
+}
+
+TEST(MPMCRingTest, KeepsSlotContent) {
+  // Slots are swapped in and out, like the blobs of BlobsQueue
+  MPMCRing<std::vector<int>> ring(
+      std::vector<std::vector<int>>({{1}, {2}}));
+  std::vector<int> in = {3, 4};
+  EXPECT_TRUE(ring.tryPush([&in](std::vector<int>& slot) { in.swap(slot); }));
+  EXPECT_EQ(in, std::vector<int>({1}));
+  std::vector<int> out;
+  EXPECT_TRUE(ring.tryPop([&out](std::vector<int>& slot) { out.swap(slot); }));
+  EXPECT_EQ(out, std::vector<int>({3, 4}));
+}
+
+TEST(MPMCRingTest, CloseWakesUpWaiters) {
+  MPMCRing<int> ring(2);
+  std::thread reader([&ring]() {
+    EXPECT_FALSE(ring.pop([](int&) {}));
+    EXPECT_EQ(ring.popMany(2, [](int&) {}), 0);
+  });
+  std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  ring.close();
+  reader.join();
+
+  // Full slots can still be read once closed, but not waited for
+  EXPECT_TRUE(ring.push([](int& slot) { slot = 1; }));
+  EXPECT_TRUE(ring.pop([](int&) {}));
+  EXPECT_FALSE(ring.pop([](int&) {}));
+}
+
+TEST(MPMCRingTest, Timeout) {
+  MPMCRing<int> ring(1);
+  EXPECT_FALSE(ring.pop([](int&) {}, std::chrono::milliseconds(5)));
+  EXPECT_TRUE(ring.push([](int& slot) { slot = 1; }));
+  EXPECT_FALSE(
+      ring.push([](int& slot) { slot = 2; }, std::chrono::milliseconds(5)));
+  EXPECT_FALSE(ring.isClosed());
+}
+
+TEST(MPMCRingTest, ManyProducersManyConsumers) {
+  const int kProducers = 4;
+  const int kConsumers = 4;
+  const int kItems = 20000;
+  MPMCRing<int64_t> ring(16);
+
+  std::atomic<int64_t> sum{0};
+  std::atomic<int64_t> count{0};
+  std::vector<std::thread> threads;
+  for (int p = 0; p < kProducers; ++p) {
+    threads.emplace_back([&ring]() {
+      for (int i = 1; i <= kItems; ++i) {
+        EXPECT_TRUE(ring.push([i](int64_t& slot) { slot = i; }));
+      }
+    });
+  }
+  for (int c = 0; c < kConsumers; ++c) {
+    threads.emplace_back([&ring, &sum, &count, c]() {
+      for (;;) {
+        int64_t localSum = 0;
+        auto read = [&localSum](int64_t& slot) { localSum += slot; };
+        // Half of the consumers read in batches
+        size_t n = c % 2 ? ring.popMany(8, read) : ring.pop(read);
+        if (n == 0) {
+          return;
+        }
+        sum += localSum;
+        count += n;
+      }
+    });
+  }
+  for (int p = 0; p < kProducers; ++p) {
+    threads[p].join();
+  }
+  ring.close();
+  for (int c = 0; c < kConsumers; ++c) {
+    threads[kProducers + c].join();
+  }
+  EXPECT_EQ(count.load(), int64_t(kProducers) * kItems);
+  EXPECT_EQ(sum.load(), int64_t(kProducers) * kItems * (kItems + 1) / 2);
+}
+
+} // namespace caffe2
@@ -130,41 +130,51 @@ class SafeDequeueBlobsOp final : public Operator<Context> {
   bool dequeueMany(std::shared_ptr<BlobsQueue>& queue) {
     auto size = queue->getNumBlobs();
 
-    if (blobs_.size() != size) {
-      blobs_.resize(size);
-      blobPtrs_.resize(size);
-      for (int col = 0; col < size; ++col) {
-        blobPtrs_.at(col) = &blobs_.at(col);
+    if (blobs_.size() != numRecords_ * size) {
+      blobs_.resize(numRecords_ * size);
+      recordPtrs_.resize(numRecords_);
+      for (int i = 0; i < numRecords_; ++i) {
+        recordPtrs_[i].resize(size);
+        for (int col = 0; col < size; ++col) {
+          recordPtrs_[i][col] = &blobs_.at(i * size + col);
+        }
       }
     }
 
     const int kTensorGrowthPct = 40;
-    for (int i = 0; i < numRecords_; ++i) {
-      if (!queue->blockingRead(blobPtrs_)) {
+    int numRead = 0;
+    while (numRead < numRecords_) {
+      // Takes as many of the remaining records as the queue holds at once.
+      // They are copied to the outputs before the next read, which reuses
+      // the same blobs.
+      auto n = queue->blockingReadMany(recordPtrs_, numRecords_ - numRead);
+      if (n == 0) {
         // if we read at least one record, status is still true
-        return i > 0;
+        return numRead > 0;
       }
-      for (int col = 0; col < size; ++col) {
-        auto* out = this->Output(col);
-        const auto& in = blobPtrs_.at(col)->template Get<Tensor<Context>>();
-        if (i == 0) {
-          out->CopyFrom(in);
-        } else {
-          auto oldSize = out->size();
-
-          CAFFE_ENFORCE(
-              in.ndim() > 0,
-              "Empty tensor to dequeue at column ",
-              col,
-              " within ",
-              size,
-              " total columns");
-
-          out->Extend(in.dims()[0], kTensorGrowthPct, &context_);
-          auto* dst =
-              (char*)out->raw_mutable_data() + oldSize * in.meta().itemsize();
-          context_.template CopyItems<Context, Context>(
-              in.meta(), in.size(), in.raw_data(), dst);
+      for (int i = 0; i < n; ++i, ++numRead) {
+        for (int col = 0; col < size; ++col) {
+          auto* out = this->Output(col);
+          const auto& in = recordPtrs_[i][col]->template Get<Tensor<Context>>();
+          if (numRead == 0) {
+            out->CopyFrom(in);
+          } else {
+            auto oldSize = out->size();
+
+            CAFFE_ENFORCE(
+                in.ndim() > 0,
+                "Empty tensor to dequeue at column ",
+                col,
+                " within ",
+                size,
+                " total columns");
+
+            out->Extend(in.dims()[0], kTensorGrowthPct, &context_);
+            auto* dst =
+                (char*)out->raw_mutable_data() + oldSize * in.meta().itemsize();
+            context_.template CopyItems<Context, Context>(
+                in.meta(), in.size(), in.raw_data(), dst);
+          }
         }
       }
     }
@@ -195,7 +205,7 @@ class SafeDequeueBlobsOp final : public Operator<Context> {
  private:
   int numRecords_;
   std::vector<Blob> blobs_;
-  std::vector<Blob*> blobPtrs_;
+  std::vector<std::vector<Blob*>> recordPtrs_;
 };
 
 template <typename Context>
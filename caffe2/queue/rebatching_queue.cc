@@ -1,4 +1,5 @@
 #include "rebatching_queue.h"
+#include "caffe2/core/timer.h"
 #include "caffe2/utils/smart_tensor_printer.h"
 
 namespace caffe2 {
@@ -97,17 +98,19 @@ std::vector<std::vector<TensorCPU>> split(
 }
 } // anonymous namespace
 
-RebatchingQueue::RebatchingQueue(size_t capacity, size_t numBlobs)
-    : capacity_(capacity), numBlobs_(numBlobs), queue_(capacity) {}
+RebatchingQueue::RebatchingQueue(
+    size_t capacity,
+    size_t numBlobs,
+    const std::string& name)
+    : capacity_(capacity),
+      numBlobs_(numBlobs),
+      queue_(capacity),
+      stats_(name) {}
 
 RebatchingQueue::~RebatchingQueue() {
   close();
 }
 
-bool RebatchingQueue::canRead() const {
-  return tail_ < head_;
-}
-
 bool RebatchingQueue::dequeue(
     CPUContext& context,
     size_t numElements,
@@ -115,30 +118,21 @@ bool RebatchingQueue::dequeue(
   std::vector<std::vector<TensorCPU>> results;
   results.reserve(numElements);
 
-  for (;;) {
-    if (results.size() == numElements) {
-      break;
-    }
-
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-
-      cvEmpty_.wait(lock, [this] { return canRead() || isClosed_; });
-
-      // We only want to stop reading if the queue is empty and closed
-      if (!canRead() && isClosed_) {
-        break;
-      }
-
-      do {
-        results.push_back(std::move(queue_[tail_++ % capacity()]));
-      } while (canRead() && results.size() < numElements);
+  auto read = [&results](std::vector<TensorCPU>& row) {
+    results.push_back(std::move(row));
+  };
+  while (results.size() < numElements) {
+    const auto remaining = numElements - results.size();
+    if (queue_.tryPopMany(remaining, read) > 0) {
+      continue;
     }
-
-    if (numElements == 1) {
-      cvOverflow_.notify_one();
-    } else {
-      cvOverflow_.notify_all();
+    CAFFE_EVENT(stats_, dequeue_stalls);
+    Timer stallTimer;
+    // We only want to stop reading if the queue is empty and closed
+    auto count = queue_.popMany(remaining, read);
+    CAFFE_EVENT(stats_, dequeue_stall_time_ns, stallTimer.NanoSeconds());
+    if (count == 0) {
+      break;
     }
   }
 
@@ -151,10 +145,6 @@ bool RebatchingQueue::dequeue(
   return true;
 }
 
-bool RebatchingQueue::canWrite() const {
-  return tail_ + capacity() > head_;
-}
-
 bool RebatchingQueue::enqueueOne(
     CPUContext& /*context*/,
     const std::vector<const TensorCPU*>& inputs) {
@@ -181,29 +171,25 @@ bool RebatchingQueue::enqueueMany(
 
 bool RebatchingQueue::enqueue(
     std::vector<std::vector<TensorCPU>> splittedInputs) {
-  int idx = 0;
-  for (;;) {
-    if (idx >= splittedInputs.size()) {
-      break;
+  for (auto& row : splittedInputs) {
+    if (queue_.isClosed()) {
+      // If we are here it means that we didn't apply the entire batch and if
+      // we get closed in the middle of enquing we treat it as a non-success.
+      return false;
     }
-
-    {
-      std::unique_lock<std::mutex> lock(mutex_);
-
-      cvOverflow_.wait(lock, [this] { return canWrite() || isClosed_; });
-
-      if (isClosed_) {
-        // If we are here it means that we didn't apply the entire batch and if
-        // we get closed in the middle of enquing we treat it as a non-success.
-        return false;
-      }
-
-      do {
-        queue_[head_++ % capacity()] = std::move(splittedInputs[idx++]);
-      } while (canWrite() && idx < splittedInputs.size());
+    auto write = [&row](std::vector<TensorCPU>& slot) {
+      slot = std::move(row);
+    };
+    if (queue_.tryPush(write)) {
+      continue;
+    }
+    CAFFE_EVENT(stats_, enqueue_stalls);
+    Timer stallTimer;
+    bool success = queue_.push(write);
+    CAFFE_EVENT(stats_, enqueue_stall_time_ns, stallTimer.NanoSeconds());
+    if (!success) {
+      return false;
     }
-
-    cvEmpty_.notify_all();
   }
 
   return true;
@@ -218,17 +204,10 @@ size_t RebatchingQueue::numBlobs() const {
 }
 
 bool RebatchingQueue::isClosed() const {
-  std::lock_guard<std::mutex> g(mutex_);
-  return isClosed_;
+  return queue_.isClosed();
 }
 
 void RebatchingQueue::close() {
-  {
-    std::lock_guard<std::mutex> g(mutex_);
-    isClosed_ = true;
-  }
-
-  cvEmpty_.notify_all();
-  cvOverflow_.notify_all();
+  queue_.close();
 }
 } // caffe2
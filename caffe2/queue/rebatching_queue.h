@@ -1,25 +1,27 @@
 #pragma once
 
-#include <atomic>
-#include <condition_variable>
 #include <memory>
-#include <mutex>
-#include <queue>
+#include <string>
+#include <vector>
 
 #include "caffe2/core/logging.h"
 #include "caffe2/core/operator.h"
 #include "caffe2/core/stats.h"
 #include "caffe2/core/tensor.h"
+#include "caffe2/queue/mpmc_ring.h"
 
 namespace caffe2 {
 
-// TODO: This is a very naive implementation with a single mutex. We can do the
-// atomic index + circular queue optimizations or pull something more
-// heavy-weight later
+// Producers and consumers exchange rows through a lock-free ring, see
+// MPMCRing, and a dequeue takes as many of the rows it needs as are
+// available at once.
 
 class RebatchingQueue {
  public:
-  RebatchingQueue(size_t capacity, size_t numBlobs);
+  RebatchingQueue(
+      size_t capacity,
+      size_t numBlobs,
+      const std::string& name = "rebatching_queue");
 
   ~RebatchingQueue();
 
@@ -47,22 +49,19 @@ class RebatchingQueue {
  private:
   bool enqueue(std::vector<std::vector<TensorCPU>> splittedInputs);
 
-  bool canWrite() const;
-  bool canRead() const;
-
   const size_t capacity_;
   const size_t numBlobs_;
 
-  mutable std::mutex mutex_;
-
-  bool isClosed_{false};
-
-  uint64_t head_{0};
-  uint64_t tail_{0};
-
-  std::condition_variable cvEmpty_;
-  std::condition_variable cvOverflow_;
-
-  std::vector<std::vector<TensorCPU>> queue_;
+  MPMCRing<std::vector<TensorCPU>> queue_;
+
+  struct QueueStats {
+    CAFFE_STAT_CTOR(QueueStats);
+    // Number of enqueued rows that found the queue full, and of dequeues
+    // that found it empty, and the time they waited
+    CAFFE_EXPORTED_STAT(enqueue_stalls);
+    CAFFE_EXPORTED_STAT(dequeue_stalls);
+    CAFFE_AVG_EXPORTED_STAT(enqueue_stall_time_ns);
+    CAFFE_AVG_EXPORTED_STAT(dequeue_stall_time_ns);
+  } stats_;
 };
 } // caffe2
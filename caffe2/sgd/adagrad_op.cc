@@ -50,7 +50,8 @@ new_moment) as in the dense case.
     .Input(4, "lr", "learning rate")
     .Output(0, "output_param", "Updated parameters")
     .Output(1, "output_moment_1", "Updated moment")
-    .Arg("epsilon", "Default 1e-5");
+    .Arg("epsilon", "Default 1e-5")
+    .Arg("num_shards", kShardedSparseUpdateNumShardsDoc);
 
 REGISTER_CPU_OPERATOR(
     RowWiseSparseAdagrad,
@@ -77,7 +78,8 @@ also be a 1D tensor indexing into the rows of param.
     .Input(4, "lr", "learning rate")
     .Output(0, "output_param", "Updated parameters")
     .Output(1, "output_moment_1", "Updated moment")
-    .Arg("epsilon", "Default 1e-5");
+    .Arg("epsilon", "Default 1e-5")
+    .Arg("num_shards", kShardedSparseUpdateNumShardsDoc);
 
 SHOULD_NOT_DO_GRADIENT(Adagrad);
 SHOULD_NOT_DO_GRADIENT(SparseAdagrad);
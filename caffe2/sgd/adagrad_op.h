@@ -1,6 +1,7 @@
 #pragma once
 
 #include "caffe2/core/operator.h"
+#include "caffe2/sgd/sharded_sparse_update.h"
 
 namespace caffe2 {
 
@@ -64,7 +65,9 @@ class SparseAdagradOp final : public Operator<Context> {
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   SparseAdagradOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
-        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        num_shards_(OperatorBase::GetSingleArgument<int>("num_shards", 0)),
+        pool_(sparse_update_pool<Context>(ws)) {}
 
   bool RunOnDevice() override {
     // Enforce shapes
@@ -94,54 +97,64 @@ class SparseAdagradOp final : public Operator<Context> {
     }
 
     auto block_size = Input(GRAD).size() / n;
+#ifndef NDEBUG
     for (auto i = 0; i < n; ++i) {
       auto idx = indices[i];
-      if (block_size == 1) {
-        float gi = gradIn[i];
-        float hi = momentOut[idx] = momentIn[idx] + gi * gi;
-        paramOut[idx] = paramIn[idx] + lr[0] * gi / (std::sqrt(hi) + epsilon_);
-      } else {
-        auto offsetI = i * block_size;
-        auto offsetIdx = idx * block_size;
-
-#ifndef NDEBUG
-        CAFFE_ENFORCE_GE(
-            Input(PARAM).size(),
-            block_size + offsetIdx,
-            this->debug_def().input(PARAM),
-            ", out of bound,  idx:",
-            idx,
-            " for input i:",
-            i,
-            " and block size:",
-            block_size);
-        CAFFE_ENFORCE_GE(
-            Input(GRAD).size(),
-            block_size + offsetI,
-            this->debug_def().input(GRAD),
-            ", out of bound idx, idx:",
-            idx,
-            " for input i:",
-            i);
-#endif
-        adagrad_update(
-            block_size,
-            paramIn + offsetIdx,
-            gradIn + offsetI,
-            momentIn + offsetIdx,
-            paramOut + offsetIdx,
-            momentOut + offsetIdx,
-            epsilon_,
-            1.0f,
-            lr,
-            &context_);
-      }
+      auto offsetI = i * block_size;
+      auto offsetIdx = idx * block_size;
+      CAFFE_ENFORCE_GE(
+          Input(PARAM).size(),
+          block_size + offsetIdx,
+          this->debug_def().input(PARAM),
+          ", out of bound,  idx:",
+          idx,
+          " for input i:",
+          i,
+          " and block size:",
+          block_size);
+      CAFFE_ENFORCE_GE(
+          Input(GRAD).size(),
+          block_size + offsetI,
+          this->debug_def().input(GRAD),
+          ", out of bound idx, idx:",
+          idx,
+          " for input i:",
+          i);
     }
+#endif
+
+    // Updates of the same row are applied in order, see sharded_sparse_update
+    sharded_sparse_update(
+        indices, n, block_size, num_shards_, pool_, [&](TIndex i) {
+          auto idx = indices[i];
+          if (block_size == 1) {
+            float gi = gradIn[i];
+            float hi = momentOut[idx] = momentIn[idx] + gi * gi;
+            paramOut[idx] =
+                paramIn[idx] + lr[0] * gi / (std::sqrt(hi) + epsilon_);
+          } else {
+            auto offsetI = i * block_size;
+            auto offsetIdx = idx * block_size;
+            adagrad_update(
+                block_size,
+                paramIn + offsetIdx,
+                gradIn + offsetI,
+                momentIn + offsetIdx,
+                paramOut + offsetIdx,
+                momentOut + offsetIdx,
+                epsilon_,
+                1.0f,
+                lr,
+                &context_);
+          }
+        });
     return true;
   }
 
  protected:
   T epsilon_;
+  int num_shards_;
+  ThreadPool* pool_;
   INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
   OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
@@ -152,7 +165,9 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
   USE_OPERATOR_CONTEXT_FUNCTIONS;
   RowWiseSparseAdagradOp(const OperatorDef& operator_def, Workspace* ws)
       : Operator<Context>(operator_def, ws),
-        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)) {}
+        epsilon_(OperatorBase::GetSingleArgument<float>("epsilon", 1e-5f)),
+        num_shards_(OperatorBase::GetSingleArgument<int>("num_shards", 0)),
+        pool_(sparse_update_pool<Context>(ws)) {}
 
   bool RunOnDevice() override {
     // Enforce shapes
@@ -182,60 +197,67 @@ class RowWiseSparseAdagradOp final : public Operator<Context> {
     }
 
     auto block_size = Input(GRAD).size() / n;
-
+#ifndef NDEBUG
     for (auto i = 0; i < n; ++i) {
       auto idx = indices[i];
-      if (block_size == 1) {
-        float gi = gradIn[i];
-        float hi = momentOut[idx] = momentIn[idx] + gi * gi;
-        paramOut[idx] = paramIn[idx] + lr[0] * gi / (std::sqrt(hi) + epsilon_);
-      } else {
-        auto offsetI = i * block_size;
-        auto offsetIdx = idx * block_size;
-
-#ifndef NDEBUG
-        CAFFE_ENFORCE_GE(
-            Input(PARAM).size(),
-            block_size + offsetIdx,
-            this->debug_def().input(PARAM),
-            ", out of bound,  idx:",
-            idx,
-            " for input i:",
-            i,
-            " and block size:",
-            block_size);
-        CAFFE_ENFORCE_GE(
-            Input(GRAD).size(),
-            block_size + offsetI,
-            this->debug_def().input(GRAD),
-            ", out of bound idx, idx:",
-            idx,
-            " for input i:",
-            i);
+      auto offsetI = i * block_size;
+      auto offsetIdx = idx * block_size;
+      CAFFE_ENFORCE_GE(
+          Input(PARAM).size(),
+          block_size + offsetIdx,
+          this->debug_def().input(PARAM),
+          ", out of bound,  idx:",
+          idx,
+          " for input i:",
+          i,
+          " and block size:",
+          block_size);
+      CAFFE_ENFORCE_GE(
+          Input(GRAD).size(),
+          block_size + offsetI,
+          this->debug_def().input(GRAD),
+          ", out of bound idx, idx:",
+          idx,
+          " for input i:",
+          i);
+    }
 #endif
 
-        const float* w = paramIn + offsetIdx;
-        const float* g = gradIn + offsetI;
-        const float* h = momentIn + idx;
-        float* nw = paramOut + offsetIdx;
-        float* nh = momentOut + idx;
-        float hs = 0.;
-        for (auto j = 0; j < block_size; ++j) {
-          float gj = g[j];
-          hs += gj * gj;
-        }
-        float hi = nh[0] = h[0] + hs / block_size;
-        float step = lr[0] / (std::sqrt(hi) + epsilon_);
-        for (auto j = 0; j < block_size; ++j) {
-          nw[j] = w[j] + g[j] * step;
-        }
-      }
-    }
+    sharded_sparse_update(
+        indices, n, block_size, num_shards_, pool_, [&](TIndex i) {
+          auto idx = indices[i];
+          if (block_size == 1) {
+            float gi = gradIn[i];
+            float hi = momentOut[idx] = momentIn[idx] + gi * gi;
+            paramOut[idx] =
+                paramIn[idx] + lr[0] * gi / (std::sqrt(hi) + epsilon_);
+          } else {
+            auto offsetI = i * block_size;
+            auto offsetIdx = idx * block_size;
+            const float* w = paramIn + offsetIdx;
+            const float* g = gradIn + offsetI;
+            const float* h = momentIn + idx;
+            float* nw = paramOut + offsetIdx;
+            float* nh = momentOut + idx;
+            float hs = 0.;
+            for (auto j = 0; j < block_size; ++j) {
+              float gj = g[j];
+              hs += gj * gj;
+            }
+            float hi = nh[0] = h[0] + hs / block_size;
+            float step = lr[0] / (std::sqrt(hi) + epsilon_);
+            for (auto j = 0; j < block_size; ++j) {
+              nw[j] = w[j] + g[j] * step;
+            }
+          }
+        });
     return true;
   }
 
  protected:
   T epsilon_;
+  int num_shards_;
+  ThreadPool* pool_;
   INPUT_TAGS(PARAM, MOMENT_1, INDICES, GRAD, LR);
   OUTPUT_TAGS(OUTPUT_PARAM, OUTPUT_MOMENT_1);
 };
@@ -99,35 +99,37 @@ void SparseFtrlOp<T>::DoRun() {
   const SIndex* idxs = indices.template data<SIndex>();
   const T* g = grad.template data<T>();
 
-  // TODO(cxj): use OMP when it is reliable
-  // #pragma omp parallel for
   for (TIndex i = 0; i < K; ++i) {
-    SIndex idx = idxs[i];
-    DCHECK(0 <= idx && idx < N) << "Index out of bounds: " << idx
-                                << ", range 0 to " << N;
-    if (block_size == 1) {
-      ftrl_compute(
-          w[idx],
-          nz[idx * 2],
-          nz[idx * 2 + 1],
-          g[i],
-          w[idx],
-          nz[idx * 2],
-          nz[idx * 2 + 1],
-          params_);
-    } else {
-      TIndex x = block_size * idx;
-      ftrl_update(
-          block_size,
-          w + x,
-          nz + x * 2,
-          g + i * block_size,
-          w + x,
-          nz + x * 2,
-          params_,
-          &context_);
-    }
+    DCHECK(0 <= idxs[i] && idxs[i] < N) << "Index out of bounds: " << idxs[i]
+                                        << ", range 0 to " << N;
   }
+
+  sharded_sparse_update(
+      idxs, K, block_size, num_shards_, pool_, [&](TIndex i) {
+        SIndex idx = idxs[i];
+        if (block_size == 1) {
+          ftrl_compute(
+              w[idx],
+              nz[idx * 2],
+              nz[idx * 2 + 1],
+              g[i],
+              w[idx],
+              nz[idx * 2],
+              nz[idx * 2 + 1],
+              params_);
+        } else {
+          TIndex x = block_size * idx;
+          ftrl_update(
+              block_size,
+              w + x,
+              nz + x * 2,
+              g + i * block_size,
+              w + x,
+              nz + x * 2,
+              params_,
+              &context_);
+        }
+      });
 }
 
 namespace {
@@ -140,7 +142,8 @@ REGISTER_CPU_OPERATOR(SparseFtrl, SparseFtrlOp<float>);
 OPERATOR_SCHEMA(SparseFtrl)
     .NumInputs(4, 5)
     .NumOutputs(2)
-    .EnforceInplace({{0, 0}, {1, 1}});
+    .EnforceInplace({{0, 0}, {1, 1}})
+    .Arg("num_shards", kShardedSparseUpdateNumShardsDoc);
 SHOULD_NOT_DO_GRADIENT(SparseFtrl);
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "caffe2/core/operator.h"
+#include "caffe2/sgd/sharded_sparse_update.h"
 
 namespace caffe2 {
 
@@ -40,7 +41,10 @@ template <typename T>
 class SparseFtrlOp final : public Operator<CPUContext> {
  public:
   SparseFtrlOp(const OperatorDef& operator_def, Workspace* ws)
-      : Operator<CPUContext>(operator_def, ws), params_(this) {
+      : Operator<CPUContext>(operator_def, ws),
+        params_(this),
+        num_shards_(GetSingleArgument<int>("num_shards", 0)),
+        pool_(ws->GetThreadPool()) {
     CAFFE_ENFORCE(
         !HasArgument("alpha") || ALPHA >= InputSize(),
         "Cannot specify alpha by both input and argument");
@@ -67,6 +71,8 @@ class SparseFtrlOp final : public Operator<CPUContext> {
 
  protected:
   FtrlParams<T> params_;
+  int num_shards_;
+  ThreadPool* pool_;
   INPUT_TAGS(VAR, N_Z, INDICES, GRAD, ALPHA);
   OUTPUT_TAGS(OUTPUT_VAR, OUTPUT_N_Z);
 
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include "caffe2/core/common.h"
+#include "caffe2/core/context.h"
+#include "caffe2/core/workspace.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
+
+namespace caffe2 {
+
+// Sparse updates of fewer elements than this run on the calling thread
+constexpr TIndex kShardedSparseUpdateMinWork = 1 << 15;
+
+// Doc of the num_shards argument of the ops that use sharded_sparse_update
+constexpr const char* kShardedSparseUpdateNumShardsDoc =
+    "Default 0. Number of shards of the rows updated in parallel on the "
+    "workspace thread pool, picked from the pool size if 0, 1 to run "
+    "serially. The result does not depend on it.";
+
+// The pool that an op on Context runs sharded_sparse_update on. Only CPU ops
+// update rows on the host, other ops don't create the pool.
+template <class Context>
+inline ThreadPool* sparse_update_pool(Workspace* /* unused */) {
+  return nullptr;
+}
+
+template <>
+inline ThreadPool* sparse_update_pool<CPUContext>(Workspace* ws) {
+  return ws->GetThreadPool();
+}
+
+template <typename SIndex>
+inline int sparse_update_shard(SIndex idx, int num_shards) {
+  // Fibonacci hashing, so that runs of consecutive or strided ids are spread
+  // over all the shards
+  return ((static_cast<uint64_t>(idx) * 0x9E3779B97F4A7C15ULL) >> 32) %
+      num_shards;
+}
+
+// Calls update(i) for i in [0, n), where update(i) reads and writes only the
+// row indices[i] of the parameters and their optimizer state.
+//
+// The updates are sharded by a hash of the row, so that two threads never
+// write the same row, and run on the thread pool. Within a shard the updates
+// are sorted by row, keeping their original order, so all the updates of a
+// duplicated row are applied one after the other while it is in cache, in the
+// same order as the serial loop. The results are thus the same, bit for bit,
+// whatever the number of shards.
+//
+// num_shards == 0 picks a number of shards from the size of the pool, and
+// runs serially if there is no pool or the update is small.
+template <typename SIndex, typename Update>
+void sharded_sparse_update(
+    const SIndex* indices,
+    TIndex n,
+    TIndex block_size,
+    int num_shards,
+    ThreadPool* pool,
+    Update update) {
+  if (num_shards == 0) {
+    if (pool == nullptr || pool->getNumThreads() <= 1 ||
+        n * block_size < kShardedSparseUpdateMinWork) {
+      num_shards = 1;
+    } else {
+      // the pool runs small ranges on the calling thread, and more shards
+      // than threads balance the load of the most frequent rows
+      num_shards = std::max<int>(
+          4 * pool->getNumThreads(), pool->getMinWorkSize());
+    }
+  }
+  if (num_shards <= 1 || pool == nullptr) {
+    for (TIndex i = 0; i < n; ++i) {
+      update(i);
+    }
+    return;
+  }
+
+  // Counting sort of the updates by shard, which keeps their order
+  std::vector<TIndex> shard_begin(num_shards + 1, 0);
+  for (TIndex i = 0; i < n; ++i) {
+    shard_begin[sparse_update_shard(indices[i], num_shards) + 1]++;
+  }
+  for (int s = 0; s < num_shards; ++s) {
+    shard_begin[s + 1] += shard_begin[s];
+  }
+  std::vector<TIndex> order(n);
+  {
+    std::vector<TIndex> next(shard_begin.begin(), shard_begin.end() - 1);
+    for (TIndex i = 0; i < n; ++i) {
+      order[next[sparse_update_shard(indices[i], num_shards)]++] = i;
+    }
+  }
+
+  pool->run(
+      [&](int /* thread_id */, size_t s) {
+        auto begin = order.begin() + shard_begin[s];
+        auto end = order.begin() + shard_begin[s + 1];
+        std::stable_sort(begin, end, [indices](TIndex a, TIndex b) {
+          return indices[a] < indices[b];
+        });
+        for (auto it = begin; it != end; ++it) {
+          update(*it);
+        }
+      },
+      num_shards);
+}
+
+} // namespace caffe2
@@ -293,6 +293,29 @@ void GemmBatched(
     Tensor<Context>* scratch = nullptr,
     TensorProto::DataType math_type = TensorProto_DataType_FLOAT);
 
+// GemmStridedBatched is GemmBatched on matrices that start every A_stride,
+// B_stride and C_stride elements of A, B and C. A stride of 0 uses the same
+// matrix for the whole batch, e.g. to broadcast B, but the matrices of C must
+// not overlap.
+template <typename T, class Context, class Engine = DefaultEngine>
+void GemmStridedBatched(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const T* A,
+    const int A_stride,
+    const T* B,
+    const int B_stride,
+    const float beta,
+    T* C,
+    const int C_stride,
+    Context* context,
+    TensorProto::DataType math_type = TensorProto_DataType_FLOAT);
+
 // Gemv always takes in a M*N matrix A, and depending on whether we set TransA
 // to Trans, the output is:
 // CblasNoTrans: x is an N dim vector and y is an M dim vector.
@@ -21,6 +21,8 @@
 #include <chrono>
 #include <cstring>
 #include <functional>
+#include <memory>
+#include <mutex>
 #include <numeric>
 #include <random>
 #include <unordered_set>
@@ -28,6 +30,7 @@
 
 #include "caffe2/utils/cpu_neon.h"
 #include "caffe2/core/context.h"
+#include "caffe2/utils/threadpool/ThreadPool.h"
 
 #include "Eigen/Core"
 #include "Eigen/Dense"
@@ -412,8 +415,34 @@ CAFFE2_SPECIALIZED_AXPBY(float, s)
 
 #endif  // CAFFE2_USE_EIGEN_FOR_BLAS
 
+namespace {
+
+// Batches of products of at most this many multiply-adds each run their
+// entries in parallel. Larger products are left to BLAS, which parallelizes
+// each of them itself.
+constexpr TIndex kParallelGemmMaxEntryWork = 64 * 64 * 64;
+// Smaller batches are not worth waking up the threads for.
+constexpr TIndex kParallelGemmMinWork = 1 << 16;
+
+// Only one batch uses the pool at a time: batches that run concurrently, e.g.
+// in other operators of an async net, stay on their own thread rather than
+// wait for it.
+std::mutex gemm_thread_pool_mutex;
+
+ThreadPool* GemmThreadPool() {
+  static std::unique_ptr<ThreadPool> pool = []() {
+    auto pool = ThreadPool::defaultThreadPool();
+    // a batch of two products is already worth splitting
+    pool->setMinWorkSize(2);
+    return pool;
+  }();
+  return pool.get();
+}
+
+} // namespace
+
 template <>
-void GemmBatched<float, CPUContext>(
+void GemmStridedBatched<float, CPUContext>(
     const CBLAS_TRANSPOSE TransA,
     const CBLAS_TRANSPOSE TransB,
     const int batch_size,
@@ -422,28 +451,31 @@ void GemmBatched<float, CPUContext>(
     const int K,
     const float alpha,
     const float* A,
+    const int A_stride,
     const float* B,
+    const int B_stride,
     const float beta,
     float* C,
+    const int C_stride,
     CPUContext* context,
-    Tensor<CPUContext>*, /* scratch */
     TensorProto::DataType /* math_type */) {
-  const int a_stride = M * K;
-  const int b_stride = K * N;
-  const int c_stride = M * N;
-
 #ifdef CAFFE2_USE_MKL
   (void)context;
 
   const int lda = (TransA == CblasNoTrans) ? K : M;
   const int ldb = (TransB == CblasNoTrans) ? N : K;
-  std::vector<const float*> a_array(batch_size, nullptr);
-  std::vector<const float*> b_array(batch_size, nullptr);
-  std::vector<float*> c_array(batch_size, nullptr);
+  // Kept across calls, so that they are only allocated when a batch is larger
+  // than all the previous ones of the thread
+  thread_local std::vector<const float*> a_array;
+  thread_local std::vector<const float*> b_array;
+  thread_local std::vector<float*> c_array;
+  a_array.resize(batch_size);
+  b_array.resize(batch_size);
+  c_array.resize(batch_size);
   for (int i = 0; i < batch_size; ++i) {
-    a_array[i] = A + a_stride * i;
-    b_array[i] = B + b_stride * i;
-    c_array[i] = C + c_stride * i;
+    a_array[i] = A + static_cast<TIndex>(A_stride) * i;
+    b_array[i] = B + static_cast<TIndex>(B_stride) * i;
+    c_array[i] = C + static_cast<TIndex>(C_stride) * i;
   }
   cblas_sgemm_batch(
       CblasRowMajor,
@@ -463,8 +495,7 @@ void GemmBatched<float, CPUContext>(
       1,
       &batch_size);
 #else // CAFFE2_USE_MKL
-  // loop over matrices in the batch
-  for (int i = 0; i < batch_size; ++i) {
+  auto gemm = [&](int /* thread */, size_t i) {
     math::Gemm<float, CPUContext>(
         TransA,
         TransB,
@@ -472,15 +503,64 @@ void GemmBatched<float, CPUContext>(
         N,
         K,
         alpha,
-        A + a_stride * i,
-        B + b_stride * i,
+        A + static_cast<TIndex>(A_stride) * i,
+        B + static_cast<TIndex>(B_stride) * i,
         beta,
-        C + c_stride * i,
+        C + static_cast<TIndex>(C_stride) * i,
         context);
+  };
+  const TIndex entry_work = static_cast<TIndex>(M) * N * K;
+  if (batch_size > 1 && entry_work <= kParallelGemmMaxEntryWork &&
+      entry_work * batch_size >= kParallelGemmMinWork) {
+    std::unique_lock<std::mutex> lock(
+        gemm_thread_pool_mutex, std::try_to_lock);
+    if (lock.owns_lock()) {
+      GemmThreadPool()->run(gemm, batch_size);
+      return;
+    }
+  }
+  // loop over matrices in the batch
+  for (int i = 0; i < batch_size; ++i) {
+    gemm(0, i);
   }
 #endif
 }
 
+template <>
+void GemmBatched<float, CPUContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const float* B,
+    const float beta,
+    float* C,
+    CPUContext* context,
+    Tensor<CPUContext>*, /* scratch */
+    TensorProto::DataType math_type) {
+  GemmStridedBatched<float, CPUContext>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      M * K,
+      B,
+      K * N,
+      beta,
+      C,
+      M * N,
+      context,
+      math_type);
+}
+
 ////////////////////////////////////////////////////////////////////////////////
 // MKL VML alternatives.
 // Depending on whether we are using MKL, we will delegate the Caffe math
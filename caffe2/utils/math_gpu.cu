@@ -279,7 +279,7 @@ void Gemm<float16, CUDAContext>(
 }
 
 template <>
-void GemmBatched<float, CUDAContext>(
+void GemmStridedBatched<float, CUDAContext>(
     const CBLAS_TRANSPOSE TransA,
     const CBLAS_TRANSPOSE TransB,
     const int batch_size,
@@ -288,15 +288,14 @@ void GemmBatched<float, CUDAContext>(
     const int K,
     const float alpha,
     const float* A,
+    const int A_stride,
     const float* B,
+    const int B_stride,
     const float beta,
     float* C,
+    const int C_stride,
     CUDAContext* context,
-    Tensor<CUDAContext>* scratch,
     TensorProto::DataType math_type) {
-  const int a_stride = M * K;
-  const int b_stride = K * N;
-  const int c_stride = M * N;
 #if __CUDACC_VER_MAJOR__ < 8
   // loop over matrices in the batch
   for (int i = 0; i < batch_size; ++i) {
@@ -307,10 +306,10 @@ void GemmBatched<float, CUDAContext>(
         N,
         K,
         alpha,
-        A + a_stride * i,
-        B + b_stride * i,
+        A + static_cast<TIndex>(A_stride) * i,
+        B + static_cast<TIndex>(B_stride) * i,
         beta,
-        C + c_stride * i,
+        C + static_cast<TIndex>(C_stride) * i,
         context);
   }
 #else
@@ -332,18 +331,53 @@ void GemmBatched<float, CUDAContext>(
       &alpha,
       B,
       ldb,
-      b_stride,
+      B_stride,
       A,
       lda,
-      a_stride,
+      A_stride,
       &beta,
       C,
       N,
-      c_stride,
+      C_stride,
       batch_size));
 #endif
 }
 
+template <>
+void GemmBatched<float, CUDAContext>(
+    const CBLAS_TRANSPOSE TransA,
+    const CBLAS_TRANSPOSE TransB,
+    const int batch_size,
+    const int M,
+    const int N,
+    const int K,
+    const float alpha,
+    const float* A,
+    const float* B,
+    const float beta,
+    float* C,
+    CUDAContext* context,
+    Tensor<CUDAContext>* scratch,
+    TensorProto::DataType math_type) {
+  GemmStridedBatched<float, CUDAContext>(
+      TransA,
+      TransB,
+      batch_size,
+      M,
+      N,
+      K,
+      alpha,
+      A,
+      M * K,
+      B,
+      K * N,
+      beta,
+      C,
+      M * N,
+      context,
+      math_type);
+}
+
 namespace {
 
 __global__ void FloatToHalfKernel(const int N, const float* X, half* Y) {
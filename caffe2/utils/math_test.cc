@@ -226,6 +226,71 @@ INSTANTIATE_TEST_CASE_P(
 
 } // namespace
 
+TEST(MathTest, GemmStridedBatched) {
+  DeviceOption option;
+  CPUContext cpu_context(option);
+  // Padded matrices of A and C, and the same B for the whole batch, with
+  // enough products to run on the thread pool
+  const int batch_size = 64;
+  const int M = 16;
+  const int N = 12;
+  const int K = 20;
+  const int A_stride = M * K + 3;
+  const int C_stride = M * N + 5;
+  TensorCPU A(std::vector<int>{batch_size * A_stride});
+  TensorCPU B(std::vector<int>{K * N});
+  TensorCPU Y(std::vector<int>{batch_size * C_stride});
+  TensorCPU Y_ref(std::vector<int>{M * N});
+  for (int i = 0; i < A.size(); ++i) {
+    A.mutable_data<float>()[i] = (i % 7) * 0.25f - 0.5f;
+  }
+  for (int i = 0; i < B.size(); ++i) {
+    B.mutable_data<float>()[i] = (i % 5) * 0.5f - 1.0f;
+  }
+  math::Set<float, CPUContext>(
+      Y.size(), 1, Y.mutable_data<float>(), &cpu_context);
+  math::GemmStridedBatched<float, CPUContext>(
+      CblasNoTrans,
+      CblasNoTrans,
+      batch_size,
+      M,
+      N,
+      K,
+      1.0f,
+      A.data<float>(),
+      A_stride,
+      B.data<float>(),
+      0,
+      0.5f,
+      Y.mutable_data<float>(),
+      C_stride,
+      &cpu_context);
+  for (int b = 0; b < batch_size; ++b) {
+    math::Set<float, CPUContext>(
+        Y_ref.size(), 1, Y_ref.mutable_data<float>(), &cpu_context);
+    math::Gemm<float, CPUContext>(
+        CblasNoTrans,
+        CblasNoTrans,
+        M,
+        N,
+        K,
+        1.0f,
+        A.data<float>() + b * A_stride,
+        B.data<float>(),
+        0.5f,
+        Y_ref.mutable_data<float>(),
+        &cpu_context);
+    const float* Y_b = Y.data<float>() + b * C_stride;
+    for (int i = 0; i < M * N; ++i) {
+      EXPECT_FLOAT_EQ(Y_ref.data<float>()[i], Y_b[i]) << b << " " << i;
+    }
+    // The padding is not written
+    for (int i = M * N; i < C_stride && b + 1 < batch_size; ++i) {
+      EXPECT_EQ(1, Y_b[i]);
+    }
+  }
+}
+
 TEST(MathTest, GemvNoTrans) {
   DeviceOption option;
   CPUContext cpu_context(option);
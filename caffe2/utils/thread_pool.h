@@ -7,12 +7,24 @@
 #include <queue>
 #include <thread>
 #include <utility>
+#include <vector>
 
 #include "caffe2/core/numa.h"
 
 namespace caffe2 {
 
-class TaskThreadPool {
+// Interface shared by the thread pools handed out to async nets and
+// operators through ExecutorHelper.
+class TaskThreadPoolBase {
+ public:
+  virtual void run(const std::function<void()>& func) = 0;
+
+  virtual size_t size() const = 0;
+
+  virtual ~TaskThreadPoolBase() noexcept {}
+};
+
+class TaskThreadPool : public TaskThreadPoolBase {
  private:
   struct task_element_t {
     bool run_with_id;
@@ -50,7 +62,7 @@ class TaskThreadPool {
   }
 
   // Set running flag to false then notify all threads.
-  ~TaskThreadPool() {
+  ~TaskThreadPool() override {
     {
       std::unique_lock<std::mutex> lock(mutex_);
       running_ = false;
@@ -65,7 +77,7 @@ class TaskThreadPool {
     }
   }
 
-  size_t size() const {
+  size_t size() const override {
     return threads_.size();
   }
 
@@ -81,7 +93,7 @@ class TaskThreadPool {
     condition_.notify_one();
   }
 
-  void run(const std::function<void()>& func) {
+  void run(const std::function<void()>& func) override {
     runTask(func);
   }
 
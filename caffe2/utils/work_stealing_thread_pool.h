@@ -0,0 +1,283 @@
+#ifndef CAFFE2_UTILS_WORK_STEALING_THREAD_POOL_H_
+#define CAFFE2_UTILS_WORK_STEALING_THREAD_POOL_H_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "caffe2/core/numa.h"
+#include "caffe2/utils/thread_pool.h"
+
+namespace caffe2 {
+
+// Chase-Lev work-stealing deque (Le et al., "Correct and Efficient
+// Work-Stealing for Weak Memory Models", PPoPP'13).
+// push() and pop() may only be called by the owning thread and operate on the
+// bottom end without locks; steal() may be called by any thread and takes
+// items from the top end.
+template <typename T>
+class WorkStealingQueue {
+ public:
+  explicit WorkStealingQueue(int64_t capacity = 256)
+      : top_(0), bottom_(0), array_(new Array(capacity)) {
+    garbage_.emplace_back(array_.load(std::memory_order_relaxed));
+  }
+
+  bool empty() const {
+    auto b = bottom_.load(std::memory_order_relaxed);
+    auto t = top_.load(std::memory_order_relaxed);
+    return b <= t;
+  }
+
+  void push(T* item) {
+    auto b = bottom_.load(std::memory_order_relaxed);
+    auto t = top_.load(std::memory_order_acquire);
+    auto* a = array_.load(std::memory_order_relaxed);
+    if (b - t > a->capacity - 1) {
+      a = grow(a, b, t);
+    }
+    a->put(b, item);
+    std::atomic_thread_fence(std::memory_order_release);
+    bottom_.store(b + 1, std::memory_order_relaxed);
+  }
+
+  T* pop() {
+    auto b = bottom_.load(std::memory_order_relaxed) - 1;
+    auto* a = array_.load(std::memory_order_relaxed);
+    bottom_.store(b, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto t = top_.load(std::memory_order_relaxed);
+    T* item = nullptr;
+    if (t <= b) {
+      item = a->get(b);
+      if (t == b) {
+        // Last item, race against concurrent steal() calls
+        if (!top_.compare_exchange_strong(
+                t,
+                t + 1,
+                std::memory_order_seq_cst,
+                std::memory_order_relaxed)) {
+          item = nullptr;
+        }
+        bottom_.store(b + 1, std::memory_order_relaxed);
+      }
+    } else {
+      bottom_.store(b + 1, std::memory_order_relaxed);
+    }
+    return item;
+  }
+
+  T* steal() {
+    auto t = top_.load(std::memory_order_acquire);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    auto b = bottom_.load(std::memory_order_acquire);
+    if (t >= b) {
+      return nullptr;
+    }
+    auto* a = array_.load(std::memory_order_acquire);
+    T* item = a->get(t);
+    if (!top_.compare_exchange_strong(
+            t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+      return nullptr;
+    }
+    return item;
+  }
+
+ private:
+  struct Array {
+    explicit Array(int64_t cap)
+        : capacity(cap), mask(cap - 1), buffer(new std::atomic<T*>[cap]) {}
+
+    T* get(int64_t i) const {
+      return buffer[i & mask].load(std::memory_order_relaxed);
+    }
+
+    void put(int64_t i, T* item) {
+      buffer[i & mask].store(item, std::memory_order_relaxed);
+    }
+
+    const int64_t capacity;
+    const int64_t mask;
+    std::unique_ptr<std::atomic<T*>[]> buffer;
+  };
+
+  Array* grow(Array* a, int64_t b, int64_t t) {
+    auto* new_array = new Array(a->capacity * 2);
+    for (auto i = t; i < b; ++i) {
+      new_array->put(i, a->get(i));
+    }
+    // Thieves may still be reading from the old array, keep it alive until
+    // the queue is destroyed
+    garbage_.emplace_back(new_array);
+    array_.store(new_array, std::memory_order_release);
+    return new_array;
+  }
+
+  std::atomic<int64_t> top_;
+  std::atomic<int64_t> bottom_;
+  std::atomic<Array*> array_;
+  std::vector<std::unique_ptr<Array>> garbage_;
+};
+
+// Thread pool with a deque per worker. Tasks submitted from one of the
+// pool's own workers are pushed onto that worker's deque and popped in LIFO
+// order, so that work made ready by a task (e.g. children of a finished chain
+// in an async net) runs next on the same thread. Tasks submitted from outside
+// of the pool go through a shared injection queue. Idle workers steal from
+// the other workers' deques before going to sleep.
+class WorkStealingThreadPool : public TaskThreadPoolBase {
+ public:
+  explicit WorkStealingThreadPool(std::size_t pool_size, int numa_node_id = -1)
+      : running_(true),
+        num_pending_(0),
+        num_sleeping_(0),
+        num_injected_(0),
+        numa_node_id_(numa_node_id) {
+    workers_.reserve(pool_size);
+    for (std::size_t i = 0; i < pool_size; ++i) {
+      workers_.emplace_back(new WorkStealingQueue<Task>());
+    }
+    threads_.reserve(pool_size);
+    for (std::size_t i = 0; i < pool_size; ++i) {
+      threads_.emplace_back(
+          std::bind(&WorkStealingThreadPool::main_loop, this, i));
+    }
+  }
+
+  ~WorkStealingThreadPool() override {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      running_ = false;
+      condition_.notify_all();
+    }
+
+    try {
+      for (auto& t : threads_) {
+        t.join();
+      }
+    } catch (const std::exception&) {
+    }
+
+    // Drop the tasks that were never run
+    for (auto& worker : workers_) {
+      while (auto* task = worker->pop()) {
+        delete task;
+      }
+    }
+    while (!injected_tasks_.empty()) {
+      delete injected_tasks_.front();
+      injected_tasks_.pop();
+    }
+  }
+
+  size_t size() const override {
+    return threads_.size();
+  }
+
+  void run(const std::function<void()>& func) override {
+    auto* task = new Task(func);
+    ++num_pending_;
+    auto& worker = currentWorker();
+    if (worker.first == this) {
+      workers_[worker.second]->push(task);
+    } else {
+      std::unique_lock<std::mutex> lock(mutex_);
+      injected_tasks_.push(task);
+      ++num_injected_;
+    }
+    if (num_sleeping_ > 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      condition_.notify_one();
+    }
+  }
+
+  /// @brief Returns true if called from one of this pool's workers
+  bool inThreadPool() const {
+    return currentWorker().first == this;
+  }
+
+ private:
+  typedef std::function<void()> Task;
+
+  // (pool, worker index) of the calling thread
+  static std::pair<const WorkStealingThreadPool*, std::size_t>&
+  currentWorker() {
+    static thread_local std::pair<const WorkStealingThreadPool*, std::size_t>
+        worker(nullptr, 0);
+    return worker;
+  }
+
+  Task* nextTask(std::size_t index) {
+    if (auto* task = workers_[index]->pop()) {
+      return task;
+    }
+    if (num_injected_ > 0) {
+      std::unique_lock<std::mutex> lock(mutex_);
+      if (!injected_tasks_.empty()) {
+        auto* task = injected_tasks_.front();
+        injected_tasks_.pop();
+        --num_injected_;
+        return task;
+      }
+    }
+    auto num_workers = workers_.size();
+    for (std::size_t i = 1; i < num_workers; ++i) {
+      if (auto* task = workers_[(index + i) % num_workers]->steal()) {
+        return task;
+      }
+    }
+    return nullptr;
+  }
+
+  /// @brief Entry point for pool threads.
+  void main_loop(std::size_t index) {
+    NUMABind(numa_node_id_);
+    currentWorker() = std::make_pair(this, index);
+
+    while (running_) {
+      std::unique_ptr<Task> task(nextTask(index));
+      if (task) {
+        --num_pending_;
+        try {
+          (*task)();
+        } catch (const std::exception&) {
+        }
+        continue;
+      }
+
+      // num_pending_ is incremented before a task is published, a non-zero
+      // value means that a task is either visible or about to become visible,
+      // so retry instead of going to sleep
+      std::unique_lock<std::mutex> lock(mutex_);
+      ++num_sleeping_;
+      while (running_ && num_pending_ == 0) {
+        condition_.wait(lock);
+      }
+      --num_sleeping_;
+    }
+  }
+
+  std::vector<std::unique_ptr<WorkStealingQueue<Task>>> workers_;
+  std::vector<std::thread> threads_;
+
+  std::mutex mutex_;
+  std::condition_variable condition_;
+  std::queue<Task*> injected_tasks_;
+
+  std::atomic<bool> running_;
+  std::atomic<int> num_pending_;
+  std::atomic<int> num_sleeping_;
+  std::atomic<int> num_injected_;
+  int numa_node_id_;
+};
+
+} // namespace caffe2
+
+#endif // CAFFE2_UTILS_WORK_STEALING_THREAD_POOL_H_
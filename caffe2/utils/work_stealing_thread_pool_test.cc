@@ -0,0 +1,111 @@
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include "caffe2/utils/work_stealing_thread_pool.h"
+#include <gtest/gtest.h>
+
+namespace caffe2 {
+
+namespace {
+
+class Latch {
+ public:
+  explicit Latch(int count) : count_(count) {}
+
+  void countDown() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (--count_ == 0) {
+      cv_.notify_all();
+    }
+  }
+
+  void wait() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (count_ > 0) {
+      cv_.wait(lock);
+    }
+  }
+
+ private:
+  std::mutex mutex_;
+  std::condition_variable cv_;
+  int count_;
+};
+
+} // namespace
+
+TEST(WorkStealingQueueTest, PushPopSteal) {
+  WorkStealingQueue<int> queue(2);
+  int values[10];
+  for (int i = 0; i < 10; ++i) {
+    values[i] = i;
+    queue.push(&values[i]);
+  }
+  // Owner pops from the bottom, thieves steal from the top
+  EXPECT_EQ(9, *queue.pop());
+  EXPECT_EQ(0, *queue.steal());
+  EXPECT_EQ(8, *queue.pop());
+  EXPECT_EQ(1, *queue.steal());
+  for (int i = 7; i >= 2; --i) {
+    EXPECT_EQ(i, *queue.pop());
+  }
+  EXPECT_TRUE(queue.empty());
+  EXPECT_EQ(nullptr, queue.pop());
+  EXPECT_EQ(nullptr, queue.steal());
+}
+
+TEST(WorkStealingThreadPoolTest, ExternalTasks) {
+  const int kNumTasks = 1000;
+  WorkStealingThreadPool pool(4);
+  EXPECT_EQ(4, pool.size());
+  EXPECT_FALSE(pool.inThreadPool());
+
+  std::atomic<int> counter(0);
+  Latch latch(kNumTasks);
+  for (int i = 0; i < kNumTasks; ++i) {
+    pool.run([&counter, &latch]() {
+      counter.fetch_add(1);
+      latch.countDown();
+    });
+  }
+  latch.wait();
+  EXPECT_EQ(kNumTasks, counter.load());
+}
+
+TEST(WorkStealingThreadPoolTest, NestedTasks) {
+  // Every task spawns kFanout children from inside the pool, down to kDepth
+  // levels, exercising local pushes and stealing between workers
+  const int kFanout = 4;
+  const int kDepth = 5;
+  int total = 0;
+  for (int level = 0, n = 1; level <= kDepth; ++level, n *= kFanout) {
+    total += n;
+  }
+
+  WorkStealingThreadPool pool(4);
+  std::atomic<int> counter(0);
+  std::atomic<int> in_pool(0);
+  Latch latch(total);
+  std::function<void(int)> spawn;
+  spawn = [&](int level) {
+    pool.run([&, level]() {
+      counter.fetch_add(1);
+      if (pool.inThreadPool()) {
+        in_pool.fetch_add(1);
+      }
+      if (level < kDepth) {
+        for (int i = 0; i < kFanout; ++i) {
+          spawn(level + 1);
+        }
+      }
+      latch.countDown();
+    });
+  };
+  spawn(0);
+  latch.wait();
+  EXPECT_EQ(total, counter.load());
+  EXPECT_EQ(total, in_pool.load());
+}
+
+} // namespace caffe2
@@ -2,11 +2,13 @@ import contextlib
 import gc
 import sys
 import math
+import subprocess
+import textwrap
 import torch
 import unittest
 import warnings
 from copy import deepcopy
-from collections import OrderedDict
+from collections import OrderedDict, defaultdict
 from itertools import product
 from operator import mul
 from functools import reduce, wraps
@@ -1774,6 +1776,65 @@ class TestAutograd(TestCase):
         out.sum().backward()
         self.assertEqual(x.grad.data, y_data)
 
+    def test_multiple_cpu_workers(self):
+        # The CPU workers are started by the first backward of a process, so
+        # this runs in a new one
+        script = textwrap.dedent("""
+            import threading
+            import torch
+            from torch.autograd import Variable, Function
+
+            engine = Variable._execution_engine
+            engine.set_num_cpu_workers(4)
+
+            # independent branches accumulating into the same leaf
+            x = Variable(torch.randn(10, 10), requires_grad=True)
+            sum((x * i).tanh().sum() for i in range(32)).backward()
+            expected = sum(i * (1 - (x.data * i).tanh() ** 2) for i in range(32))
+            assert (x.grad.data - expected).abs().max() < 1e-4
+
+            # reentrant backward in every branch
+            class Reenter(Function):
+                @staticmethod
+                def forward(ctx, x):
+                    with torch.enable_grad():
+                        ctx.x = Variable(x, requires_grad=True)
+                        ctx.output = (ctx.x * 2).sum()
+                    return x.clone()
+
+                @staticmethod
+                def backward(ctx, grad_output):
+                    with torch.enable_grad():
+                        ctx.output.backward()
+                    return grad_output * ctx.x.grad
+
+            y = Variable(torch.randn(5), requires_grad=True)
+            sum(Reenter.apply(y * i).sum() for i in range(16)).backward()
+            assert (y.grad.data - 2 * sum(range(16))).abs().max() == 0
+
+            # concurrent backwards into the same leaf
+            z = Variable(torch.randn(10), requires_grad=True)
+
+            def run():
+                for _ in range(10):
+                    (z * 2).sum().backward()
+
+            threads = [threading.Thread(target=run) for _ in range(4)]
+            for t in threads:
+                t.start()
+            for t in threads:
+                t.join()
+            assert (z.grad.data - 80).abs().max() == 0
+
+            try:
+                engine.set_num_cpu_workers(2)
+            except RuntimeError:
+                pass
+            else:
+                raise AssertionError("set_num_cpu_workers should fail after backward")
+        """)
+        subprocess.check_call([sys.executable, '-c', script])
+
     def test_cat(self):
         f_args_variable = (Variable(torch.randn(1, S, S), requires_grad=True),
                            Variable(torch.randn(2, S, S), requires_grad=True),
@@ -1979,6 +2040,74 @@ class TestAutograd(TestCase):
             self.assertEqual(info.name, expected_name)
             last_end = info.cpu_interval.end
 
+    def test_profiler_sampling(self):
+        x = Variable(torch.randn(10, 10))
+
+        with profile(sample_period=3) as p:
+            for _ in range(7):
+                y = x * 2
+        # The top-level ranges 0, 3 and 6 are recorded
+        self.assertEqual(len(p.function_events), 3)
+        for info in p.function_events:
+            self.assertEqual(info.name, 'mul')
+
+    def test_profiler_shapes_and_allocations(self):
+        x = Variable(torch.randn(10, 10), requires_grad=True)
+
+        with profile(record_shapes=True) as p:
+            y = x * 2
+            y.sum().backward()
+
+        events = [e for e in p.function_events if e.input_shapes is not None]
+        self.assertTrue(any(e.input_shapes == [[10, 10]] for e in events))
+        mul = next(e for e in p.function_events if e.name == 'mul')
+        self.assertGreaterEqual(mul.allocated_bytes, 10 * 10 * 4)
+
+    def test_profiler_stream_trace(self):
+        import json
+        import tempfile
+        x = Variable(torch.randn(10, 10), requires_grad=True)
+
+        with tempfile.NamedTemporaryFile(mode='r', suffix='.json') as f:
+            with torch.autograd.profiler.stream_trace(f.name, record_shapes=True) as trace:
+                for _ in range(5):
+                    (x * 2 + 4).sum().backward()
+            events = json.load(f)
+
+        self.assertEqual(trace.events_dropped, 0)
+        self.assertEqual(len(events), trace.events_written)
+        begins = [e for e in events if e['ph'] == 'B']
+        ends = [e for e in events if e['ph'] == 'E']
+        self.assertEqual(len(begins), len(ends))
+        self.assertEqual(sum(e['name'] == 'mul' for e in begins), 5)
+        self.assertTrue(all('allocated_bytes' in e['args'] for e in ends))
+
+    def test_profiler_stream_trace_small_ring(self):
+        import json
+        import tempfile
+        x = Variable(torch.randn(10, 10), requires_grad=True)
+
+        # The ring of each thread holds only a few events, so that the ranges
+        # are dropped, but every range that starts in the trace also ends
+        with tempfile.NamedTemporaryFile(mode='r', suffix='.json') as f:
+            with torch.autograd.profiler.stream_trace(f.name, block_size=4) as trace:
+                for _ in range(200):
+                    (x * 2 + 4).sum().backward()
+            events = json.load(f)
+
+        self.assertGreater(trace.events_dropped, 0)
+        self.assertEqual(len(events), trace.events_written)
+        open_ranges = defaultdict(list)
+        for e in events:
+            if e['ph'] == 'B':
+                open_ranges[e['tid']].append(e['name'])
+            elif e['ph'] == 'E':
+                self.assertTrue(open_ranges[e['tid']])
+                open_ranges[e['tid']].pop()
+                # The writer matched the end with the start of its range
+                self.assertIn('allocated_bytes', e['args'])
+        self.assertTrue(all(len(ranges) == 0 for ranges in open_ranges.values()))
+
     def test_dir(self):
         x = Variable(torch.randn(10, 10))
         keys = dir(x)
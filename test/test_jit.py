@@ -9,7 +9,9 @@ from torch.autograd import Variable, Function
 from torch.autograd.function import traceable
 from common import TestCase, run_tests, IS_WINDOWS
 import io
+import os
 import sys
+import subprocess
 import unittest
 import inspect
 import textwrap
@@ -258,6 +260,119 @@ class TestJit(TestCase):
     def test_run_lstm_fusion_cpu(self):
         self.run_lstm_fusion(False)
 
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fuser_cpu_broadcast_reduction(self):
+        @torch.jit.compile(nderivs=0)
+        def f(x, b):
+            y = (x + b).sigmoid() * x
+            return y, y.sum(1), y.mean(1, keepdim=True)
+
+        x = Variable(torch.randn(5, 37))
+        b = Variable(torch.randn(37))
+        f(x, b)
+        with self.assertCompiled(f):
+            y, s, m = f(x, b)
+        expected = (x + b).sigmoid() * x
+        self.assertEqual(y, expected)
+        self.assertEqual(s, expected.sum(1))
+        self.assertEqual(m, expected.mean(1, keepdim=True))
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fuser_cpu_chunks(self):
+        @torch.jit.compile(nderivs=0)
+        def f(x, y):
+            return (x * y).sigmoid() + x
+
+        # chunks of the map span several rows, and rows span several chunks
+        for size in [(200001,), (7, 30001), (30001, 7)]:
+            x = Variable(torch.randn(*size))
+            y = Variable(torch.randn(*size))
+            f(x, y)
+            with self.assertCompiled(f):
+                z = f(x, y)
+            self.assertEqual(z, (x * y).sigmoid() + x)
+        x = Variable(torch.randn(30001, 7)).t()
+        y = Variable(torch.randn(30001, 7)).t()
+        self.assertEqual(f(x, y), (x * y).sigmoid() + x)
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fuser_cpu_reduction_accumulates_in_double(self):
+        @torch.jit.compile(nderivs=0)
+        def f(x):
+            y = x + x
+            return y, y.sum(1)
+
+        # 2**24 + 1 rounds to 2**24 in float, so the ones would be lost
+        x = Variable(torch.Tensor(2, 1001).fill_(0.5))
+        x[:, 0] = 2 ** 23
+        f(x)
+        with self.assertCompiled(f):
+            _, s = f(x)
+        self.assertEqual(s, torch.Tensor(2).fill_(2 ** 24 + 1000), prec=0)
+
+    @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
+    def test_fuser_disk_cache(self):
+        # the cache directory is read when the fuser is created, so each
+        # run needs a fresh process
+        script = textwrap.dedent("""
+            import sys
+            import torch
+            from torch.autograd import Variable
+
+            @torch.jit.compile(nderivs=0)
+            def f(x, y):
+                return (x * y).sigmoid() + x
+
+            @torch.jit.compile(nderivs=0)
+            def g(x, y):
+                return (x + y).tanh() * y
+
+            x = Variable(torch.randn(4, 4))
+            y = Variable(torch.randn(4, 4))
+            if 'g' in sys.argv[1:]:
+                g(x, y)
+            f(x, y)
+            f(x, y)
+            stats = torch._C._jit_fuser_cache_stats()
+            print(stats['hits'], stats['misses'], stats['evictions'])
+            """)
+
+        def run(cache_dir, *args, **env):
+            env = dict(os.environ, PYTORCH_FUSION_CACHE_DIR=cache_dir, **env)
+            output = subprocess.check_output([sys.executable, '-c', script] + list(args), env=env)
+            return tuple(int(n) for n in output.decode().split())
+
+        cache_dir = tempfile.mkdtemp()
+        try:
+            hits, misses, evictions = run(cache_dir)
+            if misses == 0:
+                raise unittest.SkipTest("no C++ compiler for the CPU fuser")
+            self.assertEqual(hits, 0)
+            self.assertEqual(evictions, 0)
+            self.assertEqual(run(cache_dir), (misses, 0, 0))
+            # kernels are cached by content, compiling another fusion group
+            # first doesn't change the entry of f
+            self.assertEqual(run(cache_dir, 'g')[0], misses)
+        finally:
+            shutil.rmtree(cache_dir)
+
+        cache_dir = tempfile.mkdtemp()
+        try:
+            # temporary files of a crashed writer are removed once stale
+            stale = [os.path.join(cache_dir, '0' * 16 + 'abcdef' + ext) for ext in ('.so', '.key')]
+            fresh = os.path.join(cache_dir, '1' * 16 + 'abcdef.so')
+            for path in stale + [fresh]:
+                open(path, 'w').close()
+            for path in stale:
+                os.utime(path, (0, 0))
+            # with no room every new entry is evicted right after it is loaded
+            hits, misses, evictions = run(cache_dir, 'g', PYTORCH_FUSION_CACHE_SIZE_MB='0')
+            self.assertEqual(hits, 0)
+            self.assertEqual(evictions, misses)
+            self.assertEqual(os.listdir(cache_dir), [os.path.basename(fresh)])
+        finally:
+            shutil.rmtree(cache_dir)
+
     @unittest.skipIf(IS_WINDOWS, "NYI: fuser support for Windows")
     @unittest.skipIf(not RUN_CUDA, "fuser requires CUDA")
     def test_run_lstm_fusion_concat(self):
@@ -52,6 +52,14 @@ def send_tensor(queue, event, tp):
     event.wait()
 
 
+def send_slab_tensors(queue, done):
+    torch._C._init_worker_slab(1024 * 1024, 2)
+    for i in range(5):
+        storage = torch.FloatStorage._new_shared(25)
+        queue.put(torch.FloatTensor(storage).view(5, 5).fill_(i))
+    done.wait()
+
+
 def call_backward():
     x = torch.autograd.Variable(torch.randn(3, 3), requires_grad=True)
     x.sum().backward()
@@ -293,6 +301,54 @@ class TestMultiprocessing(TestCase):
             for _ in range(TEST_REPEATS):
                 queue_put()
 
+    @unittest.skipIf(IS_WINDOWS, "shared memory slabs are not supported on Windows")
+    def test_slab_sharing(self):
+        q = mp.Queue()
+        done = mp.Event()
+        p = mp.Process(target=send_slab_tensors, args=(q, done))
+        p.daemon = True
+        p.start()
+        tensors = [q.get() for _ in range(5)]
+        handles = set()
+        for i, t in enumerate(tensors):
+            self.assertEqual(t, torch.ones(5, 5) * i)
+            self.assertTrue(t.is_shared())
+            metadata = t.storage()._share_slab_()
+            self.assertIsNotNone(metadata)
+            handles.add(metadata[1])
+        # All the tensors are in the single slab of the sender
+        self.assertEqual(len(handles), 1)
+        done.set()
+        p.join()
+        del tensors
+        torch._C._release_worker_slabs((p.pid,))
+
+    @unittest.skipIf(IS_WINDOWS, "shared memory slabs are not supported on Windows")
+    def test_slab_segment_reuse_and_fallback(self):
+        segment_numel = 1024
+        torch._C._init_worker_slab(segment_numel * 4, 2)
+        try:
+            # Each storage fills a segment
+            s1 = torch.FloatStorage._new_shared(segment_numel)
+            s2 = torch.FloatStorage._new_shared(segment_numel)
+            self.assertEqual(s2.data_ptr(), s1.data_ptr() + segment_numel * 4)
+            # While both segments are used, storages fall back to the sharing
+            # strategy, and so do storages larger than a segment
+            s3 = torch.FloatStorage._new_shared(segment_numel)
+            self.assertIsNone(s3._share_slab_())
+            s4 = torch.FloatStorage._new_shared(segment_numel + 1)
+            self.assertIsNone(s4._share_slab_())
+            self.assertTrue(s3.is_shared() and s4.is_shared())
+            # The first segment is reused once its storage is freed
+            p1 = s1.data_ptr()
+            del s1
+            s5 = torch.FloatStorage._new_shared(segment_numel)
+            self.assertEqual(s5.data_ptr(), p1)
+            del s2, s3, s4, s5
+        finally:
+            torch._C._close_worker_slab()
+        self.assertIsNone(torch.FloatStorage._new_shared(1)._share_slab_())
+
     def test_inherit_tensor(self):
         t = torch.zeros(5, 5)
         p = SubProcess(t.share_memory_())
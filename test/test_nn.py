@@ -1474,6 +1474,16 @@ class TestNN(NNTestCase):
                  [0, 0],
                  [1, 2],
                  [3, 4]])
+        elif mode == 'max':
+            expected_output = torch.Tensor(
+                [[7, 8],
+                 [9, 10]])
+            expected_grad_weight = torch.Tensor(
+                [[0, 0],
+                 [0, 0],
+                 [0, 0],
+                 [1, 2],
+                 [3, 4]])
         else:
             expected_output = torch.Tensor(
                 [[13. / 3, 16. / 3],
@@ -1514,7 +1524,7 @@ class TestNN(NNTestCase):
         self.assertEqual(output.data, expected_output)
         self.assertEqual(es_weight_grad, expected_grad_weight, type2prec[dtype.__name__])
 
-        # now compare EmbeddingBag vs Embedding + Sum/Mean, for constant bag length
+        # now compare EmbeddingBag vs Embedding + Sum/Mean/Max, for constant bag length
         def _test_vs_Embedding(N, D, B, L):
             es = nn.EmbeddingBag(N, D, mode=mode, sparse=sparse).type(dtype)
             e = nn.Embedding(N, D).type(dtype)
@@ -1533,6 +1543,8 @@ class TestNN(NNTestCase):
             output = es(input.view(-1), offsets)
             if mode == 'sum':
                 ref_output = e(input).sum(1)
+            elif mode == 'max':
+                ref_output = e(input).max(1)[0]
             else:
                 ref_output = e(input).mean(1)
 
@@ -1613,6 +1625,93 @@ class TestNN(NNTestCase):
         self._test_EmbeddingBag(False, 'mean', False)
         self._test_EmbeddingBag(False, 'sum', True)
         self._test_EmbeddingBag(False, 'mean', True)
+        self._test_EmbeddingBag(False, 'max', False)
+
+        es = nn.EmbeddingBag(10, 20, mode='max', sparse=True)
+        input = Variable(torch.LongTensor([1, 2, 3, 4]))
+        offsets = Variable(torch.LongTensor([0, 2]))
+        self.assertRaises(ValueError, lambda: es(input, offsets))
+
+    def test_embedding_bag_empty_bag_max(self):
+        es = nn.EmbeddingBag(5, 2, mode='max').double()
+        input = Variable(torch.LongTensor([3, 1, 4]))
+        offsets = Variable(torch.LongTensor([0, 2, 2]))
+        output = es(input, offsets)
+        self.assertEqual(output[1].data, torch.zeros(2).double())
+        output.backward(torch.ones(3, 2).double())
+        self.assertEqual(es.weight.grad.data.sum(), 4)
+
+    def test_embedding_bag_max_nan(self):
+        es = nn.EmbeddingBag(5, 2, mode='max').double()
+        es.weight.data.copy_(torch.DoubleTensor([[0, 1], [float('nan'), 2], [3, 4], [5, 6], [7, 8]]))
+        input = Variable(torch.LongTensor([0, 1, 2, 1, 3, 4]))
+        offsets = Variable(torch.LongTensor([0, 3]))
+        output = es(input, offsets).data
+        # a NaN propagates whether it comes first in the bag or not
+        self.assertNotEqual(output[0, 0], output[0, 0])
+        self.assertNotEqual(output[1, 0], output[1, 0])
+        self.assertEqual(output[:, 1], torch.DoubleTensor([4, 8]))
+
+    def test_embedding_bag_empty_bag_mean(self):
+        es = nn.EmbeddingBag(5, 2, mode='mean').double()
+        input = Variable(torch.LongTensor([3, 1, 4]))
+        offsets = Variable(torch.LongTensor([0, 2, 2]))
+        output = es(input, offsets)
+        self.assertEqual(output[1].data, torch.zeros(2).double())
+        output.backward(torch.ones(3, 2).double())
+        self.assertEqual(es.weight.grad.data.sum(), 4)
+
+    def _test_EmbeddingBag_per_sample_weights(self, sparse):
+        N, D, B, L = 10, 5, 4, 3
+        es = nn.EmbeddingBag(N, D, mode='sum', sparse=sparse).double()
+        e = nn.Embedding(N, D).double()
+        e.weight.data.copy_(es.weight.data)
+        input = Variable(torch.rand(B, L).mul(N).long())
+        weights = torch.randn(B, L).double()
+        es_weights = Variable(weights.clone(), requires_grad=True)
+        e_weights = Variable(weights.clone(), requires_grad=True)
+        grad_output = torch.randn(B, D).double()
+
+        output = es(input, per_sample_weights=es_weights)
+        ref_output = (e(input) * e_weights.unsqueeze(2)).sum(1)
+        self.assertEqual(output, ref_output)
+
+        output.backward(grad_output)
+        ref_output.backward(grad_output)
+        es_weight_grad = es.weight.grad.data
+        if sparse:
+            es_weight_grad = es.weight.grad.data.to_dense()
+        self.assertEqual(es_weight_grad, e.weight.grad.data)
+        self.assertEqual(es_weights.grad, e_weights.grad)
+
+        # 1D input with offsets
+        offsets = Variable(torch.arange(0, B).mul(L).long())
+        output = es(input.view(-1), offsets, es_weights.view(-1))
+        self.assertEqual(output, ref_output)
+
+        # strided 1D per_sample_weights
+        strided_weights = Variable(torch.stack([weights.view(-1), weights.view(-1)], 1))
+        output = es(input.view(-1), offsets, strided_weights[:, 0])
+        self.assertEqual(output, ref_output)
+
+        def fn(weight, per_sample_weights):
+            return F.embedding_bag(weight, input.view(-1), offsets, mode='sum',
+                                   per_sample_weights=per_sample_weights)
+        self.assertTrue(gradcheck(fn, (Variable(es.weight.data.clone(), requires_grad=True),
+                                       Variable(weights.view(-1).clone(), requires_grad=True))))
+
+    def test_embedding_bag_per_sample_weights(self):
+        self._test_EmbeddingBag_per_sample_weights(False)
+        self._test_EmbeddingBag_per_sample_weights(True)
+
+        input = Variable(torch.LongTensor([1, 2, 3, 4]))
+        offsets = Variable(torch.LongTensor([0, 2]))
+        weights = Variable(torch.ones(4))
+        for mode in ['mean', 'max']:
+            es = nn.EmbeddingBag(10, 20, mode=mode)
+            self.assertRaises(ValueError, lambda: es(input, offsets, weights))
+        es = nn.EmbeddingBag(10, 20, mode='sum')
+        self.assertRaises(ValueError, lambda: es(input, offsets, weights[:3]))
 
     @unittest.skipIf(not TEST_CUDA, "CUDA unavailable")
     @repeat_test_for_types(ALL_TENSORTYPES)
@@ -5626,6 +5626,40 @@ class TestTorch(TestCase):
     def test_serialization_offset_filelike(self):
         self._test_serialization_offset(BytesIOContext)
 
+    def _test_serialization_async(self, filecontext_lambda):
+        a = torch.randn(5, 5)
+        b = a[1:3]
+        c = torch.LongTensor(4).fill_(7)
+        with filecontext_lambda() as f:
+            future = torch.save_async((a, b, c), f)
+            expected = a.clone()
+            # The tensors are copied before save_async returns
+            a.fill_(0)
+            self.assertTrue(future.wait())
+            self.assertTrue(future.done())
+            f.seek(0)
+            a2, b2, c2 = torch.load(f)
+            self.assertEqual(a2, expected, 0)
+            self.assertEqual(c2, c, 0)
+            self.assertEqual(b2.storage().data_ptr(), a2.storage().data_ptr())
+
+    def test_serialization_async(self):
+        self._test_serialization_async(tempfile.NamedTemporaryFile)
+
+    def test_serialization_async_filelike(self):
+        self._test_serialization_async(BytesIOContext)
+
+    def test_serialization_async_error(self):
+        class BrokenFile(object):
+            def write(self, data):
+                raise IOError("broken")
+
+            def flush(self):
+                pass
+
+        future = torch.save_async(torch.randn(5), BrokenFile())
+        self.assertRaises(IOError, lambda: future.wait())
+
     def test_half_tensor(self):
         x = torch.randn(5, 5).float()
         y = torch.randn(5, 5).float()
@@ -6536,6 +6570,33 @@ class TestTorch(TestCase):
         self.assertEqual(torch.ByteTensor([7, 42, 128, 133]), byte_unique)
         self.assertEqual(torch.LongTensor([3, 0, 0, 0, 1, 2]), byte_inverse)
 
+        # Tests counts.
+        x_unique, x_inverse, x_counts = torch.unique(
+            x, sorted=True, return_inverse=True, return_counts=True)
+        self.assertEqual(expected_unique, x_unique)
+        self.assertEqual(expected_inverse, x_inverse)
+        self.assertEqual(torch.LongTensor([1, 3, 2, 1, 1]), x_counts)
+
+        x_unique, x_counts = x.unique(return_counts=True)
+        self.assertEqual(
+            expected_unique.tolist(), sorted(x_unique.tolist()))
+        self.assertEqual(x.numel(), sum(x_counts.tolist()))
+
+        # Tests large inputs, which are deduplicated in parallel.
+        z = torch.LongTensor(300007).random_(0, 1000)
+        z[0] = -5
+        z_unique, z_inverse, z_counts = torch.unique(
+            z, sorted=True, return_inverse=True, return_counts=True)
+        expected_z_unique = sorted(set(z.tolist()))
+        self.assertEqual(expected_z_unique, z_unique.tolist())
+        self.assertEqual(z, z_unique[z_inverse])
+        self.assertEqual(z_counts, torch.zeros(z_unique.numel()).long().index_add_(
+            0, z_inverse, torch.ones(z.numel()).long()))
+
+        z_unique, z_inverse = z.float().unique(return_inverse=True)
+        self.assertEqual(expected_z_unique, sorted(z_unique.long().tolist()))
+        self.assertEqual(z.float(), z_unique[z_inverse])
+
     @unittest.skipIf(not torch.cuda.is_available(), 'no CUDA')
     def test_unique_cuda(self):
         # unique currently does not support CUDA.
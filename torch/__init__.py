@@ -17,7 +17,8 @@ from ._six import string_classes as _string_classes
 __all__ = [
     'typename', 'is_tensor', 'is_storage', 'set_default_tensor_type',
     'set_rng_state', 'get_rng_state', 'manual_seed', 'initial_seed',
-    'save', 'load', 'set_printoptions', 'chunk', 'split', 'stack', 'matmul',
+    'save', 'save_async', 'load', 'set_printoptions', 'chunk', 'split',
+    'stack', 'matmul',
     'no_grad', 'enable_grad',
     'DoubleStorage', 'FloatStorage', 'LongStorage', 'IntStorage',
     'ShortStorage', 'CharStorage', 'ByteStorage',
@@ -170,7 +171,7 @@ def set_default_dtype(d):
     _C._set_default_dtype(d)
 
 from .random import set_rng_state, get_rng_state, manual_seed, initial_seed
-from .serialization import save, load
+from .serialization import save, save_async, load
 from ._tensor_str import set_printoptions
 
 ################################################################################
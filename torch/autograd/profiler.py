@@ -142,6 +142,12 @@ class profile(object):
             Adds approximately 4us of overhead to each tensor operation.
             Default: ``False``
 
+        sample_period (int, optional): Records only one in ``sample_period`` top-level
+            ranges of each thread, with all the ranges nested in them. Default: ``1``
+
+        record_shapes (bool, optional): Records the sizes of the inputs of autograd
+            functions in ``input_shapes``. Default: ``False``
+
     .. warning:
         This context managers should not be called recursively, i.e. at most one
         instance should be enabled at any given time.
@@ -166,9 +172,11 @@ class profile(object):
         N5torch8autograd5CloneE                        4.088us          0.000us
     """
 
-    def __init__(self, enabled=True, use_cuda=False):
+    def __init__(self, enabled=True, use_cuda=False, sample_period=1, record_shapes=False):
         self.enabled = enabled
         self.use_cuda = use_cuda
+        self.sample_period = sample_period
+        self.record_shapes = record_shapes
         self.function_events = None
         if not self.enabled:
             return
@@ -182,7 +190,7 @@ class profile(object):
         self.entered = True
         profiler_kind = torch.autograd.ProfilerState.CUDA if self.use_cuda \
             else torch.autograd.ProfilerState.CPU
-        torch.autograd._enable_profiler(profiler_kind)
+        torch.autograd._enable_profiler(profiler_kind, self.sample_period, self.record_shapes)
         return self
 
     def __exit__(self, exc_type, exc_val, exc_tb):
@@ -227,6 +235,65 @@ class profile(object):
     total_average.__doc__ = EventList.total_average.__doc__
 
 
+class stream_trace(object):
+    """Context manager that streams autograd profiler events to a Chrome trace file.
+
+    Unlike :class:`profile`, the events are not kept in memory: each thread fills
+    a fixed number of buffers, which a background thread writes to ``path`` as
+    they fill up. It is meant to stay enabled during long runs, e.g. with
+    ``sample_period`` set. If the writer doesn't keep up with a thread, the
+    events of the thread are dropped until a buffer is free again. The trace
+    can be inspected under the ``chrome://tracing`` URL, and has the allocated
+    bytes of each range, and the input shapes if ``record_shapes`` is set.
+    Names are not demangled.
+
+    Arguments:
+        path (str): Path where the trace will be written.
+        enabled (bool, optional): Setting this to False makes this context manager a no-op.
+            Default: ``True``.
+        sample_period (int, optional): Records only one in ``sample_period`` top-level
+            ranges of each thread, with all the ranges nested in them. Default: ``1``
+        record_shapes (bool, optional): Records the sizes of the inputs of autograd
+            functions. Default: ``False``
+        block_size (int, optional): The number of events in each buffer of a thread,
+            or 0 for buffers of 1MB. Default: ``0``
+
+    After it exits, ``events_written`` and ``events_dropped`` hold the number of
+    events that were written to the trace, and that were dropped.
+
+    Example:
+        >>> with torch.autograd.profiler.stream_trace('trace.json', sample_period=100) as trace:
+        ...     for x in data:
+        ...         model(x).sum().backward()
+        >>> print(trace.events_dropped)
+    """
+    def __init__(self, path, enabled=True, sample_period=1, record_shapes=False, block_size=0):
+        self.path = path
+        self.enabled = enabled
+        self.sample_period = sample_period
+        self.record_shapes = record_shapes
+        self.block_size = block_size
+        self.entered = False
+        self.events_written = None
+        self.events_dropped = None
+
+    def __enter__(self):
+        if not self.enabled:
+            return
+        if self.entered:
+            raise RuntimeError("trace streaming context manager is not reentrant")
+        self.entered = True
+        torch.autograd._start_trace_streaming(self.path, self.sample_period, self.record_shapes,
+                                              self.block_size)
+        return self
+
+    def __exit__(self, exc_type, exc_val, exc_tb):
+        if not self.enabled:
+            return
+        self.events_written, self.events_dropped = torch.autograd._stop_trace_streaming()
+        return False
+
+
 class emit_nvtx(object):
     """Context manager that makes every autograd operation emit an NVTX range.
 
@@ -336,11 +403,13 @@ class Kernel(object):
 # TODO: record TID too
 class FunctionEvent(FormattedTimesMixin):
     """Profiling information about a single function."""
-    def __init__(self, id, name, thread, cpu_start, cpu_end):
+    def __init__(self, id, name, thread, cpu_start, cpu_end, input_shapes=None, allocated_bytes=0):
         self.id = id
         self.name = name
         self.cpu_interval = Interval(cpu_start, cpu_end)
         self.thread = thread
+        self.input_shapes = input_shapes
+        self.allocated_bytes = allocated_bytes
         self.kernels = []
         self.count = 1
 
@@ -450,7 +519,9 @@ def parse_cpu_trace(thread_records):
                 name=string_table[start.name()],
                 thread=start.thread_id(),
                 cpu_start=start_record.cpu_elapsed_us(start),
-                cpu_end=start_record.cpu_elapsed_us(record))
+                cpu_end=start_record.cpu_elapsed_us(record),
+                input_shapes=start.shapes() or None,
+                allocated_bytes=record.allocated_bytes() - start.allocated_bytes())
             if start.has_cuda():
                 cuda_start = adjusted_time(start)
                 cuda_end = adjusted_time(record)
@@ -20,6 +20,7 @@
 #include <signal.h>
 #include <sstream>
 #include <sys/wait.h>
+#include <libshm.h>
 
 #include "torch/csrc/Exceptions.h"
 #include "torch/csrc/utils/python_numbers.h"
@@ -184,6 +185,49 @@ static PyObject *THPModule_removeWorkerPIDs(PyObject *module, PyObject *loader_i
   END_HANDLE_TH_ERRORS
 }
 
+// Workers allocate the batches they send to the main process from a shared
+// memory slab, which the main process maps once and whose regions it gives
+// back by freeing them, see libshm/slab.cpp. Python handle is
+// _init_worker_slab(segment_size, num_segments).
+static PyObject *THPModule_initWorkerSlab(PyObject *module, PyObject *args) {
+  HANDLE_TH_ERRORS
+  if (PyTuple_GET_SIZE(args) != 2) {
+    throw TypeError("_init_worker_slab expects exactly 2 arguments.");
+  }
+  int64_t segment_size = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 0));
+  int64_t num_segments = THPUtils_unpackLong(PyTuple_GET_ITEM(args, 1));
+  libshm_slab_init(segment_size, num_segments);
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+// Drops the reference of a worker to its own slab when it exits. Python
+// handle is _close_worker_slab().
+static PyObject *THPModule_closeWorkerSlab(PyObject *module, PyObject *_ignored) {
+  HANDLE_TH_ERRORS
+  libshm_slab_close();
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+// Unmaps the slabs of the given workers once their storages are freed, and
+// leaves those of the workers of other loaders. Python handle is
+// _release_worker_slabs(child_pids), where child_pids is a tuple.
+static PyObject *THPModule_releaseWorkerSlabs(PyObject *module, PyObject *child_pids) {
+  HANDLE_TH_ERRORS
+  if (!PyTuple_Check(child_pids)) {
+    throw TypeError("_release_worker_slabs expects a tuple for child_pids, but got %s.",
+        Py_TYPE(child_pids)->tp_name);
+  }
+  auto size = PyTuple_GET_SIZE(child_pids);
+  for (int idx = 0; idx < size; idx++) {
+    PyObject* obj = PyTuple_GET_ITEM(child_pids, idx);
+    libshm_slab_release_process((pid_t) THPUtils_unpackLong(obj));
+  }
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 #undef SIGNAL_HANDLER
 
 #else
@@ -205,6 +249,18 @@ static PyObject *THPModule_errorIfAnyWorkerFails(PyObject *module, PyObject *_ig
   Py_RETURN_NONE;
 }
 
+static PyObject *THPModule_initWorkerSlab(PyObject *module, PyObject *_ignored) {
+  Py_RETURN_NONE;
+}
+
+static PyObject *THPModule_closeWorkerSlab(PyObject *module, PyObject *_ignored) {
+  Py_RETURN_NONE;
+}
+
+static PyObject *THPModule_releaseWorkerSlabs(PyObject *module, PyObject *_ignored) {
+  Py_RETURN_NONE;
+}
+
 #endif
 
 PyMethodDef DataLoaderMethods[] = {
@@ -212,5 +268,8 @@ PyMethodDef DataLoaderMethods[] = {
   {"_update_worker_pids",          (PyCFunction)THPModule_updateWorkerPIDs,         METH_VARARGS,  NULL},
   {"_remove_worker_pids",          (PyCFunction)THPModule_removeWorkerPIDs,         METH_O,        NULL},
   {"_error_if_any_worker_fails",   (PyCFunction)THPModule_errorIfAnyWorkerFails,    METH_NOARGS,   NULL},
+  {"_init_worker_slab",            (PyCFunction)THPModule_initWorkerSlab,           METH_VARARGS,  NULL},
+  {"_close_worker_slab",           (PyCFunction)THPModule_closeWorkerSlab,          METH_NOARGS,   NULL},
+  {"_release_worker_slabs",        (PyCFunction)THPModule_releaseWorkerSlabs,       METH_O,        NULL},
   {NULL, NULL, 0, NULL}
 };
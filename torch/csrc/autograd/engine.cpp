@@ -6,9 +6,11 @@
 #include "torch/csrc/autograd/variable.h"
 #include "torch/csrc/utils/auto_gpu.h"
 
+#include <algorithm>
 #include <atomic>
 #include <condition_variable>
 #include <cstdint>
+#include <cstdlib>
 #include <functional>
 #include <iostream>
 #include <memory>
@@ -49,6 +51,13 @@ static thread_local bool checkpoint_valid = true;
 // executed at the same time). Adding multiple threads per-device or removing
 // engine thread affinity to the device can break this invariant, and we depend
 // on it in a few places (e.g. AccumulateGrad function).
+// When several CPU workers are enabled (see Note [Multiple CPU workers]), the
+// invariant no longer holds for CPU functions, and the functions that mutate
+// shared state lock it themselves.
+
+// Environment variable with the number of CPU worker threads,
+// see Note [Multiple CPU workers]
+static constexpr const char* CPU_WORKERS_ENV = "TORCH_AUTOGRAD_CPU_WORKERS";
 
 struct FunctionTask {
   GraphTask* base;
@@ -76,7 +85,13 @@ struct ReadyQueue {
   std::mutex mutex;
 
   void push(FunctionTask item);
-  FunctionTask pop();
+  // Blocks until a task is available. If graph_task is given, also returns
+  // when it has no outstanding tasks left; the returned task has a null base
+  // in that case.
+  FunctionTask pop(GraphTask* graph_task = nullptr);
+  // Wakes up all threads blocked in pop(), so that the owner of a finished
+  // graph task can return. See Note [Reentrant backwards]
+  void wake_all();
 };
 
 // Note [Reentrant backwards]
@@ -115,6 +130,25 @@ struct ReadyQueue {
 //    loop.  Thus the faffing about in thread_main() after
 //    evaluate_function() completes.
 
+// Note [Multiple CPU workers]
+// ~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// By default a single worker thread processes the CPU ready queue.  Setting
+// TORCH_AUTOGRAD_CPU_WORKERS=N (or calling Engine::set_num_cpu_workers before
+// the first backward) starts N CPU workers that all pop from the CPU ready
+// queue, so independent branches of the graph are evaluated in parallel.
+// The queue stays a single heap ordered by sequence_nr; the dependency
+// counting and the input buffers in GraphTask are already updated under
+// GraphTask::mutex.
+//
+// No lock is held while a function is applied, since it may run user code,
+// e.g. hooks or a reentrant backward. A function that is reached by two graph
+// tasks at once can thus be applied concurrently, and AccumulateGrad, whose
+// gradient is shared, serializes its update with a mutex of its own.
+//
+// Since all CPU workers share a worker_device, the thread that owns a
+// reentrant GraphTask is identified by GraphTask::owner_thread, and it is
+// woken up through ReadyQueue::wake_all() once its graph task completes.
+
 
 // GraphTask holds metadata needed for a single execution of backward()
 struct GraphTask {
@@ -160,6 +194,9 @@ struct GraphTask {
   // The value of worker_device in the thread that created this task.
   // See Note [Reentrant backwards]
   int owner;
+  // The thread that created this task, only meaningful if owner != NO_DEVICE.
+  // See Note [Multiple CPU workers]
+  std::thread::id owner_thread;
 
   bool can_checkpoint() {
     return exec_info.empty();
@@ -187,14 +224,26 @@ auto ReadyQueue::push(FunctionTask item) -> void {
   not_empty.notify_one();
 }
 
-auto ReadyQueue::pop() -> FunctionTask {
+auto ReadyQueue::pop(GraphTask* graph_task) -> FunctionTask {
   std::unique_lock<std::mutex> lock(mutex);
-  not_empty.wait(lock, [this]{ return !heap.empty(); });
+  not_empty.wait(lock, [this, graph_task]{
+    return !heap.empty() || (graph_task && graph_task->outstanding_tasks == 0);
+  });
+  if (heap.empty()) {
+    return FunctionTask(nullptr, nullptr, InputBuffer(0));
+  }
   auto task = std::move(const_cast<FunctionTask&>(heap.top())); heap.pop();
   return task;
 }
 
-Engine::Engine() : ready_queues() {
+auto ReadyQueue::wake_all() -> void {
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+  }
+  not_empty.notify_all();
+}
+
+Engine::Engine() : ready_queues(), num_cpu_workers(0), threads_started(false) {
 }
 
 // This Engine's ReadyQueues and their corresponding threads are leaked here
@@ -226,7 +275,11 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
   // Why the test on graph_task->outstanding_tasks?  See
   // Note [Reentrant backwards]
   while (!graph_task || graph_task->outstanding_tasks > 0) {
-    FunctionTask task = queue->pop();
+    FunctionTask task = queue->pop(graph_task);
+    if (!task.base) {
+      // graph_task has completed on another thread
+      continue;
+    }
     if (task.fn && !task.base->has_error.load()) {
       GradMode::set_enabled(task.base->grad_mode);
       try {
@@ -248,18 +301,15 @@ auto Engine::thread_main(GraphTask *graph_task) -> void {
     } else {
       // If it's a task initiated from this thread, decrease the counter, but
       // don't do anything - loop condition will do all checks for us next.
-      if (base_owner == worker_device) {
+      if (base_owner == worker_device &&
+          task.base->owner_thread == std::this_thread::get_id()) {
         --task.base->outstanding_tasks;
-      // Otherwise send a dummy function task to the owning thread just to
-      // ensure that it's not sleeping. If it has work, it might see that
-      // graph_task->outstanding_tasks == 0 before it gets to the task, but
-      // it's a no-op anyway.
-      } else if (base_owner != worker_device) {
-        if (--task.base->outstanding_tasks == 0) {
-          // Synchronize outstanding_tasks with queue mutex
-          std::atomic_thread_fence(std::memory_order_release);
-          ready_queue(base_owner).push(FunctionTask(task.base, nullptr, InputBuffer(0)));
-        }
+      // Otherwise wake up the owning thread just to ensure that it's not
+      // sleeping. If it has work, it might see that
+      // graph_task->outstanding_tasks == 0 before it gets to the next task,
+      // which stays in the queue for the other workers.
+      } else if (--task.base->outstanding_tasks == 0) {
+        ready_queue(base_owner).wake_all();
       }
     }
   }
@@ -450,6 +500,7 @@ auto Engine::execute(const edge_list& input_roots,
     // complete!
     // See Note [Reentrant backwards]
     graph_task.owner = worker_device;
+    graph_task.owner_thread = std::this_thread::get_id();
     lock.unlock();
     thread_main(&graph_task);
   }
@@ -496,6 +547,18 @@ auto Engine::ready_queue(int device) -> ReadyQueue& {
   return *ready_queues.at(device + 1);
 }
 
+void Engine::set_num_cpu_workers(int num_workers) {
+  if (num_workers < 1) {
+    throw std::runtime_error("number of autograd CPU workers must be positive");
+  }
+  std::lock_guard<std::mutex> lock(workers_lock);
+  if (threads_started) {
+    throw std::runtime_error("the number of autograd CPU workers can't be "
+        "changed once backward has run");
+  }
+  num_cpu_workers = num_workers;
+}
+
 auto Engine::start_threads() -> void {
   int num_devices = 0;
 #ifdef WITH_CUDA
@@ -505,12 +568,25 @@ auto Engine::start_threads() -> void {
     num_devices = 0;
   }
 #endif
-  // One for CPU, plus one for every GPU device
-  int num_threads = num_devices + 1;
-  ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_threads);
+  // See Note [Multiple CPU workers]
+  std::lock_guard<std::mutex> lock(workers_lock);
+  threads_started = true;
+  if (num_cpu_workers <= 0) {
+    num_cpu_workers = 1;
+    if (const char* workers_env = std::getenv(CPU_WORKERS_ENV)) {
+      num_cpu_workers = std::max(std::atoi(workers_env), 1);
+    }
+  }
+  // One queue for CPU, plus one for every GPU device
+  int num_queues = num_devices + 1;
+  ready_queues = std::vector<std::shared_ptr<ReadyQueue>>(num_queues);
   for (auto& queue : ready_queues)
     queue.reset(new ReadyQueue());
-  for (int i = 0; i < num_threads; ++i) {
+  for (int i = 0; i < num_cpu_workers; ++i) {
+    std::thread t(&Engine::thread_init, this, -1);
+    t.detach();
+  }
+  for (int i = 1; i < num_queues; ++i) {
     std::thread t(&Engine::thread_init, this, i - 1);
     t.detach();
   }
@@ -3,6 +3,7 @@
 // Engine implements backpropagation from output variables and their gradients
 // to "root" variables (variables created by the user with requires_grad=True).
 
+#include <atomic>
 #include <deque>
 #include <memory>
 #include <unordered_map>
@@ -43,6 +44,11 @@ struct Engine {
 
   bool is_checkpoint_valid();
 
+  // Sets the number of worker threads processing the CPU ready queue, has to
+  // be called before the first call to execute, and throws afterwards.
+  // Defaults to the value of TORCH_AUTOGRAD_CPU_WORKERS, or 1 if it's not set.
+  void set_num_cpu_workers(int num_workers);
+
 protected:
   void compute_dependencies(Function* root, GraphTask& task);
   void evaluate_function(FunctionTask& task);
@@ -56,6 +62,9 @@ protected:
   std::vector<std::shared_ptr<ReadyQueue>> ready_queues;
   std::vector<std::function<void()>> final_callbacks;
   std::mutex post_callbacks_lock;
+  std::mutex workers_lock;
+  std::atomic<int> num_cpu_workers;
+  bool threads_started;
 };
 
 }} // namespace torch::autograd
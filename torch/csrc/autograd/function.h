@@ -102,7 +102,7 @@ struct Function : std::enable_shared_from_this<Function> {
   /// Evaluates the function on the given inputs and returns the result of the
   /// function call.
   variable_list operator()(const variable_list& inputs) {
-    profiler::RecordFunction rec(this);
+    profiler::RecordFunction rec(this, inputs);
     if (jit::tracer::isTracingVar(inputs)) {
       return traced_apply(inputs);
     }
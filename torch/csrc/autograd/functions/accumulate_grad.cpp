@@ -15,7 +15,6 @@ AccumulateGrad::AccumulateGrad(Variable variable_)
     : Function(/*num_inputs=*/1), variable(std::move(variable_)) {}
 
 auto AccumulateGrad::apply(const variable_list& grads) -> variable_list {
-  // XXX: this method is not thread-safe!
   check_input_variables("AccumulateGrad", grads, 1, 0);
 
   if (!grads[0].defined())
@@ -30,6 +29,8 @@ auto AccumulateGrad::apply(const variable_list& grads) -> variable_list {
     new_grad = (*hook)({new_grad})[0];
   }
 
+  // The hooks above are user code, and are run without the lock
+  std::lock_guard<std::mutex> lock(mutex_);
   auto& grad = variable.grad();
   if (!grad.defined()) {
     variable.grad() = new_grad.clone();
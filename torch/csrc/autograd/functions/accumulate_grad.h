@@ -3,6 +3,8 @@
 #include "torch/csrc/autograd/function.h"
 #include "torch/csrc/autograd/variable.h"
 
+#include <mutex>
+
 namespace torch { namespace autograd {
 
 struct AccumulateGrad : public Function {
@@ -11,6 +13,11 @@ struct AccumulateGrad : public Function {
   virtual variable_list apply(const variable_list& inputs) override;
 
   Variable variable;
+
+ private:
+  // Serializes the updates of the gradient by several CPU workers.
+  // See Note [Multiple CPU workers]
+  std::mutex mutex_;
 };
 
 }} // namespace torch::autograd
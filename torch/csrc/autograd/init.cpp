@@ -31,6 +31,8 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   .def("device",&torch::autograd::profiler::Event::device)
   .def("cpu_elapsed_us",&torch::autograd::profiler::Event::cpu_elapsed_us)
   .def("cuda_elapsed_us",&torch::autograd::profiler::Event::cuda_elapsed_us)
+  .def("allocated_bytes",&torch::autograd::profiler::Event::allocated_bytes)
+  .def("shapes",&torch::autograd::profiler::Event::shapes)
   .def("has_cuda",&torch::autograd::profiler::Event::has_cuda);
   py::enum_<torch::autograd::profiler::ProfilerState>(m,"ProfilerState")
   .value("Disabled", torch::autograd::profiler::ProfilerState::Disabled)
@@ -38,8 +40,14 @@ PyObject * THPAutograd_initExtension(PyObject *_unused)
   .value("CUDA", torch::autograd::profiler::ProfilerState::CUDA)
   .value("NVTX", torch::autograd::profiler::ProfilerState::NVTX);
 
-  m.def("_enable_profiler", torch::autograd::profiler::enableProfiler);
+  m.def("_enable_profiler", torch::autograd::profiler::enableProfiler,
+        py::arg("state"), py::arg("sample_period") = 1,
+        py::arg("record_shapes") = false);
   m.def("_disable_profiler", torch::autograd::profiler::disableProfiler);
+  m.def("_start_trace_streaming", torch::autograd::profiler::startTraceStreaming,
+        py::arg("path"), py::arg("sample_period") = 1,
+        py::arg("record_shapes") = false, py::arg("block_size") = 0);
+  m.def("_stop_trace_streaming", torch::autograd::profiler::stopTraceStreaming);
 
   m.def("_push_range", [](const char *name) {
     using namespace torch::autograd::profiler;
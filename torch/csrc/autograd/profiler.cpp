@@ -1,17 +1,209 @@
 #include "torch/csrc/autograd/profiler.h"
 #include "torch/csrc/autograd/function.h"
 
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <unordered_map>
+
 namespace torch { namespace autograd { namespace profiler {
 
 ProfilerState state = ProfilerState::Disabled;
+uint32_t sample_period = 1;
+bool record_shapes = false;
 uint32_t next_thread_id = 0;
 std::mutex all_event_lists_mutex;
 std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 thread_local std::shared_ptr<RangeEventList> event_list;
 thread_local int32_t thread_id;
 
-void RecordFunction::pushFunctionRange(Function* fn) {
-  pushRange(fn->name());
+// Names by id. A deque never moves its elements, so the references that
+// symbolName returns stay valid.
+static std::mutex symbols_mutex;
+static std::deque<std::string> symbol_names = {""};
+static std::unordered_map<std::string, uint32_t> symbol_ids = {{"", 0}};
+
+static uint32_t internNameSlow(const std::string& name) {
+  std::lock_guard<std::mutex> guard(symbols_mutex);
+  auto it = symbol_ids.find(name);
+  if (it != symbol_ids.end()) {
+    return it->second;
+  }
+  uint32_t id = symbol_names.size();
+  symbol_names.push_back(name);
+  symbol_ids.emplace(name, id);
+  return id;
+}
+
+const std::string& symbolName(uint32_t id) {
+  std::lock_guard<std::mutex> guard(symbols_mutex);
+  return symbol_names.at(id);
+}
+
+uint32_t internName(const std::string& name) {
+  thread_local std::unordered_map<std::string, uint32_t> cache;
+  auto it = cache.find(name);
+  if (it != cache.end()) {
+    return it->second;
+  }
+  uint32_t id = internNameSlow(name);
+  cache.emplace(name, id);
+  return id;
+}
+
+uint32_t internName(const char* name) {
+  // Most names are string literals or type names, so the cache is by
+  // address. The name at an address may change (e.g. for names that come
+  // from Python), which the comparison with the interned name catches.
+  thread_local std::unordered_map<const char*, std::pair<uint32_t, const std::string*>> cache;
+  auto it = cache.find(name);
+  if (it != cache.end() && std::strcmp(it->second.second->c_str(), name) == 0) {
+    return it->second.first;
+  }
+  uint32_t id = internName(std::string(name));
+  cache[name] = std::make_pair(id, &symbolName(id));
+  return id;
+}
+
+void RecordFunction::pushFunctionRange(Function* fn, const variable_list* inputs) {
+  if (state == ProfilerState::NVTX) {
+    pushRange(fn->name());
+    return;
+  }
+  Event* event = getEventList().pushRange(internName(fn->name()),
+                                          state == ProfilerState::CUDA);
+  if (event && inputs && record_shapes) {
+    std::vector<std::vector<int64_t>> shapes;
+    shapes.reserve(inputs->size());
+    for (auto& input : *inputs) {
+      if (input.defined()) {
+        auto sizes = input.sizes();
+        shapes.emplace_back(sizes.begin(), sizes.end());
+      } else {
+        shapes.emplace_back();
+      }
+    }
+    event->set_shapes(std::move(shapes));
+  }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Event lists
+////////////////////////////////////////////////////////////////////////////////
+
+// Pushes a block on a list of blocks that another thread takes at once
+static void pushBlock(std::atomic<RangeEventList::Block*>& list,
+                      RangeEventList::Block* block) {
+  RangeEventList::Block* head = list.load(std::memory_order_relaxed);
+  do {
+    block->next = head;
+  } while (!list.compare_exchange_weak(head, block, std::memory_order_release,
+                                       std::memory_order_relaxed));
+}
+
+// The full blocks of all the threads, the most recent first
+static std::atomic<RangeEventList::Block*> full_blocks{nullptr};
+static bool trace_streaming = false;
+static std::size_t trace_block_elements = RangeEventList::num_block_elements;
+
+RangeEventList& initEventList() {
+  std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+  thread_id = next_thread_id++;
+  event_list = std::make_shared<RangeEventList>(thread_id);
+  if (trace_streaming) {
+    event_list->startStreaming(trace_block_elements);
+  }
+  all_event_lists.emplace_front(event_list);
+  return *event_list;
+}
+
+bool RangeEventList::refill(std::size_t reserve) {
+  if (!streaming) {
+    if (!current || current->events.size() == block_elements) {
+      blocks.emplace_front(new Block(this, block_elements));
+      current = blocks.front().get();
+    }
+    return true;
+  }
+  reclaim();
+  std::size_t available = free_blocks.size() * block_elements;
+  if (current) {
+    available += block_elements - current->events.size();
+  }
+  if (available <= reserve) {
+    return false;
+  }
+  if (!current || current->events.size() == block_elements) {
+    if (current) {
+      pushBlock(full_blocks, current);
+    }
+    current = free_blocks.back();
+    free_blocks.pop_back();
+  }
+  return true;
+}
+
+void RangeEventList::reclaim() {
+  Block* block = returned.exchange(nullptr, std::memory_order_acquire);
+  while (block) {
+    free_blocks.push_back(block);
+    block = block->next;
+  }
+}
+
+std::vector<Event> RangeEventList::consolidate() {
+  std::vector<Event> result;
+  if (streaming) {
+    return result;
+  }
+  for (auto & block : blocks) {
+    result.insert(result.begin(),
+                  std::make_move_iterator(block->events.begin()),
+                  std::make_move_iterator(block->events.end()));
+  }
+  blocks.clear();
+  current = nullptr;
+  return result;
+}
+
+void RangeEventList::startStreaming(std::size_t new_block_elements) {
+  consolidate();
+  block_elements = new_block_elements;
+  for (std::size_t i = 0; i < num_ring_blocks; i++) {
+    blocks.emplace_front(new Block(this, block_elements));
+    free_blocks.push_back(blocks.front().get());
+  }
+  streaming = true;
+  dropped = 0;
+}
+
+void RangeEventList::flush() {
+  if (current && !current->events.empty()) {
+    pushBlock(full_blocks, current);
+    current = nullptr;
+  }
+}
+
+void RangeEventList::stopStreaming() {
+  returned.store(nullptr);
+  free_blocks.clear();
+  blocks.clear();
+  current = nullptr;
+  streaming = false;
+  block_elements = num_block_elements;
+}
+
+// GCs the lists that are not held by any threads
+static void eraseUnusedEventLists() {
+  for (auto it = all_event_lists.begin(); it != all_event_lists.end();) {
+    if (it->use_count() == 1) {
+      it = all_event_lists.erase(it);
+    } else {
+      ++it;
+    }
+  }
 }
 
 #ifdef WITH_CUDA
@@ -26,7 +218,8 @@ static void onEachDevice(std::function<void(int)> op) {
 }
 #endif
 
-void enableProfiler(ProfilerState new_state) {
+void enableProfiler(ProfilerState new_state, uint32_t new_sample_period,
+                    bool new_record_shapes) {
   TORCH_ASSERT(new_state != ProfilerState::Disabled);
 #ifndef WITH_CUDA
   if (new_state == ProfilerState::NVTX)
@@ -35,6 +228,20 @@ void enableProfiler(ProfilerState new_state) {
   if (state != ProfilerState::Disabled && new_state != state) {
       throw std::runtime_error("can't change kind of profiling (e.g. NVTX to CPU) while profiler is running");
   }
+  if (trace_streaming) {
+    throw std::runtime_error("can't enable the profiler while it is streaming a trace");
+  }
+  if (new_sample_period == 0) {
+    throw std::runtime_error("the sample period of the profiler must be positive");
+  }
+  if (state == ProfilerState::Disabled) {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    for (auto & list : all_event_lists) {
+      list->resetRanges();
+    }
+  }
+  sample_period = new_sample_period;
+  record_shapes = new_record_shapes;
   state = new_state;
 
 #ifdef WITH_CUDA
@@ -63,6 +270,9 @@ thread_event_lists disableProfiler() {
   if (state == ProfilerState::Disabled) {
     throw std::runtime_error("can't disable profiler when it's not running");
   }
+  if (trace_streaming) {
+    throw std::runtime_error("the profiler is streaming a trace, which must be stopped instead");
+  }
   ProfilerState old_state = state;
   mark("__stop_profile");
   state = ProfilerState::Disabled;
@@ -71,20 +281,217 @@ thread_event_lists disableProfiler() {
   } else {
     thread_event_lists result;
     std::lock_guard<std::mutex> guard(all_event_lists_mutex);
-    for (auto it = all_event_lists.begin(); it != all_event_lists.end();) {
-      auto & list = *it;
+    for (auto & list : all_event_lists) {
       result.emplace_back(list->consolidate());
-      // GC lists that are not held by any threads
-      if (list.use_count() == 1) {
-        auto current_it = it;
-        ++it;
-        all_event_lists.erase(current_it);
-      } else {
-        ++it;
-      }
     }
+    eraseUnusedEventLists();
     return result;
   }
 }
 
+////////////////////////////////////////////////////////////////////////////////
+// Trace streaming
+////////////////////////////////////////////////////////////////////////////////
+
+// Writes the events of the full blocks as Chrome trace events, which
+// chrome://tracing matches into ranges by thread.
+struct TraceWriter {
+  TraceWriter(const std::string& path, int64_t start_ns)
+  : path(path)
+  , out(path)
+  , start_ns(start_ns) {
+    if (!out) {
+      throw std::runtime_error("can't open trace file " + path);
+    }
+    out << std::fixed << std::setprecision(3) << "[";
+  }
+
+  void write(const RangeEventList::Block& block) {
+    for (auto & e : block.events) {
+      out << (written++ == 0 ? "\n" : ",\n");
+      double ts = (e.cpu_ns() - start_ns) / 1000.0;
+      auto & ranges = open_ranges[e.thread_id()];
+      switch (e.event_kind()) {
+        case EventKind::Mark:
+          out << "{\"name\":" << name(e.name_id()) << ",\"ph\":\"i\",\"s\":\"t\"";
+          writeThread(e, ts);
+          out << "}";
+          break;
+        case EventKind::PushRange:
+          ranges.push_back(e.allocated_bytes());
+          out << "{\"name\":" << name(e.name_id()) << ",\"ph\":\"B\"";
+          writeThread(e, ts);
+          if (!e.shapes().empty()) {
+            out << ",\"args\":{\"input_shapes\":[";
+            for (std::size_t i = 0; i < e.shapes().size(); i++) {
+              out << (i == 0 ? "[" : ",[");
+              auto & shape = e.shapes()[i];
+              for (std::size_t j = 0; j < shape.size(); j++) {
+                out << (j == 0 ? "" : ",") << shape[j];
+              }
+              out << "]";
+            }
+            out << "]}";
+          }
+          out << "}";
+          break;
+        case EventKind::PopRange:
+          out << "{\"ph\":\"E\"";
+          writeThread(e, ts);
+          if (!ranges.empty()) {
+            out << ",\"args\":{\"allocated_bytes\":"
+                << e.allocated_bytes() - ranges.back() << "}";
+            ranges.pop_back();
+          }
+          out << "}";
+          break;
+      }
+    }
+  }
+
+  void writeThread(const Event& e, double ts) {
+    out << ",\"ts\":" << ts << ",\"pid\":0,\"tid\":" << e.thread_id();
+  }
+
+  // The JSON string of a name, escaped once
+  const std::string& name(uint32_t id) {
+    if (id >= names.size()) {
+      names.resize(id + 1);
+    }
+    std::string& escaped = names[id];
+    if (escaped.empty()) {
+      std::ostringstream ss;
+      ss << "\"";
+      for (unsigned char c : symbolName(id)) {
+        if (c == '"' || c == '\\') {
+          ss << '\\' << c;
+        } else if (c < 0x20) {
+          ss << "\\u" << std::hex << std::setw(4) << std::setfill('0') << (int)c
+             << std::dec;
+        } else {
+          ss << c;
+        }
+      }
+      ss << "\"";
+      escaped = ss.str();
+    }
+    return escaped;
+  }
+
+  void close() {
+    out << "\n]\n";
+    out.close();
+    if (!out) {
+      throw std::runtime_error("error writing trace file " + path);
+    }
+  }
+
+  std::string path;
+  std::ofstream out;
+  int64_t start_ns;
+  uint64_t written = 0;
+  std::vector<std::string> names;
+  // The allocated bytes at the start of the open ranges of each thread
+  std::unordered_map<uint32_t, std::vector<int64_t>> open_ranges;
+};
+
+static std::unique_ptr<TraceWriter> trace_writer;
+static std::thread flusher;
+static std::mutex flusher_mutex;
+static std::condition_variable flusher_cv;
+static bool flusher_stop = false;
+
+// Writes the full blocks, in the order in which they were handed off, and
+// gives them back to their threads
+static void flushBlocks() {
+  RangeEventList::Block* block = full_blocks.exchange(nullptr, std::memory_order_acquire);
+  RangeEventList::Block* ordered = nullptr;
+  while (block) {
+    RangeEventList::Block* next = block->next;
+    block->next = ordered;
+    ordered = block;
+    block = next;
+  }
+  while (ordered) {
+    RangeEventList::Block* next = ordered->next;
+    trace_writer->write(*ordered);
+    ordered->events.clear();
+    pushBlock(ordered->owner->returned, ordered);
+    ordered = next;
+  }
+}
+
+// The threads that record events never wake up the flusher, which polls
+static void flusherLoop() {
+  std::unique_lock<std::mutex> lock(flusher_mutex);
+  for (;;) {
+    bool stop = flusher_stop;
+    lock.unlock();
+    flushBlocks();
+    lock.lock();
+    if (stop) {
+      return;
+    }
+    flusher_cv.wait_for(lock, std::chrono::milliseconds(10),
+                        []() { return flusher_stop; });
+  }
+}
+
+void startTraceStreaming(const std::string& path, uint32_t new_sample_period,
+                         bool new_record_shapes, uint32_t block_size) {
+  if (state != ProfilerState::Disabled) {
+    throw std::runtime_error("can't stream a trace while the profiler is running");
+  }
+  if (block_size > RangeEventList::num_block_elements) {
+    throw std::runtime_error("the block size of the trace can be at most " +
+                             std::to_string(RangeEventList::num_block_elements) +
+                             " events");
+  }
+  std::unique_ptr<TraceWriter> writer(new TraceWriter(path, getTime()));
+  enableProfiler(ProfilerState::CPU, new_sample_period, new_record_shapes);
+  trace_writer = std::move(writer);
+  {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    trace_block_elements = block_size > 0 ? block_size : RangeEventList::num_block_elements;
+    for (auto & list : all_event_lists) {
+      list->startStreaming(trace_block_elements);
+    }
+    trace_streaming = true;
+  }
+  flusher_stop = false;
+  flusher = std::thread(flusherLoop);
+}
+
+std::pair<uint64_t, uint64_t> stopTraceStreaming() {
+  if (!trace_streaming) {
+    throw std::runtime_error("the profiler is not streaming a trace");
+  }
+  state = ProfilerState::Disabled;
+  uint64_t dropped = 0;
+  {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    for (auto & list : all_event_lists) {
+      list->flush();
+    }
+  }
+  {
+    std::lock_guard<std::mutex> guard(flusher_mutex);
+    flusher_stop = true;
+  }
+  flusher_cv.notify_one();
+  flusher.join();
+  {
+    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
+    for (auto & list : all_event_lists) {
+      dropped += list->dropped;
+      list->stopStreaming();
+    }
+    trace_streaming = false;
+    eraseUnusedEventLists();
+  }
+  std::unique_ptr<TraceWriter> writer = std::move(trace_writer);
+  writer->close();
+  return std::make_pair(writer->written, dropped);
+}
+
 }}}
@@ -4,6 +4,7 @@
 #include <nvToolsExt.h>
 #endif
 #include <thread>
+#include <atomic>
 #include <iostream>
 #include <mutex>
 #include <memory>
@@ -15,6 +16,7 @@
 #include <forward_list>
 #include <tuple>
 #include "ATen/ATen.h"
+#include "TH/THGeneral.h"
 #include "torch/csrc/cuda/cuda_check.h"
 #ifdef WITH_CUDA
 #include <cuda_runtime.h>
@@ -23,6 +25,8 @@
 namespace torch { namespace autograd {
 
 struct Function;
+struct Variable;
+using variable_list = std::vector<Variable>;
 
 namespace profiler {
 
@@ -36,17 +40,25 @@ inline uint64_t getTime() {
   return duration_cast<nanoseconds>(clock::now().time_since_epoch()).count();
 }
 
-enum class EventKind {
+// Range and mark names are interned: events only hold the id of their name,
+// which is looked up when the events are read. Both internName overloads
+// keep a per-thread cache, so that interning a known name takes no lock.
+uint32_t internName(const std::string& name);
+uint32_t internName(const char* name);
+const std::string& symbolName(uint32_t id);
+
+enum class EventKind : uint8_t {
   Mark,
   PushRange,
   PopRange
 };
 
 struct Event {
-  Event(EventKind kind, std::string name, uint32_t thread_id, bool record_cuda)
+  Event(EventKind kind, uint32_t name, uint32_t thread_id, bool record_cuda)
   : kind_(kind)
-  , name_(std::move(name))
-  , thread_id_(thread_id) {
+  , name_(name)
+  , thread_id_(thread_id)
+  , allocated_bytes_(THGetThreadAllocatedBytes()) {
 #ifdef WITH_CUDA
     if(record_cuda) {
       TORCH_CUDA_CHECK(cudaGetDevice(&device_));
@@ -69,12 +81,21 @@ struct Event {
     }
     throw std::runtime_error("unknown EventKind");
   }
+  EventKind event_kind() const {
+    return kind_;
+  }
   const std::string & name() const {
+    return symbolName(name_);
+  }
+  uint32_t name_id() const {
     return name_;
   }
   uint32_t thread_id() const {
     return thread_id_;
   }
+  int64_t cpu_ns() const {
+    return cpu_ns_;
+  }
   double cpu_elapsed_us(const Event & e) {
     return (e.cpu_ns_ - cpu_ns_)/(1000.0);
   }
@@ -95,6 +116,17 @@ struct Event {
     throw std::logic_error("CUDA not enabled");
 #endif
   }
+  // Bytes allocated by TH on the thread of the event before it was recorded
+  int64_t allocated_bytes() const {
+    return allocated_bytes_;
+  }
+  // Sizes of the inputs of a range, if they were recorded
+  const std::vector<std::vector<int64_t>> & shapes() const {
+    return shapes_;
+  }
+  void set_shapes(std::vector<std::vector<int64_t>> shapes) {
+    shapes_ = std::move(shapes);
+  }
   bool has_cuda() const {
 #ifdef WITH_CUDA
     return event != nullptr;
@@ -107,52 +139,139 @@ struct Event {
   }
 private:
   EventKind kind_;
-  std::string name_;
+  uint32_t name_;
   uint32_t thread_id_;
   int64_t cpu_ns_; // signed to allow for negative intervals
+  int64_t allocated_bytes_;
+  std::vector<std::vector<int64_t>> shapes_;
 #ifdef WITH_CUDA
   cudaEvent_t event = nullptr;
 #endif
   int device_ = -1;
 };
 
-// a linked-list of fixed sized vectors, to avoid
-// a std::vector resize from taking a large amount of time inside
-// a profiling  event
+// The top-level ranges recorded are 1 in sample_period
+extern uint32_t sample_period;
+
+// The events of a thread, in fixed sized blocks, to avoid a std::vector
+// resize from taking a large amount of time inside a profiling event.
+//
+// When the events are kept in memory, the list grows a block at a time until
+// consolidate() is called. When they are streamed to a trace, the list owns a
+// fixed ring of blocks instead: full blocks are handed off to the flusher
+// thread without locking, and come back once written. If no block is free,
+// the thread drops its events (and the ranges nested in a dropped range)
+// rather than wait, and keeps room for the ends of the ranges it recorded.
 struct RangeEventList {
   constexpr static std::size_t MB = 1024 * 1024;
-  constexpr static std::size_t event_block_size = 16 * MB;
+  constexpr static std::size_t event_block_size = 1 * MB;
   constexpr static std::size_t num_block_elements =
     event_block_size / ceilToMultiple(sizeof(Event), alignof(Event));
   static_assert(sizeof(Event[num_block_elements]) <= event_block_size,
                 "num_block_elements is calculated incorrectly");
-  using block_type = std::vector<Event>;
+  // Blocks per thread when streaming
+  constexpr static std::size_t num_ring_blocks = 8;
 
-  void allocBlock() {
-    blocks.emplace_front();
-    blocks.front().reserve(num_block_elements);
-  }
+  struct Block {
+    Block(RangeEventList* owner, std::size_t capacity) : owner(owner) {
+      events.reserve(capacity);
+    }
+    std::vector<Event> events;
+    RangeEventList* owner;
+    // Link in the list of full blocks, or of the blocks given back
+    Block* next = nullptr;
+  };
+
+  explicit RangeEventList(uint32_t thread_id) : thread_id(thread_id) {}
 
   template<typename... Args>
-  void record(Args&&... args) {
-    if (blocks.empty() || blocks.front().size() == num_block_elements) {
-      allocBlock();
+  Event* record(std::size_t reserve, Args&&... args) {
+    if (!current || block_elements - current->events.size() <= reserve) {
+      if (!refill(reserve)) {
+        dropped++;
+        return nullptr;
+      }
     }
-    blocks.front().emplace_back(std::forward<Args>(args)...);
+    current->events.emplace_back(std::forward<Args>(args)...);
+    return &current->events.back();
+  }
+
+  void mark(uint32_t name, bool record_cuda) {
+    record(depth, EventKind::Mark, name, thread_id, record_cuda);
   }
 
-  std::vector<Event> consolidate() {
-    std::vector<Event> result;
-    for (auto & block : blocks) {
-      result.insert(result.begin(),
-                    std::make_move_iterator(block.begin()),
-                    std::make_move_iterator(block.end()));
+  // Returns the event that starts the range, or nullptr if the range is not
+  // recorded: because it is nested in a range that is not, because it is a
+  // top-level range that is not sampled, or because it was dropped. The range
+  // is only recorded if there is room left for its end, and for the ends of
+  // the depth ranges it is nested in.
+  Event* pushRange(uint32_t name, bool record_cuda) {
+    Event* event = nullptr;
+    if (skip_depth < 0) {
+      if (depth == 0 && sample_period > 1 &&
+          top_level_ranges++ % sample_period != 0) {
+        skip_depth = depth;
+      } else {
+        event = record(depth + 1, EventKind::PushRange, name, thread_id, record_cuda);
+        if (!event) {
+          skip_depth = depth;
+        }
+      }
     }
-    blocks.clear();
-    return result;
+    depth++;
+    return event;
+  }
+
+  void popRange(bool record_cuda) {
+    if (depth == 0) {
+      return;
+    }
+    depth--;
+    if (skip_depth >= 0) {
+      if (depth == skip_depth) {
+        skip_depth = -1;
+      }
+      return;
+    }
+    record(0, EventKind::PopRange, 0, thread_id, record_cuda);
+  }
+
+  std::vector<Event> consolidate();
+
+  // The ranges that are open when the profiler is enabled are not recorded
+  void resetRanges() {
+    depth = 0;
+    skip_depth = -1;
+    top_level_ranges = 0;
   }
 
-  std::forward_list<block_type> blocks;
+  void startStreaming(std::size_t block_elements);
+  // Hands off the block being filled, even if it is not full
+  void flush();
+  // Must be called once the flusher gave back all the blocks
+  void stopStreaming();
+
+  bool refill(std::size_t reserve);
+  void reclaim();
+
+  const uint32_t thread_id;
+  uint64_t dropped = 0;
+  // The number of events in a block, which is smaller when streaming to a
+  // trace with small buffers
+  std::size_t block_elements = num_block_elements;
+
+  // All the blocks, the most recent first if they are kept in memory
+  std::forward_list<std::unique_ptr<Block>> blocks;
+  Block* current = nullptr;
+  bool streaming = false;
+  std::vector<Block*> free_blocks;
+  // The blocks written by the flusher, pushed by it without locking
+  std::atomic<Block*> returned{nullptr};
+
+  int32_t depth = 0;
+  // The depth of the outermost range that is not recorded, or -1
+  int32_t skip_depth = -1;
+  uint64_t top_level_ranges = 0;
 };
 
 enum class ProfilerState {
@@ -163,6 +282,7 @@ enum class ProfilerState {
 };
 
 extern ProfilerState state;
+extern bool record_shapes;
 extern uint32_t next_thread_id;
 extern std::mutex all_event_lists_mutex;
 extern std::list<std::shared_ptr<RangeEventList>> all_event_lists;
@@ -170,12 +290,11 @@ extern std::list<std::shared_ptr<RangeEventList>> all_event_lists;
 extern thread_local std::shared_ptr<RangeEventList> event_list;
 extern thread_local int32_t thread_id;
 
+RangeEventList& initEventList();
+
 inline RangeEventList& getEventList() {
   if (!event_list) {
-    std::lock_guard<std::mutex> guard(all_event_lists_mutex);
-    event_list = std::make_shared<RangeEventList>();
-    thread_id = next_thread_id++;
-    all_event_lists.emplace_front(event_list);
+    return initEventList();
   }
   return *event_list;
 }
@@ -188,7 +307,7 @@ inline void mark(std::string name, bool include_cuda = true) {
     throw std::logic_error("mark called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::Mark, std::move(name), thread_id, include_cuda && state == ProfilerState::CUDA);
+    getEventList().mark(internName(name), include_cuda && state == ProfilerState::CUDA);
   }
 }
 
@@ -200,7 +319,19 @@ inline void pushRange(std::string name) {
     throw std::logic_error("pushRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PushRange, std::move(name), thread_id, state == ProfilerState::CUDA);
+    getEventList().pushRange(internName(name), state == ProfilerState::CUDA);
+  }
+}
+
+inline void pushRange(const char *name) {
+  if (state == ProfilerState::NVTX) {
+#ifdef WITH_CUDA
+    nvtxRangePushA(name);
+#else
+    throw std::logic_error("pushRange called with NVTX tracing, but compiled without CUDA");
+#endif
+  } else {
+    getEventList().pushRange(internName(name), state == ProfilerState::CUDA);
   }
 }
 
@@ -212,14 +343,20 @@ inline void popRange() {
     throw std::logic_error("popRange called with NVTX tracing, but compiled without CUDA");
 #endif
   } else {
-    getEventList().record(EventKind::PopRange, std::string(), thread_id, state == ProfilerState::CUDA);
+    getEventList().popRange(state == ProfilerState::CUDA);
   }
 }
 
 struct RecordFunction {
   explicit RecordFunction(Function *fn) {
     if (state == ProfilerState::Disabled) return;
-    pushFunctionRange(fn);
+    pushFunctionRange(fn, nullptr);
+  }
+
+  // Also records the shapes of the inputs, if the profiler is set to
+  RecordFunction(Function *fn, const variable_list& inputs) {
+    if (state == ProfilerState::Disabled) return;
+    pushFunctionRange(fn, &inputs);
   }
 
   explicit RecordFunction(std::string name) {
@@ -238,14 +375,24 @@ struct RecordFunction {
   }
 
   // Needed only because we don't have Function defined yet.
-  void pushFunctionRange(Function *fn);
+  void pushFunctionRange(Function *fn, const variable_list *inputs);
 };
 
 using thread_event_lists = std::vector<std::vector<Event>>;
 // NOTE: changing profiler modes is **NOT THREAD SAFE**. You should ensure that
 // there no autograd functions are being executed when these function are used.
-void enableProfiler(ProfilerState state);
+void enableProfiler(ProfilerState state, uint32_t sample_period = 1,
+                    bool record_shapes = false);
 thread_event_lists disableProfiler();
 
+// Profiles the CPU and streams the events to a Chrome trace file at path as
+// they are recorded, instead of keeping them in memory. Stopping returns the
+// number of events written, and of events dropped because the flusher thread
+// did not keep up. Each thread streams from a ring of blocks of block_size
+// events, or of num_block_elements events if it is 0.
+void startTraceStreaming(const std::string& path, uint32_t sample_period = 1,
+                         bool record_shapes = false, uint32_t block_size = 0);
+std::pair<uint64_t, uint64_t> stopTraceStreaming();
+
 } // namespace profiler
 }} // namespace torch::autograd
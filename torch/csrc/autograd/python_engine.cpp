@@ -208,6 +208,16 @@ PyObject* THPEngine_is_checkpoint_valid(PyObject *self) {
   END_HANDLE_TH_ERRORS
 }
 
+PyObject* THPEngine_set_num_cpu_workers(PyObject *self, PyObject *num_workers) {
+  HANDLE_TH_ERRORS
+  THPUtils_assert(THPUtils_checkLong(num_workers), "set_num_cpu_workers "
+      "expects an int, but got %s", THPUtils_typename(num_workers));
+  _maybe_reinitialize_engine_after_fork();
+  engine.set_num_cpu_workers(THPUtils_unpackLong(num_workers));
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
 PyObject *THPEngine_new(PyTypeObject *type, PyObject *args, PyObject *kwargs)
 {
   return type->tp_alloc(type, 0);
@@ -217,6 +227,7 @@ static struct PyMethodDef THPEngine_methods[] = {
   {(char*)"run_backward", (PyCFunction)THPEngine_run_backward, METH_VARARGS | METH_KEYWORDS, nullptr},
   {(char*)"queue_callback", (PyCFunction)THPEngine_queue_callback, METH_O, nullptr},
   {(char*)"is_checkpoint_valid", (PyCFunction)THPEngine_is_checkpoint_valid, METH_NOARGS, nullptr},
+  {(char*)"set_num_cpu_workers", (PyCFunction)THPEngine_set_num_cpu_workers, METH_O, nullptr},
   {nullptr}
 };
 
@@ -2,6 +2,8 @@
 #include <cuda_runtime.h>
 #endif
 
+#include "torch/csrc/utils/auto_gil.h"
+
 static PyObject * THPStorage_(size)(THPStorage *self)
 {
   HANDLE_TH_ERRORS
@@ -212,7 +214,12 @@ PyObject * THPStorage_(writeFile)(THPStorage *self, PyObject *args)
   int fd = PyObject_AsFileDescriptor(file);
   THPUtils_assert(fd != -1, "_write_file couldn't retrieve a file descriptor "
       "from given object");
-  THPStorage_(writeFileRaw)(self->cdata, fd);
+  {
+    // Nothing below touches Python objects, so that other threads, e.g. the
+    // training loop while torch.save_async writes a checkpoint, keep running
+    AutoNoGIL no_gil;
+    THPStorage_(writeFileRaw)(self->cdata, fd);
+  }
   Py_RETURN_NONE;
   END_HANDLE_TH_ERRORS
 }
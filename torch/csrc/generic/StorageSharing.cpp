@@ -4,10 +4,33 @@
 #endif
 
 
+#if !defined(THC_GENERIC_FILE) && !defined(_WIN32)
+// Returns the slab region of a storage allocated in a shared memory slab,
+// or NULL
+static libshm_slab_region * THPStorage_(slabRegion)(THStorage *storage)
+{
+  if (storage->allocator == &THSlabSharedAllocator) {
+    return (libshm_slab_region*)storage->allocatorContext;
+  } else if (storage->allocator == &THStorageWeakRefAllocator) {
+    auto allocator_obj = ((StorageWeakRefAllocator*)storage->allocatorContext);
+    if (allocator_obj->allocator == &THSlabSharedAllocator)
+      return (libshm_slab_region*)allocator_obj->allocatorContext;
+  }
+  return NULL;
+}
+#endif
+
 static PyObject * THPStorage_(sharedDecref)(THPStorage *self)
 {
   HANDLE_TH_ERRORS
 #ifndef THC_GENERIC_FILE
+#ifndef _WIN32
+  if (libshm_slab_region *region = THPStorage_(slabRegion)(self->cdata)) {
+    libshm_slab_region_decref(region);
+    Py_INCREF(self);
+    return (PyObject *)self;
+  }
+#endif
   libshm_context *ctx = NULL;
   THStorage *storage = self->cdata;
   if (storage->allocator == &THManagedSharedAllocator) {
@@ -29,6 +52,12 @@ static PyObject * THPStorage_(sharedIncref)(THPStorage *self)
 {
   HANDLE_TH_ERRORS
 #ifndef THC_GENERIC_FILE
+#ifndef _WIN32
+  if (libshm_slab_region *region = THPStorage_(slabRegion)(self->cdata)) {
+    libshm_slab_region_incref(region);
+    Py_RETURN_NONE;
+  }
+#endif
   libshm_context *ctx = NULL;
   THStorage *storage = self->cdata;
   if (storage->allocator == &THManagedSharedAllocator) {
@@ -148,6 +177,98 @@ static PyObject * THPStorage_(newSharedFilename)(PyObject *_unused, PyObject *ar
   END_HANDLE_TH_ERRORS
 }
 
+// Storages in the slab of this process are sent by offset, see slab.cpp in
+// libshm. The slab methods return None when a storage cannot use a slab,
+// and the caller falls back to the other sharing strategies.
+static PyObject * THPStorage_(pyNewSlabStorage)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  long long size;
+  if (!PyArg_ParseTuple(args, "L", &size)) {
+    return NULL;
+  }
+#ifndef _WIN32
+  libshm_slab_region *region = libshm_slab_region_new(size * sizeof(real));
+  if (region) {
+    return THPStorage_(New)(THStorage_(newWithDataAndAllocator)(
+        (real*)libshm_slab_region_data(region), size, &THSlabSharedAllocator,
+        (void*)region));
+  }
+#endif
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPStorage_(shareSlab)(THPStorage *self)
+{
+  HANDLE_TH_ERRORS
+#ifndef _WIN32
+  THStorage *storage = self->cdata;
+  libshm_slab_region *region = THPStorage_(slabRegion)(storage);
+  if (region) {
+    const char *manager_handle;
+    const char *slab_handle;
+    ptrdiff_t slab_size;
+    ptrdiff_t offset;
+    libshm_slab_region_info(region, &manager_handle, &slab_handle, &slab_size,
+        &offset);
+
+    THPObjectPtr tuple(PyTuple_New(5));
+    THPObjectPtr _manager_handle(PyBytes_FromString(manager_handle));
+    THPObjectPtr _slab_handle(PyBytes_FromString(slab_handle));
+    THPObjectPtr _slab_size(PyLong_FromSsize_t((Py_ssize_t)slab_size));
+    THPObjectPtr _offset(PyLong_FromSsize_t((Py_ssize_t)offset));
+    THPObjectPtr size(PyLong_FromLong(storage->size));
+    if (!tuple || !_manager_handle || !_slab_handle || !_slab_size ||
+        !_offset || !size) {
+      return NULL;
+    }
+    PyTuple_SET_ITEM(tuple.get(), 0, _manager_handle.release());
+    PyTuple_SET_ITEM(tuple.get(), 1, _slab_handle.release());
+    PyTuple_SET_ITEM(tuple.get(), 2, _slab_size.release());
+    PyTuple_SET_ITEM(tuple.get(), 3, _offset.release());
+    PyTuple_SET_ITEM(tuple.get(), 4, size.release());
+    return tuple.release();
+  }
+#endif
+  Py_RETURN_NONE;
+  END_HANDLE_TH_ERRORS
+}
+
+static PyObject * THPStorage_(newSharedSlab)(PyObject *_unused, PyObject *args)
+{
+  HANDLE_TH_ERRORS
+  THPUtils_assert(PyTuple_GET_SIZE(args) == 5, "tuple of 5 items expected");
+  PyObject *_manager_handle = PyTuple_GET_ITEM(args, 0);
+  PyObject *_slab_handle = PyTuple_GET_ITEM(args, 1);
+  PyObject *_slab_size = PyTuple_GET_ITEM(args, 2);
+  PyObject *_offset = PyTuple_GET_ITEM(args, 3);
+  PyObject *_size = PyTuple_GET_ITEM(args, 4);
+  if (!PyBytes_Check(_manager_handle) || !PyBytes_Check(_slab_handle) ||
+      !THPUtils_checkLong(_slab_size) || !THPUtils_checkLong(_offset) ||
+      !THPUtils_checkLong(_size)) {
+    THPUtils_invalidArguments(args, NULL, "_new_shared_slab", 1,
+        "(bytes manager_handle, bytes slab_handle, int slab_size, int offset, int size)");
+    return NULL;
+  }
+#ifndef _WIN32
+  const char *manager_handle = PyBytes_AS_STRING(_manager_handle);
+  const char *slab_handle = PyBytes_AS_STRING(_slab_handle);
+  int64_t slab_size = THPUtils_unpackLong(_slab_size);
+  int64_t offset = THPUtils_unpackLong(_offset);
+  int64_t size = THPUtils_unpackLong(_size);
+  libshm_slab_region *region = libshm_slab_region_open(manager_handle,
+      slab_handle, slab_size, offset, size * sizeof(real));
+  return THPStorage_(New)(THStorage_(newWithDataAndAllocator)(
+      (real*)libshm_slab_region_data(region), size, &THSlabSharedAllocator,
+      (void*)region));
+#else
+  THPUtils_setError("shared memory slabs are not supported on Windows");
+  return NULL;
+#endif
+  END_HANDLE_TH_ERRORS
+}
+
 static THStorage* THPStorage_(newFdStorage)(ptrdiff_t size)
 {
   int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM |
@@ -422,6 +543,9 @@ PyObject * THPStorage_(isShared)(THPStorage *self)
   void *allocator = self->cdata->allocator;
   if (allocator == &THMapAllocator ||
       allocator == &THStorageWeakRefAllocator ||
+#ifndef _WIN32
+      allocator == &THSlabSharedAllocator ||
+#endif
       allocator == &THManagedSharedAllocator) {
     Py_RETURN_TRUE;
   } else {
@@ -442,6 +566,9 @@ static PyMethodDef THPStorage_(sharingMethods)[] = {
   {"_share_filename_", (PyCFunction)THPStorage_(shareFilename), METH_NOARGS, NULL},
   {"_new_shared_filename", (PyCFunction)THPStorage_(newSharedFilename), METH_VARARGS | METH_STATIC, NULL},
   {"_new_using_filename", (PyCFunction)THPStorage_(pyNewFilenameStorage), METH_VARARGS | METH_STATIC, NULL},
+  {"_share_slab_", (PyCFunction)THPStorage_(shareSlab), METH_NOARGS, NULL},
+  {"_new_shared_slab", (PyCFunction)THPStorage_(newSharedSlab), METH_VARARGS | METH_STATIC, NULL},
+  {"_new_using_slab", (PyCFunction)THPStorage_(pyNewSlabStorage), METH_VARARGS | METH_STATIC, NULL},
 #endif
   {"_weak_ref", (PyCFunction)THPStorage_(weakRef), METH_O, NULL},
   {"_new_view", (PyCFunction)THPStorage_(newView), METH_VARARGS, NULL},
@@ -34,7 +34,8 @@ void THPStorage_(writeFileRaw)(THStorage *self, io fd)
     if (remaining != 0)
       throw std::system_error(result, std::system_category());
   } else {
-    int64_t buffer_size = std::min(size, (int64_t)5000);
+    // convert in blocks of 4MB, so that the writes stay large
+    int64_t buffer_size = std::min(size, (int64_t)(4194304 / sizeof(real)));
     std::unique_ptr<uint8_t[]> le_buffer(new uint8_t[buffer_size * sizeof(real)]);
     for (int64_t i = 0; i < size; i += buffer_size) {
       size_t to_convert = std::min(size - i, buffer_size);
@@ -54,7 +55,15 @@ void THPStorage_(writeFileRaw)(THStorage *self, io fd)
             THPByteOrder::THP_LITTLE_ENDIAN,
             to_convert);
       }
-      SYSCHECK(doWrite(fd, le_buffer.get(), to_convert * sizeof(real)));
+      char *bytes = (char *) le_buffer.get();
+      int64_t remaining = sizeof(real) * to_convert;
+      while (remaining > 0) {
+        ssize_t result = doWrite(fd, bytes, remaining);
+        if (result < 0)
+          throw std::system_error(result, std::system_category());
+        bytes += result;
+        remaining -= result;
+      }
     }
   }
 }
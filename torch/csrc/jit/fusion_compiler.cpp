@@ -5,6 +5,7 @@
 #include "torch/csrc/jit/resource_guard.h"
 #include "torch/csrc/utils/disallow_copy.h"
 #include "ATen/ATen.h"
+#include "ATen/ExpandUtils.h"
 #ifdef WITH_CUDA
 #include "torch/csrc/cuda/cuda_check.h"
 #include <nvrtc.h>
@@ -16,9 +17,18 @@
 #include <unordered_map>
 #include <vector>
 #include <sstream>
+#include <fstream>
+#include <limits>
+#include <iomanip>
 #include <iostream>
+#include <cerrno>
+#include <cstring>
+#include <ctime>
 #include <dlfcn.h>
+#include <dirent.h>
 #include <unistd.h>
+#include <utime.h>
+#include <sys/stat.h>
 
 namespace torch { namespace jit {
 
@@ -83,31 +93,163 @@ void ${kernelName}(IndexType totalElements, ${formals}) {
 }
 )");
 
+// CPU kernels split the flattened map into chunks that are handed out to
+// threads. A chunk is processed one run, i.e. the part of a row (a run of the
+// last dimension) that lies in the chunk, at a time, and the elements of a
+// run are computed a vector at a time when all tensors have an inner stride
+// of 1. Reductions over the last dimension are accumulated along the row, so
+// kernels with a reduction use whole rows as chunks.
 auto cpu_compilation_unit_template = CodeTemplate(R"(
 #include <cstddef>
+#include <cstring>
+#include <ctime>
 #include <math.h>
 #include <iostream>
 ${type_declarations}
+${cpu_declarations}
 
 #define OMP_THRESHOLD 100000
-static void ${kernelName}_kernel(IndexType totalElements, ${formals}) {
+#define CHUNK_SIZE 4096
+static void ${kernelName}_kernel(IndexType totalElements, IndexType rowSize, ${formals}) {
+  IndexType chunkSize = ${chunkSize};
+  IndexType numChunks = chunkSize > 0 ? (totalElements + chunkSize - 1) / chunkSize : 0;
   #pragma omp parallel for if(totalElements > OMP_THRESHOLD)
-  for (IndexType linearIndex = 0;
-        linearIndex < totalElements;
-        linearIndex += 1) {
-      // Convert `linearIndex` into an offset of tensor:
+  for (IndexType chunkIndex = 0;
+        chunkIndex < numChunks;
+        chunkIndex += 1) {
+    IndexType chunkStart = chunkIndex * chunkSize;
+    IndexType chunkEnd = totalElements - chunkStart > chunkSize ? chunkStart + chunkSize : totalElements;
+    IndexType runSize;
+    for (IndexType linearIndex = chunkStart;
+          linearIndex < chunkEnd;
+          linearIndex += runSize) {
+      IndexType rowEnd = (linearIndex / rowSize + 1) * rowSize;
+      runSize = (rowEnd < chunkEnd ? rowEnd : chunkEnd) - linearIndex;
+      // Convert `linearIndex` into the offset of the run in each tensor:
       ${tensorOffsets}
-      // calculate the results
-      ${kernelBody}
+      ${rowPrologue}
+      IndexType i = 0;
+      ${vectorLoop}
+      for (; i < runSize; i += 1) {
+        // calculate the results
+        ${kernelBody}
+      }
+      ${rowEpilogue}
     }
+  }
 }
 
 extern "C"
-void ${kernelName}(IndexType totalElements, void ** args) {
-  ${kernelName}_kernel(totalElements ${,argument_loads});
+void ${kernelName}(IndexType totalElements, IndexType rowSize, void ** args) {
+  ${kernelName}_kernel(totalElements, rowSize ${,argument_loads});
 }
 )");
 
+auto cpu_vector_loop_template = CodeTemplate(R"(
+for (; i + Vec256::size <= runSize; i += Vec256::size) {
+  ${vectorBody}
+}
+)");
+
+// Math functions that simple_map_ops uses and libm lacks, and a vector of
+// floats with the interface of at::vec256::Vec256<float>. The ATen headers
+// are not available to the runtime compiler, so it is defined here: the
+// arithmetic uses the vector extensions of the compiler, which emits AVX
+// instructions with -march=native, and the other functions are applied
+// lane by lane; sum() adds the lanes in double. The functions are overloaded
+// for vectors so that the same expressions compute the vector loop and the
+// scalar remainder of a run.
+auto cpu_declarations = R"(
+static inline float absf(float a) { return fabsf(a); }
+static inline float rsqrtf(float a) { return 1.f / sqrtf(a); }
+static inline float fracf(float a) { return a - truncf(a); }
+static inline float reciprocalf(float a) { return 1.f / a; }
+static inline float min(float a, float b) { return fminf(a, b); }
+static inline float max(float a, float b) { return fmaxf(a, b); }
+
+struct Vec256 {
+  typedef float Vector __attribute__((vector_size(32)));
+  static constexpr int size = 8;
+  Vector values;
+  Vec256() {}
+  explicit Vec256(Vector v) : values(v) {}
+  Vec256(float val) {
+    for (int i = 0; i < size; i++)
+      values[i] = val;
+  }
+  static Vec256 s_load(const float* ptr) {
+    Vec256 vec;
+    std::memcpy(&vec.values, ptr, sizeof(Vector));
+    return vec;
+  }
+  void store(float* ptr) const {
+    std::memcpy(ptr, &values, sizeof(Vector));
+  }
+  Vec256 map(float (*f)(float)) const {
+    Vec256 ret;
+    for (int i = 0; i < size; i++)
+      ret.values[i] = f(values[i]);
+    return ret;
+  }
+  Vec256 map(float (*f)(float, float), const Vec256& other) const {
+    Vec256 ret;
+    for (int i = 0; i < size; i++)
+      ret.values[i] = f(values[i], other.values[i]);
+    return ret;
+  }
+  double sum() const {
+    double ret = 0;
+    for (int i = 0; i < size; i++)
+      ret += values[i];
+    return ret;
+  }
+};
+
+static inline Vec256 operator+(const Vec256& a, const Vec256& b) { return Vec256(a.values + b.values); }
+static inline Vec256 operator-(const Vec256& a, const Vec256& b) { return Vec256(a.values - b.values); }
+static inline Vec256 operator*(const Vec256& a, const Vec256& b) { return Vec256(a.values * b.values); }
+static inline Vec256 operator/(const Vec256& a, const Vec256& b) { return Vec256(a.values / b.values); }
+static inline Vec256 operator-(const Vec256& a) { return Vec256(-a.values); }
+
+#define VECTOR_FUNCTION(name) \
+  static inline Vec256 name(const Vec256& a) { return a.map(name); }
+#define VECTOR_FUNCTION2(name) \
+  static inline Vec256 name(const Vec256& a, const Vec256& b) { return a.map(name, b); }
+VECTOR_FUNCTION(absf)
+VECTOR_FUNCTION(logf)
+VECTOR_FUNCTION(log10f)
+VECTOR_FUNCTION(log1pf)
+VECTOR_FUNCTION(log2f)
+VECTOR_FUNCTION(lgammaf)
+VECTOR_FUNCTION(expf)
+VECTOR_FUNCTION(expm1f)
+VECTOR_FUNCTION(cosf)
+VECTOR_FUNCTION(acosf)
+VECTOR_FUNCTION(coshf)
+VECTOR_FUNCTION(sinf)
+VECTOR_FUNCTION(asinf)
+VECTOR_FUNCTION(sinhf)
+VECTOR_FUNCTION(tanf)
+VECTOR_FUNCTION(atanf)
+VECTOR_FUNCTION(tanhf)
+VECTOR_FUNCTION(sqrtf)
+VECTOR_FUNCTION(rsqrtf)
+VECTOR_FUNCTION(ceilf)
+VECTOR_FUNCTION(floorf)
+VECTOR_FUNCTION(roundf)
+VECTOR_FUNCTION(truncf)
+VECTOR_FUNCTION(fracf)
+VECTOR_FUNCTION(reciprocalf)
+VECTOR_FUNCTION2(atan2f)
+VECTOR_FUNCTION2(fminf)
+VECTOR_FUNCTION2(fmaxf)
+VECTOR_FUNCTION2(fmodf)
+VECTOR_FUNCTION2(remainderf)
+VECTOR_FUNCTION2(powf)
+VECTOR_FUNCTION2(min)
+VECTOR_FUNCTION2(max)
+)";
+
 // curDimIndex = linearId % sizes[i]; // % sizes[i] is not needed for d == 0, because we already guard for numel outside the index calculation
 // offset += curDimIndex*strides[i]; // *strides[i] is optional if list_is_cont becaause strides.back() == 1
 // linearId /= sizes[i];
@@ -187,7 +329,7 @@ std::string encodeRHS(Node * n) {
     {aten::reciprocal, "reciprocalf(${0})"},
     {aten::neg, "-${0}"},
     //simple binary
-    {aten::atan2, "atan2(${0}, ${1})"},
+    {aten::atan2, "atan2f(${0}, ${1})"},
     {aten::min, "fminf(${0}, ${1})"},
     {aten::max, "fmaxf(${0}, ${1})"},
 
@@ -251,10 +393,15 @@ std::string encodeRHS(Node * n) {
   return format(str, env);
 }
 
+bool isReduction(Node * n) {
+  return n->kind() == aten::sum || n->kind() == aten::mean;
+}
+
 std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
                                             const std::string & name,
                                             AnnotatedGraph & agraph,
-                                            bool use_cuda) {
+                                            bool use_cuda,
+                                            std::vector<ReductionDesc> & reduction_desc) {
   Graph& subgraph = *agraph.graph;
   TemplateEnv env;
   env.s("kernelName",name);
@@ -262,9 +409,14 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
   env.s("IndexType","unsigned int"); //avoiding slow header includes to get uint32_t
 
   std::stringstream body;
+  std::stringstream vector_body;
+  std::stringstream row_prologue;
+  std::stringstream row_epilogue;
   std::stringstream tensorOffsets;
   std::vector<std::string> formals;
   std::vector<std::string> argument_loads;
+  // inner stride of each formal, empty if it is 1
+  std::vector<std::string> inner_strides;
   auto emitFormal = [&](Value * n, const TensorDesc & desc) {
     std::string tensor = "t" + std::to_string(formals.size()); //can't be unique() because Param may be an output
     size_t nDim = desc.nDim();
@@ -272,56 +424,110 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
     env.s("tensor",tensor);
     env.d("formal_index", formals.size() + 1); // + 1 because the first argument is the linearIndex
     env.d("nDim",nDim);
+    env.d("last_dim", nDim - 1);
     env.s("scalar_type",scalarTypeName(desc.scalar_type));
     formals.push_back(format("TensorInfo<${scalar_type},${nDim}> ${tensor}",env));
     argument_loads.push_back(format("*static_cast<TensorInfo<${scalar_type},${nDim}>*>(args[${formal_index}])",env));
+    inner_strides.push_back(desc.lastIsContiguous() ? "" : format(" * ${tensor}.strides[${last_dim}]",env));
+  };
+  // CPU code only vectorizes float kernels whose tensors all have an inner stride of 1
+  bool vectorize = !use_cuda;
+  auto addElementwiseFormal = [&](Value * n, const TensorDesc & desc) {
+    vectorize = vectorize && desc.lastIsContiguous() && desc.scalar_type == at::kFloat;
+    emitFormal(n, desc);
   };
   {
     size_t i = 0;
     for(auto p : subgraph.inputs())
-      emitFormal(p,agraph.input_desc[i++]);
+      addElementwiseFormal(p,agraph.input_desc[i++]);
   }
   std::vector<ConcatDesc> concat_desc;
-  std::vector<Value*> flat_output_nodes;
+  reduction_desc.clear();
+  std::vector<std::pair<Value*, size_t>> flat_output_nodes;
+  struct ReductionOutput {
+    Node * node;
+    size_t formal;
+    at::ScalarType scalar_type;
+  };
+  std::vector<ReductionOutput> reduction_outputs;
   {
     size_t i = 0;
     for(auto o : subgraph.outputs()) {
       auto & desc = agraph.output_desc[i++];
-      if(o->node()->kind() != aten::cat) {
-        emitFormal(o, desc);
+      if(isReduction(o->node())) {
+        auto reduction = o->node();
+        if(use_cuda) {
+          throw std::runtime_error("reductions are only fused on CPU");
+        }
         concat_desc.emplace_back();
-        flat_output_nodes.push_back(o);
+        reduction_desc.emplace_back(desc, reduction->i(attr::keepdim) != 0, reduction->kind() == aten::mean);
+        reduction_outputs.push_back({reduction, formals.size(), desc.scalar_type});
+        emitFormal(o, *reduction_desc.back().viewDesc);
+      } else if(o->node()->kind() != aten::cat) {
+        concat_desc.emplace_back();
+        reduction_desc.emplace_back();
+        flat_output_nodes.emplace_back(o, formals.size());
+        addElementwiseFormal(o, desc);
       } else {
         auto cat = o->node();
         size_t nInputs = cat->inputs().size();
         concat_desc.emplace_back(desc, nInputs, cat->i(attr::dim));
+        reduction_desc.emplace_back();
         for(auto c : cat->inputs()) {
-          emitFormal(c, *concat_desc.back().subtensorDesc);
-          flat_output_nodes.push_back(c);
+          flat_output_nodes.emplace_back(c, formals.size());
+          addElementwiseFormal(c, *concat_desc.back().subtensorDesc);
         }
       }
     }
   }
+  auto scalarAccess = [&](size_t formal) {
+    env.d("formal",formal);
+    env.s("inner_stride",inner_strides[formal]);
+    if(use_cuda)
+      return format("t${formal}.data[t${formal}_offset]",env);
+    return format("t${formal}.data[t${formal}_offset + i${inner_stride}]",env);
+  };
+  auto vectorAccess = [&](size_t formal) {
+    env.d("formal",formal);
+    return format("t${formal}.data + t${formal}_offset + i",env);
+  };
   size_t formal_count = 0;
   for(auto p : subgraph.inputs()) {
     env.s("node",valueName(p));
-    env.d("formal",formal_count++);
-    env.s("access",format("t${formal}.data[t${formal}_offset]",env));
+    env.s("access",scalarAccess(formal_count));
+    env.s("vector_access",vectorAccess(formal_count));
+    formal_count++;
     //TODO: actual type propagation rather than relying on auto..
     body << format("auto ${node} = ${access};\n",env);
+    vector_body << format("auto ${node} = Vec256::s_load(${vector_access});\n",env);
   }
   for(auto n : subgraph.nodes()) {
     if(n->kind() == aten::cat)
       continue; // Concat nodes by narrowing the output Tensors before the kernel runs
+    if(isReduction(n))
+      continue; // Reductions are accumulated below
     env.s("node",valueName(n->output()));
     env.s("rhs", encodeRHS(n));
     body << format("auto ${node} = ${rhs};\n",env);
+    vector_body << format("auto ${node} = ${rhs};\n",env);
   }
-  for(auto o : flat_output_nodes) {
-    env.d("formal",formal_count++);
-    env.s("access",format("t${formal}.data[t${formal}_offset]",env));
-    env.s("node",valueName(o));
+  for(auto & o : flat_output_nodes) {
+    env.s("access",scalarAccess(o.second));
+    env.s("vector_access",vectorAccess(o.second));
+    env.s("node",valueName(o.first));
     body << format("${access} = ${node};\n",env);
+    vector_body << format("${node}.store(${vector_access});\n",env);
+  }
+  for(auto & r : reduction_outputs) {
+    env.d("formal",r.formal);
+    env.s("node",valueName(r.node->input()));
+    // like TH, float reductions are accumulated in double
+    env.s("acc_type",r.scalar_type == at::kFloat ? "double" : scalarTypeName(r.scalar_type));
+    env.s("divisor",r.node->kind() == aten::mean ? " / rowSize" : "");
+    row_prologue << format("${acc_type} acc${formal} = 0;\n",env);
+    body << format("acc${formal} += ${node};\n",env);
+    vector_body << format("acc${formal} += ${node}.sum();\n",env);
+    row_epilogue << format("t${formal}.data[t${formal}_offset] = acc${formal}${divisor};\n",env);
   }
   env.s("tensorOffsets",tensorOffsets.str());
   env.s("kernelBody",body.str());
@@ -331,6 +537,12 @@ std::vector<ConcatDesc> emitCompilationUnit(std::ostream & out,
   if(use_cuda) {
     out << cuda_compilation_unit_template.format(env);
   } else {
+    env.s("cpu_declarations", cpu_declarations);
+    env.s("rowPrologue", row_prologue.str());
+    env.s("rowEpilogue", row_epilogue.str());
+    env.s("vectorBody", vector_body.str());
+    env.s("vectorLoop", vectorize ? cpu_vector_loop_template.format(env) : "");
+    env.s("chunkSize", reduction_outputs.empty() ? "CHUNK_SIZE" : "rowSize");
     out << cpu_compilation_unit_template.format(env);
   }
   return concat_desc;
@@ -404,6 +616,29 @@ void compressContiguous(
   JIT_ASSERT(!cont.back() || strides.back() == 1);
 }
 
+// The map of a fusion group has the size that its inputs broadcast to.
+// Inputs are expanded to it, which gives broadcast dimensions a stride of 0.
+std::vector<int64_t> mapSize(at::ArrayRef<at::Tensor> inputs) {
+  std::vector<int64_t> map_size;
+  for(auto & i : inputs)
+    map_size = at::infer_size(map_size, i.sizes());
+  return map_size;
+}
+
+TensorDesc expandedDesc(TensorType * type, at::IntList map_size) {
+  auto & sizes = type->sizes();
+  if(map_size.equals(sizes))
+    return TensorDesc(type);
+  JIT_ASSERT(sizes.size() <= map_size.size());
+  size_t offset = map_size.size() - sizes.size();
+  std::vector<int64_t> strides(map_size.size(), 0);
+  for(size_t i = 0; i < sizes.size(); ++i) {
+    if(sizes[i] == map_size[offset + i])
+      strides[offset + i] = type->strides()[i];
+  }
+  return TensorDesc(type->scalarType(), map_size, strides);
+}
+
 } // anonymous namespace
 
 void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs, at::ArrayRef<at::Tensor> outputs) {
@@ -415,11 +650,15 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
     flat_outputs_size += c.nSubtensors;
   // XXX: this code assumes that inputs are 32-bit addressable
   // XXX: this code assumes that all inputs are of the same size
-  JIT_ASSERT(inputs[0].numel() <= std::numeric_limits<uint32_t>::max());
-  uint32_t numel = inputs[0].numel();
-  at::IntList map_size = inputs[0].sizes();
+  std::vector<int64_t> map_size = mapSize(inputs);
+  int64_t map_numel = 1;
+  for(auto s : map_size)
+    map_numel *= s;
+  JIT_ASSERT(map_numel <= std::numeric_limits<uint32_t>::max());
+  uint32_t numel = map_numel;
+  uint32_t row_size = map_size.empty() ? 1 : map_size.back();
   // Compute the storage needed to store TensorInfo structs for inputs and outputs.
-  size_t uncompressedDim = input_desc.at(0).contiguity.size();
+  size_t uncompressedDim = std::max<size_t>(map_size.size(), 1);
   size_t maxPossibleTensorInfoSize = sizeof(TensorInfo) + 2 * sizeof(uint32_t) * uncompressedDim;
   size_t maxPossibleBufferSize = maxPossibleTensorInfoSize * (inputs.size() + flat_outputs_size);
   std::vector<char> buffer(maxPossibleBufferSize);
@@ -439,12 +678,34 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
     arguments.push_back(ti);
   };
   arguments.push_back(&numel);
-  for (std::size_t i = 0; i < input_desc.size(); ++i)
-    addTensorInfo(input_desc[i], inputs[i]);
+  for (std::size_t i = 0; i < input_desc.size(); ++i) {
+    if(inputs[i].sizes().equals(map_size)) {
+      addTensorInfo(input_desc[i], inputs[i]);
+    } else {
+      addTensorInfo(input_desc[i], inputs[i].expand(map_size));
+    }
+  }
   for (std::size_t i = 0; i < output_desc.size(); ++i) {
     auto & c = concat_desc[i];
+    auto & r = reduction_desc[i];
     at::Tensor o = outputs[i];
-    if(c.nSubtensors == 1) {
+    if(r.isReduction) {
+      JIT_ASSERT(!map_size.empty());
+      std::vector<int64_t> reduced_size = map_size;
+      if(r.keepdim) {
+        reduced_size.back() = 1;
+      } else {
+        reduced_size.pop_back();
+      }
+      o.resize_(reduced_size);
+      if(row_size == 0) {
+        // the kernel has no rows to reduce
+        o.fill_(r.mean ? std::numeric_limits<double>::quiet_NaN() : 0);
+      }
+      // the output is written at the start of each row of the map
+      auto view = r.keepdim ? o.expand(map_size) : o.unsqueeze(-1).expand(map_size);
+      addTensorInfo(*r.viewDesc, view);
+    } else if(c.nSubtensors == 1) {
       o.resize_(map_size);
       addTensorInfo(output_desc[i], outputs[i]);
     } else {
@@ -463,7 +724,7 @@ void CompiledFusionFunction::launch_with_tensors(at::ArrayRef<at::Tensor> inputs
       }
     }
   }
-  launch_raw(numel, arguments.data());
+  launch_raw(numel, row_size, arguments.data());
 }
 
 void CompiledFusionFunction::launch(at::ArrayRef<at::Tensor> inputs, std::vector<at::Tensor> & outputs) {
@@ -498,7 +759,7 @@ struct CUDAFusionFunction : public CompiledFusionFunction {
     checkCUDAVersion(prop);
 
     std::stringstream cu;
-    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, true);
+    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, true, reduction_desc);
     compilation_unit = cu.str();
     nvrtcProgram program;
     TORCH_NVRTC_CHECK(nvrtcCreateProgram(&program, compilation_unit.c_str(), NULL, 0, nullptr, nullptr));
@@ -538,7 +799,7 @@ protected:
   virtual at::Backend backend() const override {
     return at::kCUDA;
   }
-  virtual void launch_raw(uint32_t numel, void ** arguments) override {
+  virtual void launch_raw(uint32_t numel, uint32_t row_size, void ** arguments) override {
      int numBlocks = std::min(maxBlocks, ceilDiv(numel, blockSize));
      //std::cout << "maxBlocks = " << maxBlocks << " needed blocks: " << ceilDiv(numel,blockSize)
      //          << " numblocks =  " << numBlocks;
@@ -622,6 +883,14 @@ struct DynamicLibrary {
   DynamicLibrary(const char * name) {
     handle = checkDL(dlopen(name, RTLD_LOCAL | RTLD_NOW));
   }
+  // returns nullptr instead of raising if the library cannot be loaded
+  static std::unique_ptr<DynamicLibrary> tryOpen(const char * name) {
+    void * handle = dlopen(name, RTLD_LOCAL | RTLD_NOW);
+    if(!handle) return nullptr;
+    std::unique_ptr<DynamicLibrary> lib(new DynamicLibrary());
+    lib->handle = handle;
+    return lib;
+  }
   void * sym(const char * name) {
     JIT_ASSERT(handle);
     return checkDL(dlsym(handle, name));
@@ -634,6 +903,7 @@ struct DynamicLibrary {
     }
   }
 private:
+  DynamicLibrary() {}
   void * handle = nullptr;
 };
 
@@ -679,34 +949,209 @@ static void disas(const std::string & so_file) {
   JIT_ASSERT(r == 0);
 }
 
+// On-disk cache of compiled CPU kernels, which can be shared by concurrent
+// processes. An entry is a pair of files named after the hash of its key:
+// <hash>.so, the kernel, and <hash>.key, the key itself, which is compared on
+// lookup so that hash collisions are misses. The key contains everything the
+// kernel depends on: the compilation unit, the compiler command, and the CPU
+// flags of the host, since we compile with -march=native.
+// Both files are written under temporary names and renamed into place, the
+// key last, so readers never see a partially written entry.
+
+// Increment when the calling convention of the kernels changes
+static const int kFusionCacheVersion = 2;
+static const size_t kCacheHashLength = 16;
+
+static std::string hashCacheKey(const std::string & key) {
+  // 64-bit FNV-1a, which unlike std::hash is stable across processes
+  uint64_t hash = 14695981039346656037ULL;
+  for(unsigned char c : key) {
+    hash ^= c;
+    hash *= 1099511628211ULL;
+  }
+  std::stringstream ss;
+  ss << std::hex << std::setw(kCacheHashLength) << std::setfill('0') << hash;
+  return ss.str();
+}
+
+static const std::string & hostCPUFlags() {
+  static const std::string flags = [] {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while(std::getline(cpuinfo, line)) {
+      if(line.compare(0, 5, "flags") == 0)
+        return line;
+    }
+    return std::string();
+  }();
+  return flags;
+}
+
+static std::string cacheKey(const FusionCompilerConfig & config, const std::string & compilation_unit) {
+  TemplateEnv env;
+  env.s("cxx", config.cxx);
+  env.s("fopenmp", config.openmp ? "-fopenmp" : "");
+  env.s("cpp_file", "<cpp_file>");
+  env.s("so_file", "<so_file>");
+  std::stringstream key;
+  key << "version " << kFusionCacheVersion << "\n";
+  key << format(compile_string, env) << "\n";
+  key << hostCPUFlags() << "\n";
+  key << compilation_unit;
+  return key.str();
+}
+
+static std::string cachePath(const FusionCompilerConfig & config, const std::string & name, const char * ext) {
+  return config.cache_dir + "/" + name + ext;
+}
+
+static void renameOrBarf(const std::string & from, const std::string & to) {
+  if(rename(from.c_str(), to.c_str()) != 0) {
+    barf("error renaming %s to %s: %s", from.c_str(), to.c_str(), strerror(errno));
+  }
+}
+
+static std::unique_ptr<DynamicLibrary> cacheLookup(const FusionCompilerConfig & config,
+                                                   const std::string & hash,
+                                                   const std::string & key) {
+  std::ifstream key_file(cachePath(config, hash, ".key"));
+  if(!key_file)
+    return nullptr;
+  std::stringstream stored_key;
+  stored_key << key_file.rdbuf();
+  if(stored_key.str() != key)
+    return nullptr;
+  // the entry may have been evicted since we read the key
+  std::string so_path = cachePath(config, hash, ".so");
+  auto lib = DynamicLibrary::tryOpen(so_path.c_str());
+  if(lib) {
+    // the modification time orders the entries for eviction
+    utime(so_path.c_str(), nullptr);
+  }
+  return lib;
+}
+
+// Temporary files of an entry are named <hash>XXXXXX.so and <hash>XXXXXX.key.
+// They are renamed within seconds unless the writer died, so older ones are
+// removed during eviction.
+static const time_t kCacheTempFileMaxAge = 60 * 60;
+
+static bool isCacheTempFile(const std::string & name) {
+  size_t prefix = kCacheHashLength + 6;
+  return (name.size() == prefix + 3 && name.compare(prefix, 3, ".so") == 0) ||
+         (name.size() == prefix + 4 && name.compare(prefix, 4, ".key") == 0);
+}
+
+// Removes the least recently used entries until the kernels fit in
+// config.cache_size_limit, and temporary files left behind by crashed writers.
+static void cacheEvict(const FusionCompilerConfig & config, FusionCacheStats & stats) {
+  struct Entry {
+    std::string hash;
+    size_t size;
+    time_t mtime;
+  };
+  std::vector<Entry> entries;
+  size_t total_size = 0;
+  DIR * dir = opendir(config.cache_dir.c_str());
+  if(!dir)
+    return;
+  time_t now = time(nullptr);
+  while(dirent * ent = readdir(dir)) {
+    std::string name = ent->d_name;
+    if(isCacheTempFile(name)) {
+      struct stat st;
+      if(stat(cachePath(config, name, "").c_str(), &st) == 0 &&
+         now - st.st_mtime > kCacheTempFileMaxAge) {
+        unlink(cachePath(config, name, "").c_str());
+      }
+      continue;
+    }
+    if(name.size() != kCacheHashLength + 3 || name.compare(kCacheHashLength, 3, ".so") != 0)
+      continue;
+    struct stat st;
+    if(stat(cachePath(config, name, "").c_str(), &st) != 0)
+      continue;
+    entries.push_back({name.substr(0, kCacheHashLength), static_cast<size_t>(st.st_size), st.st_mtime});
+    total_size += st.st_size;
+  }
+  closedir(dir);
+  std::sort(entries.begin(), entries.end(), [](const Entry & a, const Entry & b) {
+    return a.mtime < b.mtime;
+  });
+  for(auto & entry : entries) {
+    if(total_size <= config.cache_size_limit)
+      break;
+    // remove the key first so that lookups miss instead of failing to load
+    unlink(cachePath(config, entry.hash, ".key").c_str());
+    unlink(cachePath(config, entry.hash, ".so").c_str());
+    total_size -= entry.size;
+    stats.evictions++;
+  }
+}
+
 struct CPUFusionFunction : public CompiledFusionFunction {
-  CPUFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config)
+  CPUFusionFunction(const std::string & name, AnnotatedGraph & agraph, FusionCompilerConfig & config, FusionCacheStats & cache_stats)
   : CompiledFusionFunction(name, agraph) {
-    TempFile so_file(so_template, 3);
-    TempFile cpp_file(cpp_template, 4);
-
     std::stringstream cu;
-    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, false);
+    concat_desc = codegen::emitCompilationUnit(cu, name, agraph, false, reduction_desc);
     compilation_unit = cu.str();
-    cpp_file.write(compilation_unit);
-    cpp_file.sync();
-    runCompiler(config, cpp_file.name(), so_file.name());
-    if(config.debug) {
-      std::cout << compilation_unit << "\n";
-      disas(so_file.name());
+    if(config.cache_dir.empty()) {
+      TempFile so_file(so_template, 3);
+      compile(config, so_file.name());
+      so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
+    } else {
+      so_lib = loadCached(config, cache_stats);
     }
-    so_lib.reset(new DynamicLibrary(so_file.name().c_str()));
-    kernel = reinterpret_cast<void(*)(uint32_t, void**)>(so_lib->sym(name.c_str()));
+    kernel = reinterpret_cast<void(*)(uint32_t, uint32_t, void**)>(so_lib->sym(name.c_str()));
   }
 protected:
   virtual at::Backend backend() const override {
     return at::kCPU;
   }
-  virtual void launch_raw(uint32_t numel, void ** arguments) override {
-    kernel(numel, arguments);
+  virtual void launch_raw(uint32_t numel, uint32_t row_size, void ** arguments) override {
+    kernel(numel, row_size, arguments);
+  }
+  void compile(FusionCompilerConfig & config, const std::string & so_name) {
+    TempFile cpp_file(cpp_template, 4);
+    cpp_file.write(compilation_unit);
+    cpp_file.sync();
+    runCompiler(config, cpp_file.name(), so_name);
+    if(config.debug) {
+      std::cout << compilation_unit << "\n";
+      disas(so_name);
+    }
+  }
+  std::unique_ptr<DynamicLibrary> loadCached(FusionCompilerConfig & config, FusionCacheStats & stats) {
+    std::string key = cacheKey(config, compilation_unit);
+    std::string hash = hashCacheKey(key);
+    if(auto lib = cacheLookup(config, hash, key)) {
+      stats.hits++;
+      if(config.debug) {
+        std::cout << compilation_unit << "\n";
+        std::cout << "using cached kernel " << cachePath(config, hash, ".so") << "\n";
+      }
+      return lib;
+    }
+    stats.misses++;
+    std::string so_path = cachePath(config, hash, ".so");
+    {
+      TempFile so_file(cachePath(config, hash + "XXXXXX", ".so"), 3);
+      compile(config, so_file.name());
+      renameOrBarf(so_file.name(), so_path);
+    }
+    // load before evicting, which may remove this entry if it is too large
+    std::unique_ptr<DynamicLibrary> lib(new DynamicLibrary(so_path.c_str()));
+    {
+      TempFile key_file(cachePath(config, hash + "XXXXXX", ".key"), 4);
+      key_file.write(key);
+      key_file.sync();
+      renameOrBarf(key_file.name(), cachePath(config, hash, ".key"));
+    }
+    cacheEvict(config, stats);
+    return lib;
   }
   std::unique_ptr<DynamicLibrary> so_lib;
-  void (*kernel)(uint32_t, void**) = nullptr;
+  void (*kernel)(uint32_t, uint32_t, void**) = nullptr;
 };
 
 std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(AnnotatedGraph & agraph) {
@@ -721,17 +1166,20 @@ std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(AnnotatedGr
 
   auto it = cache.find(key_);
   if (it == cache.end()) {
-    std::string name = "kernel_" + std::to_string(cache.size());
     CompiledFusionFunction * raw_func;
     if(agraph.device != kCPUDevice) {
 #ifdef WITH_CUDA
+      std::string name = "kernel_" + std::to_string(cache.size());
       raw_func = new CUDAFusionFunction(name, agraph);
 #else
       throw std::runtime_error("cannot compile a CUDA fusion group, CUDA is not enabled.");
 #endif
     } else {
       JIT_ASSERT(canCompileOnCPU());
-      raw_func = new CPUFusionFunction(name, agraph, config_);
+      // every CPU kernel is loaded from its own library, so the symbol name
+      // is fixed and the source, which keys the disk cache, depends only on
+      // the fusion group
+      raw_func = new CPUFusionFunction("kernel", agraph, config_, cache_stats_);
     }
     it = cache.emplace(key_, std::shared_ptr<CompiledFusionFunction>(raw_func)).first;
   }
@@ -741,9 +1189,13 @@ std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(AnnotatedGr
 std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(Node* fusion_group) {
   auto & graph = *fusion_group->g(attr::Subgraph);
   AnnotatedGraph agraph(graph, fusion_group->i(attr::device));
+  std::vector<int64_t> map_size;
+  for(auto & input : graph.inputs()) {
+    map_size = at::infer_size(map_size, input->type()->expect<TensorType>()->sizes());
+  }
   for(auto & input : graph.inputs()) {
     auto t = input->type()->expect<TensorType>();
-    agraph.input_desc.emplace_back(t);
+    agraph.input_desc.push_back(expandedDesc(t, map_size));
   }
   for(auto & output : graph.outputs()) {
     auto t = output->type()->expect<TensorType>();
@@ -758,8 +1210,13 @@ std::shared_ptr<CompiledFusionFunction> FusionCompiler::getOrCompile(Graph & gra
                                                      at::ArrayRef<at::Tensor> inputs,
                                                      at::ArrayRef<at::Tensor> outputs) {
   AnnotatedGraph agraph(graph, device);
+  auto map_size = mapSize(inputs);
   for(auto & i : inputs) {
-   agraph.input_desc.emplace_back(i);
+    if(i.sizes().equals(map_size)) {
+      agraph.input_desc.emplace_back(i);
+    } else {
+      agraph.input_desc.emplace_back(i.expand(map_size));
+    }
   }
   for(auto & i : outputs) {
    agraph.output_desc.emplace_back(i);
@@ -782,6 +1239,18 @@ static bool programExists(const std::string & program) {
   return 0 == system(cmd.c_str());
 }
 
+// creates path and its missing parents, returns false on failure
+static bool makeDirectories(const std::string & path) {
+  for(size_t pos = path.find('/', 1); ; pos = path.find('/', pos + 1)) {
+    std::string prefix = path.substr(0, pos);
+    if(mkdir(prefix.c_str(), 0755) != 0 && errno != EEXIST)
+      return false;
+    if(pos == std::string::npos)
+      break;
+  }
+  return access(path.c_str(), W_OK) == 0;
+}
+
 FusionCompiler::FusionCompiler() {
   const char * cxx_env = getenv("CXX");
   if(cxx_env != nullptr) {
@@ -792,6 +1261,29 @@ FusionCompiler::FusionCompiler() {
   }
   const char * debug_env = getenv("PYTORCH_FUSION_DEBUG");
   config_.debug = debug_env && atoi(debug_env) != 0;
+  // the cache defaults to $TORCH_HOME/fuser like the model zoo, and is
+  // disabled by setting PYTORCH_FUSION_CACHE_DIR to an empty string
+  const char * cache_env = getenv("PYTORCH_FUSION_CACHE_DIR");
+  if(cache_env != nullptr) {
+    config_.cache_dir = cache_env;
+  } else {
+    const char * torch_home = getenv("TORCH_HOME");
+    const char * home = getenv("HOME");
+    if(torch_home != nullptr) {
+      config_.cache_dir = std::string(torch_home) + "/fuser";
+    } else if(home != nullptr) {
+      config_.cache_dir = std::string(home) + "/.torch/fuser";
+    }
+  }
+  if(!config_.cache_dir.empty() && !makeDirectories(config_.cache_dir)) {
+    std::cerr << "warning: pytorch jit fuser cannot write to cache directory "
+              << config_.cache_dir << ", kernels will not be cached\n";
+    config_.cache_dir = "";
+  }
+  const char * cache_size_env = getenv("PYTORCH_FUSION_CACHE_SIZE_MB");
+  if(cache_size_env != nullptr) {
+    config_.cache_size_limit = static_cast<size_t>(atoll(cache_size_env)) * 1024 * 1024;
+  }
 }
 
 //TODO: thread safety
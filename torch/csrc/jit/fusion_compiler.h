@@ -78,6 +78,31 @@ struct ConcatDesc {
   }
 };
 
+struct ReductionDesc {
+  bool isReduction; // false for outputs that are not sums or means over the last dimension
+  bool keepdim;
+  bool mean;
+  // descriptor for the view of the output that is expanded to the size of the map,
+  // which has a stride of 0 along the reduced dimension
+  std::unique_ptr<TensorDesc> viewDesc;
+  ReductionDesc()
+  : isReduction(false), keepdim(false), mean(false) {}
+  ReductionDesc(const TensorDesc & desc, bool keepdim, bool mean)
+  : isReduction(true), keepdim(keepdim), mean(mean) {
+    std::vector<bool> cont = desc.contiguity;
+    if(keepdim) {
+      cont.pop_back();
+    }
+    // the reduced dimension has a stride of 0, so neither it nor the
+    // dimension before it are contiguous
+    if(!cont.empty()) {
+      cont.back() = false;
+    }
+    cont.push_back(false);
+    viewDesc.reset(new TensorDesc(desc.scalar_type, cont));
+  }
+};
+
 struct CompiledFusionFunction {
   TH_DISALLOW_COPY_AND_ASSIGN(CompiledFusionFunction);
 
@@ -104,7 +129,9 @@ protected:
   // that compiled code uses to load Tensor data.
   // launch_with_tensors handles packing at::Tensors into this arguments array.
   // CPU code uses the same convension so that launch_with_tensors can be shared.
-  virtual void launch_raw(uint32_t numel, void ** arguments) = 0;
+  // row_size is the size of the last dimension of the map, which CPU code
+  // processes one row at a time.
+  virtual void launch_raw(uint32_t numel, uint32_t row_size, void ** arguments) = 0;
   std::string name;
   // We keep these around for debugging
   std::string compilation_unit;
@@ -115,12 +142,29 @@ protected:
   // an output is actually a concatenation of
   // many subtensors that the fusion group produces
   std::vector<ConcatDesc> concat_desc;
+
+  // same size as output_desc, describes whether
+  // an output is actually a reduction over the last
+  // dimension of the map
+  std::vector<ReductionDesc> reduction_desc;
 };
 
 struct FusionCompilerConfig {
   std::string cxx = "g++"; // compiler location
   bool debug = false; // emit debugging information about fusions
   bool openmp = true;
+  // directory of the on-disk cache of compiled CPU kernels, disabled if empty
+  std::string cache_dir;
+  // the least recently used kernels are removed from the on-disk cache
+  // when its size exceeds this limit
+  size_t cache_size_limit = 256 * 1024 * 1024;
+};
+
+// counters of the on-disk cache of compiled CPU kernels
+struct FusionCacheStats {
+  size_t hits = 0;
+  size_t misses = 0;
+  size_t evictions = 0;
 };
 
 // caching compiler
@@ -146,8 +190,12 @@ struct FusionCompiler {
   bool canCompileOnCPU() const {
     return config_.cxx.size() > 0;
   }
+  const FusionCacheStats & diskCacheStats() const {
+    return cache_stats_;
+  }
 private:
   FusionCompilerConfig config_;
+  FusionCacheStats cache_stats_;
   std::unordered_map<std::string, std::shared_ptr<CompiledFusionFunction>> cache;
 };
 
@@ -5,6 +5,7 @@
 #include "torch/csrc/jit/python_ir.h"
 #include "torch/csrc/jit/python_arg_flatten.h"
 #include "torch/csrc/jit/export.h"
+#include "torch/csrc/jit/fusion_compiler.h"
 #include "torch/csrc/jit/python_compiled_function.h"
 #include "torch/csrc/jit/argument_spec.h"
 #include "torch/csrc/jit/passes/graph_fuser.h"
@@ -75,6 +76,14 @@ void initJITBindings(PyObject *module) {
      PropagateInputShapes(graph, ArgumentSpec(with_grad, tensor_inputs));
    })
    .def("_jit_run_cpp_tests", runJITCPPTests)
+   .def("_jit_fuser_cache_stats", [] {
+     auto & stats = sharedFusionCompiler().diskCacheStats();
+     py::dict result;
+     result["hits"] = stats.hits;
+     result["misses"] = stats.misses;
+     result["evictions"] = stats.evictions;
+     return result;
+   })
    .def("_jit_flatten", [](py::handle& obj) {
      auto res =  python::flatten(obj);
      return std::make_pair(res.vars, res.desc);
@@ -652,25 +652,6 @@ Operation getOperation(jit::Node* node, bool values_are_variables) {
       stack.insert(stack.end(), toutputs.begin(), toutputs.end());
       return 0;
     };
-  IR_ELSEIF(Constant)
-  if (values_are_variables) {
-    auto t = torch::autograd::make_variable(value->t(attr::value), false);
-    return [t](Stack& stack) {
-      stack.push_back(t);
-      return 0;
-    };
-    } else {
-      auto t = value->t(attr::value);
-      return [t](Stack & stack) {
-        stack.push_back(t);
-        return 0;
-      };
-    }
-  IR_ELSEIF(Undefined)
-    return [](Stack & stack) {
-      stack.push_back(at::Tensor());
-      return 0;
-    };
   IR_ELSEIF(ReplaceIfUndef)
     return [](Stack & stack) {
       auto alternate = pop(stack);
@@ -715,31 +696,8 @@ Operation getOperation(jit::Node* node, bool values_are_variables) {
       stack.insert(stack.end(), toutputs.begin(), toutputs.end());
       return 0;
     };
-
-
-  // Load x, y
-  // loads values from registers onto the stack, the actual callback does
-  // nothing since the stack manipulation is already encoded in inst.inputs
-  // and inst.outputs
-  IR_ELSEIF(Load)
-    return [=](Stack& stack) {
-      return 0;
-    };
-
-  // x, y = Store
-  // stores values from stack into registers, the actual callback does
-  // nothing since the stack manipulation is already encoded in inst.inputs
-  // and inst.outputs
-  IR_ELSEIF(Store)
-    return [=](Stack& stack) {
-      return 0;
-    };
-  IR_ELSEIF(Drop)
-    auto N = value->inputs().size();
-    return [=](Stack& stack) {
-      drop(stack, N);
-      return 0;
-    };
+  // Constant, Undefined, Load, Store and Drop nodes have no Operation,
+  // the interpreter runs them inline (see OpCode)
   IR_ELSE()
     return getTensorOp(node).op;
   IR_END()
@@ -764,11 +722,42 @@ struct UseList {
   ListHandle<bool> free_flags;
 };
 
-// one instruction plus meta-data
+// What an instruction does. Only Call goes through an Operation, the
+// interpreter runs the other instructions inline, on the registers.
+enum class OpCode : uint8_t {
+  // loads the inputs on the stack, runs operations[payload], and stores the
+  // outputs it leaves on the stack
+  Call,
+  // loads the inputs on the stack and stores the outputs from it, which is
+  // also how Load and Store move values to and from the stack of a stage.
+  // Inputs in excess are left on the stack (e.g. the condition of a Loop).
+  Assign,
+  // frees the inputs that are moved
+  Drop,
+  // output = constants[payload]
+  Constant,
+  // output = undefined tensor
+  Undefined,
+  // relative jumps by payload, the conditional ones take their condition
+  // from their input, or from the top of the stack if they have none
+  Jump,
+  JumpZ,
+  JumpNZ,
+};
+
+// one instruction, laid out compactly so that the interpreter loop only
+// touches the instructions, the register lists and the registers
 struct Instruction {
-  Operation callback;
+  OpCode op;
+  // index into operations for Call, into constants for Constant, or the
+  // relative offset of jumps
+  int payload;
   UseList inputs;
   ListHandle<int> outputs;
+};
+
+// meta-data of an instruction, which is only read for dumps and errors
+struct InstructionInfo {
   Symbol debug_name; // used in dump to understand the generated code
   std::shared_ptr<SourceLocation> debug_location; // for error reporting
 };
@@ -788,36 +777,25 @@ struct CodeImpl {
 
   // jump when input is 0
   void createJumpZ(int from_inst, int to_inst) {
-    auto & inst = instructions[from_inst];
-    JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [offset](Stack & stack) {
-      auto t = tensor_as<int64_t>(pop(stack));
-      return (t == 0) ? offset : 0;
-    };
-    inst.debug_name = prim::JumpZ;
+    createJump(from_inst, to_inst, OpCode::JumpZ, prim::JumpZ);
   }
 
   // jump when input is not 0
   void createJumpNZ(int from_inst, int to_inst) {
-    auto & inst = instructions[from_inst];
-    JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [offset](Stack & stack) {
-      auto t = tensor_as<int64_t>(pop(stack));
-      return (t != 0) ? offset : 0;
-    };
-    inst.debug_name = prim::JumpNZ;
+    createJump(from_inst, to_inst, OpCode::JumpNZ, prim::JumpNZ);
   }
 
   void createJump(int from_inst, int to_inst) {
+    createJump(from_inst, to_inst, OpCode::Jump, prim::Jump);
+  }
+
+  void createJump(int from_inst, int to_inst, OpCode op, Symbol debug_name) {
+    auto & info = instruction_info[from_inst];
+    JIT_ASSERT(info.debug_name == prim::Placeholder);
     auto & inst = instructions[from_inst];
-    JIT_ASSERT(inst.debug_name == prim::Placeholder);
-    auto offset = relativeJump(from_inst, to_inst);
-    inst.callback = [=](Stack & stack) {
-      return offset;
-    };
-    inst.debug_name = prim::Jump;
+    inst.op = op;
+    inst.payload = relativeJump(from_inst, to_inst);
+    info.debug_name = debug_name;
   }
 
   void insertNodesFromBlock(Block* block) {
@@ -907,7 +885,38 @@ struct CodeImpl {
 
   size_t insertInstruction(Node * n) {
     auto inst = insertInstruction(n->kind(), n->getSourceLocation(), n->inputs(), moveFlags(n) , n->outputs());
-    instructions[inst].callback = getOperation(n, values_are_variables);
+    auto & instruction = instructions[inst];
+    switch(n->kind()) {
+      case prim::Constant: {
+        instruction.op = OpCode::Constant;
+        instruction.payload = constants.size();
+        auto t = n->t(attr::value);
+        if(values_are_variables) {
+          constants.push_back(autograd::make_variable(t, false));
+        } else {
+          constants.push_back(t);
+        }
+      } break;
+      case prim::Undefined:
+        instruction.op = OpCode::Undefined;
+        break;
+      // Load x, y
+      // loads values from registers onto the stack, and x, y = Store stores
+      // values from the stack into registers, which is all encoded in
+      // inst.inputs and inst.outputs
+      case prim::Load:
+      case prim::Store:
+        instruction.op = OpCode::Assign;
+        break;
+      case prim::Drop:
+        instruction.op = OpCode::Drop;
+        break;
+      default:
+        instruction.op = OpCode::Call;
+        instruction.payload = operations.size();
+        operations.push_back(getOperation(n, values_are_variables));
+        break;
+    }
     return inst;
   }
   size_t insertInstruction(Symbol sym,
@@ -917,8 +926,11 @@ struct CodeImpl {
                                  ArrayRef<Value*> outputs) {
     instructions.emplace_back();
     auto & inst = instructions.back();
-    inst.debug_name = sym;
-    inst.debug_location = std::move(debug_location);
+    inst.op = OpCode::Assign;
+    inst.payload = 0;
+    instruction_info.emplace_back();
+    instruction_info.back().debug_name = sym;
+    instruction_info.back().debug_location = std::move(debug_location);
     listBegin(inst.inputs.values);
     for(auto input : inputs) {
       listInsert(inst.inputs.values, getOrAllocateRegister(input, true));
@@ -941,12 +953,10 @@ struct CodeImpl {
   }
 
   size_t insertAssign(std::shared_ptr<SourceLocation> debug_location, ArrayRef<Value*> inputs, ArrayRef<uint8_t> move_flags, ArrayRef<Value*> outputs) {
-    auto inst = insertInstruction(prim::Assign, std::move(debug_location),inputs, move_flags, outputs);
     // This node effectively forwards its inputs into different places in a register list.
-    // We don't need to manipulate the stack in any way, because all inputs are also outputs,
-    // and the interpreter will take care of putting them in correct places.
-    instructions[inst].callback = [](Stack& stack) { return 0; };
-    return inst;
+    // insertInstruction creates OpCode::Assign instructions, for which the
+    // interpreter takes care of putting them in correct places.
+    return insertInstruction(prim::Assign, std::move(debug_location),inputs, move_flags, outputs);
   }
 
   // helpers to build/access RegList objects
@@ -1017,8 +1027,11 @@ struct CodeImpl {
     writeList(inst.outputs);
     // NB: debug names are the kind of operator used to select
     // dispatch
-    out << " = " << inst.debug_name.toUnqualString() << " ";
+    out << " = " << instruction_info.at(pc).debug_name.toUnqualString() << " ";
     writeUseList(inst.inputs);
+    if(inst.op == OpCode::Jump || inst.op == OpCode::JumpZ || inst.op == OpCode::JumpNZ) {
+      out << " -> " << pc + 1 + inst.payload;
+    }
   }
   void dump(std::ostream & out) const {
     for(size_t i = 0; i < instructions.size(); ++i) {
@@ -1040,21 +1053,44 @@ struct CodeImpl {
 
   friend struct InterpreterState;
   std::vector<Instruction> instructions;
+  std::vector<InstructionInfo> instruction_info;
+  // the operations of Call instructions, and the values of Constant ones,
+  // are created once for the graph
+  std::vector<Operation> operations;
+  std::vector<at::Tensor> constants;
   std::vector<size_t> stage_end; // each stage runs while(pc < stage_end[stage])
   int register_size = 0;
 
   // all memory ArrayRef<int> are slices of this, to make sure
   // the interpreter is mostly linearly scanning through memory
   std::vector<int> int_data;
-  std::vector<bool> bool_data;
+  // NB: not a std::vector<bool>, whose elements are bits
+  std::vector<uint8_t> bool_data;
 };
 
+// The condition of a branch, which is usually a CPU tensor with a single
+// element, read without going through at::Scalar
+static bool branchCondition(const at::Tensor & t) {
+  if(t.defined() && !t.is_variable_or_undefined() &&
+     t.type().backend() == at::Backend::CPU && t.numel() == 1) {
+    switch(t.type().scalarType()) {
+      case at::ScalarType::Byte: return *t.data<uint8_t>() != 0;
+      case at::ScalarType::Int: return *t.data<int>() != 0;
+      case at::ScalarType::Long: return *t.data<int64_t>() != 0;
+      case at::ScalarType::Float: return static_cast<int64_t>(*t.data<float>()) != 0;
+      case at::ScalarType::Double: return static_cast<int64_t>(*t.data<double>()) != 0;
+      default: break;
+    }
+  }
+  return tensor_as<int64_t>(at::Tensor(t)) != 0;
+}
+
 // InterpreterState state that is held across stages and used to compute a Code
 struct InterpreterStateImpl {
   InterpreterStateImpl(const Code & function_)
   : function(function_.pImpl),
     int_data(function->int_data.data()),
-    bool_data(function->bool_data),
+    bool_data(function->bool_data.data()),
     registers(function->register_size) {
   }
   void runOneStage(Stack & stack) {
@@ -1063,26 +1099,60 @@ struct InterpreterStateImpl {
     // function->dump(std::cout);
     size_t pc = current_pc;
     size_t last = function->stage_end[current_stage];
-    auto & instructions = function->instructions;
+    const Instruction * instructions = function->instructions.data();
+    Operation * operations = function->operations.data();
+    const at::Tensor * constants = function->constants.data();
     while(pc < last) {
         // std::cout << "executing " << pc << ": ";
         // function->dumpInstruction(std::cout, pc);
         // std::cout << "\n";
         try {
           auto & inst = instructions[pc];
-          loadTensorsFromRegisters(inst.inputs, stack);
-          size_t new_pc = pc + 1 + inst.callback(stack);
-          for(int i = inst.outputs.size - 1; i >= 0; i--) {
-            int reg = get(inst.outputs,i);
-            registers[reg] = pop(stack);
-            // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
+          switch(inst.op) {
+            case OpCode::Call:
+            {
+              loadTensorsFromRegisters(inst.inputs, stack);
+              size_t new_pc = pc + 1 + operations[inst.payload](stack);
+              storeTensorsToRegisters(inst.outputs, stack);
+              pc = new_pc;
+            } break;
+            case OpCode::Assign:
+              loadTensorsFromRegisters(inst.inputs, stack);
+              storeTensorsToRegisters(inst.outputs, stack);
+              pc++;
+              break;
+            case OpCode::Drop:
+              for(int i = 0; i < inst.inputs.values.size; i++) {
+                if(get(inst.inputs.free_flags, i)) {
+                  registers[get(inst.inputs.values, i)].reset();
+                }
+              }
+              pc++;
+              break;
+            case OpCode::Constant:
+              registers[get(inst.outputs, 0)] = constants[inst.payload];
+              pc++;
+              break;
+            case OpCode::Undefined:
+              registers[get(inst.outputs, 0)].reset();
+              pc++;
+              break;
+            case OpCode::Jump:
+              pc += 1 + inst.payload;
+              break;
+            case OpCode::JumpZ:
+            case OpCode::JumpNZ: {
+              bool cond = takeCondition(inst.inputs, stack);
+              bool jump = (inst.op == OpCode::JumpNZ) == cond;
+              pc += 1 + (jump ? inst.payload : 0);
+            } break;
           }
-          pc = new_pc;
         } catch(std::exception & e) {
-          if(!instructions[pc].debug_location)
+          auto & debug_location = function->instruction_info[pc].debug_location;
+          if(!debug_location)
             throw; // rethrow original exception
           // throw a new exception with enhanced debugging information
-          instructions[pc].debug_location->wrapAndRethrowException(e, "operation failed in interpreter");
+          debug_location->wrapAndRethrowException(e, "operation failed in interpreter");
         }
     }
     current_pc = pc;
@@ -1097,6 +1167,27 @@ struct InterpreterStateImpl {
   bool get(const ListHandle<bool> & list, int i) {
     return bool_data[list.start + i];
   }
+  bool takeCondition(const UseList & uses, Stack & stack) {
+    if(uses.values.size == 0) {
+      bool cond = branchCondition(stack.back());
+      stack.pop_back();
+      return cond;
+    }
+    auto & reg = registers[get(uses.values, 0)];
+    bool cond = branchCondition(reg);
+    if(get(uses.free_flags, 0)) {
+      reg.reset();
+    }
+    return cond;
+  }
+  void storeTensorsToRegisters(const ListHandle<int> & outputs, Stack & stack) {
+    for(int i = outputs.size - 1; i >= 0; i--) {
+      int reg = get(outputs,i);
+      registers[reg] = std::move(stack.back());
+      stack.pop_back();
+      // std::cout << "pop reg[" << reg << "];\n" << registers[reg].pImpl << "\n";
+    }
+  }
   void loadTensorsFromRegisters(const UseList & uses, Stack & stack) {
     for(int i = 0; i < uses.values.size; i++) {
       int reg = get(uses.values,i);
@@ -1114,7 +1205,7 @@ struct InterpreterStateImpl {
   std::shared_ptr<CodeImpl> function; // keep function alive
   // these are just copies of function to prevent indirections in interpreter
   int * int_data;
-  const std::vector<bool> & bool_data;
+  const uint8_t * bool_data;
 
 
   // this holds all the tensors for this interpreter run
@@ -6,6 +6,9 @@
 
 #include <ATen/ATen.h>
 #include <algorithm>
+#include <functional>
+#include <limits>
+#include <map>
 #include <unordered_map>
 
 namespace torch { namespace jit {
@@ -139,6 +142,324 @@ struct TreeToken {
   }
 };
 
+// Note [Batching independent matmuls]
+// Models with several heads or towers apply many matmuls (Linear layers are
+// traced to addmm) that don't depend on each other, to the same input or to
+// inputs of the same size. Each of them is a small GEMM, which is much less
+// efficient than a single large one, so we batch them:
+//
+//  - mm(X, W1), ..., mm(X, Wn), which share their lhs, are computed by
+//    mm(X, cat(W1, ..., Wn, dim=1)), and narrowed out of its columns;
+//  - mm(A1, B1), ..., mm(An, Bn) of the same sizes are computed by
+//    bmm(stack(A1, ..., An), stack(B1, ..., Bn)), and selected out of it.
+//
+// addmm nodes with beta = alpha = 1 are batched likewise, by concatenating
+// or stacking their biases too (and using baddbmm).
+//
+// The batched matmul is inserted before the last matmul of the batch, which
+// is only valid if:
+//  - the outputs of the matmuls are not used before it. This also guarantees
+//    that none of the matmuls depends on another one;
+//  - the earlier matmuls read the same values when they are batched later,
+//    i.e. no node between the first and the last matmul writes to a tensor,
+//    which could be aliased by one of their inputs.
+// We scan the block in order, and start a new window of candidates at each
+// node that may write to a tensor. In each window, a matmul can join a batch
+// if it comes before the first use of the outputs of the batch.
+
+static bool isScalarOne(Node *node, Symbol name) {
+  return node->hasAttribute(name) && node->kindOf(name) == AttributeKind::t &&
+         at::Scalar(node->t(name)).toDouble() == 1;
+}
+
+static TensorType* tensorType(Value *v) {
+  return v->type()->cast<TensorType>();
+}
+
+static bool isBatchableMatMul(Node *node) {
+  size_t num_inputs;
+  if (node->kind() == aten::mm) {
+    num_inputs = 2;
+  } else if (node->kind() == aten::addmm) {
+    num_inputs = 3;
+    if (!isScalarOne(node, attr::beta) || !isScalarOne(node, attr::alpha))
+      return false;
+  } else {
+    return false;
+  }
+  if (node->inputs().size() != num_inputs || node->outputs().size() != 1)
+    return false;
+  auto output_type = tensorType(node->output());
+  if (!output_type || output_type->sizes().size() != 2)
+    return false;
+  for (size_t i = 0; i < num_inputs; ++i) {
+    auto type = tensorType(node->inputs()[i]);
+    if (!type || type->scalarType() != output_type->scalarType() ||
+        type->device() != output_type->device())
+      return false;
+    // the bias of addmm can be broadcast along its rows
+    size_t dim = type->sizes().size();
+    if (dim != 2 && !(i == 0 && num_inputs == 3 && dim == 1))
+      return false;
+  }
+  return true;
+}
+
+// Conservatively, can node write to a tensor?
+static bool mayMutate(Node *node) {
+  if (node->kind() == prim::PythonOp || node->kind() == prim::CppOp ||
+      node->blocks().size() > 0)
+    return true;
+  if (!node->kind().is_aten())
+    return false;
+  // in-place ops end with a single underscore, unlike e.g. __and__, or are
+  // in-place dunder ops, e.g. __iand__ or __ilshift__
+  std::string name = node->kind().toUnqualString();
+  if (name.size() > 5 && name.compare(0, 3, "__i") == 0 &&
+      name.compare(name.size() - 2, 2, "__") == 0)
+    return true;
+  return name.size() > 1 && name.back() == '_' && name[name.size() - 2] != '_';
+}
+
+static void visitInputs(Node *node, const std::function<void(Value*)>& fn) {
+  for (auto input : node->inputs())
+    fn(input);
+  for (auto block : node->blocks()) {
+    for (auto n : block->nodes())
+      visitInputs(n, fn);
+    visitInputs(block->return_node(), fn);
+  }
+}
+
+struct MatMulCandidate {
+  Node *node;
+  size_t position;
+  // position of the first node that uses the output
+  size_t first_use = std::numeric_limits<size_t>::max();
+
+  Value* bias() const { return node->kind() == aten::addmm ? node->inputs()[0] : nullptr; }
+  Value* lhs() const { return node->inputs()[node->inputs().size() - 2]; }
+  Value* rhs() const { return node->inputs()[node->inputs().size() - 1]; }
+};
+
+using MatMulBatch = std::vector<MatMulCandidate*>;
+
+// Splits candidates, in order, into batches whose outputs are not used before
+// their last matmul
+static std::vector<MatMulBatch> splitIntoBatches(const MatMulBatch& candidates) {
+  std::vector<MatMulBatch> batches;
+  MatMulBatch batch;
+  size_t first_use = std::numeric_limits<size_t>::max();
+  for (auto candidate : candidates) {
+    if (candidate->position >= first_use) {
+      batches.push_back(std::move(batch));
+      batch.clear();
+      first_use = std::numeric_limits<size_t>::max();
+    }
+    batch.push_back(candidate);
+    first_use = std::min(first_use, candidate->first_use);
+  }
+  batches.push_back(std::move(batch));
+  return batches;
+}
+
+static Value* insertCat(Node *before, at::ArrayRef<Value*> inputs, int64_t dim) {
+  auto graph = before->owningGraph();
+  auto type = tensorType(inputs[0]);
+  std::vector<int64_t> sizes = type->sizes();
+  sizes[dim] = 0;
+  for (auto input : inputs)
+    sizes[dim] += tensorType(input)->sizes()[dim];
+  Node *cat = graph->create(aten::cat, inputs)->i_(attr::dim, dim);
+  cat->insertBefore(before);
+  cat->output()->setType(type->withSizes(sizes));
+  return cat->output();
+}
+
+static Value* insertStack(Node *before, at::ArrayRef<Value*> inputs) {
+  auto graph = before->owningGraph();
+  auto type = tensorType(inputs[0]);
+  std::vector<int64_t> sizes = type->sizes();
+  sizes.insert(sizes.begin(), inputs.size());
+  Node *stack = graph->create(aten::stack, inputs)->i_(attr::dim, 0);
+  stack->insertBefore(before);
+  stack->output()->setType(type->withSizes(sizes));
+  return stack->output();
+}
+
+// mm(X, cat(W1, ..., Wn, dim=1)), narrowed into the outputs
+static void concatMatMuls(const MatMulBatch& batch) {
+  Node *last = batch.back()->node;
+  auto graph = last->owningGraph();
+  auto type = tensorType(last->output());
+  auto rhs = insertCat(last, fmap(batch, [](MatMulCandidate *c) { return c->rhs(); }), 1);
+  int64_t rows = type->sizes()[0];
+  int64_t cols = tensorType(rhs)->sizes()[1];
+  Node *mm;
+  if (last->kind() == aten::addmm) {
+    auto biases = fmap(batch, [](MatMulCandidate *c) { return c->bias(); });
+    // the columns are the last dimension of the biases
+    auto bias = insertCat(last, biases, tensorType(biases[0])->sizes().size() - 1);
+    mm = graph->create(aten::addmm, {bias, batch[0]->lhs(), rhs});
+    mm->copyAttributes(*last);
+  } else {
+    mm = graph->create(aten::mm, {batch[0]->lhs(), rhs});
+  }
+  mm->insertBefore(last);
+  mm->output()->setType(type->withSizes({rows, cols}));
+  int64_t start = 0;
+  for (auto candidate : batch) {
+    int64_t length = tensorType(candidate->node->output())->sizes()[1];
+    Node *narrow = graph->create(aten::narrow, {mm->output()})
+                        ->i_(attr::dim, 1)
+                        ->i_(attr::start, start)
+                        ->i_(attr::length, length);
+    narrow->insertBefore(last);
+    narrow->output()->setType(type->withSizesStrides({rows, length}, {cols, 1}));
+    candidate->node->output()->replaceAllUsesWith(narrow->output());
+    start += length;
+  }
+}
+
+// bmm(stack(A1, ..., An), stack(B1, ..., Bn)), selected into the outputs
+static void stackMatMuls(const MatMulBatch& batch) {
+  Node *last = batch.back()->node;
+  auto graph = last->owningGraph();
+  auto type = tensorType(last->output());
+  auto lhs = insertStack(last, fmap(batch, [](MatMulCandidate *c) { return c->lhs(); }));
+  auto rhs = insertStack(last, fmap(batch, [](MatMulCandidate *c) { return c->rhs(); }));
+  Node *bmm;
+  if (last->kind() == aten::addmm) {
+    auto bias = insertStack(last, fmap(batch, [](MatMulCandidate *c) { return c->bias(); }));
+    if (tensorType(bias)->sizes().size() == 2) {
+      // broadcast the stacked rows of the biases along the rows of the outputs
+      auto bias_type = tensorType(bias);
+      Node *unsqueeze = graph->create(aten::unsqueeze, {bias})->i_(attr::dim, 1);
+      unsqueeze->insertBefore(last);
+      unsqueeze->output()->setType(bias_type->withSizes(
+          {bias_type->sizes()[0], 1, bias_type->sizes()[1]}));
+      bias = unsqueeze->output();
+    }
+    bmm = graph->create(aten::baddbmm, {bias, lhs, rhs});
+    bmm->t_(attr::beta, at::Scalar(1).toTensor());
+    bmm->t_(attr::alpha, at::Scalar(1).toTensor());
+  } else {
+    bmm = graph->create(aten::bmm, {lhs, rhs});
+  }
+  bmm->insertBefore(last);
+  int64_t batch_size = batch.size();
+  bmm->output()->setType(type->withSizes(
+      {batch_size, type->sizes()[0], type->sizes()[1]}));
+  for (int64_t i = 0; i < batch_size; ++i) {
+    Node *select = graph->create(aten::select, {bmm->output()})
+                        ->i_(attr::dim, 0)
+                        ->i_(attr::index, i);
+    select->insertBefore(last);
+    select->output()->setType(batch[i]->node->output()->type());
+    batch[i]->node->output()->replaceAllUsesWith(select->output());
+  }
+}
+
+static void batchWindow(std::vector<MatMulCandidate>& window) {
+  std::vector<bool> batched(window.size(), false);
+  auto batchGroups = [&](const std::function<std::vector<int64_t>(MatMulCandidate&)>& key,
+                         const std::function<void(const MatMulBatch&)>& batchFn) {
+    // groups are kept in order of appearance so that the pass is deterministic
+    std::map<std::vector<int64_t>, size_t> group_index;
+    std::vector<MatMulBatch> groups;
+    for (size_t i = 0; i < window.size(); ++i) {
+      if (batched[i])
+        continue;
+      // an empty key keeps the candidate out of all groups
+      auto k = key(window[i]);
+      if (k.empty())
+        continue;
+      auto it = group_index.find(k);
+      if (it == group_index.end()) {
+        it = group_index.emplace(k, groups.size()).first;
+        groups.emplace_back();
+      }
+      groups[it->second].push_back(&window[i]);
+    }
+    for (auto & group : groups) {
+      for (auto & batch : splitIntoBatches(group)) {
+        if (batch.size() < min_fusion_size)
+          continue;
+        batchFn(batch);
+        for (auto candidate : batch)
+          batched[candidate - window.data()] = true;
+      }
+    }
+  };
+  auto appendSizes = [](std::vector<int64_t>& key, Value *v) {
+    auto & sizes = tensorType(v)->sizes();
+    key.push_back(sizes.size());
+    key.insert(key.end(), sizes.begin(), sizes.end());
+  };
+
+  // matmuls that share their lhs, with biases that can be concatenated
+  batchGroups([&](MatMulCandidate& c) {
+    std::vector<int64_t> key {static_cast<int64_t>(static_cast<unique_t>(c.node->kind())),
+                              static_cast<int64_t>(c.lhs()->unique())};
+    if (auto bias = c.bias()) {
+      auto & sizes = tensorType(bias)->sizes();
+      // biases broadcast along the columns, e.g. of size [M, 1] or [1], can't
+      // be concatenated along them
+      if (sizes.back() != tensorType(c.node->output())->sizes()[1])
+        return std::vector<int64_t>();
+      key.push_back(sizes.size());
+      // the rows of 2D biases are not concatenated
+      if (sizes.size() == 2)
+        key.push_back(sizes[0]);
+    }
+    return key;
+  }, concatMatMuls);
+
+  // the other matmuls of the same sizes
+  batchGroups([&](MatMulCandidate& c) {
+    auto type = tensorType(c.node->output());
+    std::vector<int64_t> key {static_cast<int64_t>(static_cast<unique_t>(c.node->kind())),
+                              static_cast<int64_t>(type->scalarType()),
+                              type->device()};
+    for (auto input : c.node->inputs())
+      appendSizes(key, input);
+    return key;
+  }, stackMatMuls);
+
+  for (size_t i = 0; i < window.size(); ++i) {
+    if (batched[i])
+      window[i].node->destroy();
+  }
+}
+
+static void BatchIndependentMMs(Block *block) {
+  std::vector<std::vector<MatMulCandidate>> windows(1);
+  // candidates of the current window whose outputs are not used yet
+  std::unordered_map<Value*, size_t> unused;
+  size_t position = 0;
+  for (auto node : block->nodes()) {
+    ++position;
+    auto & window = windows.back();
+    visitInputs(node, [&](Value *v) {
+      auto it = unused.find(v);
+      if (it != unused.end()) {
+        window[it->second].first_use = position;
+        unused.erase(it);
+      }
+    });
+    if (mayMutate(node)) {
+      windows.emplace_back();
+      unused.clear();
+    } else if (isBatchableMatMul(node)) {
+      unused[node->output()] = window.size();
+      window.push_back(MatMulCandidate{node, position});
+    }
+  }
+  // the graph is only changed once the windows are complete
+  for (auto & window : windows)
+    batchWindow(window);
+}
+
 void BatchMMBlock(Block* block) {
   enum class Side { LHS, RHS };
   auto graph = block->owningGraph();
@@ -203,6 +524,9 @@ void BatchMMBlock(Block* block) {
     // NB: don't bother with cleaning up after yourself. We'll use DCE for that.
   }
   EliminateDeadCode(block);
+
+  // See Note [Batching independent matmuls]
+  BatchIndependentMMs(block);
 }
 
 void BatchMM(std::shared_ptr<Graph>& graph) {
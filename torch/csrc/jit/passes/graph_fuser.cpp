@@ -1,5 +1,6 @@
 #include "torch/csrc/jit/passes/graph_fuser.h"
 #include "torch/csrc/jit/fusion_compiler.h"
+#include "ATen/ExpandUtils.h"
 #include <unordered_map>
 
 namespace torch { namespace jit {
@@ -98,6 +99,64 @@ bool isSimpleMap(Node *node) {
   return true;
 }
 
+// Are sizes equal to map_sizes, except for leading dimensions
+// that are missing or of size 1?
+bool isLeadingBroadcastOf(at::IntList sizes, at::IntList map_sizes) {
+  if (sizes.size() > map_sizes.size())
+    return false;
+  size_t offset = map_sizes.size() - sizes.size();
+  size_t i = sizes.size();
+  while (i > 0 && sizes[i - 1] == map_sizes[offset + i - 1])
+    --i;
+  for (; i > 0; --i) {
+    if (sizes[i - 1] != 1)
+      return false;
+  }
+  return true;
+}
+
+// A simple map whose inputs may be broadcast along leading dimensions,
+// e.g. a bias of size [C] added to an input of size [N, C]. The CPU fuser
+// expands such inputs to the size of the map when it launches a kernel.
+bool isLeadingBroadcastMap(Node *node) {
+  if(simple_mappable.count(node->kind()) == 0)
+    return false;
+  if((node->kind() == aten::min || node->kind() == aten::max) && node->inputs().size() == 1)
+    return false;
+  if(node->inputs().size() == 0 || node->outputs().size() != 1)
+    return false;
+  TensorType* output_type = node->output()->type()->cast<TensorType>();
+  if (!output_type || output_type->device() != kCPUDevice)
+    return false;
+  for (Value * val : node->inputs()) {
+    TensorType* type = val->type()->cast<TensorType>();
+    if (!type ||
+        type->scalarType() != output_type->scalarType() ||
+        type->device() != output_type->device() ||
+        !isLeadingBroadcastOf(type->sizes(), output_type->sizes()))
+      return false;
+  }
+  return true;
+}
+
+// A sum or mean over the last dimension, which the CPU fuser accumulates
+// in the same pass as the map that computes its input. Like concat, it
+// can only produce an output of a fusion group.
+bool isTrailingReduction(Node *node) {
+  if(node->kind() != aten::sum && node->kind() != aten::mean)
+    return false;
+  if(node->inputs().size() != 1 ||
+     !node->hasAttribute(attr::dim) || node->kindOf(attr::dim) != AttributeKind::i ||
+     !node->hasAttribute(attr::keepdim) || node->kindOf(attr::keepdim) != AttributeKind::i)
+    return false;
+  TensorType* type = node->input()->type()->cast<TensorType>();
+  if (!type || type->device() != kCPUDevice || !node->output()->type()->cast<TensorType>())
+    return false;
+  int64_t ndim = type->sizes().size();
+  int64_t dim = node->i(attr::dim);
+  return ndim > 0 && (dim == ndim - 1 || dim == -1);
+}
+
 struct GraphFuser {
   Block * block;
 
@@ -142,7 +201,7 @@ struct GraphFuser {
   bool isFusable(Node * node) {
     if (node->owningBlock() != block) return false;
     if (node->kind() == prim::FusionGroup) return true;
-    return isSimpleMap(node) && allFloatIO(node);
+    return (isSimpleMap(node) || isLeadingBroadcastMap(node)) && allFloatIO(node);
   }
 
   bool allOutputsHaveSameSize(Node * node) {
@@ -172,7 +231,51 @@ struct GraphFuser {
     // otherwise they cannot partipate in the same map
     if(node->kind() == aten::cat && allOutputsHaveSameSize(node))
       return true;
+    // reductions over the last dimension only fuse on CPU
+    if(isTrailingReduction(node) && allFloatIO(node))
+      return true;
+
+    return false;
+  }
+
+  // the sizes of the map that node computes, or is part of
+  std::vector<int64_t> mapSizes(Node * node) {
+    if(node->kind() == prim::FusionGroup) {
+      std::vector<int64_t> sizes;
+      for(auto n : getSubgraph(node).nodes()) {
+        sizes = at::infer_size(sizes, mapSizes(n));
+      }
+      return sizes;
+    }
+    if(node->kind() == aten::cat || isTrailingReduction(node)) {
+      return node->inputs()[0]->type()->expect<TensorType>()->sizes();
+    }
+    return node->output()->type()->expect<TensorType>()->sizes();
+  }
 
+  // concats and reductions can only produce outputs of a fusion group,
+  // so a group cannot be merged into a consumer of one of them
+  bool consumesExitOnlyOutput(Node * consumer, Node * producer_group) {
+    auto & subgraph = getSubgraph(producer_group);
+    for(size_t i = 0; i < producer_group->outputs().size(); ++i) {
+      Node * inner = subgraph.outputs()[i]->node();
+      if(inner->kind() != aten::cat && !isTrailingReduction(inner))
+        continue;
+      for(auto u : producer_group->outputs()[i]->uses()) {
+        if(u.user == consumer)
+          return true;
+      }
+    }
+    return false;
+  }
+
+  bool containsReduction(Node * node) {
+    if(node->kind() != prim::FusionGroup)
+      return isTrailingReduction(node);
+    for(auto n : getSubgraph(node).nodes()) {
+      if(isTrailingReduction(n))
+        return true;
+    }
     return false;
   }
 
@@ -209,10 +312,26 @@ struct GraphFuser {
     // we can move the consumer up into the producer.
     // but this requires better handling of merging fusion groups so it is not done now
     int consumer_device = getDevice(consumer);
-    return isFusable(producer->node()) &&
-      allUsersAreThisConsumerOrOccurAfterIt(consumer, producer) &&
-      consumer_device == getDevice(producer->node()) &&
-      (consumer_device != kCPUDevice || sharedFusionCompiler().canCompileOnCPU());
+    if(!(isFusable(producer->node()) &&
+         allUsersAreThisConsumerOrOccurAfterIt(consumer, producer) &&
+         consumer_device == getDevice(producer->node()) &&
+         (consumer_device != kCPUDevice || sharedFusionCompiler().canCompileOnCPU())))
+      return false;
+    if(producer->node()->kind() == prim::FusionGroup &&
+       consumesExitOnlyOutput(consumer, producer->node()))
+      return false;
+    // the rows of a reduction are those of the map of its group, so merging
+    // groups of different maps would change the size of its output
+    if(producer->node()->kind() == prim::FusionGroup &&
+       (containsReduction(producer->node()) || containsReduction(consumer)) &&
+       mapSizes(producer->node()) != mapSizes(consumer))
+      return false;
+    // A producer that is broadcast in the map of consumer is recomputed for
+    // every element of the map, so it cannot also be an output of the group,
+    // which has the size of the map
+    if(producer->type()->expect<TensorType>()->sizes() != mapSizes(consumer))
+      return allUsersAreThisConsumer(consumer, producer);
+    return true;
   }
 
   // insert a producer node into a consuming fusion group.
@@ -398,6 +517,12 @@ struct GraphFuser {
     Value * producer_for_chunk = chunk->input();
     if (!isFusable(producer_for_chunk->node()) || !allUsersAreThisConsumer(chunk,producer_for_chunk))
       return false;
+    // and its operands can be chunked like it, i.e. none is broadcast
+    for (auto input : producer_for_chunk->node()->inputs()) {
+      auto input_type = input->type()->cast<TensorType>();
+      if (!input_type || input_type->sizes() != producer_for_chunk->type()->expect<TensorType>()->sizes())
+        return false;
+    }
     // and all uses of the chunk are in this consumer
     for (auto s : chunk->outputs()) {
       for (auto u : s->uses()) {
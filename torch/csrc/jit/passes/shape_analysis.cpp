@@ -195,7 +195,8 @@ void PropagateShapeOnNode(Node * node) {
         node->output()->setType(tp->withSizesStrides(sizes, tp->strides()));
       }
     } break;
-    case aten::sum: {
+    case aten::sum:
+    case aten::mean: {
       if (check_overload(/*num_inputs=*/1, /*num_outputs=*/1,
                          {{AKind::i, attr::dim},
                           {AKind::i, attr::keepdim}})) {
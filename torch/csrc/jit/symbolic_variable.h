@@ -125,6 +125,13 @@ struct SymbolicVariable {
      ->i_(a("keepdim"), keepdim);
     return r;
   }
+  SymbolicVariable mean(int dim, bool keepdim) const {
+    Node * n;
+    auto r = create(t("mean"), {*this}, 1, &n)[0];
+    n->i_(a("dim"), dim)
+     ->i_(a("keepdim"), keepdim);
+    return r;
+  }
   SymbolicVariable squeeze(int dim) const {
     Node * n;
     auto r = create(t("squeeze"), {*this}, 1, &n)[0];
@@ -24,6 +24,8 @@
 #include "torch/csrc/jit/argument_spec.h"
 #include "torch/csrc/jit/passes/shape_analysis.h"
 #include "torch/csrc/jit/passes/dead_code_elimination.h"
+#include "torch/csrc/jit/passes/batch_mm.h"
+#include "torch/csrc/jit/passes/graph_fuser.h"
 
 #include "torch/csrc/assertions.h"
 
@@ -35,6 +37,9 @@
 #include "torch/csrc/jit/script/compiler.h"
 #include "torch/csrc/jit/script/module.h"
 
+#include <algorithm>
+#include <chrono>
+#include <limits>
 #include <vector>
 #include <iostream>
 
@@ -238,6 +243,81 @@ static void fusionTests() {
   testConcat(2);
 }
 
+static void cpuFusionTests() {
+  FusionCompiler comp;
+  if(!comp.canCompileOnCPU())
+    return;
+
+  // a bias broadcast along the leading dimension, and reductions over the
+  // last one, with rows that are not a whole number of vectors
+  auto testBroadcastReduce = [&](int64_t row_size, bool keepdim, bool transpose) {
+    Graph graph;
+    Var i0 = Var::asNewInput(graph);
+    Var i1 = Var::asNewInput(graph);
+    auto o0 = (i0 + i1).sigmoid() * i0;
+    o0.addAsOutput();
+    o0.sum(1, keepdim).addAsOutput();
+    o0.mean(1, keepdim).addAsOutput();
+
+    // a transposed input is not contiguous along rows, so the kernel is not vectorized
+    auto a = transpose ? at::rand(at::CPU(at::kFloat), {row_size, 7}).transpose(0, 1)
+                       : at::rand(at::CPU(at::kFloat), {7, row_size});
+    auto b = at::rand(at::CPU(at::kFloat), {row_size});
+    auto o = at::zeros(at::CPU(at::kFloat), {7, row_size});
+    std::vector<int64_t> reduced_size = {7};
+    if(keepdim)
+      reduced_size.push_back(1);
+    auto s = at::zeros(at::CPU(at::kFloat), reduced_size);
+    auto m = at::zeros(at::CPU(at::kFloat), reduced_size);
+    comp.debugLaunchGraph(graph, kCPUDevice, {a, b}, {o, s, m});
+
+    auto o_r = (a + b).sigmoid() * a;
+    float max_diff = (o_r - o).abs().max().toCDouble();
+    REQUIRE(max_diff < 1e-6);
+    REQUIRE(s.sizes().equals(reduced_size));
+    float max_diff_sum = (o_r.sum(1, keepdim) - s).abs().max().toCDouble();
+    REQUIRE(max_diff_sum < 1e-4);
+    float max_diff_mean = (o_r.mean(1, keepdim) - m).abs().max().toCDouble();
+    REQUIRE(max_diff_mean < 1e-6);
+  };
+  testBroadcastReduce(3, false, false);
+  testBroadcastReduce(37, false, false);
+  testBroadcastReduce(37, true, false);
+  testBroadcastReduce(37, false, true);
+
+  // z is broadcast in the map of w, so the group of z and its reduction
+  // cannot be merged into the group of w, whose rows are not those of z
+  {
+    auto graph = std::make_shared<Graph>();
+    Var b = Var::asNewInput(*graph);
+    Var x = Var::asNewInput(*graph);
+    auto z = b * 2;
+    z.sum(-1, false).addAsOutput();
+    (x + z).addAsOutput();
+
+    auto b_t = at::rand(at::CPU(at::kFloat), {5});
+    auto x_t = at::rand(at::CPU(at::kFloat), {3, 5});
+    auto v = [](at::Tensor t) { return autograd::make_variable(t, false); };
+    variable_tensor_list spec_inputs(std::vector<at::Tensor>{v(b_t), v(x_t)});
+    PropagateInputShapes(*graph, ArgumentSpec(false, spec_inputs));
+    FuseGraph(graph);
+    Code code(graph, /*values_are_variables=*/false);
+    InterpreterState interp(code);
+    std::vector<at::Tensor> stack = {b_t, x_t};
+    interp.runOneStage(stack);
+
+    auto s_r = (b_t * 2).sum(-1, false);
+    auto w_r = x_t + b_t * 2;
+    REQUIRE(stack.size() == 2);
+    REQUIRE(stack[0].sizes().equals(s_r.sizes()));
+    REQUIRE(stack[1].sizes().equals(w_r.sizes()));
+    float max_diff_sum = (stack[0] - s_r).abs().max().toCDouble();
+    REQUIRE(max_diff_sum < 1e-5);
+    float max_diff = (stack[1] - w_r).abs().max().toCDouble();
+    REQUIRE(max_diff < 1e-6);
+  }
+}
+
 struct Attr : public Attributes<Attr> {
 };
 void attributesTest() {
@@ -884,8 +964,308 @@ void testControlFlow() {
   REQUIRE(256 == run_binary("while_test",2,0));
 }
 
+// Builds mm, or addmm if a bias is given, as a node of the graph
+static Value* appendMatMul(Graph & graph, Value *lhs, Value *rhs, Value *bias = nullptr) {
+  auto lhs_type = lhs->type()->expect<TensorType>();
+  auto rhs_type = rhs->type()->expect<TensorType>();
+  Node *node;
+  if (bias) {
+    node = graph.create(aten::addmm, {bias, lhs, rhs});
+    node->t_(attr::beta, at::Scalar(1).toTensor());
+    node->t_(attr::alpha, at::Scalar(1).toTensor());
+  } else {
+    node = graph.create(aten::mm, {lhs, rhs});
+  }
+  graph.appendNode(node);
+  node->output()->setType(std::make_shared<TensorType>(
+      lhs_type->scalarType(), lhs_type->device(),
+      at::IntList{lhs_type->sizes()[0], rhs_type->sizes()[1]}));
+  return node->output();
+}
+
+static Value* addTypedInput(Graph & graph, const at::Tensor & t) {
+  auto input = graph.addInput();
+  input->setType(std::make_shared<TensorType>(t));
+  return input;
+}
+
+static std::vector<at::Tensor> runGraph(std::shared_ptr<Graph> graph, std::vector<at::Tensor> stack) {
+  Code code(graph, /*values_are_variables=*/false);
+  InterpreterState interp(code);
+  interp.runOneStage(stack);
+  return stack;
+}
+
+static size_t countNodesOfKind(Graph & graph, NodeKind kind) {
+  size_t n = 0;
+  for(auto node : graph.nodes()) {
+    if(node->kind() == kind)
+      n++;
+  }
+  return n;
+}
+
+void testBatchMM() {
+  auto x = at::rand(at::CPU(at::kFloat), {4, 8});
+  auto y = at::rand(at::CPU(at::kFloat), {4, 8});
+  std::vector<at::Tensor> w, b;
+  for(int i = 0; i < 3; i++) {
+    w.push_back(at::rand(at::CPU(at::kFloat), {8, 5 + i}));
+    b.push_back(at::rand(at::CPU(at::kFloat), {5 + i}));
+  }
+  auto v = at::rand(at::CPU(at::kFloat), {8, 5});
+  auto c = at::rand(at::CPU(at::kFloat), {4, 5});
+
+  // three heads on x, concatenated into one addmm, and two mms of the same
+  // size, stacked into one bmm
+  auto graph = std::make_shared<Graph>();
+  std::vector<at::Tensor> inputs {x, y, v, c};
+  auto gx = addTypedInput(*graph, x);
+  auto gy = addTypedInput(*graph, y);
+  auto gv = addTypedInput(*graph, v);
+  auto gc = addTypedInput(*graph, c);
+  for(int i = 0; i < 3; i++) {
+    inputs.push_back(w[i]);
+    inputs.push_back(b[i]);
+    auto gw = addTypedInput(*graph, w[i]);
+    auto gb = addTypedInput(*graph, b[i]);
+    graph->registerOutput(appendMatMul(*graph, gx, gw, gb));
+  }
+  graph->registerOutput(appendMatMul(*graph, gy, gv, gc));
+  graph->registerOutput(appendMatMul(*graph, gx, gv, gc));
+  auto expected = runGraph(graph, inputs);
+
+  BatchMM(graph);
+  REQUIRE(countNodesOfKind(*graph, aten::addmm) == 1);
+  REQUIRE(countNodesOfKind(*graph, aten::baddbmm) == 1);
+  REQUIRE(countNodesOfKind(*graph, aten::narrow) == 3);
+  REQUIRE(countNodesOfKind(*graph, aten::select) == 2);
+  auto outputs = runGraph(graph, inputs);
+  REQUIRE(outputs.size() == expected.size());
+  for(size_t i = 0; i < outputs.size(); i++) {
+    REQUIRE(outputs[i].sizes().equals(expected[i].sizes()));
+    float max_diff = (outputs[i] - expected[i]).abs().max().toCDouble();
+    REQUIRE(max_diff < 1e-5);
+  }
+
+  // biases broadcast along the columns are not concatenated, but biases of
+  // the same sizes are still stacked
+  auto bias_rows = at::rand(at::CPU(at::kFloat), {4, 1});
+  auto bias_one = at::rand(at::CPU(at::kFloat), {1});
+  graph = std::make_shared<Graph>();
+  inputs = {x, v, bias_rows, bias_one};
+  gx = addTypedInput(*graph, x);
+  gv = addTypedInput(*graph, v);
+  auto gbias_rows = addTypedInput(*graph, bias_rows);
+  auto gbias_one = addTypedInput(*graph, bias_one);
+  for(int i = 0; i < 3; i++) {
+    inputs.push_back(w[i]);
+    auto gw = addTypedInput(*graph, w[i]);
+    graph->registerOutput(appendMatMul(*graph, gx, gw, gbias_rows));
+    graph->registerOutput(appendMatMul(*graph, gx, gw, gbias_one));
+  }
+  graph->registerOutput(appendMatMul(*graph, gx, gv, gbias_rows));
+  graph->registerOutput(appendMatMul(*graph, gx, gv, gbias_rows));
+  expected = runGraph(graph, inputs);
+  BatchMM(graph);
+  REQUIRE(countNodesOfKind(*graph, aten::narrow) == 0);
+  REQUIRE(countNodesOfKind(*graph, aten::baddbmm) == 1);
+  outputs = runGraph(graph, inputs);
+  REQUIRE(outputs.size() == expected.size());
+  for(size_t i = 0; i < outputs.size(); i++) {
+    REQUIRE(outputs[i].sizes().equals(expected[i].sizes()));
+    float max_diff = (outputs[i] - expected[i]).abs().max().toCDouble();
+    REQUIRE(max_diff < 1e-5);
+  }
+
+  // the second mm uses the output of the first one, and an in-place op
+  // writes to the lhs of the third one after the second one
+  auto u = at::rand(at::CPU(at::kFloat), {8, 8});
+  graph = std::make_shared<Graph>();
+  gx = addTypedInput(*graph, x);
+  gy = addTypedInput(*graph, y);
+  auto gu = addTypedInput(*graph, u);
+  graph->registerOutput(appendMatMul(*graph, appendMatMul(*graph, gx, gu), gu));
+  auto relu = graph->appendNode(graph->create(Symbol::aten("relu_"), {gy}));
+  relu->output()->setType(gy->type());
+  graph->registerOutput(relu->output());
+  graph->registerOutput(appendMatMul(*graph, gy, gu));
+  BatchMM(graph);
+  REQUIRE(countNodesOfKind(*graph, aten::mm) == 3);
+
+  // in-place dunder ops, e.g. y |= x, write to the lhs shared by two mms,
+  // unlike their out-of-place versions
+  auto v2 = at::rand(at::CPU(at::kFloat), {8, 5});
+  std::vector<std::pair<std::string, int>> dunder_ops {
+    {"__or__", 1}, {"__iand__", 2}, {"__ior__", 2}, {"__ixor__", 2},
+    {"__ilshift__", 2}, {"__irshift__", 2}};
+  for (auto & op : dunder_ops) {
+    graph = std::make_shared<Graph>();
+    gx = addTypedInput(*graph, x);
+    gy = addTypedInput(*graph, y);
+    gv = addTypedInput(*graph, v);
+    auto gv2 = addTypedInput(*graph, v2);
+    graph->registerOutput(appendMatMul(*graph, gy, gv));
+    auto dunder = graph->appendNode(graph->create(Symbol::aten(op.first), {gy, gx}));
+    dunder->output()->setType(gy->type());
+    graph->registerOutput(dunder->output());
+    graph->registerOutput(appendMatMul(*graph, gy, gv2));
+    BatchMM(graph);
+    REQUIRE(countNodesOfKind(*graph, aten::mm) == op.second);
+  }
+}
+
+const static auto bench_examples = R"JIT(
+  def small_ops(a, b):
+      c = a * b
+      d = c + a
+      e = d - b
+      f = e * c
+      return f + d
+  def count_loop(a, i):
+    while i < 1000:
+      a = a + i
+      i += 1
+    return a
+)JIT";
+
+// The best of several trials, so that numbers of different builds can be
+// compared on a machine that is not idle
+template<typename F>
+static double nanosecondsPerRun(int runs, F f) {
+  constexpr int trials = 5;
+  f(); // warm up
+  double best = std::numeric_limits<double>::infinity();
+  for(int trial = 0; trial < trials; trial++) {
+    auto start = std::chrono::steady_clock::now();
+    for(int i = 0; i < runs; i++) {
+      f();
+    }
+    auto end = std::chrono::steady_clock::now();
+    best = std::min(best, std::chrono::duration<double, std::nano>(end - start).count() / runs);
+  }
+  return best;
+}
+
+// Measures the time the interpreter spends per node, on graphs of ops on
+// single-element tensors, whose cost is mostly dispatch. The same ops are run
+// directly from C++ too, and the difference is the overhead of the
+// interpreter, including the creation of the InterpreterState.
+// It only uses the Code and InterpreterState interface, so it can be compared
+// with another interpreter by building this test against its interpreter.cpp.
+void interpreterBenchmark(std::ostream & out) {
+  script::Module cu;
+  script::defineMethodsInModule(cu, bench_examples, torch::jit::script::Resolver(), nullptr);
+  auto F = [](float f) { return at::Scalar(f).toTensor(); };
+  auto V = [](at::Tensor t) { return at::Scalar(t).toFloat(); };
+  auto countNodes = [](Graph & g) {
+    size_t n = 0;
+    for(auto node : g.nodes()) {
+      (void)node;
+      n++;
+    }
+    return n;
+  };
+  constexpr int runs = 10000;
+
+  auto small_ops = cu.get_method("small_ops").graph();
+  Code small_ops_code(small_ops, /*values_are_variables=*/false);
+  auto a = F(2), b = F(3);
+  std::vector<at::Tensor> stack;
+  double interp_ns = nanosecondsPerRun(runs, [&]() {
+    InterpreterState interp(small_ops_code);
+    stack = {a, b};
+    interp.runOneStage(stack);
+  });
+  REQUIRE(V(stack[0]) == 38);
+  double direct_ns = nanosecondsPerRun(runs, [&]() {
+    auto c = a * b;
+    auto d = c + a;
+    auto e = d - b;
+    auto f = e * c;
+    stack = {f + d};
+  });
+  size_t nodes = countNodes(*small_ops);
+  out << "small_ops: " << interp_ns << "ns per run, " << direct_ns << "ns direct, "
+      << (interp_ns - direct_ns) / nodes << "ns per node (" << nodes << " nodes)\n";
+
+  auto count_loop = cu.get_method("count_loop").graph();
+  Code count_loop_code(count_loop, /*values_are_variables=*/false);
+  auto zero = F(0), one = F(1), limit = F(1000);
+  interp_ns = nanosecondsPerRun(runs / 100, [&]() {
+    InterpreterState interp(count_loop_code);
+    stack = {zero, zero};
+    interp.runOneStage(stack);
+  });
+  REQUIRE(V(stack[0]) == 999 * 1000 / 2);
+  direct_ns = nanosecondsPerRun(runs / 100, [&]() {
+    auto x = zero;
+    auto i = zero;
+    while(V(i < limit)) {
+      x = x + i;
+      i = i + one;
+    }
+    stack = {x};
+  });
+  out << "count_loop: " << interp_ns / 1000 << "ns per iteration, "
+      << direct_ns / 1000 << "ns direct\n";
+}
+
+// Measures the inference time of small-matrix graphs, with several heads of
+// Linear layers on the same input and towers of the same sizes on different
+// inputs, before and after BatchMM batches their matmuls.
+void batchMMBenchmark(std::ostream & out) {
+  constexpr int runs = 1000;
+  for(int64_t rows : {1, 16}) {
+    for(int64_t features : {16, 64}) {
+      auto x = at::rand(at::CPU(at::kFloat), {rows, features});
+      auto graph = std::make_shared<Graph>();
+      std::vector<at::Tensor> inputs {x};
+      auto gx = addTypedInput(*graph, x);
+      for(int i = 0; i < 8; i++) {
+        auto w = at::rand(at::CPU(at::kFloat), {features, features});
+        auto b = at::rand(at::CPU(at::kFloat), {features});
+        inputs.push_back(w);
+        inputs.push_back(b);
+        graph->registerOutput(appendMatMul(*graph, gx, addTypedInput(*graph, w), addTypedInput(*graph, b)));
+      }
+      for(int i = 0; i < 8; i++) {
+        auto y = at::rand(at::CPU(at::kFloat), {rows, features});
+        auto w = at::rand(at::CPU(at::kFloat), {features, features});
+        inputs.push_back(y);
+        inputs.push_back(w);
+        graph->registerOutput(appendMatMul(*graph, addTypedInput(*graph, y), addTypedInput(*graph, w)));
+      }
+      Code code(graph, /*values_are_variables=*/false);
+      double unbatched_ns = nanosecondsPerRun(runs, [&]() {
+        InterpreterState interp(code);
+        std::vector<at::Tensor> stack = inputs;
+        interp.runOneStage(stack);
+      });
+      BatchMM(graph);
+      Code batched_code(graph, /*values_are_variables=*/false);
+      double batched_ns = nanosecondsPerRun(runs, [&]() {
+        InterpreterState interp(batched_code);
+        std::vector<at::Tensor> stack = inputs;
+        interp.runOneStage(stack);
+      });
+      out << "8 heads and 8 towers of " << rows << "x" << features << " by "
+          << features << "x" << features << ": " << unbatched_ns / 1000 << "us, "
+          << batched_ns / 1000 << "us batched\n";
+    }
+  }
+}
+
 #ifdef NO_PYTHON
 
+TEST_CASE( "jit interpreter benchmark", "[.][benchmark]" ) {
+  interpreterBenchmark(std::cout);
+}
+
+TEST_CASE( "jit batch mm benchmark", "[.][benchmark]" ) {
+  batchMMBenchmark(std::cout);
+}
+
 TEST_CASE( "jit test CPU", "[cpu]" ) {
 
   std::stringstream out;
@@ -907,6 +1287,10 @@ TEST_CASE( "jit test CPU", "[cpu]" ) {
     attributesTest();
   SECTION( "interned strings" )
     internedStringsTests();
+  SECTION( "CPU fusion" )
+    cpuFusionTests();
+  SECTION( "batch mm" )
+    testBatchMM();
 }
 
 TEST_CASE( "jit test CUDA", "[cuda]" ) {
@@ -940,6 +1324,8 @@ std::string runJITCPPTests() {
   interpStageTest();
   codeTemplateTest();
   fusionTests();
+  cpuFusionTests();
+  testBatchMM();
   attributesTest();
   internedStringsTests();
   fromQualStringTests();
@@ -322,7 +322,7 @@ def isnan(tensor):
     return tensor != tensor
 
 
-def unique(input, sorted=False, return_inverse=False):
+def unique(input, sorted=False, return_inverse=False, return_counts=False):
     r"""Returns the unique scalar elements of the input tensor as a 1-D tensor.
 
     Arguments:
@@ -331,16 +331,23 @@ def unique(input, sorted=False, return_inverse=False):
             before returning as output.
         return_inverse (bool): Whether to also return the indices for where
             elements in the original input ended up in the returned unique list.
+        return_counts (bool): Whether to also return the number of occurrences
+            of every unique element.
 
     Returns:
-        (Tensor, Tensor (optional)): A tensor or a tuple of tensors containing
+        (Tensor, Tensor (optional), Tensor (optional)): A tensor or a tuple of
+        tensors containing
 
             - **output** (*Tensor*): the output list of unique scalar elements.
             - **inverse_indices** (*Tensor*): (optional) if
-              :attr:`return_inverse` is True, there will be a
-              2nd returned tensor (same shape as input) representing the indices
+              :attr:`return_inverse` is True, there will be an
+              additional returned tensor (same shape as input) representing the indices
               for where elements in the original input map to in the output;
               otherwise, this function will only return a single tensor.
+            - **counts** (*Tensor*): (optional) if
+              :attr:`return_counts` is True, there will be an additional
+              returned tensor (same shape as output) representing the number
+              of occurrences of every unique element.
 
     Example::
 
@@ -384,6 +391,15 @@ def unique(input, sorted=False, return_inverse=False):
          1  2
         [torch.LongTensor of size (2,2)]
     """
+    if return_counts:
+        output, inverse_indices, counts = torch._C._VariableFunctions._unique_with_counts(
+            input,
+            sorted=sorted,
+            return_inverse=return_inverse,
+        )
+        if return_inverse:
+            return output, inverse_indices, counts
+        return output, counts
     output, inverse_indices = torch._C._VariableFunctions._unique(
         input,
         sorted=sorted,
@@ -3,6 +3,7 @@
 #include <sys/poll.h>
 #include <unistd.h>
 #include <algorithm>
+#include <array>
 #include <cstdint>
 #include <cstdlib>
 #include <cstring>
@@ -37,6 +38,11 @@ inline std::uint64_t pow2(T value) {
   return pof2;
 }
 
+// Messages of at least this size are all-reduced with the ring algorithm
+constexpr std::uint64_t RING_ALLREDUCE_MIN_BYTES = 1 << 18;
+// Size of the pieces in which the ring algorithm pipelines its chunks
+constexpr std::uint64_t RING_SEGMENT_BYTES = 1 << 17;
+
 } // namespace
 
 
@@ -362,20 +368,6 @@ void DataChannelTCP::scatter(std::vector<at::Tensor>& input,
 
 void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
                                THDGroup group_id) {
-  /*
-   * Allreduce implementation is recursive doubling algorithm. It is good
-   * algorithm for small sizes of message but other (theoratically better)
-   * implementations could not be addapted because of non-commutative
-   * operations on tensors (operation cannot be commutative because this could
-   * introduce different numerical errors on different workers).
-   *
-   * More about efficiency can be found here:
-   *   > http://www.mcs.anl.gov/~thakur/papers/ijhpca-coll.pdf (section 4.5)
-   *
-   * Implementation is based on:
-   *   > https://github.com/pmodels/mpich/blob/master/src/mpi/coll/allreduce.c
-   */
-
   std::lock_guard<std::mutex> lock(_mutex);
 
   const auto& group = _groups.at(group_id);
@@ -386,8 +378,43 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
   if (!exists)
     return;
 
+  // Algorithm has to be chosen from values that are equal on all processes,
+  // otherwise they would run different protocols and deadlock
+  std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
+  if (tensor_bytes >= RING_ALLREDUCE_MIN_BYTES &&
+      static_cast<std::uint64_t>(data.numel()) >= group.size()) {
+    if (data.is_contiguous()) {
+      _allReduceRing(data, operation, group, group_rank);
+    } else {
+      auto contig_data = data.contiguous();
+      _allReduceRing(contig_data, operation, group, group_rank);
+      data.copy_(contig_data);
+    }
+  } else {
+    _allReduceRecursiveDoubling(data, operation, group, group_rank);
+  }
+}
+
+
+void DataChannelTCP::_allReduceRecursiveDoubling(at::Tensor& data,
+                                                 THDReduceOp operation,
+                                                 const DataChannel::Group& group,
+                                                 rank_type group_rank) {
+  /*
+   * Allreduce implementation is recursive doubling algorithm. It is good
+   * algorithm for small sizes of message because it needs only log(p) steps,
+   * but every step sends the whole tensor. Large messages go through
+   * `_allReduceRing` instead.
+   *
+   * More about efficiency can be found here:
+   *   > http://www.mcs.anl.gov/~thakur/papers/ijhpca-coll.pdf (section 4.5)
+   *
+   * Implementation is based on:
+   *   > https://github.com/pmodels/mpich/blob/master/src/mpi/coll/allreduce.c
+   */
+
   std::uint64_t tensor_bytes = data.type().elementSizeInBytes() * data.numel();
-  auto tmp_tensor = data.clone();
+  auto tmp_tensor = _getScratch(data, data.numel()).view(data.sizes());
 
   auto pof2 = pow2(group.size());
   int rem = group.size() - pof2;
@@ -438,6 +465,152 @@ void DataChannelTCP::allReduce(at::Tensor& data, THDReduceOp operation,
 }
 
 
+void DataChannelTCP::_allReduceRing(at::Tensor& data, THDReduceOp operation,
+                                    const DataChannel::Group& group,
+                                    rank_type group_rank) {
+  /*
+   * Ring allreduce: reduce-scatter followed by allgather, both done as ring
+   * algorithms. Tensor is split into `p` chunks and every process sends
+   * and receives 2 * (p - 1) / p of the tensor in total, independently of
+   * the number of processes.
+   *
+   * During reduce-scatter, in step `i` process `r` sends chunk (r - i) to
+   * its right neighbour and reduces chunk (r - i - 1) received from its left
+   * neighbour. After p - 1 steps process `r` owns fully reduced chunk
+   * (r + 1), which is then passed around the ring in allgather. Every chunk
+   * is reduced on exactly one process and copied to the others, so results
+   * are bitwise identical on all processes.
+   *
+   * Chunks are split into segments of at most RING_SEGMENT_BYTES which are
+   * pipelined: a segment is forwarded as soon as it is reduced, and the next
+   * segment is received into the second half of the scratch buffer while
+   * the current one is reduced.
+   *
+   * More about efficiency can be found here:
+   *   > http://www.mcs.anl.gov/~thakur/papers/ijhpca-coll.pdf (section 4.5)
+   */
+
+  auto size = group.size();
+  auto left = group.mustGetGlobalRank((size + group_rank - 1) % size);
+  auto right = group.mustGetGlobalRank((group_rank + 1) % size);
+
+  auto flat = data.view({data.numel()});
+  std::int64_t numel = flat.numel();
+  std::int64_t segment_numel = std::max<std::int64_t>(
+      RING_SEGMENT_BYTES / data.type().elementSizeInBytes(), 1);
+
+  auto chunk_begin = [numel, size](rank_type chunk) -> std::int64_t {
+    return numel / size * chunk + std::min<std::int64_t>(chunk, numel % size);
+  };
+  // Appends segments of `chunk` to `segments` as (offset, length) pairs
+  auto add_segments = [&](rank_type chunk,
+                          std::vector<std::pair<std::int64_t, std::int64_t>>& segments) {
+    auto begin = chunk_begin(chunk), end = chunk_begin(chunk + 1);
+    for (auto offset = begin; offset < end; offset += segment_numel)
+      segments.emplace_back(offset, std::min(segment_numel, end - offset));
+  };
+
+  std::vector<req_ptr> send_requests;
+  auto send_segment = [&](const std::pair<std::int64_t, std::int64_t>& segment) {
+    auto tensor = flat.narrow(0, segment.first, segment.second);
+    send_requests.emplace_back(isend(tensor, right));
+  };
+  auto wait_sends = [&send_requests]() {
+    for (auto& request : send_requests)
+      request->wait();
+    send_requests.clear();
+  };
+
+  // Reduce-scatter
+  std::vector<std::pair<std::int64_t, std::int64_t>> segments;
+  add_segments(group_rank, segments);
+  for (const auto& segment : segments)
+    send_segment(segment);
+
+  // Segments to receive, in order of all steps
+  segments.clear();
+  std::vector<std::size_t> step_end;
+  for (rank_type k = 0; k < size - 1; ++k) {
+    add_segments((size + group_rank - k - 1) % size, segments);
+    step_end.push_back(segments.size());
+  }
+
+  auto scratch = _getScratch(data, 2 * segment_numel);
+  std::array<at::Tensor, 2> buffers = {{
+    scratch.narrow(0, 0, segment_numel),
+    scratch.narrow(0, segment_numel, segment_numel)
+  }};
+  auto receive_segment = [&](std::size_t i) {
+    auto tensor = buffers[i % 2].narrow(0, 0, segments[i].second);
+    return req_ptr(ireceive(tensor, left));
+  };
+
+  req_ptr recv_request = receive_segment(0);
+  rank_type step = 0;
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    req_ptr next_recv_request;
+    if (i + 1 < segments.size())
+      next_recv_request = receive_segment(i + 1);
+    recv_request->wait();
+
+    auto result = flat.narrow(0, segments[i].first, segments[i].second);
+    auto incoming = buffers[i % 2].narrow(0, 0, segments[i].second);
+    _reduce(result, incoming, operation);
+
+    while (i >= step_end[step])
+      ++step;
+    // Reduced segment is sent in the next step, unless this is the last one
+    if (step + 1 < size - 1)
+      send_segment(segments[i]);
+
+    recv_request = std::move(next_recv_request);
+  }
+  // Chunks sent so far are overwritten during allgather
+  wait_sends();
+
+  // Allgather
+  segments.clear();
+  add_segments((group_rank + 1) % size, segments);
+  for (const auto& segment : segments)
+    send_segment(segment);
+
+  segments.clear();
+  step_end.clear();
+  for (rank_type k = 0; k < size - 1; ++k) {
+    add_segments((size + group_rank - k) % size, segments);
+    step_end.push_back(segments.size());
+  }
+
+  // Received chunks are disjoint, so all receives can be queued at once
+  std::vector<req_ptr> recv_requests;
+  recv_requests.reserve(segments.size());
+  for (const auto& segment : segments) {
+    auto tensor = flat.narrow(0, segment.first, segment.second);
+    recv_requests.emplace_back(ireceive(tensor, left));
+  }
+
+  step = 0;
+  for (std::size_t i = 0; i < segments.size(); ++i) {
+    recv_requests[i]->wait();
+    while (i >= step_end[step])
+      ++step;
+    if (step + 1 < size - 1)
+      send_segment(segments[i]);
+  }
+  wait_sends();
+}
+
+
+at::Tensor DataChannelTCP::_getScratch(const at::Tensor& data,
+                                       std::int64_t numel) {
+  if (!_scratch.defined() || &_scratch.type() != &data.type() ||
+      _scratch.numel() < numel) {
+    _scratch = data.type().tensor({numel});
+  }
+  return _scratch.narrow(0, 0, numel);
+}
+
+
 void DataChannelTCP::reduce(at::Tensor& data, THDReduceOp operation,
                             rank_type dst_rank, THDGroup group_id) {
   /*
@@ -93,6 +93,12 @@ private:
   void _receive(const at::Tensor& data, rank_type src_id);
   void _reduce(at::Tensor& result, at::Tensor& data,
                THDReduceOp operation) const;
+  void _allReduceRecursiveDoubling(at::Tensor& data, THDReduceOp operation,
+                                   const DataChannel::Group& group,
+                                   rank_type group_rank);
+  void _allReduceRing(at::Tensor& data, THDReduceOp operation,
+                      const DataChannel::Group& group, rank_type group_rank);
+  at::Tensor _getScratch(const at::Tensor& data, std::int64_t numel);
 
 
   rank_type _rank; // Rank of current process, range: [0.._processes.size()-1]
@@ -112,6 +118,9 @@ private:
   // Workers
   QueueWorker _send_worker, _receive_worker;
 
+  // Scratch buffer for incoming data in `allReduce`, reused between calls
+  at::Tensor _scratch;
+
 };
 
 } // namespace thd
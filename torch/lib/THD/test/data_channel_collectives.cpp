@@ -121,13 +121,14 @@ void test_reduce(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
 }
 
 void _test_allReduce_helper(std::shared_ptr<thd::DataChannel> data_channel,
-                            THDReduceOp op_type, int64_t init_value, int64_t expected_value) {
+                            THDReduceOp op_type, int64_t init_value, int64_t expected_value,
+                            std::vector<int64_t> shape = {1, 2, 3, 4, 5, 6, 7, 100}) {
   if (data_channel->getRank() == 0) {
-    auto int_tensor = buildTensor<int>({1, 2, 3, 4, 5, 6, 7, 100}, init_value);
+    auto int_tensor = buildTensor<int>(shape, init_value);
     data_channel->allReduce(*int_tensor, op_type, 0);
     ASSERT_TENSOR_VALUE(int, *int_tensor, expected_value)
   } else {
-    auto int_tensor = buildTensor<int>({1, 2, 3, 4, 5, 6, 7, 100}, data_channel->getRank());
+    auto int_tensor = buildTensor<int>(shape, data_channel->getRank());
     data_channel->allReduce(*int_tensor, op_type, 0);
     ASSERT_TENSOR_VALUE(int, *int_tensor, expected_value)
   }
@@ -143,6 +144,17 @@ void test_allReduce(std::shared_ptr<thd::DataChannel> data_channel, int workers)
                          -1, data_channel->getNumProcesses() - 1);
 }
 
+// Large enough for DataChannelTCP to use the ring algorithm, with a size
+// that does not divide evenly into chunks and segments
+void test_allReduce_large(std::shared_ptr<thd::DataChannel> data_channel, int workers) {
+  std::vector<int64_t> shape = {3, 100003};
+  _test_allReduce_helper(data_channel, THDReduceOp::THDReduceSUM,
+                         2, 2 + (workers * (workers + 1) / 2), shape);
+  _test_allReduce_helper(data_channel, THDReduceOp::THDReduceMIN, 10010, 1, shape);
+  _test_allReduce_helper(data_channel, THDReduceOp::THDReduceMAX,
+                         -1, data_channel->getNumProcesses() - 1, shape);
+}
+
 void test_scatter(std::shared_ptr<thd::DataChannel> data_channel) {
   if (g_data_channel_type == "gloo") {
     return; // XXX: Gloo does not support scatter
@@ -618,6 +630,7 @@ void run_all_tests(std::shared_ptr<thd::DataChannel> data_channel, int workers)
   test_broadcast(data_channel);
   test_reduce(data_channel, workers);
   test_allReduce(data_channel, workers);
+  test_allReduce_large(data_channel, workers);
   test_scatter(data_channel);
   test_gather(data_channel);
   test_allGather(data_channel);
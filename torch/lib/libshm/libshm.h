@@ -20,4 +20,29 @@ EXPORT_API void libshm_context_free(libshm_context *context);
 
 extern THAllocator THManagedSharedAllocator;
 
+// Storages carved from a shared memory slab that is mapped once per process,
+// see slab.cpp. A process creates the slab that it allocates from with
+// libshm_slab_init(); libshm_slab_region_new() then returns NULL if the
+// process has no slab, or when the slab has no room left.
+typedef struct libshm_slab_region libshm_slab_region;
+
+EXPORT_API void libshm_slab_init(ptrdiff_t segment_size, int num_segments);
+// Drops the reference of this process to the slab it allocates from, which
+// is unmapped, and unlinked once no process uses it, when the storages in it
+// are freed
+EXPORT_API void libshm_slab_close();
+// Drops the mappings of the slabs created by process pid, which stay mapped
+// until the storages in them are freed
+EXPORT_API void libshm_slab_release_process(int pid);
+EXPORT_API libshm_slab_region * libshm_slab_region_new(ptrdiff_t size);
+EXPORT_API libshm_slab_region * libshm_slab_region_open(const char *manager_handle, const char *filename, ptrdiff_t slab_size, ptrdiff_t offset, ptrdiff_t size);
+EXPORT_API void * libshm_slab_region_data(libshm_slab_region *region);
+EXPORT_API void libshm_slab_region_info(libshm_slab_region *region, const char **manager_handle, const char **filename, ptrdiff_t *slab_size, ptrdiff_t *offset);
+// References held by regions in flight between two processes
+EXPORT_API void libshm_slab_region_incref(libshm_slab_region *region);
+EXPORT_API void libshm_slab_region_decref(libshm_slab_region *region);
+
+// Frees the region given as context
+extern THAllocator THSlabSharedAllocator;
+
 #endif
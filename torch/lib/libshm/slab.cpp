@@ -0,0 +1,310 @@
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <pthread.h>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <unistd.h>
+
+#include <TH/TH.h>
+#include "libshm.h"
+
+// A slab is a single shared memory segment which a process maps once and
+// carves storages from, so that sending a storage to another process costs
+// no shm_open, mmap or file descriptor passing: the receiver maps the slab
+// the first time it sees it, and afterwards only gets offsets into it.
+//
+// The data of the slab is split into a ring of equal segments. The producer
+// allocates regions one after another in the current segment. When it is
+// full, the producer starts it again if all its regions were freed, so that
+// a consumer that keeps up only ever touches one segment, and otherwise moves
+// to the next free segment of the ring. Every segment has a count of
+// the storages, in any process, that use one of its regions, and of the
+// regions that are in flight between two processes. The count lives in the
+// slab itself, and a segment is only reused once it drops to zero, i.e. once
+// the storages of the receivers are freed.
+
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2,
+              "slab counters must be lock free to live in shared memory");
+
+static const uint64_t SLAB_MAGIC = 0x62616c736d687374; // "tshmslab"
+static const uint64_t SLAB_ALIGNMENT = 64;
+
+struct SlabHeader {
+  uint64_t magic;
+  uint64_t segment_size;
+  uint64_t num_segments;
+  uint64_t data_offset;
+};
+
+// Each count is on its own cache line
+struct SlabCounter {
+  std::atomic<int64_t> live;
+  char padding[SLAB_ALIGNMENT - sizeof(std::atomic<int64_t>)];
+};
+
+struct libshm_slab {
+  libshm_context *ctx;
+  std::string manager_handle;
+  std::string filename;
+  char *base;
+  uint64_t size;
+  SlabHeader *header;
+  SlabCounter *counters;
+  // The regions of this process that use the slab, and the reference of the
+  // process slab or of the cache of opened slabs
+  std::atomic<int64_t> refcount;
+  // The allocation position of the process that owns the slab
+  uint64_t segment;
+  uint64_t used;
+  // The process that mapped the slab. A child inherits the mappings of its
+  // parent on fork, but not their references in the mapping refcount.
+  pid_t pid;
+};
+
+struct libshm_slab_region {
+  libshm_slab *slab;
+  uint64_t segment;
+  uint64_t offset;
+};
+
+// Guards the slabs below, and the allocation from the process slab
+static std::mutex slabs_mutex;
+// The slab that this process allocates from, if any
+static libshm_slab *process_slab = nullptr;
+// The slabs of other processes that this process received regions of
+static std::unordered_map<std::string, libshm_slab*> opened_slabs;
+
+// A fork while another thread, e.g. the pin memory thread of a DataLoader,
+// holds slabs_mutex would leave it locked forever in the child, so it is held
+// across fork() and released on both sides.
+static void slabs_prepare_fork() {
+  slabs_mutex.lock();
+}
+
+static void slabs_after_fork() {
+  slabs_mutex.unlock();
+}
+
+static const int slabs_atfork_registered =
+    pthread_atfork(slabs_prepare_fork, slabs_after_fork, slabs_after_fork);
+
+static uint64_t round_up(uint64_t size) {
+  return (size + SLAB_ALIGNMENT - 1) / SLAB_ALIGNMENT * SLAB_ALIGNMENT;
+}
+
+// The prefix of the handles of the slabs created by process pid
+static std::string slab_handle_prefix(int pid) {
+  std::string prefix = "/torch_slab_";
+  prefix += std::to_string(pid);
+  prefix += "_";
+  return prefix;
+}
+
+static std::string new_slab_handle() {
+  static std::atomic<int> counter(0);
+  std::random_device rd;
+  std::string handle = slab_handle_prefix(getpid());
+  handle += std::to_string(counter++);
+  handle += "_";
+  handle += std::to_string(rd());
+  return handle;
+}
+
+static libshm_slab * map_slab(const char *manager_handle, const char *filename,
+    uint64_t size, int flags) {
+  libshm_slab *slab = new libshm_slab();
+  slab->ctx = libshm_context_new(manager_handle, filename, flags);
+  slab->base = (char*)THManagedSharedAllocator.malloc(slab->ctx, size);
+  slab->manager_handle = slab->ctx->manager_handle;
+  slab->filename = filename;
+  slab->size = size;
+  slab->header = (SlabHeader*)slab->base;
+  slab->counters = (SlabCounter*)(slab->base + SLAB_ALIGNMENT);
+  slab->refcount = 1;
+  slab->segment = 0;
+  slab->used = 0;
+  slab->pid = getpid();
+  return slab;
+}
+
+static void slab_decref(libshm_slab *slab) {
+  if (--slab->refcount == 0) {
+    // Also frees the context
+    THManagedSharedAllocator.free(slab->ctx, slab->base);
+    delete slab;
+  }
+}
+
+void libshm_slab_init(ptrdiff_t segment_size, int num_segments) {
+  if (segment_size <= 0 || num_segments <= 0) {
+    THError("invalid slab of %d segments of %td bytes", num_segments, segment_size);
+  }
+  uint64_t data_offset = SLAB_ALIGNMENT + num_segments * sizeof(SlabCounter);
+  segment_size = round_up(segment_size);
+  uint64_t size = data_offset + num_segments * segment_size;
+
+  std::string handle = new_slab_handle();
+  int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_EXCLUSIVE;
+  libshm_slab *slab = map_slab(NULL, handle.c_str(), size, flags);
+  slab->header->magic = SLAB_MAGIC;
+  slab->header->segment_size = segment_size;
+  slab->header->num_segments = num_segments;
+  slab->header->data_offset = data_offset;
+  for (int i = 0; i < num_segments; i++) {
+    new (&slab->counters[i].live) std::atomic<int64_t>(0);
+  }
+
+  std::lock_guard<std::mutex> lock(slabs_mutex);
+  // A slab inherited from the parent is left to it
+  if (process_slab && process_slab->pid == getpid()) {
+    slab_decref(process_slab);
+  }
+  process_slab = slab;
+}
+
+void libshm_slab_close() {
+  std::lock_guard<std::mutex> lock(slabs_mutex);
+  if (process_slab && process_slab->pid == getpid()) {
+    slab_decref(process_slab);
+  }
+  process_slab = nullptr;
+}
+
+void libshm_slab_release_process(int pid) {
+  std::string prefix = slab_handle_prefix(pid);
+  std::lock_guard<std::mutex> lock(slabs_mutex);
+  for (auto it = opened_slabs.begin(); it != opened_slabs.end();) {
+    if (it->first.compare(0, prefix.size(), prefix) == 0) {
+      slab_decref(it->second);
+      it = opened_slabs.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+libshm_slab_region * libshm_slab_region_new(ptrdiff_t size) {
+  std::lock_guard<std::mutex> lock(slabs_mutex);
+  libshm_slab *slab = process_slab;
+  if (!slab || slab->pid != getpid() || size <= 0) {
+    return nullptr;
+  }
+
+  const SlabHeader &header = *slab->header;
+  uint64_t nbytes = round_up(size);
+  if (nbytes > header.segment_size) {
+    return nullptr;
+  }
+  if (slab->used + nbytes > header.segment_size) {
+    // Start the current segment again if all its regions were freed, or move
+    // to the next free one
+    bool found = false;
+    for (uint64_t i = 0; i < header.num_segments; i++) {
+      uint64_t next = (slab->segment + i) % header.num_segments;
+      if (slab->counters[next].live.load(std::memory_order_acquire) == 0) {
+        slab->segment = next;
+        slab->used = 0;
+        found = true;
+        break;
+      }
+    }
+    if (!found) {
+      return nullptr;
+    }
+  }
+
+  libshm_slab_region *region = new libshm_slab_region();
+  region->slab = slab;
+  region->segment = slab->segment;
+  region->offset = header.data_offset + slab->segment * header.segment_size +
+      slab->used;
+  slab->used += nbytes;
+  slab->counters[region->segment].live.fetch_add(1, std::memory_order_relaxed);
+  slab->refcount++;
+  return region;
+}
+
+libshm_slab_region * libshm_slab_region_open(const char *manager_handle,
+    const char *filename, ptrdiff_t slab_size, ptrdiff_t offset, ptrdiff_t size) {
+  libshm_slab *slab;
+  {
+    std::lock_guard<std::mutex> lock(slabs_mutex);
+    auto it = opened_slabs.find(filename);
+    if (it != opened_slabs.end()) {
+      slab = it->second;
+    } else if (process_slab && process_slab->filename == filename) {
+      slab = process_slab;
+    } else {
+      int flags = TH_ALLOCATOR_MAPPED_SHAREDMEM | TH_ALLOCATOR_MAPPED_NOCREATE;
+      slab = map_slab(manager_handle, filename, slab_size, flags);
+      if (slab->header->magic != SLAB_MAGIC) {
+        slab_decref(slab);
+        THError("<%s> is not a shared memory slab", filename);
+      }
+      opened_slabs.emplace(filename, slab);
+    }
+    slab->refcount++;
+  }
+
+  const SlabHeader &header = *slab->header;
+  if (offset < (ptrdiff_t)header.data_offset || size < 0 ||
+      (uint64_t)(offset + size) > slab->size) {
+    slab_decref(slab);
+    THError("region of %td bytes at %td is out of slab <%s>", size, offset, filename);
+  }
+  libshm_slab_region *region = new libshm_slab_region();
+  region->slab = slab;
+  region->segment = (offset - header.data_offset) / header.segment_size;
+  region->offset = offset;
+  slab->counters[region->segment].live.fetch_add(1, std::memory_order_relaxed);
+  return region;
+}
+
+void * libshm_slab_region_data(libshm_slab_region *region) {
+  return region->slab->base + region->offset;
+}
+
+void libshm_slab_region_info(libshm_slab_region *region,
+    const char **manager_handle, const char **filename, ptrdiff_t *slab_size,
+    ptrdiff_t *offset) {
+  *manager_handle = region->slab->manager_handle.c_str();
+  *filename = region->slab->filename.c_str();
+  *slab_size = region->slab->size;
+  *offset = region->offset;
+}
+
+void libshm_slab_region_incref(libshm_slab_region *region) {
+  region->slab->counters[region->segment].live.fetch_add(1, std::memory_order_relaxed);
+}
+
+void libshm_slab_region_decref(libshm_slab_region *region) {
+  region->slab->counters[region->segment].live.fetch_sub(1, std::memory_order_release);
+}
+
+static void * slab_malloc(void *ctx, ptrdiff_t size) {
+  THError("slab regions are allocated with libshm_slab_region_new");
+  return NULL;
+}
+
+static void * slab_realloc(void *ctx, void *data, ptrdiff_t size) {
+  THError("cannot realloc a slab region");
+  return NULL;
+}
+
+static void slab_free(void *ctx, void *data) {
+  auto *region = (libshm_slab_region*)ctx;
+  libshm_slab *slab = region->slab;
+  libshm_slab_region_decref(region);
+  delete region;
+  slab_decref(slab);
+}
+
+THAllocator THSlabSharedAllocator = {
+  slab_malloc,
+  slab_realloc,
+  slab_free,
+};
@@ -88,6 +88,15 @@ def rebuild_storage_filename(cls, manager, handle, size):
     return storage._shared_decref()
 
 
+def rebuild_storage_slab(cls, manager, handle, slab_size, offset, size):
+    storage = storage_from_cache(cls, (handle, offset))
+    if storage is not None:
+        return storage._shared_decref()
+    storage = cls._new_shared_slab(manager, handle, slab_size, offset, size)
+    shared_cache[(handle, offset)] = storage._weak_ref(StorageRef)
+    return storage._shared_decref()
+
+
 def rebuild_storage_cuda(cls, device, handle, size, offset, view_size):
     storage = storage_from_cache(cls, handle)
     if storage is not None:
@@ -104,10 +113,18 @@ def rebuild_storage_empty(cls):
 
 def reduce_storage(storage):
     from . import get_sharing_strategy
+    # Storages allocated in a shared memory slab are sent by offset in the
+    # slab, whatever the sharing strategy
+    slab_metadata = None if storage.is_cuda else storage._share_slab_()
     if storage.is_cuda:
         metadata = storage._share_cuda_()
         cache_key = metadata[1]
         rebuild = rebuild_storage_cuda
+    elif slab_metadata is not None:
+        metadata = slab_metadata
+        cache_key = (metadata[1], metadata[3])
+        rebuild = rebuild_storage_slab
+        storage._shared_incref()
     elif get_sharing_strategy() == 'file_system':
         metadata = storage._share_filename_()
         cache_key = metadata[1]
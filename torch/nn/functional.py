@@ -1088,13 +1088,15 @@ def embedding(input, weight, padding_idx=None, max_norm=None, norm_type=2,
 
 
 def embedding_bag(embedding_matrix, indices, offsets=None,
-                  max_norm=None, norm_type=2, scale_grad_by_freq=False, mode='mean', sparse=False):
-    r"""Computes sums or means of 'bags' of embeddings, without instantiating the
+                  max_norm=None, norm_type=2, scale_grad_by_freq=False, mode='mean', sparse=False,
+                  per_sample_weights=None):
+    r"""Computes sums, means or maxes of 'bags' of embeddings, without instantiating the
         intermediate embeddings.
 
         For bags of constant length,
             * embedding_bag with `mode=sum` is equivalent to nn.functional.embedding followed by `torch.sum(dim=1)`
             * with `mode=mean` is equivalent to nn.functional.embedding followed by `torch.mean(dim=1)`
+            * with `mode=max` is equivalent to nn.functional.embedding followed by `torch.max(dim=1)`
 
         However, embedding_bag is much more time and memory efficient than using a chain of these
         operations.
@@ -1112,9 +1114,13 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
             norm_type (float, optional): The p of the p-norm to compute for the max_norm option
             scale_grad_by_freq (boolean, optional): if given, this will scale gradients by the frequency of
                                                     the words in the dictionary.
-            mode (string, optional): 'sum' | 'mean'. Specifies the way to reduce the bag. Default: 'mean'
+            mode (string, optional): 'sum' | 'mean' | 'max'. Specifies the way to reduce the bag. Default: 'mean'.
+                                     On CPU an empty bag gives zeros in every mode, including 'mean'.
             sparse (boolean, optional): if ``True``, gradient w.r.t. weight matrix will be a sparse tensor. See Notes
-                                        for more details regarding sparse gradients.
+                                        for more details regarding sparse gradients. Not supported for `mode='max'`.
+            per_sample_weights (Tensor, optional): a Tensor of the same shape as `indices` holding a weight
+                                                   for every index; the embeddings are scaled by these weights
+                                                   before being summed. Only supported for `mode='sum'`.
 
         Shape:
             - Embedding_matrix: FloatTensor `(V, embedding_dim)`,
@@ -1126,6 +1132,7 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
                        offsets in `input` for each bag, i.e. the cumsum of lengths.
                        Offsets is not given if Input is 2D `BxN` Tensor,
                        the input is considered to be of fixed-length sequences
+            - Per_sample_weights: same shape as Input
             - Output: `(B, embedding_dim)`
 
         Examples::
@@ -1152,6 +1159,8 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
             offsets = Variable(torch.arange(0, indices.numel(), indices.size(1),
                                             out=indices.data.new().long()))
             indices = indices.view(-1)
+            if per_sample_weights is not None:
+                per_sample_weights = per_sample_weights.contiguous().view(-1)
     elif indices.dim() == 1:
         if offsets is None:
             raise ValueError("offsets has to be a 1D Tensor but got None")
@@ -1173,20 +1182,33 @@ def embedding_bag(embedding_matrix, indices, offsets=None,
         mode = 0
     elif mode == 'mean':
         mode = 1
+    elif mode == 'max':
+        mode = 2
+        if sparse:
+            raise ValueError("sparse gradients are not supported for mode='max'")
     else:
-        raise ValueError("mode has to be one of sum or mean")
+        raise ValueError("mode has to be one of sum, mean or max")
+
+    if per_sample_weights is not None:
+        if mode != 0:
+            raise ValueError("per_sample_weights are only supported for mode='sum'")
+        if per_sample_weights.size() != indices.size():
+            raise ValueError("per_sample_weights has to be of the same shape as input"
+                             " ({}), but got shape {}"
+                             .format(tuple(indices.size()), tuple(per_sample_weights.size())))
 
     if max_norm is not None:
         with torch.no_grad():
             torch.embedding_renorm_(weight, input, max_norm, norm_type)
 
-    ret, _, _ = torch.embedding_bag(
+    ret, _, _, _ = torch.embedding_bag(
         embedding_matrix,
         indices,
         offsets,
         scale_grad_by_freq,
         mode,
-        sparse)
+        sparse,
+        per_sample_weights)
     return ret
 
 
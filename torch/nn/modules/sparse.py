@@ -160,12 +160,13 @@ class Embedding(Module):
 
 
 class EmbeddingBag(Module):
-    r"""Computes sums or means of 'bags' of embeddings, without instantiating the
+    r"""Computes sums, means or maxes of 'bags' of embeddings, without instantiating the
     intermediate embeddings.
 
     For bags of constant length,
         * nn.EmbeddingBag with `mode=sum` is equivalent to nn.Embedding followed by `torch.sum(dim=1)`
         * with `mode=mean` is equivalent to nn.Embedding followed by `torch.mean(dim=1)`
+        * with `mode=max` is equivalent to nn.Embedding followed by `torch.max(dim=1)`
 
     However, nn.EmbeddingBag is much more time and memory efficient than using a chain of these
     operations.
@@ -177,14 +178,15 @@ class EmbeddingBag(Module):
         norm_type (float, optional): The p of the p-norm to compute for the max_norm option
         scale_grad_by_freq (bool, optional): if given, this will scale gradients by the frequency of
                                                 the words in the dictionary.
-        mode (string, optional): 'sum' | 'mean'. Specifies the way to reduce the bag. Default: 'mean'
+        mode (string, optional): 'sum' | 'mean' | 'max'. Specifies the way to reduce the bag. Default: 'mean'.
+                                 On CPU an empty bag gives zeros in every mode, including 'mean'.
         sparse (bool, optional): if ``True``, gradient w.r.t. weight matrix will be a sparse tensor. See Notes for
-                                    more details regarding sparse gradients.
+                                    more details regarding sparse gradients. Not supported for `mode='max'`.
 
     Attributes:
         weight (Tensor): the learnable weights of the module of shape (num_embeddings, embedding_dim)
 
-    Inputs: input, offsets
+    Inputs: input, offsets, per_sample_weights
         - **input** (``N`` or ``B x N``): LongTensor containing the indices of the embeddings
                                 to extract. When `input` is 1D Tensor of shape `N`,
                                 an `offsets` Tensor is given, that contains the
@@ -196,7 +198,10 @@ class EmbeddingBag(Module):
                                    does not need to be given, as the `input` is
                                    treated as a mini-batch of fixed length sequences
                                    of length `N` each.
-
+        - **per_sample_weights** (``N`` or ``B x N`` or ``None``): Tensor of the same shape as
+                                   `input` holding a weight for every index, by which
+                                   the embeddings are scaled before being summed.
+                                   Only supported for `mode='sum'`.
 
     Shape:
         - Input: LongTensor `N`, N = number of embeddings to extract
@@ -241,10 +246,11 @@ class EmbeddingBag(Module):
     def reset_parameters(self):
         self.weight.data.normal_(0, 1)
 
-    def forward(self, input, offsets=None):
+    def forward(self, input, offsets=None, per_sample_weights=None):
         return F.embedding_bag(self.weight, input, offsets,
                                self.max_norm, self.norm_type,
-                               self.scale_grad_by_freq, self.mode, self.sparse)
+                               self.scale_grad_by_freq, self.mode, self.sparse,
+                               per_sample_weights)
 
     def extra_repr(self):
         s = '{num_embeddings}, {embedding_dim}'
@@ -248,13 +248,15 @@ def embedding_bag(g,
                   offsets,
                   scale_grad_by_freq,
                   mode,
-                  sparse):
+                  sparse,
+                  per_sample_weights=None):
+    inputs = [embedding_matrix, indices, offsets]
+    if per_sample_weights is not None:
+        inputs.append(per_sample_weights)
     return g.op("ATen",
-                embedding_matrix,
-                indices,
-                offsets,
+                *inputs,
                 operator_s="embedding_bag",
-                outputs=3,
+                outputs=4,
                 scale_grad_by_freq_i=scale_grad_by_freq,
                 mode_i=mode,
                 sparse_i=sparse)
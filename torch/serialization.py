@@ -8,15 +8,18 @@ import sys
 import torch
 import tarfile
 import tempfile
+import threading
 import warnings
 from contextlib import closing, contextmanager
 from ._utils import _import_dotted_name
 from ._six import string_classes as _string_classes
 if sys.version_info[0] == 2:
     import cPickle as pickle
+    import Queue as queue
 else:
     import pickle
     import pathlib
+    import queue
 
 DEFAULT_PROTOCOL = 2
 
@@ -161,7 +164,109 @@ def save(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
     return _with_file_like(f, "wb", lambda f: _save(obj, f, pickle_module, pickle_protocol))
 
 
+class SaveFuture(object):
+    """The completion of a :func:`save_async`."""
+
+    def __init__(self):
+        self._event = threading.Event()
+        self._exception = None
+
+    def done(self):
+        """Returns whether the file is completely written, or failed."""
+        return self._event.is_set()
+
+    def wait(self, timeout=None):
+        """Waits until the file is written, and raises the error of the writer
+        if it failed. Returns False if the timeout expired first."""
+        if not self._event.wait(timeout):
+            return False
+        if self._exception is not None:
+            raise self._exception
+        return True
+
+
+def _snapshot_storage(storage):
+    if storage.is_cuda:
+        return storage.cpu()
+    return storage.clone()
+
+
+def save_async(obj, f, pickle_module=pickle, pickle_protocol=DEFAULT_PROTOCOL):
+    """Saves an object to a disk file like :func:`save`, on a background thread.
+
+    The storages of obj are copied before this function returns, so that obj
+    can be modified right away, e.g. by the next training step; the storages
+    on the GPU are copied to the CPU. A dedicated thread writes the file, and
+    starts with the first copies while the others are made. When f is a real
+    file, the storages are written without holding the GIL.
+
+    The file is the same as the one :func:`save` writes, and can be read with
+    :func:`load` once it is complete.
+
+    Args:
+        obj: saved object
+        f: a file-like object (has to implement write and flush) or a string
+           containing a file name. A file-like object must not be used until
+           the returned future is done.
+        pickle_module: module used for pickling metadata and objects
+        pickle_protocol: can be specified to override the default protocol
+
+    Returns:
+        A :class:`SaveFuture`, whose ``wait()`` returns once the file is
+        written.
+
+    Example:
+        >>> future = torch.save_async(model.state_dict(), 'checkpoint.pt')
+        >>> # ... keep training ...
+        >>> future.wait()
+    """
+    metadata = io.BytesIO()
+    keys, storages = _save_metadata(obj, metadata, pickle_module, pickle_protocol)
+    snapshots = queue.Queue()
+    future = SaveFuture()
+
+    def write(f):
+        f.write(metadata.getvalue())
+        f.flush()
+        is_real_file = _is_real_file(f)
+        for _ in keys:
+            snapshot = snapshots.get()
+            if snapshot is None:
+                raise RuntimeError("save_async: could not copy the storages")
+            snapshot._write_file(f, is_real_file)
+            del snapshot
+
+    def writer():
+        try:
+            _with_file_like(f, "wb", write)
+        except Exception as e:
+            future._exception = e
+        finally:
+            future._event.set()
+
+    # Not a daemon, so that the interpreter waits for the file at exit
+    thread = threading.Thread(target=writer)
+    thread.start()
+    try:
+        for key in keys:
+            snapshots.put(_snapshot_storage(storages[key]))
+    except BaseException:
+        snapshots.put(None)
+        raise
+    return future
+
+
 def _save(obj, f, pickle_module, pickle_protocol):
+    keys, storages = _save_metadata(obj, f, pickle_module, pickle_protocol)
+    f.flush()
+    for key in keys:
+        storages[key]._write_file(f, _is_real_file(f))
+
+
+def _save_metadata(obj, f, pickle_module, pickle_protocol):
+    """Writes everything but the data of the storages, and returns the keys
+    of the storages in the order in which their data must follow, and the
+    storages by key"""
     if sys.version_info[0] == 2:
         import StringIO
         if isinstance(f, StringIO.StringIO):
@@ -233,9 +338,7 @@ def _save(obj, f, pickle_module, pickle_protocol):
 
     serialized_storage_keys = sorted(serialized_storages.keys())
     pickle_module.dump(serialized_storage_keys, f, protocol=pickle_protocol)
-    f.flush()
-    for key in serialized_storage_keys:
-        serialized_storages[key]._write_file(f, _is_real_file(f))
+    return serialized_storage_keys, serialized_storages
 
 
 def load(f, map_location=None, pickle_module=pickle):
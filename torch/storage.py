@@ -110,6 +110,9 @@ class _StorageBase(object):
         from torch.multiprocessing import get_sharing_strategy
         if cls.is_cuda:
             return cls(size)
+        storage = cls._new_using_slab(size)
+        if storage is not None:
+            return storage
         elif get_sharing_strategy() == 'file_system':
             return cls._new_using_filename(size)
         else:
@@ -292,11 +292,17 @@ class Tensor(torch._C._TensorBase):
     def expand_as(self, tensor):
         return self.expand(tensor.size())
 
-    def unique(self, sorted=False, return_inverse=False):
+    def unique(self, sorted=False, return_inverse=False, return_counts=False):
         r"""Returns the unique scalar elements of the tensor as a 1-D tensor.
 
         See :func:`torch.unique`
         """
+        if return_counts:
+            output, inverse_indices, counts = self._unique_with_counts(
+                sorted=sorted, return_inverse=return_inverse)
+            if return_inverse:
+                return output, inverse_indices, counts
+            return output, counts
         output, inverse_indices = self._unique(
             sorted=sorted, return_inverse=return_inverse)
         if return_inverse:
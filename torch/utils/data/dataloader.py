@@ -2,7 +2,8 @@ import random
 import torch
 import torch.multiprocessing as multiprocessing
 from torch._C import _set_worker_signal_handlers, _update_worker_pids, \
-    _remove_worker_pids, _error_if_any_worker_fails
+    _remove_worker_pids, _error_if_any_worker_fails, _init_worker_slab, \
+    _close_worker_slab, _release_worker_slabs
 from .sampler import SequentialSampler, RandomSampler, BatchSampler
 import signal
 import functools
@@ -30,6 +31,15 @@ class ExceptionWrapper(object):
 _use_shared_memory = False
 r"""Whether to use shared memory in default_collate"""
 
+_worker_slab_segment_size = 32 * 1024 * 1024
+_worker_slab_num_segments = 0
+r"""Size of the shared memory slab that each worker allocates the batches of
+default_collate from. The slab is a ring of segments, each of which is reused
+once all the batches in it are freed by the main process. Batches larger than
+a segment, or that do not fit while all segments are in use, are shared with
+the sharing strategy of torch.multiprocessing instead. The slab is disabled by
+default; set the number of segments to a positive number to enable it."""
+
 
 def _worker_loop(dataset, index_queue, data_queue, collate_fn, seed, init_fn, worker_id):
     global _use_shared_memory
@@ -41,6 +51,9 @@ def _worker_loop(dataset, index_queue, data_queue, collate_fn, seed, init_fn, wo
     # https://docs.python.org/3/library/signal.html Sec. 18.8.1.1
     _set_worker_signal_handlers()
 
+    if _worker_slab_num_segments > 0:
+        _init_worker_slab(_worker_slab_segment_size, _worker_slab_num_segments)
+
     torch.set_num_threads(1)
     random.seed(seed)
     torch.manual_seed(seed)
@@ -48,17 +61,22 @@ def _worker_loop(dataset, index_queue, data_queue, collate_fn, seed, init_fn, wo
     if init_fn is not None:
         init_fn(worker_id)
 
-    while True:
-        r = index_queue.get()
-        if r is None:
-            break
-        idx, batch_indices = r
-        try:
-            samples = collate_fn([dataset[i] for i in batch_indices])
-        except Exception:
-            data_queue.put((idx, ExceptionWrapper(sys.exc_info())))
-        else:
-            data_queue.put((idx, samples))
+    try:
+        while True:
+            r = index_queue.get()
+            if r is None:
+                break
+            idx, batch_indices = r
+            try:
+                samples = collate_fn([dataset[i] for i in batch_indices])
+            except Exception:
+                data_queue.put((idx, ExceptionWrapper(sys.exc_info())))
+            else:
+                data_queue.put((idx, samples))
+                del samples
+    finally:
+        # the slab is unmapped once the batches still queued are sent
+        _close_worker_slab()
 
 
 def _worker_manager_loop(in_queue, out_queue, done_event, pin_memory, device_id):
@@ -333,6 +351,8 @@ class _DataLoaderIter(object):
                 # done_event should be sufficient to exit worker_manager_thread,
                 # but be safe here and put another None
                 self.worker_result_queue.put(None)
+                # the batches that are still alive keep their slab mapped
+                _release_worker_slabs(tuple(w.pid for w in self.workers))
         finally:
             # removes pids no matter what
             if self.worker_pids_set: